@@ -0,0 +1,581 @@
+#include "../Triangulation.h"
+#include "../ThreadPool.h"
+#include "../Snapshot.h"
+#include "../PathFinding/PathFinder.h"
+#include "../PathFinding/ChunkedWorld.h"
+#include "../PathFinding/PathHierarchy.h"
+#include "../PathFinding/PathQueryService.h"
+#include "../Shadows/MapGrid.h"
+#include "../Shadows/VisibilityField.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+//! headless benchmark of the triangulation, pathfinding and visibility hot paths
+//! usage: cdt_bench [--sizes 64,256,1024,4096] [--seed 42] [--density 0.05]
+//!                  [--queries 1000] [--out cdt_bench.json]
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Options
+    {
+        std::vector<int> sizes = {64, 256, 1024, 4096};
+        unsigned int seed = 42;
+        float wall_density = 0.05f; //! fraction of tiles covered by walls
+        int n_queries = 1000;       //! number of findTriangle/path queries per map
+        int n_vision_queries = 200;
+        int n_grid_updates = 10;
+        int n_map_edits = 100; //! number of 2x2 tile edits followed by local retriangulation
+        int n_agents = 10000;  //! points located together once per tick
+        int n_ticks = 10;
+        std::string out_file = "cdt_bench.json";
+    };
+
+    //! \struct latencies of a single measured operation
+    struct Samples
+    {
+        std::string name;
+        std::vector<double> latencies_us = {};
+        double total_s = 0.;
+
+        template <class Operation>
+        void measure(Operation &&op)
+        {
+            const auto start = Clock::now();
+            op();
+            const auto end = Clock::now();
+            const double elapsed = std::chrono::duration<double>(end - start).count();
+            latencies_us.push_back(elapsed * 1e6);
+            total_s += elapsed;
+        }
+
+        double percentile(std::vector<double> &sorted, double p) const
+        {
+            if (sorted.empty())
+            {
+                return 0.;
+            }
+            const auto rank = static_cast<std::size_t>(p * (sorted.size() - 1) + 0.5);
+            return sorted[std::min(rank, sorted.size() - 1)];
+        }
+
+        void writeJson(std::ostream &os) const
+        {
+            auto sorted = latencies_us;
+            std::sort(sorted.begin(), sorted.end());
+            const auto count = sorted.size();
+            const double throughput = total_s > 0. ? count / total_s : 0.;
+            os << "\"" << name << "\": {"
+               << "\"count\": " << count << ", "
+               << "\"total_ms\": " << total_s * 1e3 << ", "
+               << "\"throughput_per_s\": " << throughput << ", "
+               << "\"p50_us\": " << percentile(sorted, 0.50) << ", "
+               << "\"p90_us\": " << percentile(sorted, 0.90) << ", "
+               << "\"p99_us\": " << percentile(sorted, 0.99) << ", "
+               << "\"max_us\": " << (count > 0 ? sorted.back() : 0.) << "}";
+        }
+
+        void print(std::ostream &os) const
+        {
+            auto sorted = latencies_us;
+            std::sort(sorted.begin(), sorted.end());
+            const double throughput = total_s > 0. ? sorted.size() / total_s : 0.;
+            os << "  " << name << ": n=" << sorted.size() << " total=" << total_s * 1e3 << "ms"
+               << " ops/s=" << throughput << " p50=" << percentile(sorted, 0.5) << "us"
+               << " p99=" << percentile(sorted, 0.99) << "us\n";
+        }
+    };
+
+    struct MapResult
+    {
+        int size = 0;
+        std::size_t n_edges = 0;
+        std::size_t n_vertices = 0;
+        std::size_t n_triangles = 0;
+        long peak_rss_kb = 0;
+        cdt::LocateStats locate_stats; //! how the findTriangle queries of the benchmark were answered
+        std::vector<Samples> samples;
+    };
+
+    //! \returns peak resident set size of the process in kilobytes (0 if unsupported)
+    long peakMemoryKb()
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+        return usage.ru_maxrss / 1024; //! bytes on macOS
+#else
+        return usage.ru_maxrss;
+#endif
+#else
+        return 0;
+#endif
+    }
+
+    //! \brief fills the map with randomly placed rectangular walls until roughly \p density of tiles is covered
+    void generateMap(MapGridDiagonal &map, int size, float density, std::mt19937 &gen)
+    {
+        std::uniform_int_distribution<int> pos_dist(1, size - 2);
+        std::uniform_int_distribution<int> size_dist(1, 4);
+        const auto n_walls = static_cast<long>(density * size * size / 6.25f);
+        for (long i = 0; i < n_walls; ++i)
+        {
+            cdt::Vector2i lower_left = {pos_dist(gen), pos_dist(gen)};
+            cdt::Vector2i wall_size = {size_dist(gen), size_dist(gen)};
+            map.changeTiles(MapGridDiagonal::Tile::Wall, lower_left, wall_size);
+        }
+        map.transformCorners();
+    }
+
+    cdt::Vector2f randomPoint(int size, std::mt19937 &gen)
+    {
+        std::uniform_real_distribution<float> dist(0.5f, size - 0.5f);
+        return {dist(gen), dist(gen)};
+    }
+
+    //! \brief inserts constraints spanning the whole map width into a triangulation of random vertices
+    //! \brief the vertices lie on even rows and the constraints on odd ones, so the constraints cross many triangles
+    //! \brief but never go through a vertex
+    void measureLongConstraints(int size, std::size_t n_vertices, cdt::ConstraintInsertion mode, unsigned int seed,
+                                Samples &samples)
+    {
+        std::mt19937 gen(seed);
+        std::uniform_int_distribution<int> x_dist(1, size - 1);
+        std::uniform_int_distribution<int> row_dist(1, size / 2 - 1);
+        std::vector<cdt::Vector2i> verts;
+        verts.reserve(n_vertices);
+        for (std::size_t i = 0; i < n_vertices; ++i)
+        {
+            verts.push_back({x_dist(gen), 2 * row_dist(gen)});
+        }
+        const int row_step = std::max(2, size / 32) | 1;
+        for (int y = row_step; y < size; y += 2 * row_step)
+        {
+            verts.push_back({1, y});
+            verts.push_back({size - 1, y});
+        }
+
+        cdt::Triangulation<cdt::Vector2i> cdt({size, size});
+        cdt.setConstraintInsertion(mode);
+        const auto vert_inds = cdt.buildFromVertices(verts);
+        for (auto i = n_vertices; i + 1 < verts.size(); i += 2)
+        {
+            samples.measure([&]
+                            { cdt.insertConstraint({vert_inds[i], vert_inds[i + 1]}); });
+        }
+    }
+
+    MapResult runMap(int size, const Options &opts)
+    {
+        std::mt19937 gen(opts.seed + size);
+
+        MapResult result;
+        result.size = size;
+
+        MapGridDiagonal map({size, size}, {size, size});
+        generateMap(map, size, opts.wall_density, gen);
+        const auto edges = map.extractEdges();
+        map.clearDirtyRegion();
+        result.n_edges = edges.size();
+
+        cdt::Triangulation<cdt::Vector2i> cdt({size, size});
+
+        Samples insert_vertex{"insertVertex"};
+        std::vector<cdt::EdgeVInd> edge_inds;
+        edge_inds.reserve(edges.size());
+        for (const auto &e : edges)
+        {
+            cdt::EdgeVInd e_ind;
+            cdt::VertexInsertionData data;
+            insert_vertex.measure([&]
+                                  { data = cdt.insertVertexAndGetData(e.from); });
+            e_ind.from = (data.overlapping_vertex == -1 ? cdt.m_vertices.size() - 1 : data.overlapping_vertex);
+            insert_vertex.measure([&]
+                                  { data = cdt.insertVertexAndGetData(e.to()); });
+            e_ind.to = (data.overlapping_vertex == -1 ? cdt.m_vertices.size() - 1 : data.overlapping_vertex);
+            edge_inds.push_back(e_ind);
+        }
+
+        cdt::ThreadPool pool;
+        Samples insert_vertices{"insertVertices"}; //! bulk load of the same vertices into an empty triangulation
+        Samples build_from_vertices{"buildFromVertices"};
+        Samples build_from_vertices_parallel{"buildFromVertices (parallel)"}; //! strips built on all hardware threads
+        Samples insert_constraints{"insertConstraints"}; //! batch insertion of all constraints into the bulk loaded one
+        Samples insert_constraints_cavity{"insertConstraints (cavity)"};
+        {
+            std::vector<cdt::Vector2i> verts;
+            verts.reserve(2 * edges.size());
+            for (const auto &e : edges)
+            {
+                verts.push_back(e.from);
+                verts.push_back(e.to());
+            }
+            cdt::Triangulation<cdt::Vector2i> bulk_cdt({size, size});
+            insert_vertices.measure([&]
+                                    { bulk_cdt.insertVertices(verts); });
+            std::vector<cdt::VertInd> vert_inds;
+            build_from_vertices.measure([&]
+                                        { vert_inds = bulk_cdt.buildFromVertices(verts); });
+            cdt::Triangulation<cdt::Vector2i> parallel_cdt({size, size});
+            build_from_vertices_parallel.measure([&]
+                                                 { parallel_cdt.buildFromVertices(verts, &pool); });
+
+            std::vector<cdt::EdgeVInd> bulk_edge_inds;
+            bulk_edge_inds.reserve(edges.size());
+            for (std::size_t i = 0; i < edges.size(); ++i)
+            {
+                bulk_edge_inds.push_back({vert_inds[2 * i], vert_inds[2 * i + 1]});
+            }
+            insert_constraints.measure([&]
+                                       { bulk_cdt.insertConstraints(bulk_edge_inds); });
+
+            cdt::Triangulation<cdt::Vector2i> cavity_cdt({size, size});
+            cavity_cdt.setConstraintInsertion(cdt::ConstraintInsertion::Cavity);
+            cavity_cdt.buildFromVertices(verts);
+            insert_constraints_cavity.measure([&]
+                                              { cavity_cdt.insertConstraints(bulk_edge_inds); });
+        }
+
+        Samples insert_long_constraint{"insertLongConstraint"};
+        Samples insert_long_constraint_cavity{"insertLongConstraint (cavity)"};
+        measureLongConstraints(size, edges.size(), cdt::ConstraintInsertion::EdgeFlips, opts.seed + size,
+                               insert_long_constraint);
+        measureLongConstraints(size, edges.size(), cdt::ConstraintInsertion::Cavity, opts.seed + size,
+                               insert_long_constraint_cavity);
+
+        Samples insert_constraint{"insertConstraint"};
+        for (const auto &e : edge_inds)
+        {
+            insert_constraint.measure([&]
+                                      { cdt.insertConstraint(e); });
+        }
+
+        Samples grid_update{"updateCellGrid"};
+        for (int i = 0; i < opts.n_grid_updates; ++i)
+        {
+            grid_update.measure([&]
+                                { cdt.updateCellGrid(); });
+        }
+
+        Samples find_triangle{"findTriangle"};
+        cdt.resetLocateStats();
+        for (int i = 0; i < opts.n_queries; ++i)
+        {
+            const auto query = randomPoint(size, gen);
+            find_triangle.measure([&]
+                                  { cdt.findTriangle(query, false); });
+        }
+        result.locate_stats = cdt.locateStats();
+
+        //! every tick the agents are located one by one, all at once and all at once from their previous triangles
+        std::vector<cdt::Vector2f> agents(opts.n_agents);
+        std::generate(agents.begin(), agents.end(), [&]()
+                      { return randomPoint(size, gen); });
+        std::vector<cdt::TriInd> agent_tri_inds(agents.size());
+        std::uniform_real_distribution<float> step_dist(-0.5f, 0.5f);
+        Samples find_triangle_agents{"findTriangle (agents)"};
+        Samples locate_many{"locateMany"};
+        Samples locate_many_hinted{"locateMany (hinted)"};
+        for (int tick = 0; tick < opts.n_ticks; ++tick)
+        {
+            find_triangle_agents.measure([&]
+                                         {
+                for (std::size_t i = 0; i < agents.size(); ++i)
+                {
+                    agent_tri_inds[i] = cdt.findTriangle(agents[i], false);
+                } });
+            locate_many.measure([&]
+                                { cdt.locateMany(agents, agent_tri_inds, false, &pool); });
+            for (auto &agent : agents)
+            {
+                agent.x = std::clamp(agent.x + step_dist(gen), 0.5f, size - 0.5f);
+                agent.y = std::clamp(agent.y + step_dist(gen), 0.5f, size - 0.5f);
+            }
+            locate_many_hinted.measure([&]
+                                       { cdt.locateMany(agents, agent_tri_inds, true, &pool); });
+        }
+
+        PathFinder pf(cdt);
+        Samples pf_update{"PathFinder::update"};
+        for (int i = 0; i < opts.n_grid_updates; ++i)
+        {
+            pf_update.measure([&]
+                              { pf.update(); });
+        }
+
+        //! cold start from a baked map: open the snapshot and take everything from it instead of rebuilding
+        Samples save_snapshot{"saveSnapshot"};
+        Samples load_snapshot{"loadSnapshot"};
+        {
+            const auto filename = (std::filesystem::temp_directory_path() / "cdt_bench_snapshot.bin").string();
+            save_snapshot.measure([&]
+                                  { pf.saveSnapshot(filename); });
+            cdt::Triangulation<cdt::Vector2i> loaded_cdt;
+            PathFinder loaded_pf(loaded_cdt);
+            load_snapshot.measure([&]
+                                  {
+                cdt::SnapshotFile snapshot(filename);
+                loaded_cdt.loadSnapshot(snapshot);
+                loaded_pf.update(snapshot); });
+            std::filesystem::remove(filename);
+        }
+
+        std::vector<std::pair<cdt::Vector2f, cdt::Vector2f>> path_queries(opts.n_queries);
+        for (auto &[r_start, r_end] : path_queries)
+        {
+            r_start = randomPoint(size, gen);
+            r_end = randomPoint(size, gen);
+        }
+        Samples path_finding{"PathFinder::doPathFinding"};
+        for (const auto &[r_start, r_end] : path_queries)
+        {
+            path_finding.measure([&]
+                                 { pf.doPathFinding(r_start, r_end, 0.5f); });
+        }
+
+        //! the same queries with A* expanding every triangle instead of only the reduced graph vertices
+        Samples path_finding_triangles{"PathFinder::doPathFinding (triangle graph)"};
+        pf.setUseReducedGraph(false);
+        for (const auto &[r_start, r_end] : path_queries)
+        {
+            path_finding_triangles.measure([&]
+                                           { pf.doPathFinding(r_start, r_end, 0.5f); });
+        }
+        pf.setUseReducedGraph(true);
+
+        //! short paths to a point at most 32 tiles away, which dominate in games
+        Samples local_path_finding{"PathFinder::doPathFinding (local)"};
+        std::uniform_real_distribution<float> local_offset_dist(-32.f, 32.f);
+        for (const auto &[r_start, r_far_end] : path_queries)
+        {
+            const cdt::Vector2f r_end = {std::clamp(r_start.x + local_offset_dist(gen), 0.5f, size - 0.5f),
+                                         std::clamp(r_start.y + local_offset_dist(gen), 0.5f, size - 0.5f)};
+            local_path_finding.measure([&]
+                                       { pf.doPathFinding(r_start, r_end, 0.5f); });
+        }
+
+        //! the same queries once the triangles got renumbered along a Hilbert curve
+        Samples reorder{"reorder"};
+        reorder.measure([&]
+                        { pf.reorder(cdt.reorder()); });
+        Samples path_finding_reordered{"PathFinder::doPathFinding (reordered)"};
+        for (const auto &[r_start, r_end] : path_queries)
+        {
+            path_finding_reordered.measure([&]
+                                           { pf.doPathFinding(r_start, r_end, 0.5f); });
+        }
+
+        //! all the queries at once answered by one worker per core, one sample per batch
+        Samples path_query_batch{"PathQueryService (batch)"};
+        {
+            PathQueryService service(pf);
+            std::vector<PathQueryService::Request> requests;
+            for (const auto &[r_start, r_end] : path_queries)
+            {
+                requests.push_back({r_start, r_end, 0.5f});
+            }
+            for (int i = 0; i < 3; ++i)
+            {
+                path_query_batch.measure([&]
+                                         {
+                    service.submit(requests, [](std::size_t, PathFinder::PathData &&) {});
+                    service.wait(); });
+            }
+        }
+
+        //! the same queries searched first among entrances of 64x64 chunks and then only in the traversed chunks
+        PathHierarchy hierarchy(cdt, pf, 64, 0.5f);
+        Samples hierarchy_build{"PathHierarchy::update"};
+        hierarchy_build.measure([&]
+                                { hierarchy.update(); });
+        Samples hierarchy_path_finding{"PathHierarchy::findPath"};
+        for (const auto &[r_start, r_end] : path_queries)
+        {
+            hierarchy_path_finding.measure([&]
+                                           { hierarchy.findPath(r_start, r_end, 0.5f); });
+        }
+
+        VisionField vision(cdt);
+        Samples vision_field{"VisionField::contrstuctField"};
+        for (int i = 0; i < opts.n_vision_queries; ++i)
+        {
+            const auto from = randomPoint(size, gen);
+            vision_field.measure([&]
+                                 { vision.contrstuctField(from, {1.f, 0.f}); });
+        }
+
+        result.n_vertices = cdt.m_vertices.size();
+        result.n_triangles = cdt.m_triangles.size();
+
+        //! the same map split into chunks of 128x128 tiles (or a single chunk for smaller maps)
+        const int chunk_size = std::min(size, 128);
+        ChunkedWorld world({chunk_size, chunk_size}, {size / chunk_size, size / chunk_size},
+                           [&map](cdt::Vector2i lower_left, cdt::Vector2i upper_right)
+                           { return map.extractEdges(lower_left, upper_right - cdt::Vector2i{1, 1}); });
+        Samples chunk_build{"ChunkedWorld::chunk (build)"};
+        for (int iy = 0; iy < size / chunk_size; ++iy)
+        {
+            for (int ix = 0; ix < size / chunk_size; ++ix)
+            {
+                chunk_build.measure([&]
+                                    { world.chunk({ix, iy}); });
+            }
+        }
+        Samples chunked_path_finding{"ChunkedWorld::findPath"};
+        for (int i = 0; i < opts.n_queries; ++i)
+        {
+            const auto r_start = randomPoint(size, gen);
+            const auto r_end = randomPoint(size, gen);
+            chunked_path_finding.measure([&]
+                                         { world.findPath(r_start, r_end, 0.5f); });
+        }
+
+        Samples map_update{"MapGrid::updateTriangulation"};
+        Samples chunk_update{"ChunkedWorld::invalidate"}; //! rebuilds the chunks touched by the same edits
+        Samples hierarchy_update{"PathHierarchy::update (edit)"}; //! recomputes costs of the chunks touched by them
+        std::uniform_int_distribution<int> edit_dist(1, size - 3);
+        for (int i = 0; i < opts.n_map_edits; ++i)
+        {
+            const auto tile = i % 2 == 0 ? MapGridDiagonal::Tile::Wall : MapGridDiagonal::Tile::Ground;
+            const cdt::Vector2i lower_left = {edit_dist(gen), edit_dist(gen)};
+            map.changeTiles(tile, lower_left, {2, 2});
+            map_update.measure([&]
+                               { map.updateTriangulation(cdt); });
+            chunk_update.measure([&]
+                                 { world.invalidate(lower_left - cdt::Vector2i{2, 2}, lower_left + cdt::Vector2i{4, 4}); });
+            pf.update();
+            hierarchy_update.measure([&]
+                                     { hierarchy.update(); });
+        }
+
+        result.peak_rss_kb = peakMemoryKb();
+        result.samples = {insert_vertex, insert_vertices, build_from_vertices, build_from_vertices_parallel, insert_constraint, insert_constraints,
+                          insert_constraints_cavity, insert_long_constraint, insert_long_constraint_cavity,
+                          grid_update, find_triangle, find_triangle_agents, locate_many, locate_many_hinted, pf_update,
+                          save_snapshot, load_snapshot, path_finding, path_finding_triangles, local_path_finding, reorder, path_finding_reordered, path_query_batch, hierarchy_build, hierarchy_path_finding, vision_field, chunk_build, chunked_path_finding,
+                          map_update, chunk_update, hierarchy_update};
+        return result;
+    }
+
+    void writeJson(std::ostream &os, const Options &opts, const std::vector<MapResult> &results)
+    {
+        os << "{\n  \"benchmark\": \"cdt_bench\",\n"
+           << "  \"seed\": " << opts.seed << ",\n"
+           << "  \"wall_density\": " << opts.wall_density << ",\n"
+           << "  \"maps\": [\n";
+        for (std::size_t i = 0; i < results.size(); ++i)
+        {
+            const auto &r = results[i];
+            os << "    {\"size\": " << r.size
+               << ", \"n_edges\": " << r.n_edges
+               << ", \"n_vertices\": " << r.n_vertices
+               << ", \"n_triangles\": " << r.n_triangles
+               << ", \"peak_rss_kb\": " << r.peak_rss_kb
+               << ",\n     \"locate\": {\"n_queries\": " << r.locate_stats.n_queries
+               << ", \"n_empty_cells\": " << r.locate_stats.n_empty_cells
+               << ", \"n_steps\": " << r.locate_stats.n_steps
+               << ", \"n_restarts\": " << r.locate_stats.n_restarts << "}"
+               << ",\n     \"ops\": {";
+            for (std::size_t j = 0; j < r.samples.size(); ++j)
+            {
+                os << (j == 0 ? "\n       " : ",\n       ");
+                r.samples[j].writeJson(os);
+            }
+            os << "}}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        os << "  ]\n}\n";
+    }
+
+    std::vector<int> parseSizes(const std::string &arg)
+    {
+        std::vector<int> sizes;
+        std::stringstream ss(arg);
+        std::string item;
+        while (std::getline(ss, item, ','))
+        {
+            sizes.push_back(std::stoi(item));
+        }
+        return sizes;
+    }
+
+    Options parseOptions(int argc, char **argv)
+    {
+        Options opts;
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            const bool has_value = i + 1 < argc;
+            if (arg == "--sizes" && has_value)
+            {
+                opts.sizes = parseSizes(argv[++i]);
+            }
+            else if (arg == "--seed" && has_value)
+            {
+                opts.seed = std::stoul(argv[++i]);
+            }
+            else if (arg == "--density" && has_value)
+            {
+                opts.wall_density = std::stof(argv[++i]);
+            }
+            else if (arg == "--queries" && has_value)
+            {
+                opts.n_queries = std::stoi(argv[++i]);
+            }
+            else if (arg == "--out" && has_value)
+            {
+                opts.out_file = argv[++i];
+            }
+            else
+            {
+                std::cerr << "unknown argument: " << arg << "\n"
+                          << "usage: cdt_bench [--sizes 64,256,1024,4096] [--seed N] [--density F]"
+                          << " [--queries N] [--out FILE]\n";
+                std::exit(1);
+            }
+        }
+        return opts;
+    }
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const auto opts = parseOptions(argc, argv);
+
+    std::vector<MapResult> results;
+    for (const auto size : opts.sizes)
+    {
+        std::cout << "map " << size << "x" << size << "\n";
+        results.push_back(runMap(size, opts));
+        for (const auto &samples : results.back().samples)
+        {
+            samples.print(std::cout);
+        }
+        std::cout << "  triangles=" << results.back().n_triangles
+                  << " peak_rss=" << results.back().peak_rss_kb << "kB\n";
+    }
+
+    std::ofstream file(opts.out_file);
+    if (!file.is_open())
+    {
+        std::cerr << "could not open " << opts.out_file << "\n";
+        return 1;
+    }
+    writeJson(file, opts, results);
+    return 0;
+}
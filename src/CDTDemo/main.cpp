@@ -16,9 +16,8 @@ void drawTriInds(sf::RenderWindow &m_window, cdt::Triangulation<cdt::Vector2i> &
     num.setFillColor(sf::Color::Blue);
     for (int ind = 0; ind < m_cdt.m_triangles.size(); ++ind)
     {
-        auto &tri = m_cdt.m_triangles.at(ind);
         num.setString(std::to_string(ind));
-        auto center = asFloat(tri.verts[0] + tri.verts[1] + tri.verts[2]) / 3.f;
+        auto center = m_cdt.getCenter(ind);
         num.setPosition(center.x, center.y); // - sf::Vector2f(num.getGlobalBounds().width, num.getLocalBounds().height)
         num.setScale(0.03f, 0.03f);
         m_window.draw(num);
@@ -90,11 +89,11 @@ int main(int argc, char **argv)
                     cdt::VertInd closest_vert_ind;
                     for (int i = 0; i < 3; ++i)
                     {
-                        float new_dist = dist(asFloat(tri.verts[i]), mouse_pos);
+                        float new_dist = dist(asFloat(cdt.vertexOf(tri, i)), mouse_pos);
                         if (new_dist < min_dist)
                         {
                             min_dist = new_dist;
-                            closest_vert_ind = cdt.m_tri_ind2vert_inds[tri_ind][i];
+                            closest_vert_ind = tri.vert_inds[i];
                         }
                     }
                     picked_vertex_inds.push_back(closest_vert_ind);
@@ -162,12 +161,12 @@ int main(int argc, char **argv)
 
         for (auto &tri : cdt.m_triangles)
         {
-            sf::Vector2f v1(tri.verts[0].x, tri.verts[0].y);
-            sf::Vector2f v2(tri.verts[1].x, tri.verts[1].y);
-            sf::Vector2f v3(tri.verts[2].x, tri.verts[2].y);
-            tri.is_constrained[0] ? drawLine(window, v1, v2, sf::Color::Red) : drawLine(window, v1, v2);
-            tri.is_constrained[1] ? drawLine(window, v2, v3, sf::Color::Red) : drawLine(window, v2, v3);
-            tri.is_constrained[2] ? drawLine(window, v3, v1, sf::Color::Red) : drawLine(window, v3, v1);
+            sf::Vector2f v1(cdt.vertexOf(tri, 0).x, cdt.vertexOf(tri, 0).y);
+            sf::Vector2f v2(cdt.vertexOf(tri, 1).x, cdt.vertexOf(tri, 1).y);
+            sf::Vector2f v3(cdt.vertexOf(tri, 2).x, cdt.vertexOf(tri, 2).y);
+            tri.isConstrained(0) ? drawLine(window, v1, v2, sf::Color::Red) : drawLine(window, v1, v2);
+            tri.isConstrained(1) ? drawLine(window, v2, v3, sf::Color::Red) : drawLine(window, v2, v3);
+            tri.isConstrained(2) ? drawLine(window, v3, v1, sf::Color::Red) : drawLine(window, v3, v1);
         }
         if (draw_grid)
         {
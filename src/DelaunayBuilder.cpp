@@ -0,0 +1,368 @@
+#include "DelaunayBuilder.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace cdt
+{
+
+    //! \param vertices unique vertices to triangulate, triangles refer to them by their index
+    //! \returns triangles ordered the same way as in Triangulation, edges on the convex hull have neighbour -1
+    template <class Vertex>
+    std::vector<Triangle> DelaunayBuilder<Vertex>::triangulate(const std::vector<Vertex> &vertices, ThreadPool *pool)
+    {
+        std::vector<VertInd> sorted_inds(vertices.size());
+        std::iota(sorted_inds.begin(), sorted_inds.end(), 0);
+        std::sort(sorted_inds.begin(), sorted_inds.end(), [&vertices](VertInd a, VertInd b)
+                  { return vertices[a].x < vertices[b].x || (vertices[a].x == vertices[b].x && vertices[a].y < vertices[b].y); });
+        return triangulate(vertices, std::move(sorted_inds), pool);
+    }
+
+    //! \param vertices unique vertices, triangles refer to them by their index
+    //! \param sorted_inds indices of \p vertices sorted by x and then by y, only these vertices get triangulated
+    //! \param pool when not null, strips of at least 4096 vertices get triangulated on its threads
+    //! \returns triangles ordered the same way as in Triangulation, edges on the convex hull have neighbour -1
+    template <class Vertex>
+    std::vector<Triangle> DelaunayBuilder<Vertex>::triangulate(const std::vector<Vertex> &vertices,
+                                                               std::vector<VertInd> sorted_inds, ThreadPool *pool)
+    {
+        m_sorted = std::move(sorted_inds);
+        m_quads.clear();
+        if (m_sorted.size() < 3)
+        {
+            return {};
+        }
+        //! the recursion works on a sorted copy so that merged halves lie next to each other in memory
+        m_points.resize(m_sorted.size());
+        for (std::size_t i = 0; i < m_sorted.size(); ++i)
+        {
+            m_points[i] = vertices[m_sorted[i]];
+        }
+        assert(std::adjacent_find(m_points.begin(), m_points.end(), [](const Vertex &a, const Vertex &b)
+                                  { return !(a.x < b.x || (a.x == b.x && a.y < b.y)); }) == m_points.end());
+
+        //! more strips than threads even out strips which take longer, but every strip adds a merge on one thread
+        constexpr std::size_t min_strip_size = 4096;
+        std::size_t n_strips = 1;
+        while (pool && n_strips < 2 * pool->size() && m_points.size() / (2 * n_strips) >= min_strip_size)
+        {
+            n_strips *= 2;
+        }
+
+        if (n_strips == 1)
+        {
+            m_quads.reserve(3 * m_points.size()); //! a planar triangulation has less than 3n edges
+            m_arenas.resize(1);
+            m_arenas[0].free_quads.clear();
+            m_arenas[0].next_quad = m_arenas[0].end_quad = 0;
+            m_arenas[0].can_grow = true;
+            triangulate(0, m_points.size(), m_arenas[0]);
+        }
+        else
+        {
+            triangulateInStrips(*pool, n_strips);
+        }
+
+        return extractTriangles();
+    }
+
+    //! \brief cuts the recursion log2(\p n_strips) levels deep and triangulates the resulting vertical strips
+    //! \brief in parallel, then merges neighbouring strips pairwise on the calling thread
+    //! \brief a merge only touches edges near the seam, so for evenly spread vertices the merges cost O(sqrt(n))
+    //! \param n_strips power of two
+    template <class Vertex>
+    void DelaunayBuilder<Vertex>::triangulateInStrips(ThreadPool &pool, std::size_t n_strips)
+    {
+        std::vector<std::size_t> strip_bounds = {0, m_points.size()};
+        while (strip_bounds.size() <= n_strips)
+        {
+            std::vector<std::size_t> halved_bounds;
+            halved_bounds.reserve(2 * strip_bounds.size());
+            for (std::size_t i = 0; i + 1 < strip_bounds.size(); ++i)
+            {
+                halved_bounds.push_back(strip_bounds[i]);
+                halved_bounds.push_back(strip_bounds[i] + (strip_bounds[i + 1] - strip_bounds[i]) / 2);
+            }
+            halved_bounds.push_back(m_points.size());
+            strip_bounds = std::move(halved_bounds);
+        }
+
+        //! each strip gets its own range of the arena big enough for all edges of its triangulation,
+        //! so the threads never reallocate m_quads
+        QuadEdge unused_quad = {};
+        unused_quad.origin = {-1u, -1u};
+        m_quads.assign(3 * m_points.size(), unused_quad);
+        m_arenas.resize(n_strips);
+        for (std::size_t i = 0; i < n_strips; ++i)
+        {
+            m_arenas[i].free_quads.clear();
+            m_arenas[i].next_quad = 3 * strip_bounds[i];
+            m_arenas[i].end_quad = 3 * strip_bounds[i + 1];
+            m_arenas[i].can_grow = false;
+        }
+
+        std::vector<Hull> hulls(n_strips);
+        pool.parallelFor(n_strips, [&](std::size_t strip_ind)
+                         { hulls[strip_ind] = triangulate(strip_bounds[strip_ind], strip_bounds[strip_ind + 1],
+                                                          m_arenas[strip_ind]); });
+
+        auto &merge_arena = m_arenas[0];
+        for (std::size_t i = 1; i < n_strips; ++i)
+        {
+            merge_arena.free_quads.insert(merge_arena.free_quads.end(), m_arenas[i].free_quads.begin(),
+                                          m_arenas[i].free_quads.end());
+        }
+        merge_arena.can_grow = true;
+        while (hulls.size() > 1)
+        {
+            for (std::size_t i = 0; i < hulls.size() / 2; ++i)
+            {
+                hulls[i] = merge(hulls[2 * i], hulls[2 * i + 1], merge_arena);
+            }
+            hulls.resize(hulls.size() / 2);
+        }
+    }
+
+    //! \brief triangulates sorted vertices in range [\p begin, \p end)
+    //! \returns counterclockwise convex hull edge going out of the leftmost vertex
+    //! \returns and clockwise convex hull edge going out of the rightmost vertex
+    template <class Vertex>
+    typename DelaunayBuilder<Vertex>::Hull DelaunayBuilder<Vertex>::triangulate(std::size_t begin, std::size_t end,
+                                                                                Arena &arena)
+    {
+        const auto n_verts = end - begin;
+        if (n_verts == 2)
+        {
+            const auto a = makeEdge(begin, begin + 1, arena);
+            return {a, sym(a)};
+        }
+        if (n_verts == 3)
+        {
+            const VertInd v1 = begin;
+            const VertInd v2 = begin + 1;
+            const VertInd v3 = begin + 2;
+            const auto a = makeEdge(v1, v2, arena);
+            const auto b = makeEdge(v2, v3, arena);
+            splice(sym(a), b);
+            if (isCounterClockwise(v1, v2, v3))
+            {
+                connect(b, a, arena);
+                return {a, sym(b)};
+            }
+            if (isCounterClockwise(v1, v3, v2))
+            {
+                const auto c = connect(b, a, arena);
+                return {sym(c), c};
+            }
+            return {a, sym(b)}; //! the three vertices are collinear
+        }
+
+        const auto middle = begin + n_verts / 2;
+        const auto left = triangulate(begin, middle, arena);
+        const auto right = triangulate(middle, end, arena);
+        return merge(left, right, arena);
+    }
+
+    //! \brief joins triangulations of two neighbouring ranges of sorted vertices into one
+    //! \param left hull edges of the range with smaller coordinates as returned by triangulate
+    //! \param right hull edges of the range right after it
+    //! \returns hull edges of the joined range
+    template <class Vertex>
+    typename DelaunayBuilder<Vertex>::Hull DelaunayBuilder<Vertex>::merge(Hull left, Hull right, Arena &arena)
+    {
+        auto [ldo, ldi] = left;
+        auto [rdi, rdo] = right;
+
+        //! find the lower common tangent of the two halves
+        while (true)
+        {
+            if (leftOf(org(rdi), ldi))
+            {
+                ldi = lnext(ldi);
+            }
+            else if (rightOf(org(ldi), rdi))
+            {
+                rdi = rprev(rdi);
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        auto base = connect(sym(rdi), ldi, arena);
+        if (org(ldi) == org(ldo))
+        {
+            ldo = sym(base);
+        }
+        if (org(rdi) == org(rdo))
+        {
+            rdo = base;
+        }
+
+        //! zip the halves together from the bottom up
+        while (true)
+        {
+            auto left_candidate = onext(sym(base));
+            const bool left_is_valid = rightOf(dest(left_candidate), base);
+            if (left_is_valid)
+            {
+                while (inCircle(dest(base), org(base), dest(left_candidate), dest(onext(left_candidate))))
+                {
+                    const auto t = onext(left_candidate);
+                    deleteEdge(left_candidate, arena);
+                    left_candidate = t;
+                }
+            }
+
+            auto right_candidate = oprev(base);
+            const bool right_is_valid = rightOf(dest(right_candidate), base);
+            if (right_is_valid)
+            {
+                while (inCircle(dest(base), org(base), dest(right_candidate), dest(oprev(right_candidate))))
+                {
+                    const auto t = oprev(right_candidate);
+                    deleteEdge(right_candidate, arena);
+                    right_candidate = t;
+                }
+            }
+
+            if (!left_is_valid && !right_is_valid)
+            {
+                break;
+            }
+            if (!left_is_valid ||
+                (right_is_valid && inCircle(dest(left_candidate), org(left_candidate), org(right_candidate),
+                                            dest(right_candidate))))
+            {
+                base = connect(right_candidate, sym(base), arena);
+            }
+            else
+            {
+                base = connect(sym(base), sym(left_candidate), arena);
+            }
+        }
+        return {ldo, rdo};
+    }
+
+    //! \brief creates isolated edge going from \p from to \p to
+    template <class Vertex>
+    typename DelaunayBuilder<Vertex>::EdgeRef DelaunayBuilder<Vertex>::makeEdge(VertInd from, VertInd to, Arena &arena)
+    {
+        EdgeRef e;
+        if (!arena.free_quads.empty())
+        {
+            e = arena.free_quads.back();
+            arena.free_quads.pop_back();
+        }
+        else if (arena.next_quad < arena.end_quad)
+        {
+            e = 4 * arena.next_quad++;
+        }
+        else
+        {
+            assert(arena.can_grow);
+            e = 4 * m_quads.size();
+            m_quads.emplace_back();
+        }
+        m_quads[e >> 2] = {{e, e + 3, e + 2, e + 1}, {from, to}};
+        return e;
+    }
+
+    //! \brief joins or separates edge rings of \p a and \p b
+    template <class Vertex>
+    void DelaunayBuilder<Vertex>::splice(EdgeRef a, EdgeRef b)
+    {
+        const auto alpha = rot(onext(a));
+        const auto beta = rot(onext(b));
+        std::swap(onext(a), onext(b));
+        std::swap(onext(alpha), onext(beta));
+    }
+
+    //! \brief adds edge going from destination of \p a to origin of \p b so that all three share the same left face
+    template <class Vertex>
+    typename DelaunayBuilder<Vertex>::EdgeRef DelaunayBuilder<Vertex>::connect(EdgeRef a, EdgeRef b, Arena &arena)
+    {
+        const auto e = makeEdge(dest(a), org(b), arena);
+        splice(e, lnext(a));
+        splice(sym(e), b);
+        return e;
+    }
+
+    //! \brief disconnects \p e from the rest of the mesh and gives its quad-edge back to the arena
+    template <class Vertex>
+    void DelaunayBuilder<Vertex>::deleteEdge(EdgeRef e, Arena &arena)
+    {
+        splice(e, oprev(e));
+        splice(sym(e), oprev(sym(e)));
+        m_quads[e >> 2].origin = {-1u, -1u};
+        arena.free_quads.push_back(e & ~3u);
+    }
+
+    //! \returns true if \p a, \p b, \p c make a strict left turn
+    template <class Vertex>
+    bool DelaunayBuilder<Vertex>::isCounterClockwise(VertInd a, VertInd b, VertInd c) const
+    {
+        return orientation(m_points[a], m_points[b], m_points[c]) > 0;
+    }
+
+    //! \returns true if \p d lies strictly inside of the circumcircle of counterclockwise triangle \p a, \p b, \p c
+    template <class Vertex>
+    bool DelaunayBuilder<Vertex>::inCircle(VertInd a, VertInd b, VertInd c, VertInd d) const
+    {
+        return cdt::inCircle(m_points[a], m_points[b], m_points[c], m_points[d]) > 0;
+    }
+
+    //! \brief converts every bounded face of the quad-edge mesh into a triangle and links them together
+    template <class Vertex>
+    std::vector<Triangle> DelaunayBuilder<Vertex>::extractTriangles() const
+    {
+        std::vector<Triangle> triangles;
+        triangles.reserve(2 * m_points.size());
+
+        const EdgeRef n_edges = 4 * m_quads.size();
+        std::vector<TriInd> edge2tri(n_edges, -1);
+        std::vector<std::uint8_t> edge2ind_in_tri(n_edges, 0);
+
+        for (EdgeRef e0 = 0; e0 < n_edges; e0 += 2) //! odd refs are dual edges
+        {
+            if (org(e0) == -1 || edge2tri[e0] != -1)
+            {
+                continue;
+            }
+            const auto e1 = lnext(e0);
+            const auto e2 = lnext(e1);
+            if (lnext(e2) != e0 || !isCounterClockwise(org(e0), org(e1), org(e2)))
+            {
+                continue; //! the outer face
+            }
+            //! triangles in Triangulation turn the other way so the face (a, b, c) is stored as (a, c, b)
+            const TriInd tri_ind = triangles.size();
+            Triangle tri;
+            tri.vert_inds = {m_sorted[org(e0)], m_sorted[org(e2)], m_sorted[org(e1)]};
+            triangles.push_back(tri);
+            for (const auto &[e, ind_in_tri] : {std::pair{e0, 2}, std::pair{e1, 1}, std::pair{e2, 0}})
+            {
+                edge2tri[e] = tri_ind;
+                edge2ind_in_tri[e] = ind_in_tri;
+            }
+        }
+
+        for (EdgeRef e = 0; e < n_edges; e += 2)
+        {
+            if (edge2tri[e] == -1)
+            {
+                continue;
+            }
+            auto &tri = triangles[edge2tri[e]];
+            const auto ind_in_tri = edge2ind_in_tri[e];
+            tri.neighbours[ind_in_tri] = edge2tri[sym(e)];
+            tri.setBackIndex(ind_in_tri, edge2ind_in_tri[sym(e)]);
+        }
+        return triangles;
+    }
+
+    template class DelaunayBuilder<cdt::Vector2i>;
+
+} // namespace cdt
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <utility>
+
+#include "Triangulation.h"
+
+namespace cdt
+{
+
+    //! \brief builds Delaunay triangulation of a whole point set at once using Guibas-Stolfi divide and conquer
+    //! \brief runs in O(n log n) and produces triangles in the same format as Triangulation::m_triangles
+    //! \brief edges live in a quad-edge arena which is kept between calls so that repeated builds do not allocate
+    //! \brief given a thread pool, vertical strips of the sorted vertices are triangulated on separate threads
+    //! \brief and then merged along their seams by the same merge step the recursion uses
+    template <class Vertex>
+    class DelaunayBuilder
+    {
+        using EdgeRef = unsigned int; //! index of a directed edge in the arena, 4 consecutive refs form one quad-edge
+
+        //! \struct one undirected edge together with its dual
+        struct QuadEdge
+        {
+            std::array<EdgeRef, 4> onext;  //! next edge counterclockwise around the origin of each of the 4 edges
+            std::array<VertInd, 2> origin; //! origins of the two primal edges, -1 when the edge was deleted
+        };
+
+        //! \struct source of new quad-edges for one part of the recursion
+        struct Arena
+        {
+            std::vector<EdgeRef> free_quads; //! deleted quad-edges which get reused first
+            std::size_t next_quad = 0;       //! next unused quad-edge of the range [next_quad, end_quad) in m_quads
+            std::size_t end_quad = 0;
+            bool can_grow = true; //! appends to m_quads once the range is used up, only when no other arena works
+        };
+        using Hull = std::pair<EdgeRef, EdgeRef>;
+
+    public:
+        //! \param vertices unique vertices to triangulate, triangles refer to them by their index
+        //! \returns triangles ordered the same way as in Triangulation, edges on the convex hull have neighbour -1
+        std::vector<Triangle> triangulate(const std::vector<Vertex> &vertices, ThreadPool *pool = nullptr);
+        //! \param sorted_inds indices of \p vertices sorted by x and then by y, only these vertices get triangulated
+        std::vector<Triangle> triangulate(const std::vector<Vertex> &vertices, std::vector<VertInd> sorted_inds,
+                                          ThreadPool *pool = nullptr);
+
+    private:
+        static EdgeRef rot(EdgeRef e) { return (e & ~3u) | ((e + 1) & 3u); }
+        static EdgeRef sym(EdgeRef e) { return (e & ~3u) | ((e + 2) & 3u); }
+        static EdgeRef rotInv(EdgeRef e) { return (e & ~3u) | ((e + 3) & 3u); }
+
+        EdgeRef &onext(EdgeRef e) { return m_quads[e >> 2].onext[e & 3u]; }
+        EdgeRef onext(EdgeRef e) const { return m_quads[e >> 2].onext[e & 3u]; }
+        EdgeRef oprev(EdgeRef e) const { return rot(onext(rot(e))); }
+        EdgeRef lnext(EdgeRef e) const { return rot(onext(rotInv(e))); }
+        EdgeRef rprev(EdgeRef e) const { return onext(sym(e)); }
+        VertInd org(EdgeRef e) const { return m_quads[e >> 2].origin[(e & 3u) >> 1]; }
+        VertInd dest(EdgeRef e) const { return org(sym(e)); }
+
+        EdgeRef makeEdge(VertInd from, VertInd to, Arena &arena);
+        void splice(EdgeRef a, EdgeRef b);
+        EdgeRef connect(EdgeRef a, EdgeRef b, Arena &arena);
+        void deleteEdge(EdgeRef e, Arena &arena);
+
+        bool isCounterClockwise(VertInd a, VertInd b, VertInd c) const;
+        bool inCircle(VertInd a, VertInd b, VertInd c, VertInd d) const;
+        bool rightOf(VertInd v, EdgeRef e) const { return isCounterClockwise(v, dest(e), org(e)); }
+        bool leftOf(VertInd v, EdgeRef e) const { return isCounterClockwise(v, org(e), dest(e)); }
+
+        Hull triangulate(std::size_t begin, std::size_t end, Arena &arena);
+        Hull merge(Hull left, Hull right, Arena &arena);
+        void triangulateInStrips(ThreadPool &pool, std::size_t n_strips);
+
+        std::vector<Triangle> extractTriangles() const;
+
+    private:
+        std::vector<VertInd> m_sorted;     //! input indices of vertices sorted lexicographically by coordinates
+        std::vector<Vertex> m_points;      //! sorted vertices, the recursion refers to vertices by their index here
+        std::vector<QuadEdge> m_quads; //! edge arena, a directed edge e lives in m_quads[e / 4]
+        std::vector<Arena> m_arenas;   //! one per strip, the first one also serves the merges of strips
+    };
+
+} // namespace cdt
@@ -3,6 +3,7 @@
 #include <cmath>
 #include <cassert>
 #include <iostream>
+#include <utility>
 
 #include "Grid.h"
 
@@ -102,4 +103,32 @@ size_t Grid::getNCells() const{
     return m_cell_count.x*m_cell_count.y;
 }
 
+//! \brief computes position of a point along the Hilbert curve filling a 2^order x 2^order square
+//! \param x coordinate in [0, 2^order)
+//! \param y coordinate in [0, 2^order)
+//! \param order number of bits per coordinate
+//! \returns distance of the point along the curve (points close on the curve are close in space)
+std::uint64_t hilbertIndex(std::uint32_t x, std::uint32_t y, int order)
+{
+    const std::uint32_t n = 1u << order;
+    std::uint64_t d = 0;
+    for (std::uint32_t s = n / 2; s > 0; s /= 2)
+    {
+        const std::uint32_t rx = (x & s) > 0;
+        const std::uint32_t ry = (y & s) > 0;
+        d += static_cast<std::uint64_t>(s) * s * ((3 * rx) ^ ry);
+        //! rotate the quadrant so that the curve inside it has the canonical orientation
+        if (ry == 0)
+        {
+            if (rx == 1)
+            {
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
 } // namespace cdt
\ No newline at end of file
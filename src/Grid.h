@@ -1,5 +1,6 @@
 #pragma once
 #include <stdexcept>
+#include <cstdint>
 #include "Vector2.h"
 
 namespace cdt
@@ -34,4 +35,6 @@ namespace cdt
     size_t getNCells() const;
   };
 
+  [[nodiscard]] std::uint64_t hilbertIndex(std::uint32_t x, std::uint32_t y, int order);
+
 } // namespace cdt;
\ No newline at end of file
@@ -98,27 +98,8 @@ void drawLine(sf::RenderWindow &window, sf::Vector2f p1, sf::Vector2f p2, sf::Co
         auto mouse_pos = cdt::Vector2f{mouse_pos_sf.x, mouse_pos_sf.y};
         if (sf::Mouse::isButtonPressed(sf::Mouse::Button::Right) && sf::Keyboard::isKeyPressed(sf::Keyboard::LControl))
         {
-            m_cdt.reset();
             m_map.changeTiles(MapGridDiagonal::Tile::Wall, mouse_pos, {2, 2});
-            m_map.extractBoundaries();
-            m_map.transformCorners();
-            auto edges = m_map.extractEdges();
-            std::vector<cdt::EdgeVInd> edge_inds;
-            for (auto &e : edges)
-            {
-                cdt::EdgeVInd e_ind;
-                auto v_ind1 = m_cdt.insertVertexAndGetData(e.from).overlapping_vertex;
-                e_ind.from = (v_ind1 == -1 ? m_cdt.m_vertices.size() - 1 : v_ind1);
-
-                auto v_ind2 = m_cdt.insertVertexAndGetData(e.to()).overlapping_vertex;
-                e_ind.to = (v_ind2 == -1 ? m_cdt.m_vertices.size() - 1 : v_ind2);
-
-                edge_inds.push_back(e_ind);
-            }
-            for (auto &e : edge_inds)
-            {
-                m_cdt.insertConstraint(e);
-            }
+            m_map.updateTriangulation(m_cdt);
 
             m_pf.update();
         }
@@ -154,10 +135,10 @@ void drawLine(sf::RenderWindow &window, sf::Vector2f p1, sf::Vector2f p2, sf::Co
         int tri_ind = 0;
         for (auto &tri : m_cdt.m_triangles)
         {
-            sf::Vector2f v1(tri.verts[0].x, tri.verts[0].y);
-            sf::Vector2f v2(tri.verts[1].x, tri.verts[1].y);
-            sf::Vector2f v3(tri.verts[2].x, tri.verts[2].y);
-            // if (!tri.is_constrained[0])
+            sf::Vector2f v1(m_cdt.vertexOf(tri, 0).x, m_cdt.vertexOf(tri, 0).y);
+            sf::Vector2f v2(m_cdt.vertexOf(tri, 1).x, m_cdt.vertexOf(tri, 1).y);
+            sf::Vector2f v3(m_cdt.vertexOf(tri, 2).x, m_cdt.vertexOf(tri, 2).y);
+            // if (!tri.isConstrained(0))
             {
                 sf::Color color = {0, 255, 0, 255};
                 int r = 255 * m_pf.triangle2tri_widths_[tri_ind].widths[0] / 2.f;
@@ -168,7 +149,7 @@ void drawLine(sf::RenderWindow &window, sf::Vector2f p1, sf::Vector2f p2, sf::Co
                 };
                 drawLine(m_window, v1, v2, color);
             }
-            // if (!tri.is_constrained[1])
+            // if (!tri.isConstrained(1))
             {
                 sf::Color color = {0, 255, 0, 255};
                 int r = 255 * m_pf.triangle2tri_widths_[tri_ind].widths[1] / 2.f;
@@ -179,7 +160,7 @@ void drawLine(sf::RenderWindow &window, sf::Vector2f p1, sf::Vector2f p2, sf::Co
                 };
                 drawLine(m_window, v2, v3, color);
             }
-            // if (!tri.is_constrained[2])
+            // if (!tri.isConstrained(2))
             {
                 sf::Color color = {0, 255, 0, 255};
                 int r = 255 * m_pf.triangle2tri_widths_[tri_ind].widths[1] / 2.f;
@@ -201,9 +182,8 @@ void drawLine(sf::RenderWindow &window, sf::Vector2f p1, sf::Vector2f p2, sf::Co
         num.setFillColor(sf::Color::Blue);
         for (int ind = 0; ind < m_cdt.m_triangles.size(); ++ind)
         {
-            auto &tri = m_cdt.m_triangles.at(ind);
             num.setString(std::to_string(ind));
-            auto center = asFloat(tri.verts[0] + tri.verts[1] + tri.verts[2]) / 3.f;
+            auto center = m_cdt.getCenter(ind);
             num.setPosition(center.x, center.y); // - sf::Vector2f(num.getGlobalBounds().width, num.getLocalBounds().height)
             num.setScale(0.03f, 0.03f);
             m_window.draw(num);
@@ -214,18 +194,18 @@ void drawLine(sf::RenderWindow &window, sf::Vector2f p1, sf::Vector2f p2, sf::Co
     {
         for (auto &tri : m_cdt.m_triangles)
         {
-            sf::Vector2f v1(tri.verts[0].x, tri.verts[0].y);
-            sf::Vector2f v2(tri.verts[1].x, tri.verts[1].y);
-            sf::Vector2f v3(tri.verts[2].x, tri.verts[2].y);
-            if (tri.is_constrained[0])
+            sf::Vector2f v1(m_cdt.vertexOf(tri, 0).x, m_cdt.vertexOf(tri, 0).y);
+            sf::Vector2f v2(m_cdt.vertexOf(tri, 1).x, m_cdt.vertexOf(tri, 1).y);
+            sf::Vector2f v3(m_cdt.vertexOf(tri, 2).x, m_cdt.vertexOf(tri, 2).y);
+            if (tri.isConstrained(0))
             {
                 drawLine(m_window, v1, v2, sf::Color::Red);
             }
-            if (tri.is_constrained[1])
+            if (tri.isConstrained(1))
             {
                 drawLine(m_window, v2, v3, sf::Color::Red);
             }
-            if (tri.is_constrained[2])
+            if (tri.isConstrained(2))
             {
                 drawLine(m_window, v3, v1, sf::Color::Red);
             }
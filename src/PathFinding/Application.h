@@ -106,7 +106,7 @@ private:
 
     PathFinder::PathData m_path;
 
-    cdt::Triangulation<Triangle> m_cdt;
+    cdt::Triangulation<cdt::Vector2i> m_cdt;
     PathFinder m_pf;
     MapGridDiagonal m_map;
 };
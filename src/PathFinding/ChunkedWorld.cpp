@@ -0,0 +1,611 @@
+#include "ChunkedWorld.h"
+#include "../Snapshot.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <queue>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+
+namespace
+{
+    //! \brief direction towards the neighbouring chunk for each side, opposite sides differ in the lowest bit
+    const std::array<cdt::Vector2i, 4> side_directions = {{{-1, 0}, {1, 0}, {0, -1}, {0, 1}}};
+
+    int oppositeSide(int side)
+    {
+        return side ^ 1;
+    }
+
+    int floorDiv(int a, int b)
+    {
+        return a >= 0 ? a / b : -((-a + b - 1) / b);
+    }
+} // namespace
+
+//! \param chunk_size size of a single chunk in world coordinates
+//! \param n_chunks number of chunks along each axis, the world spans [0, chunk_size * n_chunks]
+//! \param edge_source provides the walls of the chunks being built
+ChunkedWorld::ChunkedWorld(Vertex chunk_size, Vertex n_chunks, EdgeSource edge_source)
+    : m_chunk_size(chunk_size), m_n_chunks(n_chunks), m_edge_source(std::move(edge_source))
+{
+}
+
+//! \brief evicts the least recently used chunks right away if more than \p max_loaded_chunks are loaded
+void ChunkedWorld::setMaxLoadedChunks(std::size_t max_loaded_chunks)
+{
+    m_max_loaded_chunks = std::max<std::size_t>(max_loaded_chunks, 1);
+    trimToBudget();
+}
+
+//! \brief evicted chunks get saved as snapshots into \p cache_directory and are loaded from there instead of
+//! \brief being rebuilt, an empty path turns the cache off
+void ChunkedWorld::setCacheDirectory(std::filesystem::path cache_directory)
+{
+    m_cache_directory = std::move(cache_directory);
+    if (!m_cache_directory.empty())
+    {
+        std::filesystem::create_directories(m_cache_directory);
+    }
+}
+
+//! \returns triangulation of the chunk at \p chunk_coords, loading it if needed.
+//! \returns The reference stays valid until the chunk gets evicted
+const Triangulation<Vertex> &ChunkedWorld::chunk(Vertex chunk_coords)
+{
+    assert(contains(chunk_coords));
+    const auto &cdt = *loadedChunk(chunk_coords).cdt;
+    trimToBudget();
+    return cdt;
+}
+
+bool ChunkedWorld::isLoaded(Vertex chunk_coords) const
+{
+    return m_chunks.contains(keyOf(chunk_coords));
+}
+
+//! \brief unloads the chunk at \p chunk_coords, saving it into the cache directory if there is one
+void ChunkedWorld::evict(Vertex chunk_coords)
+{
+    const auto it = m_chunks.find(keyOf(chunk_coords));
+    if (it == m_chunks.end())
+    {
+        return;
+    }
+    auto &chunk = it->second;
+    if (!m_cache_directory.empty() && !chunk.is_cached)
+    {
+        chunk.path_finder->saveSnapshot(cacheFile(chunk_coords).string());
+    }
+    m_chunks.erase(it);
+}
+
+//! \brief rebuilds the loaded chunks touching the box [\p lower_left, \p upper_right] (in world coordinates) and
+//! \brief drops cached snapshots and summaries of the others, so they get rebuilt when needed next time. Chunks
+//! \brief whose border lies on the box border are rebuilt too, as they share walls lying on the border
+void ChunkedWorld::invalidate(Vertex lower_left, Vertex upper_right)
+{
+    const int first_x = std::max(0, floorDiv(lower_left.x - 1, m_chunk_size.x));
+    const int first_y = std::max(0, floorDiv(lower_left.y - 1, m_chunk_size.y));
+    const int last_x = std::min(m_n_chunks.x - 1, floorDiv(upper_right.x, m_chunk_size.x));
+    const int last_y = std::min(m_n_chunks.y - 1, floorDiv(upper_right.y, m_chunk_size.y));
+    for (int iy = first_y; iy <= last_y; ++iy)
+    {
+        for (int ix = first_x; ix <= last_x; ++ix)
+        {
+            const Vertex chunk_coords = {ix, iy};
+            if (!m_cache_directory.empty())
+            {
+                std::filesystem::remove(cacheFile(chunk_coords));
+            }
+            const auto it = m_chunks.find(keyOf(chunk_coords));
+            if (it != m_chunks.end())
+            {
+                build(it->second, chunk_coords);
+                findRegions(it->second, m_summaries[keyOf(chunk_coords)]);
+            }
+            else
+            {
+                m_summaries.erase(keyOf(chunk_coords));
+            }
+        }
+    }
+}
+
+//! \returns chunk and triangle containing \p r (in world coordinates), the chunk gets loaded if needed
+ChunkedWorld::Location ChunkedWorld::locate(cdt::Vector2f r)
+{
+    const auto chunk_coords = chunkOf(r);
+    if (r.x < 0 || r.y < 0 || r.x > m_chunk_size.x * m_n_chunks.x || r.y > m_chunk_size.y * m_n_chunks.y)
+    {
+        return {chunk_coords, -1u};
+    }
+    auto &chunk = loadedChunk(chunk_coords);
+    const auto tri_ind = chunk.cdt->findTriangle(r - asFloat(chunkOrigin(chunk_coords)), false);
+    trimToBudget();
+    return {chunk_coords, tri_ind};
+}
+
+//! \brief finds path between points given in world coordinates, possibly going through several chunks
+//! \brief the route is searched on points where the path crosses seams between chunk regions (parts of chunks
+//! \brief separated by walls) using only the chunk summaries, then each of its parts is found by the path finder of
+//! \brief the chunk it lies in. Chunks are loaded one at a time, so at most one more than the budget is loaded.
+//! \brief Regions do not depend on \p radius, so a part may turn out to be too narrow. It is then left out and
+//! \brief the route is searched again
+//! \param radius crossings of seams narrower than 2 * radius are not used
+//! \returns points of the path in world coordinates, empty if no path was found
+std::vector<cdt::Vector2f> ChunkedWorld::findPath(cdt::Vector2f r_start, cdt::Vector2f r_end, float radius)
+{
+    const auto start = locate(r_start);
+    if (start.tri_ind == -1)
+    {
+        return {};
+    }
+    const RouteNode start_node = {r_start, start.chunk, loadedChunk(start.chunk).tri2region[start.tri_ind],
+                                  {keyOf(start.chunk), -1, 0}};
+    const auto end = locate(r_end);
+    if (end.tri_ind == -1)
+    {
+        return {};
+    }
+    const RouteNode end_node = {r_end, end.chunk, loadedChunk(end.chunk).tri2region[end.tri_ind],
+                                {keyOf(end.chunk), -1, 1}};
+
+    std::set<Leg> blocked_legs;
+    std::vector<cdt::Vector2f> path;
+    while (path.empty())
+    {
+        const auto route = findRoute(start_node, end_node, radius, blocked_legs);
+        if (route.empty())
+        {
+            break;
+        }
+
+        path.push_back(r_start);
+        for (std::size_t i = 0; i + 1 < route.size(); ++i)
+        {
+            const auto &from = route[i];
+            const auto &to = route[i + 1];
+            const auto origin = asFloat(chunkOrigin(from.chunk));
+            auto &path_finder = *loadedChunk(from.chunk).path_finder;
+            const auto part = path_finder.doPathFinding(from.r - origin, to.r - origin, radius);
+            trimToBudget();
+            if (!part.found)
+            { //! each search leaves out one more leg, so this ends once no route is left
+                blocked_legs.insert({from.key, to.key});
+                path.clear();
+                break;
+            }
+            for (const auto &r : part.path)
+            {
+                if (!vequal(r + origin, path.back()))
+                {
+                    path.push_back(r + origin);
+                }
+            }
+        }
+    }
+    trimToBudget();
+    return path;
+}
+
+//! \brief A* over seam crossings from \p start to \p end, a crossing is entered at its point closest to the end
+//! \param blocked_legs pairs of consecutive nodes which the route must not contain
+//! \returns nodes of the route from \p start to \p end, empty if there is none
+std::vector<ChunkedWorld::RouteNode> ChunkedWorld::findRoute(const RouteNode &start, const RouteNode &end, float radius,
+                                                             const std::set<Leg> &blocked_legs)
+{
+    const Vertex search_min = {std::max(0, std::min(start.chunk.x, end.chunk.x) - m_search_margin),
+                               std::max(0, std::min(start.chunk.y, end.chunk.y) - m_search_margin)};
+    const Vertex search_max = {std::min(m_n_chunks.x - 1, std::max(start.chunk.x, end.chunk.x) + m_search_margin),
+                               std::min(m_n_chunks.y - 1, std::max(start.chunk.y, end.chunk.y) + m_search_margin)};
+    const auto r_end = end.r;
+
+    //! \struct the first node is the start, the second one the end
+    struct Node
+    {
+        RouteNode crossing;
+        float g_value = MAXFLOAT;
+        int prev = -1;
+    };
+    std::vector<Node> nodes = {{start, 0.f}, {end}};
+    std::map<CrossingKey, int> crossing2node;
+
+    using QueueEntry = std::pair<float, int>; //! f_value and node
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<>> to_visit;
+    to_visit.push({dist(start.r, r_end), 0});
+    while (!to_visit.empty())
+    {
+        const auto [f_value, node_ind] = to_visit.top();
+        to_visit.pop();
+        const auto current = nodes[node_ind];
+        if (node_ind == 1)
+        {
+            break;
+        }
+        const auto &current_r = current.crossing.r;
+        if (f_value > current.g_value + dist(current_r, r_end))
+        { //! the node was reached by a shorter path since this entry got queued
+            continue;
+        }
+        if (current.crossing.chunk == end.chunk && current.crossing.region == end.region &&
+            current.g_value + dist(current_r, r_end) < nodes[1].g_value &&
+            !blocked_legs.contains({current.crossing.key, end.key}))
+        {
+            nodes[1].g_value = current.g_value + dist(current_r, r_end);
+            nodes[1].prev = node_ind;
+            to_visit.push({nodes[1].g_value, 1});
+        }
+
+        const auto &sides = summary(current.crossing.chunk).sides;
+        for (int side = 0; side < 4; ++side)
+        {
+            const Vertex neighbour_coords = current.crossing.chunk + side_directions[side];
+            if (neighbour_coords.x < search_min.x || neighbour_coords.y < search_min.y ||
+                neighbour_coords.x > search_max.x || neighbour_coords.y > search_max.y)
+            {
+                continue;
+            }
+            const auto &neighbour_intervals = summary(neighbour_coords).sides[oppositeSide(side)];
+            const auto origin = asFloat(chunkOrigin(current.crossing.chunk));
+            const auto end_coord = side == Left || side == Right ? r_end.y - origin.y : r_end.x - origin.x;
+
+            for (const auto &interval : sides[side])
+            {
+                if (interval.region != current.crossing.region)
+                {
+                    continue;
+                }
+                for (int j = 0; j < neighbour_intervals.size(); ++j)
+                {
+                    const auto &other = neighbour_intervals[j];
+                    const auto overlap_from = std::max(interval.from, other.from);
+                    const auto overlap_to = std::min(interval.to, other.to);
+                    const CrossingKey key = {keyOf(neighbour_coords), oppositeSide(side), j};
+                    if (overlap_to <= overlap_from || overlap_to - overlap_from <= 2 * radius ||
+                        blocked_legs.contains({current.crossing.key, key}))
+                    {
+                        continue;
+                    }
+                    //! crossing point closest to the end
+                    const auto coord = std::clamp(end_coord, overlap_from + radius, overlap_to - radius);
+                    const auto r = pointOnSide(current.crossing.chunk, side, coord);
+                    const auto g_value = current.g_value + dist(current_r, r);
+
+                    const auto [it, is_new] = crossing2node.try_emplace(key, nodes.size());
+                    if (is_new)
+                    {
+                        nodes.push_back({{r, neighbour_coords, other.region, key}});
+                    }
+                    auto &node = nodes[it->second];
+                    if (g_value < node.g_value)
+                    {
+                        node.crossing.r = r;
+                        node.g_value = g_value;
+                        node.prev = node_ind;
+                        to_visit.push({g_value + dist(r, r_end), it->second});
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<RouteNode> route;
+    for (int node_ind = nodes[1].prev == -1 ? -1 : 1; node_ind != -1; node_ind = nodes[node_ind].prev)
+    {
+        route.push_back(nodes[node_ind].crossing);
+    }
+    std::reverse(route.begin(), route.end());
+    return route;
+}
+
+//! \returns coordinates of the chunk containing \p r, points outside of the world give the closest chunk
+Vertex ChunkedWorld::chunkOf(cdt::Vector2f r) const
+{
+    return {std::clamp(static_cast<int>(std::floor(r.x / m_chunk_size.x)), 0, m_n_chunks.x - 1),
+            std::clamp(static_cast<int>(std::floor(r.y / m_chunk_size.y)), 0, m_n_chunks.y - 1)};
+}
+
+//! \returns world coordinates of the lower left corner of the chunk at \p chunk_coords
+Vertex ChunkedWorld::chunkOrigin(Vertex chunk_coords) const
+{
+    return {chunk_coords.x * m_chunk_size.x, chunk_coords.y * m_chunk_size.y};
+}
+
+//! \returns loaded chunk at \p chunk_coords, it gets loaded from the cache or built if needed
+//! \note does not evict anything, so references to other loaded chunks stay valid
+ChunkedWorld::Chunk &ChunkedWorld::loadedChunk(Vertex chunk_coords)
+{
+    const auto [it, is_new] = m_chunks.try_emplace(keyOf(chunk_coords));
+    auto &chunk = it->second;
+    if (is_new)
+    {
+        chunk.coords = chunk_coords;
+        if (!loadFromCache(chunk, chunk_coords))
+        {
+            build(chunk, chunk_coords);
+        }
+        findRegions(chunk, m_summaries[keyOf(chunk_coords)]);
+    }
+    chunk.last_used = ++m_use_counter;
+    return chunk;
+}
+
+//! \returns summary of the chunk at \p chunk_coords. Chunks without one get loaded and may be evicted again right
+//! \returns away, so references to loaded chunks do not survive this, references to summaries do
+const ChunkedWorld::ChunkSummary &ChunkedWorld::summary(Vertex chunk_coords)
+{
+    const auto it = m_summaries.find(keyOf(chunk_coords));
+    if (it != m_summaries.end())
+    {
+        return it->second;
+    }
+    loadedChunk(chunk_coords);
+    trimToBudget();
+    return m_summaries.at(keyOf(chunk_coords));
+}
+
+//! \brief triangulates walls of the chunk at \p chunk_coords taken from the edge source
+void ChunkedWorld::build(Chunk &chunk, Vertex chunk_coords)
+{
+    const auto origin = chunkOrigin(chunk_coords);
+    const auto edges = clipToChunk(m_edge_source(origin, origin + m_chunk_size), chunk_coords);
+
+    chunk.cdt = std::make_unique<Triangulation<Vertex>>(m_chunk_size);
+    chunk.cdt->insertConstraints(edges);
+    chunk.path_finder = std::make_unique<PathFinder>(*chunk.cdt);
+    chunk.path_finder->update();
+    chunk.is_cached = false;
+}
+
+//! \returns true if the chunk at \p chunk_coords was loaded from its snapshot in the cache directory
+bool ChunkedWorld::loadFromCache(Chunk &chunk, Vertex chunk_coords) const
+{
+    if (m_cache_directory.empty() || !std::filesystem::exists(cacheFile(chunk_coords)))
+    {
+        return false;
+    }
+    try
+    {
+        const cdt::SnapshotFile snapshot(cacheFile(chunk_coords).string());
+        chunk.cdt = std::make_unique<Triangulation<Vertex>>();
+        chunk.cdt->loadSnapshot(snapshot);
+        chunk.path_finder = std::make_unique<PathFinder>(*chunk.cdt);
+        chunk.path_finder->update(snapshot);
+    }
+    catch (const std::runtime_error &)
+    { //! the file is broken or comes from an incompatible build, the chunk gets rebuilt instead
+        return false;
+    }
+    chunk.is_cached = true;
+    return true;
+}
+
+//! \brief splits triangles of \p chunk into regions bounded by walls and finds which region lies along
+//! \brief each part of the chunk border, those parts are written into \p summary
+void ChunkedWorld::findRegions(Chunk &chunk, ChunkSummary &summary) const
+{
+    const auto &cdt = *chunk.cdt;
+    const auto &triangles = cdt.m_triangles;
+    chunk.tri2region.assign(triangles.size(), -1);
+
+    int n_regions = 0;
+    std::vector<TriInd> to_visit;
+    for (TriInd seed = 0; seed < triangles.size(); ++seed)
+    {
+        if (chunk.tri2region[seed] != -1)
+        {
+            continue;
+        }
+        chunk.tri2region[seed] = n_regions;
+        to_visit.push_back(seed);
+        while (!to_visit.empty())
+        {
+            const auto &tri = triangles[to_visit.back()];
+            to_visit.pop_back();
+            for (int k = 0; k < 3; ++k)
+            {
+                const auto neighbour = tri.neighbours[k];
+                if (neighbour != -1 && !tri.isConstrained(k) && chunk.tri2region[neighbour] == -1)
+                {
+                    chunk.tri2region[neighbour] = n_regions;
+                    to_visit.push_back(neighbour);
+                }
+            }
+        }
+        n_regions++;
+    }
+
+    for (auto &intervals : summary.sides)
+    {
+        intervals.clear();
+    }
+    std::array<std::vector<int>, 4> wall_ends; //! coordinates along each side where a wall meets the border
+    const auto addWallEnd = [&](Vertex v)
+    {
+        if (v.x == 0 || v.x == m_chunk_size.x)
+        {
+            wall_ends[v.x == 0 ? Left : Right].push_back(v.y);
+        }
+        if (v.y == 0 || v.y == m_chunk_size.y)
+        {
+            wall_ends[v.y == 0 ? Bottom : Top].push_back(v.x);
+        }
+    };
+    for (TriInd tri_ind = 0; tri_ind < triangles.size(); ++tri_ind)
+    {
+        const auto &tri = triangles[tri_ind];
+        for (int k = 0; k < 3; ++k)
+        {
+            if (tri.neighbours[k] != -1)
+            {
+                if (tri.isConstrained(k))
+                {
+                    addWallEnd(cdt.vertexOf(tri, k));
+                    addWallEnd(cdt.vertexOf(tri, next(k)));
+                }
+                continue;
+            }
+            const auto &v0 = cdt.vertexOf(tri, k);
+            const auto &v1 = cdt.vertexOf(tri, next(k));
+            const auto region = chunk.tri2region[tri_ind];
+            if (v0.x == v1.x)
+            {
+                const auto side = v0.x == 0 ? Left : Right;
+                summary.sides[side].push_back({std::min(v0.y, v1.y), std::max(v0.y, v1.y), region});
+            }
+            else
+            {
+                const auto side = v0.y == 0 ? Bottom : Top;
+                summary.sides[side].push_back({std::min(v0.x, v1.x), std::max(v0.x, v1.x), region});
+            }
+        }
+    }
+    for (int side = 0; side < 4; ++side)
+    {
+        auto &intervals = summary.sides[side];
+        std::sort(intervals.begin(), intervals.end(), [](const auto &a, const auto &b)
+                  { return a.from < b.from; });
+        std::sort(wall_ends[side].begin(), wall_ends[side].end());
+        std::vector<BorderInterval> merged;
+        for (const auto &interval : intervals)
+        {
+            //! a wall meeting the border splits it even inside one region, the parts on its two sides
+            //! may be connected only through a gap too narrow for some agents
+            if (!merged.empty() && merged.back().to == interval.from && merged.back().region == interval.region &&
+                !std::binary_search(wall_ends[side].begin(), wall_ends[side].end(), interval.from))
+            {
+                merged.back().to = interval.to;
+            }
+            else
+            {
+                merged.push_back(interval);
+            }
+        }
+        intervals = std::move(merged);
+    }
+}
+
+//! \brief cuts \p edges (in world coordinates) to the box of the chunk at \p chunk_coords
+//! \brief a cut point is computed from the original edge and the border line only, so the chunks on both
+//! \brief sides of a seam cut a wall at the same point. Cut points are rounded to the integer grid
+//! \returns the cut edges in coordinates of the chunk
+std::vector<EdgeI<Vertex>> ChunkedWorld::clipToChunk(std::span<const EdgeI<Vertex>> edges, Vertex chunk_coords) const
+{
+    const auto lower_left = chunkOrigin(chunk_coords);
+    const auto upper_right = lower_left + m_chunk_size;
+
+    std::vector<EdgeI<Vertex>> clipped;
+    clipped.reserve(edges.size());
+    for (const auto &e : edges)
+    {
+        const auto from = e.from;
+        const auto to = e.to();
+        const double dx = e.t.x;
+        const double dy = e.t.y;
+
+        //! Liang-Barsky: the edge stays inside of the line of side k for parameters t with p[k] * t <= q[k]
+        const double p[4] = {-dx, dx, -dy, dy};
+        const double q[4] = {static_cast<double>(from.x - lower_left.x), static_cast<double>(upper_right.x - from.x),
+                             static_cast<double>(from.y - lower_left.y), static_cast<double>(upper_right.y - from.y)};
+        double t_from = 0.;
+        double t_to = 1.;
+        int from_side = -1;
+        int to_side = -1;
+        bool is_outside = false;
+        for (int side = 0; side < 4; ++side)
+        {
+            if (p[side] == 0.)
+            {
+                is_outside |= q[side] < 0.;
+                continue;
+            }
+            const auto t = q[side] / p[side];
+            if (p[side] < 0. && t > t_from)
+            {
+                t_from = t;
+                from_side = side;
+            }
+            else if (p[side] > 0. && t < t_to)
+            {
+                t_to = t;
+                to_side = side;
+            }
+        }
+        if (is_outside || t_from >= t_to)
+        {
+            continue;
+        }
+
+        const auto cut = [&](int side, Vertex endpoint) -> Vertex
+        {
+            if (side == Left || side == Right)
+            {
+                const int x = side == Left ? lower_left.x : upper_right.x;
+                return {x, from.y + static_cast<int>(std::lround((x - from.x) * dy / dx))};
+            }
+            if (side == Bottom || side == Top)
+            {
+                const int y = side == Bottom ? lower_left.y : upper_right.y;
+                return {from.x + static_cast<int>(std::lround((y - from.y) * dx / dy)), y};
+            }
+            return endpoint;
+        };
+        const auto clipped_from = cut(from_side, from) - lower_left;
+        const auto clipped_to = cut(to_side, to) - lower_left;
+        if (!(clipped_from == clipped_to))
+        {
+            clipped.push_back({clipped_from, clipped_to});
+        }
+    }
+    return clipped;
+}
+
+//! \brief evicts the least recently used chunks until at most m_max_loaded_chunks are loaded
+void ChunkedWorld::trimToBudget()
+{
+    while (m_chunks.size() > m_max_loaded_chunks)
+    {
+        const auto lru = std::min_element(m_chunks.begin(), m_chunks.end(), [](const auto &a, const auto &b)
+                                          { return a.second.last_used < b.second.last_used; });
+        evict(lru->second.coords);
+    }
+}
+
+bool ChunkedWorld::contains(Vertex chunk_coords) const
+{
+    return chunk_coords.x >= 0 && chunk_coords.y >= 0 && chunk_coords.x < m_n_chunks.x &&
+           chunk_coords.y < m_n_chunks.y;
+}
+
+std::uint64_t ChunkedWorld::keyOf(Vertex chunk_coords) const
+{
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(chunk_coords.x)) << 32) |
+           static_cast<std::uint32_t>(chunk_coords.y);
+}
+
+std::filesystem::path ChunkedWorld::cacheFile(Vertex chunk_coords) const
+{
+    return m_cache_directory / ("chunk_" + std::to_string(chunk_coords.x) + "_" + std::to_string(chunk_coords.y) + ".cdt");
+}
+
+//! \returns point in world coordinates lying on \p side of the chunk at \p chunk_coords
+//! \param coord coordinate along the side relative to the chunk origin
+cdt::Vector2f ChunkedWorld::pointOnSide(Vertex chunk_coords, int side, float coord) const
+{
+    const auto origin = asFloat(chunkOrigin(chunk_coords));
+    switch (side)
+    {
+    case Left:
+        return {origin.x, origin.y + coord};
+    case Right:
+        return {origin.x + m_chunk_size.x, origin.y + coord};
+    case Bottom:
+        return {origin.x + coord, origin.y};
+    default:
+        return {origin.x + coord, origin.y + m_chunk_size.y};
+    }
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <array>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <set>
+#include <span>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "PathFinder.h"
+
+//! \class world split into a grid of equally sized chunks, each with its own triangulation and path finder
+//! \brief border of every chunk is the constrained boundary of its triangulation. Walls crossing a border are cut
+//! \brief at the same point in both chunks, so the two boundaries form a shared seam which paths cross.
+//! \brief Chunks are built on first use, at most max_loaded_chunks of them stay loaded, the least recently used
+//! \brief ones get evicted (into snapshot files when a cache directory is set) and edits rebuild only the chunks
+//! \brief they touch. Routes are searched on small summaries of the chunks, which stay in memory after eviction
+class ChunkedWorld
+{
+public:
+    //! \brief returns the walls (in world coordinates) lying at least partly in the box [lower_left, upper_right]
+    using EdgeSource = std::function<std::vector<EdgeI<Vertex>>(Vertex lower_left, Vertex upper_right)>;
+
+    //! \struct triangle containing a point of the world
+    struct Location
+    {
+        Vertex chunk;        //! coordinates of the chunk (in chunks)
+        TriInd tri_ind = -1; //! triangle in the triangulation of the chunk, -1 if the point lies outside of the world
+    };
+
+public:
+    ChunkedWorld(Vertex chunk_size, Vertex n_chunks, EdgeSource edge_source);
+
+    void setMaxLoadedChunks(std::size_t max_loaded_chunks);
+    void setCacheDirectory(std::filesystem::path cache_directory);
+    //! \brief chunks this far (in chunks) from the box around start and end of a path may be crossed by the path
+    void setSearchMargin(int search_margin) { m_search_margin = search_margin; }
+
+    const Triangulation<Vertex> &chunk(Vertex chunk_coords);
+    bool isLoaded(Vertex chunk_coords) const;
+    std::size_t nLoadedChunks() const { return m_chunks.size(); }
+    void evict(Vertex chunk_coords);
+    void invalidate(Vertex lower_left, Vertex upper_right);
+
+    Location locate(cdt::Vector2f r);
+    std::vector<cdt::Vector2f> findPath(cdt::Vector2f r_start, cdt::Vector2f r_end, float radius);
+
+    Vertex chunkOf(cdt::Vector2f r) const;
+    Vertex chunkOrigin(Vertex chunk_coords) const;
+
+private:
+    enum Side
+    {
+        Left,
+        Right,
+        Bottom,
+        Top,
+    };
+
+    //! \struct part of a chunk border along which the same region of the chunk lies
+    struct BorderInterval
+    {
+        int from; //! coordinate along the side, relative to the chunk origin
+        int to;
+        int region;
+    };
+
+    //! \struct what the route search needs to know about a chunk. It is small and outlives eviction, so searching
+    //! \brief a route does not keep the chunks it passes loaded
+    struct ChunkSummary
+    {
+        std::array<std::vector<BorderInterval>, 4> sides; //! sorted intervals of each Side, split at walls
+    };
+
+    struct Chunk
+    {
+        std::unique_ptr<Triangulation<Vertex>> cdt;
+        std::unique_ptr<PathFinder> path_finder;
+        std::vector<int> tri2region; //! triangles in the same region are connected without crossing a wall
+        Vertex coords;
+        std::size_t last_used = 0;
+        bool is_cached = false; //! the cache file holds the chunk as it is
+    };
+
+    //! \struct entered chunk, its side and the index of the interval on that side, start and end have side -1
+    using CrossingKey = std::tuple<std::uint64_t, int, int>;
+    using Leg = std::pair<CrossingKey, CrossingKey>;
+
+    //! \struct point where a route enters a region of a chunk
+    struct RouteNode
+    {
+        cdt::Vector2f r;
+        Vertex chunk;
+        int region;
+        CrossingKey key;
+    };
+
+    std::vector<RouteNode> findRoute(const RouteNode &start, const RouteNode &end, float radius,
+                                     const std::set<Leg> &blocked_legs);
+    Chunk &loadedChunk(Vertex chunk_coords);
+    const ChunkSummary &summary(Vertex chunk_coords);
+    void build(Chunk &chunk, Vertex chunk_coords);
+    bool loadFromCache(Chunk &chunk, Vertex chunk_coords) const;
+    void findRegions(Chunk &chunk, ChunkSummary &summary) const;
+    std::vector<EdgeI<Vertex>> clipToChunk(std::span<const EdgeI<Vertex>> edges, Vertex chunk_coords) const;
+    void trimToBudget();
+
+    bool contains(Vertex chunk_coords) const;
+    std::uint64_t keyOf(Vertex chunk_coords) const;
+    std::filesystem::path cacheFile(Vertex chunk_coords) const;
+    cdt::Vector2f pointOnSide(Vertex chunk_coords, int side, float coord) const;
+
+private:
+    Vertex m_chunk_size;
+    Vertex m_n_chunks;
+    EdgeSource m_edge_source;
+
+    std::unordered_map<std::uint64_t, Chunk> m_chunks; //! loaded chunks, references stay valid until eviction
+    std::unordered_map<std::uint64_t, ChunkSummary> m_summaries; //! of every chunk loaded since its last invalidation
+    std::size_t m_max_loaded_chunks = -1;
+    std::size_t m_use_counter = 0;
+    std::filesystem::path m_cache_directory; //! evicted chunks are saved here when not empty
+    int m_search_margin = 2;
+};
@@ -1,4 +1,5 @@
 #include "PathFinder.h"
+#include "../Snapshot.h"
 
 #include <future>
 #include <thread>
@@ -6,10 +7,9 @@
 #include <fstream>
 #include <iostream>
 
-PathFinder::PathFinder(Triangulation<cdt::Vector2i> &cdt)
+PathFinder::PathFinder(const Triangulation<cdt::Vector2i> &cdt)
     : m_cdt(cdt)
 {
-    // m_rtg = std::make_unique<ReducedTriangulationGraph>();
 }
 
 //! \brief creates everything from p_triangulation_
@@ -22,12 +22,117 @@ void PathFinder::update()
     triangle2tri_widths_.resize(n_triangles);
     for (int tri_ind = 0; tri_ind < n_triangles; ++tri_ind)
     {
-        triangle2tri_widths_[tri_ind] = TriangleWidth(m_cdt.m_triangles[tri_ind]);
+        triangle2tri_widths_[tri_ind] = TriangleWidth(m_cdt.m_triangles[tri_ind], m_cdt.m_vertices);
     }
-    m_g_values.resize(n_triangles);
-    m_back_pointers.resize(n_triangles);
+    buildNavGraph();
+}
+
+//! \brief like update() but takes triangle widths from \p snapshot, which the triangulation was loaded from
+//! \brief the widths are computed if the snapshot does not hold them
+void PathFinder::update(const SnapshotFile &snapshot)
+{
+    const auto widths = snapshot.array<float>(SnapshotSection::TriangleWidths);
+    const auto n_triangles = m_cdt.m_triangles.size();
+    if (widths.size() != 3 * n_triangles)
+    {
+        update();
+        return;
+    }
+
+    triangle2tri_widths_.resize(n_triangles);
+    for (std::size_t tri_ind = 0; tri_ind < n_triangles; ++tri_ind)
+    {
+        std::copy_n(widths.data() + 3 * tri_ind, 3, triangle2tri_widths_[tri_ind].widths);
+    }
+    buildNavGraph();
+}
+
+//! \brief copies centers, neighbours, widths and walls of all triangles into m_nav_graph and rebuilds m_rtg
+void PathFinder::buildNavGraph()
+{
+    const auto &triangles = m_cdt.m_triangles;
+    m_nav_graph.resize(triangles.size());
+    for (std::size_t tri_ind = 0; tri_ind < triangles.size(); ++tri_ind)
+    {
+        auto &node = m_nav_graph[tri_ind];
+        node.center = m_cdt.getCenter(triangles[tri_ind]);
+    }
+    for (std::size_t tri_ind = 0; tri_ind < triangles.size(); ++tri_ind)
+    {
+        const auto &tri = triangles[tri_ind];
+        auto &node = m_nav_graph[tri_ind];
+        node.wall_mask = 0;
+        for (int k = 0; k < 3; ++k)
+        {
+            const auto neighbour = tri.neighbours[k];
+            node.neighbours[k] = neighbour;
+            node.widths[k] = triangle2tri_widths_[tri_ind].widths[k];
+            if (tri.isConstrained(k) || neighbour == -1)
+            {
+                node.wall_mask |= 1u << k;
+                node.costs[k] = MAXFLOAT;
+                continue;
+            }
+            node.costs[k] = dist(node.center, m_nav_graph[neighbour].center);
+        }
+    }
+
+    std::span<const float> widths;
+    if (!triangle2tri_widths_.empty())
+    {
+        widths = {triangle2tri_widths_[0].widths, 3 * triangle2tri_widths_.size()};
+    }
+    m_rtg.constructFromTriangulation(m_cdt, widths, tri_ind2component_);
+}
+
+//! \brief invalidates g values and back pointers of the previous search in O(1) by moving to the next stamp
+//! \param n_triangles number of triangles the search may reach
+void PathFinder::SearchContext::startSearch(std::size_t n_triangles)
+{
+    if (m_search_stamps.size() < n_triangles)
+    {
+        m_g_values.resize(n_triangles);
+        m_back_pointers.resize(n_triangles);
+        m_search_stamps.resize(n_triangles, 0); //! new triangles hold an old stamp, so no search reached them
+    }
+    if (++m_search_stamp == 0)
+    { //! after the stamp wrapped around, old searches could look like the current one
+        std::fill(m_search_stamps.begin(), m_search_stamps.end(), 0);
+        m_search_stamp = 1;
+    }
+}
+
+//! \brief moves the per triangle data the way Triangulation::reorder moved the triangles, which is cheaper than
+//! \brief update() as no width gets recomputed
+//! \param reordering returned by reorder() of the triangulation, which was up to date with this before
+void PathFinder::reorder(const Reordering &reordering)
+{
+    const auto &new_tri_inds = reordering.new_tri_inds;
+    if (triangle2tri_widths_.size() != new_tri_inds.size())
+    {
+        update();
+        return;
+    }
+    std::vector<TriangleWidth> widths(triangle2tri_widths_.size());
+    for (std::size_t tri_ind = 0; tri_ind < widths.size(); ++tri_ind)
+    {
+        widths[new_tri_inds[tri_ind]] = triangle2tri_widths_[tri_ind];
+    }
+    triangle2tri_widths_ = std::move(widths);
+    buildNavGraph();
+    m_search_context.m_locate_cursor.hint = 0;
+}
 
-    m_cdt.updateCellGrid();
+//! \brief saves the triangulation together with the triangle widths, see Triangulation::saveSnapshot
+//! \brief the widths are left out when update() was not called since the triangulation last changed size
+void PathFinder::saveSnapshot(const std::string &filename) const
+{
+    std::span<const float> widths;
+    if (!triangle2tri_widths_.empty() && triangle2tri_widths_.size() == m_cdt.m_triangles.size())
+    {
+        widths = {triangle2tri_widths_[0].widths, 3 * triangle2tri_widths_.size()};
+    }
+    m_cdt.saveSnapshot(filename, widths);
 }
 
 void dumpFunnelToFile(const Funnel &funnel, float radius, std::string filename)
@@ -53,17 +158,34 @@ void dumpPathToFile(const std::deque<cdt::Vector2f> &path, float radius, std::st
 }
 
 PathFinder::PathData PathFinder::doPathFinding(const cdt::Vector2f r_start, const cdt::Vector2f r_end, const float radius)
+{
+    return doPathFinding(r_start, r_end, radius, m_search_context);
+}
+
+//! \brief like doPathFinding(r_start, r_end, radius) but keeps the search state in \p context,
+//! \brief so several threads can find paths at once as long as each uses its own context
+PathFinder::PathData PathFinder::doPathFinding(const cdt::Vector2f r_start, const cdt::Vector2f r_end, const float radius,
+                                               SearchContext &context) const
 {
 
     Funnel funnel;
-    findSubOptimalPathCenters(r_start, r_end, radius, funnel);
+    const bool found = m_use_reduced_graph ? findReducedPathCenters(r_start, r_end, radius, funnel, context)
+                                           : findSubOptimalPathCenters(r_start, r_end, radius, funnel, context);
+    auto path = pathThroughFunnel(r_start, r_end, radius, funnel);
+    path.found = found;
+    return path;
+}
 
+//! \brief turns portals found by findSubOptimalPathCenters or findReducedPathCenters into a path
+//! \param funnel portals from end to start, gets start and end added and is stored in the returned data
+PathFinder::PathData PathFinder::pathThroughFunnel(const cdt::Vector2f r_start, const cdt::Vector2f r_end,
+                                                   const float radius, Funnel &funnel) const
+{
     funnel.push_back({r_start, r_start});
     std::reverse(funnel.begin(), funnel.end());
     funnel.push_back({r_end, r_end});
 
     return pathFromFunnel(r_start, r_end, radius, funnel);
-    ;
 }
 
 //! \brief finds sequence of triangles such that the path going through centers of the triangles is the shortest
@@ -71,97 +193,364 @@ PathFinder::PathData PathFinder::doPathFinding(const cdt::Vector2f r_start, cons
 //! \param r_end end position
 //! \param radius to block paths that are too narrow
 //! \param funnel stores data used to create real path going through the triangles
-//! \param thread_id which thread runs the job
-void PathFinder::findSubOptimalPathCenters(cdt::Vector2f r_start, cdt::Vector2f r_end, float radius, Funnel &funnel)
+//! \returns false when end cannot be reached
+bool PathFinder::findSubOptimalPathCenters(cdt::Vector2f r_start, cdt::Vector2f r_end, float radius, Funnel &funnel)
 {
+    return findSubOptimalPathCenters(r_start, r_end, radius, funnel, m_search_context);
+}
 
-    const auto &triangles = m_cdt.m_triangles;
-    const auto &vertices = m_cdt.m_vertices;
-    const auto start = m_cdt.findTriangle(r_start, false);
-    const auto end = m_cdt.findTriangle(r_end, false);
+//! \param context holds the search state, see doPathFinding
+//! \param area when given, the search only enters triangles of the area, the start triangle must lie in it
+bool PathFinder::findSubOptimalPathCenters(cdt::Vector2f r_start, cdt::Vector2f r_end, float radius, Funnel &funnel,
+                                           SearchContext &context, const SearchArea *area) const
+{
+
+    const auto start = m_cdt.findTriangle(r_start, context.m_locate_cursor);
+    const auto end = m_cdt.findTriangle(r_end, context.m_locate_cursor);
 
-    if (start == end or start == -1 or end == -1)
+    if (start == -1 or end == -1)
     {
-        return;
+        return false;
     }
-
-    std::vector<AstarDataPQ> to_visit;
-    for (int i = 0; i < triangles.size(); ++i)
+    if (start == end)
     {
-        m_g_values[i] = MAXFLOAT;
-        m_back_pointers[i] = -1;
+        return true;
     }
 
-    std::priority_queue to_visit_pque(
-        to_visit.begin(), to_visit.end(),
-        [&](const AstarDataPQ &a1, const AstarDataPQ &a2)
-        { return a1.f_value > a2.f_value; });
+    //! only triangles reached by this search get written, so its cost does not grow with the whole map
+    context.startSearch(m_nav_graph.size());
+    auto &to_visit = context.m_to_visit;
+    to_visit.clear();
+    const auto by_f_value = [](const AstarDataPQ &a1, const AstarDataPQ &a2)
+    { return a1.f_value > a2.f_value; };
 
-    m_g_values.at(start) = 0;
-    to_visit_pque.push({start, 0});
+    context.reach(start, 0.f, -1);
+    to_visit.push_back({start, 0});
 
-    while (!to_visit_pque.empty())
+    while (!to_visit.empty())
     {
-        auto current_tri_ind = to_visit_pque.top().next;
-        auto f_value = to_visit_pque.top().f_value;
-        to_visit_pque.pop();
-
-        const auto &current_tri = triangles[current_tri_ind];
-        std::vector<int> free_neighbours;
-        int prev_ind_in_tri = -1;
+        std::pop_heap(to_visit.begin(), to_visit.end(), by_f_value);
+        const auto [current_tri_ind, f_value] = to_visit.back();
+        to_visit.pop_back();
+        if (current_tri_ind == end)
+        { //! the heuristic is consistent, so end has its shortest distance once it leaves the heap
+            break;
+        }
 
-        for (const auto neighbour : current_tri.neighbours)
+        const auto &node = m_nav_graph[current_tri_ind];
+        const auto g_value = context.gValue(current_tri_ind);
+        if (f_value > dist(r_end, node.center) + g_value)
+        { //! a shorter way to the triangle was found after this entry had been pushed
+            continue;
+        }
+        for (int ind_in_tri = 0; ind_in_tri < 3; ++ind_in_tri)
         {
-
-            auto ind_in_tri = indInTriOf(current_tri, neighbour);
-            const auto &neighbour_tri = triangles[neighbour];
-            if (current_tri.is_constrained[ind_in_tri] || ind_in_tri == 3)
-            { //! This means that the edge is a wall
+            if (((node.wall_mask >> ind_in_tri) & 1u) || node.widths[ind_in_tri] <= 2 * radius)
+            {
                 continue;
             }
-
-            float width = MAXFLOAT;
-            width = triangle2tri_widths_[current_tri_ind].widths[ind_in_tri];
-
-            const auto t1 = asFloat(current_tri.verts[0] + current_tri.verts[1] + current_tri.verts[2]) / 3.f;
-            const auto t2 = asFloat(neighbour_tri.verts[0] + neighbour_tri.verts[1] + neighbour_tri.verts[2]) / 3.f;
-            const auto distance = dist(t1, t2);
-            const auto distance_to_end = dist(r_end, t1);
-            const auto h_value = dist(r_end, t2);
-            const auto new_g_value = m_g_values.at(current_tri_ind) + distance;
-            if (m_g_values.at(neighbour) > new_g_value && width > 2 * radius)
+            const auto neighbour = node.neighbours[ind_in_tri];
+            if (area && !area->contains(neighbour))
             {
-                m_g_values.at(neighbour) = m_g_values.at(current_tri_ind) + distance;
-                m_back_pointers.at(neighbour) = current_tri_ind;
-                to_visit_pque.push({neighbour, h_value + new_g_value});
+                continue;
+            }
+            const auto new_g_value = g_value + node.costs[ind_in_tri];
+            if (context.gValue(neighbour) > new_g_value)
+            {
+                context.reach(neighbour, new_g_value, current_tri_ind);
+                const auto h_value = dist(r_end, m_nav_graph[neighbour].center);
+                to_visit.push_back({neighbour, h_value + new_g_value});
+                std::push_heap(to_visit.begin(), to_visit.end(), by_f_value);
             }
         }
     }
     //! walk backwards from finish to start;
-    //! current_tri_ind = end;
-    Funnel path;
+    auto &tri_path = context.m_tri_path;
+    tri_path.clear();
     auto current_tri_ind = end;
     while (current_tri_ind != start)
     {
-        if (m_back_pointers[current_tri_ind] == -1)
+        tri_path.push_back(current_tri_ind);
+        current_tri_ind = context.backPointer(current_tri_ind);
+        if (current_tri_ind == -1)
         {
-            return;
+            return false;
         }
-        const auto &tri = triangles[current_tri_ind];
+    }
+    tri_path.push_back(start);
+    funnelThroughPath(tri_path, funnel);
+    return true;
+}
+
+//! \brief Dijkstra from the center of \p from over the triangles of \p area which stops once all \p targets are
+//! \brief reached, distances are measured between triangle centers like in findSubOptimalPathCenters
+//! \param costs gets the distance to each of \p targets, MAXFLOAT for those that cannot be reached
+//! \param context holds the search state, see doPathFinding
+void PathFinder::findCosts(TriInd from, std::span<const TriInd> targets, float radius, const SearchArea &area,
+                           std::span<float> costs, SearchContext &context) const
+{
+    assert(costs.size() == targets.size());
+    context.startSearch(m_nav_graph.size());
+    auto &to_visit = context.m_to_visit;
+    to_visit.clear();
+    const auto by_g_value = [](const AstarDataPQ &a1, const AstarDataPQ &a2)
+    { return a1.f_value > a2.f_value; };
+
+    context.reach(from, 0.f, -1);
+    to_visit.push_back({from, 0});
+    std::size_t n_targets_left = targets.size();
+    while (!to_visit.empty() && n_targets_left > 0)
+    {
+        std::pop_heap(to_visit.begin(), to_visit.end(), by_g_value);
+        const auto [current_tri_ind, g_value] = to_visit.back();
+        to_visit.pop_back();
+        if (g_value > context.gValue(current_tri_ind))
+        { //! a shorter way to the triangle was found after this entry had been pushed
+            continue;
+        }
+        n_targets_left -= std::count(targets.begin(), targets.end(), current_tri_ind);
+
+        const auto &node = m_nav_graph[current_tri_ind];
+        for (int ind_in_tri = 0; ind_in_tri < 3; ++ind_in_tri)
+        {
+            const auto neighbour = node.neighbours[ind_in_tri];
+            if (((node.wall_mask >> ind_in_tri) & 1u) || node.widths[ind_in_tri] <= 2 * radius ||
+                !area.contains(neighbour))
+            {
+                continue;
+            }
+            const auto new_g_value = g_value + node.costs[ind_in_tri];
+            if (context.gValue(neighbour) > new_g_value)
+            {
+                context.reach(neighbour, new_g_value, current_tri_ind);
+                to_visit.push_back({neighbour, new_g_value});
+                std::push_heap(to_visit.begin(), to_visit.end(), by_g_value);
+            }
+        }
+    }
+    for (std::size_t i = 0; i < targets.size(); ++i)
+    {
+        costs[i] = context.gValue(targets[i]);
+    }
+}
+
+//! \brief same as findSubOptimalPathCenters but A* visits only vertices of the reduced triangulation graph, each
+//! \brief corridor between two of them is a single step. Corridors of the found path get expanded to their triangles
+//! \brief afterwards. The triangles are the same as those found by findSubOptimalPathCenters up to ties
+//! \returns false when end cannot be reached
+bool PathFinder::findReducedPathCenters(cdt::Vector2f r_start, cdt::Vector2f r_end, float radius, Funnel &funnel,
+                                        SearchContext &context) const
+{
+    const auto start = m_cdt.findTriangle(r_start, context.m_locate_cursor);
+    const auto end = m_cdt.findTriangle(r_end, context.m_locate_cursor);
+
+    if (start == -1 or end == -1)
+    {
+        return false;
+    }
+    if (start == end)
+    {
+        return true;
+    }
+
+    const auto &rtg = m_rtg;
+    const auto min_width = 2 * radius; //! an agent passes through edges wider than this
+    const int start_vertex = rtg.tri_ind2vertex[start];
+    const int end_vertex = rtg.tri_ind2vertex[end];
+    const auto [start_corridor, start_pos] = rtg.tri_ind2corridor[start];
+    const auto [end_corridor, end_pos] = rtg.tri_ind2corridor[end];
+
+    //! back pointers hold the edge of the vertex triangle through which the search entered it
+    constexpr TriInd is_start_vertex = 3;
+    //! when end lies inside a corridor, it is a node of its own outside of the reduced graph
+    constexpr TriInd end_node = -2;
+    float end_g_value = MAXFLOAT;
+    int end_reached_from = -1; //! 3 * vertex + edge leading into the corridor of end, -1 for straight from start
+
+    context.startSearch(rtg.reduced_vertices.size());
+    auto &to_visit = context.m_to_visit;
+    to_visit.clear();
+    const auto by_f_value = [](const AstarDataPQ &a1, const AstarDataPQ &a2)
+    { return a1.f_value > a2.f_value; };
+
+    auto reach_vertex = [&](int vertex, float g_value, TriInd entry_edge)
+    {
+        if (context.gValue(vertex) > g_value)
+        {
+            context.reach(vertex, g_value, entry_edge);
+            const auto h_value = dist(r_end, m_nav_graph[rtg.vertex2tri_ind[vertex]].center);
+            to_visit.push_back({static_cast<TriInd>(vertex), h_value + g_value});
+            std::push_heap(to_visit.begin(), to_visit.end(), by_f_value);
+        }
+    };
+    auto reach_end = [&](float g_value, int reached_from)
+    {
+        if (end_g_value > g_value)
+        {
+            end_g_value = g_value;
+            end_reached_from = reached_from;
+            to_visit.push_back({end_node, dist(r_end, m_nav_graph[end].center) + g_value});
+            std::push_heap(to_visit.begin(), to_visit.end(), by_f_value);
+        }
+    };
+
+    if (start_vertex != -1)
+    {
+        reach_vertex(start_vertex, 0.f, is_start_vertex);
+    }
+    else
+    { //! start walks out of its corridor on either side
+        const auto &corridor = rtg.edges[start_corridor];
+        const auto crossings = rtg.crossingsOf(corridor);
+        const int last_crossing = corridor.n_tris;
+        if (rtg.minWidthFromEnd(crossings, 0, start_pos) > min_width)
+        {
+            reach_vertex(rtg.tri_ind2vertex[corridor.start.current], crossings[start_pos].length, corridor.start.to);
+        }
+        if (rtg.minWidthFromStart(crossings, start_pos + 1, last_crossing) > min_width)
+        {
+            reach_vertex(rtg.tri_ind2vertex[corridor.end.current], corridor.length - crossings[start_pos].length,
+                         corridor.end.to);
+        }
+        if (start_corridor == end_corridor)
+        {
+            const bool is_forward = start_pos < end_pos;
+            const auto width = is_forward ? rtg.minWidthFromStart(crossings, start_pos + 1, end_pos)
+                                          : rtg.minWidthFromEnd(crossings, end_pos + 1, start_pos);
+            if (width > min_width)
+            {
+                reach_end(std::abs(crossings[end_pos].length - crossings[start_pos].length), -1);
+            }
+        }
+    }
+
+    while (!to_visit.empty())
+    {
+        std::pop_heap(to_visit.begin(), to_visit.end(), by_f_value);
+        const auto current = to_visit.back().next;
+        to_visit.pop_back();
+        if (current == end_node or current == static_cast<TriInd>(end_vertex))
+        {
+            break;
+        }
+
+        const auto &vertex = rtg.reduced_vertices[current];
+        const auto current_tri_ind = rtg.vertex2tri_ind[current];
+        const auto g_value = context.gValue(current);
+        for (int ind_in_tri = 0; ind_in_tri < 3; ++ind_in_tri)
+        {
+            const auto corridor_ind = rtg.vertex2edge_inds2[current][ind_in_tri];
+            if (corridor_ind == -1)
+            {
+                continue;
+            }
+            const auto &corridor = rtg.edges[corridor_ind];
+            const bool from_start = corridor.start.current == current_tri_ind and corridor.start.to == ind_in_tri;
+            if (corridor_ind == end_corridor)
+            { //! walk only up to end
+                const auto crossings = rtg.crossingsOf(corridor);
+                const int last_crossing = corridor.n_tris;
+                const auto width = from_start ? rtg.minWidthFromStart(crossings, 0, end_pos)
+                                              : rtg.minWidthFromEnd(crossings, end_pos + 1, last_crossing);
+                const auto length = from_start ? crossings[end_pos].length : corridor.length - crossings[end_pos].length;
+                if (width > min_width)
+                {
+                    reach_end(g_value + length, 3 * current + ind_in_tri);
+                }
+                continue;
+            }
+            if (corridor_ind == start_corridor or vertex.widths[ind_in_tri] <= min_width)
+            { //! walking through start never beats starting there
+                continue;
+            }
+            reach_vertex(vertex.neighbours[ind_in_tri], g_value + vertex.lengths[ind_in_tri],
+                         from_start ? corridor.end.to : corridor.start.to);
+        }
+    }
+
+    //! walk backwards from finish to start, expanding every corridor on the way
+    auto &tri_path = context.m_tri_path;
+    tri_path.clear();
+    auto walk_corridor = [&](const ReducedTriangulationGraph::Corridor &corridor, int from_pos, int to_pos)
+    {
+        const int step = from_pos <= to_pos ? 1 : -1;
+        for (int pos = from_pos; pos != to_pos + step; pos += step)
+        {
+            tri_path.push_back(rtg.trianglesOf(corridor)[pos]);
+        }
+    };
+
+    int current_vertex = end_vertex;
+    if (end_vertex == -1)
+    {
+        if (end_g_value == MAXFLOAT)
+        {
+            return false;
+        }
+        const auto &corridor = rtg.edges[end_corridor];
+        if (end_reached_from == -1)
+        {
+            walk_corridor(corridor, end_pos, start_pos);
+            funnelThroughPath(tri_path, funnel);
+            return true;
+        }
+        current_vertex = end_reached_from / 3;
+        const bool from_start = corridor.start.current == rtg.vertex2tri_ind[current_vertex] and
+                                corridor.start.to == end_reached_from % 3;
+        walk_corridor(corridor, end_pos, from_start ? 0 : static_cast<int>(corridor.n_tris) - 1);
+    }
+    else if (context.backPointer(end_vertex) == -1)
+    {
+        return false;
+    }
+
+    while (true)
+    {
+        const auto current_tri_ind = rtg.vertex2tri_ind[current_vertex];
+        tri_path.push_back(current_tri_ind);
+        const auto entry_edge = context.backPointer(current_vertex);
+        if (entry_edge == is_start_vertex)
+        {
+            break;
+        }
+        const auto corridor_ind = rtg.vertex2edge_inds2[current_vertex][entry_edge];
+        const auto &corridor = rtg.edges[corridor_ind];
+        const bool entered_at_end = corridor.end.current == current_tri_ind and corridor.end.to == entry_edge;
+        const int last_pos = static_cast<int>(corridor.n_tris) - 1;
+        if (corridor_ind == start_corridor)
+        {
+            walk_corridor(corridor, entered_at_end ? last_pos : 0, start_pos);
+            break;
+        }
+        if (last_pos >= 0)
+        { //! corridors between two neighbouring vertices hold no triangles
+            walk_corridor(corridor, entered_at_end ? last_pos : 0, entered_at_end ? 0 : last_pos);
+        }
+        current_vertex = rtg.tri_ind2vertex[entered_at_end ? corridor.start.current : corridor.end.current];
+    }
+    funnelThroughPath(tri_path, funnel);
+    return true;
+}
+
+//! \brief adds portals between consecutive triangles of \p tri_path to \p funnel
+//! \param tri_path triangles from the end of a path to its start
+void PathFinder::funnelThroughPath(std::span<const TriInd> tri_path, Funnel &funnel) const
+{
+    const auto &triangles = m_cdt.m_triangles;
+    for (std::size_t i = 0; i + 1 < tri_path.size(); ++i)
+    {
+        const auto &tri = triangles[tri_path[i]];
 
-        auto ind_in_tri = indInTriOf(tri, m_back_pointers[current_tri_ind]);
+        auto ind_in_tri = indInTriOf(tri, tri_path[i + 1]);
         if (ind_in_tri == 3)
         {
             return;
         }
-        auto next_neighbour = tri.neighbours.at(ind_in_tri);
 
-        const auto left_vertex_of_portal = asFloat(tri.verts[ind_in_tri]);
-        const auto right_vertex_of_portal = asFloat(tri.verts[next(ind_in_tri)]);
+        const auto left_vertex_of_portal = asFloat(m_cdt.vertexOf(tri, ind_in_tri));
+        const auto right_vertex_of_portal = asFloat(m_cdt.vertexOf(tri, next(ind_in_tri)));
         assert(!std::isnan(right_vertex_of_portal.x) && !std::isnan(left_vertex_of_portal.x));
         funnel.emplace_back(right_vertex_of_portal, left_vertex_of_portal);
-
-        current_tri_ind = m_back_pointers[current_tri_ind];
     }
 }
 
@@ -188,15 +577,15 @@ std::pair<TriInd, int> PathFinder::closestPointOnNavigableComponent(const cdt::V
         const auto &tri = triangles[current_tri_ind];
         to_visit.pop();
 
-        auto tri_center = triangles[start_tri_ind].getCenter();
+        auto tri_center = m_cdt.getCenter(start_tri_ind);
 
         for (int k = 0; k < 3; ++k)
         {
             const auto neighbour = tri.neighbours[k];
             if (neighbour != prev_tri_ind and neighbour != -1)
             {
-                auto v1 = asFloat(tri.verts[k]);
-                auto v2 = asFloat(tri.verts[next(k)]);
+                auto v1 = asFloat(m_cdt.vertexOf(tri, k));
+                auto v2 = asFloat(m_cdt.vertexOf(tri, next(k)));
                 if (segmentsIntersect(tri_center, query_point, v1, v2))
                 {
                     to_visit.push(neighbour);
@@ -232,18 +621,19 @@ float calcWidth(cdt::Vector2f pos, Edgef segment)
     return norm_dist;
 }
 
-PathFinder::TriangleWidth::TriangleWidth(Triangle<Vertex> &tri)
+PathFinder::TriangleWidth::TriangleWidth(const Triangle &tri, const std::vector<Vertex> &vertices)
 {
 
     int n_constraints = 0;
     int free_ind = 0;
 
+    const Vertex verts[3] = {vertices[tri.vert_inds[0]], vertices[tri.vert_inds[1]], vertices[tri.vert_inds[2]]};
     for (int i = 0; i < 3; ++i)
     {
-        widths[i] = dist(tri.verts[i], tri.verts[next(i)]); //;
-        n_constraints += tri.is_constrained[i];
+        widths[i] = dist(verts[i], verts[next(i)]); //;
+        n_constraints += tri.isConstrained(i);
 
-        if (!tri.is_constrained[i] && !tri.is_constrained[prev(i)])
+        if (!tri.isConstrained(i) && !tri.isConstrained(prev(i)))
         {
             free_ind = i;
         }
@@ -251,10 +641,10 @@ PathFinder::TriangleWidth::TriangleWidth(Triangle<Vertex> &tri)
     //! if there are two free edges, the width is the orthogonal projection to the constrained edge
     if (n_constraints == 1)
     {
-        widths[free_ind] = calcWidth(tri.verts[free_ind],
-                                     {tri.verts[prev(free_ind)], tri.verts[next(free_ind)]});
-        widths[prev(free_ind)] = calcWidth(tri.verts[free_ind],
-                                     {tri.verts[prev(free_ind)], tri.verts[next(free_ind)]});
+        widths[free_ind] = calcWidth(asFloat(verts[free_ind]),
+                                     {verts[prev(free_ind)], verts[next(free_ind)]});
+        widths[prev(free_ind)] = calcWidth(asFloat(verts[free_ind]),
+                                     {verts[prev(free_ind)], verts[next(free_ind)]});
     }
 }
 
@@ -369,11 +759,9 @@ PathFinder::PathData PathFinder::pathFromFunnel(const cdt::Vector2f r_start, con
     int left_index = 0;
     int apex_index = 0;
 
-    std::vector<Edgef> left_portals;
-    std::vector<Edgef> right_portals;
-
-    left_portals.push_back(Edgef());
-    right_portals.push_back(Edgef());
+    //! indexed like the funnel, points that did not get pushed away from a corner have no portal
+    std::vector<Edgef> left_portals(funnel.size());
+    std::vector<Edgef> right_portals(funnel.size());
     cdt::Vector2f prev_left = r_start;
     cdt::Vector2f prev_right = r_start;
     int i_first_same = 0;
@@ -406,8 +794,7 @@ PathFinder::PathData PathFinder::pathFromFunnel(const cdt::Vector2f r_start, con
         for (int j = unique_left[i]; j < unique_left[i + 1]; ++j)
         {
             auto &mid_left = funnel[j].second;
-            const auto left_portal = pushAwayFromCorner(mid_left, prev_unique_left, next_unique_left, push_distance, true);
-            left_portals.push_back(left_portal);
+            left_portals[j] = pushAwayFromCorner(mid_left, prev_unique_left, next_unique_left, push_distance, true);
         }
     }
     for (int i = 1; i < unique_right.size() - 1; ++i)
@@ -417,16 +804,12 @@ PathFinder::PathData PathFinder::pathFromFunnel(const cdt::Vector2f r_start, con
         for (int j = unique_right[i]; j < unique_right[i + 1]; ++j)
         {
             auto &mid_right = funnel[j].first;
-            const auto right_portal =
-                pushAwayFromCorner(mid_right, prev_unique_right, next_unique_right, push_distance, false);
-            right_portals.push_back(right_portal);
+            right_portals[j] = pushAwayFromCorner(mid_right, prev_unique_right, next_unique_right, push_distance, false);
         }
     }
 
     path_and_portals.funnel = funnel;
 
-    left_portals.push_back(Edgef());
-    right_portals.push_back(Edgef());
     for (int i = 1; i < funnel.size(); ++i)
     {
 
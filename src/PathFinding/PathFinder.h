@@ -7,18 +7,7 @@
 #include <unordered_set>
 
 #include "../Triangulation.h"
-// #include "ReducedTriangulationGraph.h"
-
-
-struct Portal {
-    cdt::Vector2f first; //! left point of portal when looking through the portal
-    cdt::Vector2f second;
-
-    Portal(cdt::Vector2f a, cdt::Vector2f b) : first(a), second(b) {}
-};
-
-//! \note first and last element of portals should be one singular point with left == right
-typedef std::deque<Portal> Funnel;
+#include "ReducedTriangulationGraph.h"
 
 
 using namespace cdt;
@@ -55,35 +44,11 @@ private:
         float f_value = std::numeric_limits<float>::max(); //! sum of heuristic (h_value) and g_value
     };
 
-    struct AstarData
-    {
-        float g_value = std::numeric_limits<float>::max(); //! sum of heuristic (h_value) and g_value
-        float h_value = 0;
-        int prev;
-    };
-
-    typedef int ReducedVertexInd;
-    //! \struct contains together all the properties needed during a single Astar iteration
-    struct AstarReducedData
-    {
-        float g_value = 0;
-        float h_value = 0;
-        ReducedVertexInd prev; //! back-pointer to a reduced vertex used to backtrack path
-        int ind_in_tri;
-    };
-
-    //! data needed by priority_queue in Astar on reduced graph
-    struct AstarReducedDataPQ
-    {
-        float f_value;
-        ReducedVertexInd next; //! next reduced vertex to visit in Astar
-    };
-
     //! \struct contains information about width of each triangle sides
     struct TriangleWidth
     {
         float widths[3];
-        TriangleWidth(Triangle<Vertex> &tri);
+        TriangleWidth(const Triangle &tri, const std::vector<Vertex> &vertices);
         TriangleWidth()
         {
             widths[0] = MAXFLOAT;
@@ -91,6 +56,19 @@ private:
             widths[2] = MAXFLOAT;
         }
     };
+    static_assert(sizeof(TriangleWidth) == 3 * sizeof(float), "widths are stored in snapshots as plain floats");
+
+    //! \struct everything A* reads about a triangle, built by update() so that expanding a triangle only reads
+    //! \brief this one node instead of the triangle, its vertices, its widths and the centers of its neighbours
+    struct alignas(16) NavNode
+    {
+        cdt::Vector2f center;
+        std::array<TriInd, 3> neighbours; //! neighbours[k] lies across edge k
+        std::array<float, 3> costs;       //! distances from center to the centers of the neighbours
+        std::array<float, 3> widths;      //! widest agent passing through edge k, see TriangleWidth
+        std::uint8_t wall_mask = 0;       //! bit k is set when edge k is constrained or lies on the boundary
+    };
+    static_assert(sizeof(NavNode) == 48, "four nodes should fit into three cache lines");
 
 public:
     struct PathData
@@ -98,16 +76,85 @@ public:
         std::deque<cdt::Vector2f> path;
         std::deque<Edgef> portals;
         Funnel funnel;
+        bool found = true; //! false when end cannot be reached, path is then just the straight line from start to end
+    };
+
+    //! \class scratch state of A* searches and point location
+    //! \brief the path finder itself only reads its data during a search, so searches with different contexts
+    //! \brief can run at once on different threads. Contexts grow to the size of the triangulation on first use
+    class SearchContext
+    {
+        friend class PathFinder;
+
+    public:
+        //! \brief point location state, for callers locating points on the same triangulation between searches
+        LocateCursor &locateCursor() { return m_locate_cursor; }
+
+    private:
+        void startSearch(std::size_t n_triangles);
+        //! \returns g value of \p tri_ind in the current search, MAXFLOAT if the search did not reach it yet
+        float gValue(TriInd tri_ind) const
+        {
+            return m_search_stamps[tri_ind] == m_search_stamp ? m_g_values[tri_ind] : MAXFLOAT;
+        }
+        //! \returns triangle from which the current search reached \p tri_ind, -1 if it did not reach it yet
+        TriInd backPointer(TriInd tri_ind) const
+        {
+            return m_search_stamps[tri_ind] == m_search_stamp ? m_back_pointers[tri_ind] : -1;
+        }
+        void reach(TriInd tri_ind, float g_value, TriInd back_pointer)
+        {
+            m_search_stamps[tri_ind] = m_search_stamp;
+            m_g_values[tri_ind] = g_value;
+            m_back_pointers[tri_ind] = back_pointer;
+        }
+
+        std::vector<TriInd> m_back_pointers;
+        std::vector<float> m_g_values;
+        std::vector<std::uint32_t> m_search_stamps; //! values of the two above are valid only where this is m_search_stamp
+        std::uint32_t m_search_stamp = 0;           //! incremented by every search instead of resetting all triangles
+        std::vector<AstarDataPQ> m_to_visit;        //! heap of the open triangles, kept so that searches do not allocate
+        std::vector<TriInd> m_tri_path;             //! triangles of the found path from end to start
+        LocateCursor m_locate_cursor;               //! own point location state
+    };
+
+    //! \struct part of the map a search may enter: triangles whose region holds the stamp of the area
+    //! \brief stamps let callers build a new area without clearing the regions of the previous one
+    struct SearchArea
+    {
+        std::span<const int> tri_ind2region;              //! region of every triangle
+        std::span<const std::uint32_t> region_stamps;     //! equal to stamp for the regions the search may enter
+        std::uint32_t stamp = 1;
+
+        bool contains(TriInd tri_ind) const { return region_stamps[tri_ind2region[tri_ind]] == stamp; }
     };
 
 public:
-    explicit PathFinder(Triangulation<Vertex> &cdt);
+    explicit PathFinder(const Triangulation<Vertex> &cdt);
 
     void update();
+    void update(const SnapshotFile &snapshot);
+    void reorder(const Reordering &reordering);
+    void saveSnapshot(const std::string &filename) const;
 
-    void findSubOptimalPathCenters(const cdt::Vector2f r_start, const cdt::Vector2f r_end, float radius, Funnel &funnel);
+    bool findSubOptimalPathCenters(const cdt::Vector2f r_start, const cdt::Vector2f r_end, float radius, Funnel &funnel);
+    bool findSubOptimalPathCenters(const cdt::Vector2f r_start, const cdt::Vector2f r_end, float radius, Funnel &funnel,
+                                   SearchContext &context, const SearchArea *area = nullptr) const;
+
+    bool findReducedPathCenters(const cdt::Vector2f r_start, const cdt::Vector2f r_end, float radius, Funnel &funnel,
+                                SearchContext &context) const;
+
+    //! \brief whether doPathFinding runs A* on the reduced graph (the default) or on all triangles
+    void setUseReducedGraph(bool use_reduced_graph) { m_use_reduced_graph = use_reduced_graph; }
 
     PathData doPathFinding(const cdt::Vector2f r_start, const cdt::Vector2f r_end, const float radius);
+    PathData doPathFinding(const cdt::Vector2f r_start, const cdt::Vector2f r_end, const float radius,
+                           SearchContext &context) const;
+    PathData pathThroughFunnel(const cdt::Vector2f r_start, const cdt::Vector2f r_end, const float radius,
+                               Funnel &funnel) const;
+
+    void findCosts(TriInd from, std::span<const TriInd> targets, float radius, const SearchArea &area,
+                   std::span<float> costs, SearchContext &context) const;
 
 private:
     std::pair<TriInd, int> closestPointOnNavigableComponent(const cdt::Vector2f &r, const TriInd start_tri_ind,
@@ -119,17 +166,22 @@ private:
 
     float sign(cdt::Vector2f a, cdt::Vector2f b, cdt::Vector2f c) const;
 
+    void buildNavGraph();
+    void funnelThroughPath(std::span<const TriInd> tri_path, Funnel &funnel) const;
+
     Edgef pushAwayFromCorner(cdt::Vector2f &r_to_push, const cdt::Vector2f &r_prev, const cdt::Vector2f &r_next,
                              const float distance, bool left) const;
 
 public:
     std::vector<TriangleWidth> triangle2tri_widths_;
 private:
-    std::vector<TriInd> m_back_pointers;
-    std::vector<float> m_g_values;
-    // std::unique_ptr<ReducedTriangulationGraph> m_rtg;
+    std::vector<NavNode> m_nav_graph; //! one node per triangle of m_cdt
+    ReducedTriangulationGraph m_rtg;  //! crossroads and dead ends of m_cdt connected by corridors
+    bool m_use_reduced_graph = true;
 
-    Triangulation<Vertex>& m_cdt; //! underlying triangulation
+    const Triangulation<Vertex>& m_cdt; //! underlying triangulation
+    SearchContext m_search_context;     //! used by the overloads without a context, so path finders running on
+                                        //! different threads can share one triangulation
 
     std::vector<int> component2building_ind_; //! this should probably not be here...
 
@@ -0,0 +1,442 @@
+#include "PathHierarchy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+namespace
+{
+    std::uint64_t mix(std::uint64_t x)
+    {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ull;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+
+    //! \returns hash of the geometry and the constraints of \p tri which does not depend on the order of its vertices
+    std::uint64_t hashTriangle(const Triangulation<Vertex> &cdt, const Triangle &tri)
+    {
+        std::uint64_t hash = 0;
+        for (int k = 0; k < 3; ++k)
+        {
+            auto a = cdt.vertexOf(tri, k);
+            auto b = cdt.vertexOf(tri, next(k));
+            if (b.x < a.x || (b.x == a.x && b.y < a.y))
+            {
+                std::swap(a, b);
+            }
+            std::uint64_t edge_hash = mix(static_cast<std::uint32_t>(a.x) | std::uint64_t(static_cast<std::uint32_t>(a.y)) << 32);
+            edge_hash = mix(edge_hash ^ (static_cast<std::uint32_t>(b.x) | std::uint64_t(static_cast<std::uint32_t>(b.y)) << 32));
+            hash += mix(edge_hash + tri.isConstrained(k));
+        }
+        return mix(hash);
+    }
+} // namespace
+
+PathHierarchy::PathHierarchy(const Triangulation<Vertex> &cdt, const PathFinder &path_finder, int chunk_size,
+                             float radius)
+    : m_cdt(cdt), m_path_finder(path_finder), m_chunk_size(std::max(chunk_size, 1)), m_radius(radius)
+{
+}
+
+//! \brief finds entrances of all chunks and recomputes costs of the chunks which changed since the last update
+//! \brief should be called after every update of the path finder
+void PathHierarchy::update()
+{
+    const auto &triangles = m_cdt.m_triangles;
+    const auto boundary = m_cdt.getBoundary();
+    const cdt::Vector2i n_chunks = {std::max(1, (boundary.x + m_chunk_size - 1) / m_chunk_size),
+                                    std::max(1, (boundary.y + m_chunk_size - 1) / m_chunk_size)};
+    if (n_chunks != m_n_chunks)
+    { //! chunks of the previous map have nothing in common with these
+        m_n_chunks = n_chunks;
+        m_chunks.assign(n_chunks.x * n_chunks.y, {});
+    }
+
+    std::vector<std::uint64_t> hashes(m_chunks.size(), 0);
+    m_tri_ind2chunk.resize(triangles.size());
+    for (std::size_t tri_ind = 0; tri_ind < triangles.size(); ++tri_ind)
+    {
+        const auto chunk_ind = chunkOf(m_cdt.getCenter(triangles[tri_ind]));
+        m_tri_ind2chunk[tri_ind] = chunk_ind;
+        hashes[chunk_ind] += hashTriangle(m_cdt, triangles[tri_ind]);
+    }
+
+    findEntrances();
+
+    //! triangles and entrances of a chunk determine its costs, so unchanged chunks keep them
+    m_n_refreshed_chunks = 0;
+    for (std::size_t chunk_ind = 0; chunk_ind < m_chunks.size(); ++chunk_ind)
+    {
+        auto &chunk = m_chunks[chunk_ind];
+        const bool same_nodes = std::equal(chunk.nodes.begin(), chunk.nodes.end(), chunk.keys.begin(), chunk.keys.end(),
+                                           [this](int node, const EdgeKey &key)
+                                           { return m_nodes[node].key == key; });
+        if (chunk.hash != hashes[chunk_ind] || !same_nodes)
+        {
+            chunk.hash = hashes[chunk_ind];
+            computeCosts(chunk_ind, m_search_context);
+            m_n_refreshed_chunks++;
+        }
+    }
+
+    buildLinks();
+}
+
+//! \brief invalidates g values and back pointers of the previous search on nodes in O(1) by moving to the next stamp
+void PathHierarchy::SearchContext::startSearch(std::size_t n_nodes)
+{
+    if (m_search_stamps.size() < n_nodes)
+    {
+        m_g_values.resize(n_nodes);
+        m_back_pointers.resize(n_nodes);
+        m_search_stamps.resize(n_nodes, 0);
+    }
+    if (++m_search_stamp == 0)
+    { //! after the stamp wrapped around, old searches could look like the current one
+        std::fill(m_search_stamps.begin(), m_search_stamps.end(), 0);
+        m_search_stamp = 1;
+    }
+}
+
+//! \returns area without any chunk, chunks are added to it by allow(), areas returned earlier must not be used anymore
+PathFinder::SearchArea PathHierarchy::SearchContext::newArea(std::span<const int> tri_ind2chunk, std::size_t n_chunks)
+{
+    if (m_chunk_stamps.size() < n_chunks)
+    {
+        m_chunk_stamps.resize(n_chunks, 0);
+    }
+    if (++m_area_stamp == 0)
+    {
+        std::fill(m_chunk_stamps.begin(), m_chunk_stamps.end(), 0);
+        m_area_stamp = 1;
+    }
+    return {tri_ind2chunk, m_chunk_stamps, m_area_stamp};
+}
+
+//! \returns index of the chunk containing \p r, points outside of the map belong to the closest chunk
+int PathHierarchy::chunkOf(cdt::Vector2f r) const
+{
+    const int x = std::clamp(static_cast<int>(std::floor(r.x / m_chunk_size)), 0, m_n_chunks.x - 1);
+    const int y = std::clamp(static_cast<int>(std::floor(r.y / m_chunk_size)), 0, m_n_chunks.y - 1);
+    return y * m_n_chunks.x + x;
+}
+
+//! \brief walkable edges between triangles of two different chunks which share a vertex belong to the same entrance,
+//! \brief the widest edge of each entrance gets a node on both of its sides
+void PathHierarchy::findEntrances()
+{
+    const auto &triangles = m_cdt.m_triangles;
+    const auto &widths = m_path_finder.triangle2tri_widths_;
+
+    struct Crossing
+    {
+        TriInd tri_ind;
+        int ind_in_tri;
+        float width;
+        EdgeKey key;
+    };
+    std::vector<Crossing> crossings;
+    for (TriInd tri_ind = 0; tri_ind < triangles.size(); ++tri_ind)
+    {
+        const auto &tri = triangles[tri_ind];
+        for (int k = 0; k < 3; ++k)
+        {
+            const auto neighbour = tri.neighbours[k];
+            if (tri.isConstrained(k) || neighbour == -1 || neighbour < tri_ind ||
+                m_tri_ind2chunk[neighbour] == m_tri_ind2chunk[tri_ind])
+            {
+                continue;
+            }
+            const auto width = std::min(widths[tri_ind].widths[k], widths[neighbour].widths[tri.backIndex(k)]);
+            if (width <= 2 * m_radius)
+            {
+                continue;
+            }
+            auto a = m_cdt.vertexOf(tri, k);
+            auto b = m_cdt.vertexOf(tri, next(k));
+            if (b.x < a.x || (b.x == a.x && b.y < a.y))
+            {
+                std::swap(a, b);
+            }
+            crossings.push_back({tri_ind, k, width, {a.x, a.y, b.x, b.y}});
+        }
+    }
+
+    //! union-find over crossings of the same pair of chunks sharing a vertex
+    std::vector<int> parents(crossings.size());
+    std::iota(parents.begin(), parents.end(), 0);
+    const auto find_root = [&parents](int crossing)
+    {
+        while (parents[crossing] != crossing)
+        {
+            parents[crossing] = parents[parents[crossing]];
+            crossing = parents[crossing];
+        }
+        return crossing;
+    };
+    const std::uint64_t n_chunks = m_chunks.size();
+    const std::uint64_t n_vertices = m_cdt.m_vertices.size();
+    std::unordered_map<std::uint64_t, int> vertex2crossing;
+    vertex2crossing.reserve(2 * crossings.size());
+    for (std::size_t i = 0; i < crossings.size(); ++i)
+    {
+        const auto &tri = triangles[crossings[i].tri_ind];
+        const auto k = crossings[i].ind_in_tri;
+        const std::uint64_t chunk_a = m_tri_ind2chunk[crossings[i].tri_ind];
+        const std::uint64_t chunk_b = m_tri_ind2chunk[tri.neighbours[k]];
+        const auto chunk_pair = std::min(chunk_a, chunk_b) * n_chunks + std::max(chunk_a, chunk_b);
+        for (const auto vert_ind : {tri.vert_inds[k], tri.vert_inds[next(k)]})
+        {
+            const auto [it, inserted] = vertex2crossing.emplace(chunk_pair * n_vertices + vert_ind, i);
+            if (!inserted)
+            {
+                parents[find_root(i)] = find_root(it->second);
+            }
+        }
+    }
+
+    //! long entrances are split into pieces of a quarter of a chunk along the border, the widest crossing represents
+    //! its piece, ties are broken by position so that the choice does not depend on the order of triangles
+    const int piece_size = std::max(m_chunk_size / 4, 1);
+    const auto piece_of = [&](const Crossing &crossing)
+    {
+        const auto &tri = triangles[crossing.tri_ind];
+        const auto chunk_a = m_tri_ind2chunk[crossing.tri_ind];
+        const auto chunk_b = m_tri_ind2chunk[tri.neighbours[crossing.ind_in_tri]];
+        const auto &[ax, ay, bx, by] = crossing.key;
+        if (chunk_a % m_n_chunks.x == chunk_b % m_n_chunks.x)
+        { //! chunks lie above each other, the border is horizontal
+            return (ax + bx) / (2 * piece_size);
+        }
+        if (chunk_a / m_n_chunks.x == chunk_b / m_n_chunks.x)
+        {
+            return (ay + by) / (2 * piece_size);
+        }
+        return 0;
+    };
+    std::unordered_map<std::uint64_t, int> piece2best;
+    for (std::size_t i = 0; i < crossings.size(); ++i)
+    {
+        const auto piece = std::uint64_t(find_root(i)) << 32 | static_cast<std::uint32_t>(piece_of(crossings[i]));
+        const auto [it, inserted] = piece2best.emplace(piece, i);
+        auto &best = it->second;
+        if (crossings[i].width > crossings[best].width ||
+            (crossings[i].width == crossings[best].width && crossings[i].key < crossings[best].key))
+        {
+            best = i;
+        }
+    }
+
+    m_nodes.clear();
+    for (auto &chunk : m_chunks)
+    {
+        chunk.nodes.clear();
+    }
+    const auto add_node = [this](TriInd tri_ind, const EdgeKey &key)
+    {
+        const int chunk_ind = m_tri_ind2chunk[tri_ind];
+        m_chunks[chunk_ind].nodes.push_back(m_nodes.size());
+        m_nodes.push_back({tri_ind, chunk_ind, 0, -1, m_cdt.getCenter(tri_ind), key});
+    };
+    for (const auto &[piece, best] : piece2best)
+    {
+        const auto &[tri_ind, ind_in_tri, width, key] = crossings[best];
+        const int node = m_nodes.size();
+        add_node(tri_ind, key);
+        add_node(triangles[tri_ind].neighbours[ind_in_tri], key);
+        m_nodes[node].other_side = node + 1;
+        m_nodes[node + 1].other_side = node;
+    }
+
+    for (auto &chunk : m_chunks)
+    {
+        std::sort(chunk.nodes.begin(), chunk.nodes.end(), [this](int a, int b)
+                  { return m_nodes[a].key < m_nodes[b].key; });
+        for (std::size_t i = 0; i < chunk.nodes.size(); ++i)
+        {
+            m_nodes[chunk.nodes[i]].ind_in_chunk = i;
+        }
+    }
+}
+
+//! \brief finds costs between all pairs of nodes of the chunk at \p chunk_ind using only its triangles
+void PathHierarchy::computeCosts(int chunk_ind, SearchContext &context)
+{
+    auto &chunk = m_chunks[chunk_ind];
+    const auto n_nodes = chunk.nodes.size();
+    chunk.keys.resize(n_nodes);
+    auto &targets = context.m_targets;
+    targets.resize(n_nodes);
+    for (std::size_t i = 0; i < n_nodes; ++i)
+    {
+        targets[i] = m_nodes[chunk.nodes[i]].tri_ind;
+        chunk.keys[i] = m_nodes[chunk.nodes[i]].key;
+    }
+
+    const auto area = context.newArea(m_tri_ind2chunk, m_chunks.size());
+    context.allow(chunk_ind);
+    chunk.costs.resize(n_nodes * n_nodes);
+    for (std::size_t i = 0; i < n_nodes; ++i)
+    {
+        m_path_finder.findCosts(targets[i], targets, m_radius, area, {chunk.costs.data() + i * n_nodes, n_nodes},
+                                context.m_path_finder_context);
+    }
+}
+
+//! \brief collects the edges of the node graph: crossings of entrances and paths within chunks
+void PathHierarchy::buildLinks()
+{
+    m_first_links.resize(m_nodes.size() + 1);
+    m_links.clear();
+    for (std::size_t node = 0; node < m_nodes.size(); ++node)
+    {
+        m_first_links[node] = m_links.size();
+        const auto &[tri_ind, chunk_ind, ind_in_chunk, other_side, center, key] = m_nodes[node];
+        m_links.push_back({other_side, dist(center, m_nodes[other_side].center)});
+
+        const auto &chunk = m_chunks[chunk_ind];
+        const auto n_nodes = chunk.nodes.size();
+        for (std::size_t j = 0; j < n_nodes; ++j)
+        {
+            const auto cost = chunk.costs[ind_in_chunk * n_nodes + j];
+            if (j != ind_in_chunk && cost != MAXFLOAT)
+            {
+                m_links.push_back({chunk.nodes[j], cost});
+            }
+        }
+    }
+    m_first_links.back() = m_links.size();
+}
+
+PathFinder::PathData PathHierarchy::findPath(cdt::Vector2f r_start, cdt::Vector2f r_end, float radius)
+{
+    return findPath(r_start, r_end, radius, m_search_context);
+}
+
+//! \brief searches the node graph from the nodes reachable from start within its chunk to those from which end is
+//! \brief reachable within its chunk, then runs triangle A* restricted to the chunks of the found nodes. Falls back
+//! \brief to PathFinder::doPathFinding when \p radius is wider than the one of the hierarchy or when either of the
+//! \brief searches fails
+//! \param context holds the search state, so several threads can find paths at once each with its own context
+PathFinder::PathData PathHierarchy::findPath(cdt::Vector2f r_start, cdt::Vector2f r_end, float radius,
+                                             SearchContext &context) const
+{
+    auto &pf_context = context.m_path_finder_context;
+    const auto start = m_cdt.findTriangle(r_start, pf_context.locateCursor());
+    const auto end = m_cdt.findTriangle(r_end, pf_context.locateCursor());
+    if (radius > m_radius || start == -1 || end == -1 || start == end || m_tri_ind2chunk.size() <= std::max(start, end))
+    {
+        return m_path_finder.doPathFinding(r_start, r_end, radius, pf_context);
+    }
+
+    const int start_chunk = m_tri_ind2chunk[start];
+    const int end_chunk = m_tri_ind2chunk[end];
+    Funnel funnel;
+    if (start_chunk == end_chunk)
+    { //! the path mostly stays within the chunk, it leaves it only to get around obstacles
+        const auto area = context.newArea(m_tri_ind2chunk, m_chunks.size());
+        context.allow(start_chunk);
+        if (m_path_finder.findSubOptimalPathCenters(r_start, r_end, radius, funnel, pf_context, &area))
+        {
+            return m_path_finder.pathThroughFunnel(r_start, r_end, radius, funnel);
+        }
+        funnel.clear();
+    }
+
+    //! costs of getting from start to the nodes of its chunk and from the nodes of the chunk of end to end
+    const auto costs_within = [&](TriInd tri_ind, int chunk_ind, std::vector<float> &costs)
+    {
+        const auto &nodes = m_chunks[chunk_ind].nodes;
+        context.m_targets.resize(nodes.size());
+        std::transform(nodes.begin(), nodes.end(), context.m_targets.begin(), [this](int node)
+                       { return m_nodes[node].tri_ind; });
+        costs.resize(nodes.size());
+        const auto area = context.newArea(m_tri_ind2chunk, m_chunks.size());
+        context.allow(chunk_ind);
+        m_path_finder.findCosts(tri_ind, context.m_targets, radius, area, costs, pf_context);
+    };
+    const auto &start_costs = context.m_start_costs;
+    const auto &end_costs = context.m_end_costs;
+    costs_within(start, start_chunk, context.m_start_costs);
+    costs_within(end, end_chunk, context.m_end_costs);
+    const auto is_reached = [](float cost)
+    { return cost != MAXFLOAT; };
+    if (std::none_of(start_costs.begin(), start_costs.end(), is_reached) ||
+        std::none_of(end_costs.begin(), end_costs.end(), is_reached))
+    { //! start or end is cut off from the borders of its chunk, e.g. lies in a closed room or inside of a wall
+        return m_path_finder.doPathFinding(r_start, r_end, radius, pf_context);
+    }
+
+    //! A* over nodes, goal is a virtual node entered from the nodes of the chunk of end
+    const int goal = m_nodes.size();
+    context.startSearch(goal + 1);
+    auto &to_visit = context.m_to_visit;
+    to_visit.clear();
+    const auto by_f_value = [](const NodePQ &a, const NodePQ &b)
+    { return a.f_value > b.f_value; };
+    const auto h_value = [&](int node)
+    { return node == goal ? 0.f : dist(m_nodes[node].center, r_end); };
+    const auto relax = [&](int node, float g_value, int back_pointer)
+    {
+        if (g_value < context.gValue(node))
+        {
+            context.reach(node, g_value, back_pointer);
+            to_visit.push_back({node, g_value + h_value(node)});
+            std::push_heap(to_visit.begin(), to_visit.end(), by_f_value);
+        }
+    };
+
+    const auto &start_nodes = m_chunks[start_chunk].nodes;
+    for (std::size_t i = 0; i < start_nodes.size(); ++i)
+    {
+        if (is_reached(start_costs[i]))
+        {
+            relax(start_nodes[i], start_costs[i], -1);
+        }
+    }
+    while (!to_visit.empty())
+    {
+        std::pop_heap(to_visit.begin(), to_visit.end(), by_f_value);
+        const auto [node, f_value] = to_visit.back();
+        to_visit.pop_back();
+        if (node == goal)
+        {
+            break;
+        }
+        const auto g_value = context.gValue(node);
+        if (f_value > g_value + h_value(node))
+        { //! the node was reached by a shorter path after this entry had been pushed
+            continue;
+        }
+
+        if (m_nodes[node].chunk == end_chunk && is_reached(end_costs[m_nodes[node].ind_in_chunk]))
+        {
+            relax(goal, g_value + end_costs[m_nodes[node].ind_in_chunk], node);
+        }
+        for (int link = m_first_links[node]; link < m_first_links[node + 1]; ++link)
+        {
+            relax(m_links[link].to, g_value + m_links[link].cost, node);
+        }
+    }
+    if (context.gValue(goal) == MAXFLOAT)
+    {
+        return m_path_finder.doPathFinding(r_start, r_end, radius, pf_context);
+    }
+
+    const auto area = context.newArea(m_tri_ind2chunk, m_chunks.size());
+    context.allow(start_chunk);
+    context.allow(end_chunk);
+    for (int node = context.backPointer(goal); node != -1; node = context.backPointer(node))
+    {
+        context.allow(m_nodes[node].chunk);
+    }
+    if (!m_path_finder.findSubOptimalPathCenters(r_start, r_end, radius, funnel, pf_context, &area))
+    { //! happens only when the path finder changed after the last update()
+        return m_path_finder.doPathFinding(r_start, r_end, radius, pf_context);
+    }
+    return m_path_finder.pathThroughFunnel(r_start, r_end, radius, funnel);
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "PathFinder.h"
+
+//! \class two level path search over one triangulation in the spirit of HPA*. The map is split into square chunks
+//! \brief and every group of walkable edges joining the same two chunks is an entrance with one node on each side.
+//! \brief Costs between the nodes of a chunk are precomputed, so a path is first searched for in the small graph of
+//! \brief entrance nodes and then refined by the triangle A* of the path finder, which only enters the chunks that
+//! \brief the coarse path traverses. update() recomputes the costs only for chunks whose triangles or entrances
+//! \brief changed since the previous update
+class PathHierarchy
+{
+private:
+    //! \struct endpoints of a crossed edge sorted by coordinates, identifies an entrance node across updates
+    using EdgeKey = std::array<int, 4>;
+
+    //! \struct one side of an entrance
+    struct Node
+    {
+        TriInd tri_ind;        //! triangle of the chunk touching the crossed edge
+        int chunk;
+        int ind_in_chunk;      //! position within Chunk::nodes
+        int other_side;        //! node on the other side of the crossed edge
+        cdt::Vector2f center;  //! of the triangle
+        EdgeKey key;
+    };
+
+    //! \struct nodes of a chunk and distances between all pairs of them
+    struct Chunk
+    {
+        std::vector<int> nodes;      //! sorted by their keys
+        std::vector<EdgeKey> keys;   //! keys of the nodes the costs were computed for
+        std::vector<float> costs;    //! costs[i * nodes.size() + j] from node i to node j, MAXFLOAT if unreachable
+        std::uint64_t hash = 0;      //! of the triangles of the chunk when the costs were computed
+    };
+
+    struct Link
+    {
+        int to;
+        float cost;
+    };
+
+    //! \struct holds data needed by the priority queue of the search on nodes
+    struct NodePQ
+    {
+        int node;
+        float f_value;
+    };
+
+public:
+    //! \class scratch state of findPath, like PathFinder::SearchContext it is reused so that searches do not allocate
+    //! \brief once it grew to the size of the hierarchy, searches on different threads need different contexts
+    class SearchContext
+    {
+        friend class PathHierarchy;
+
+        void startSearch(std::size_t n_nodes);
+        //! \returns g value of \p node in the current search, MAXFLOAT if the search did not reach it yet
+        float gValue(int node) const
+        {
+            return m_search_stamps[node] == m_search_stamp ? m_g_values[node] : MAXFLOAT;
+        }
+        //! \returns node from which the current search reached \p node, -1 if it did not reach it yet
+        int backPointer(int node) const
+        {
+            return m_search_stamps[node] == m_search_stamp ? m_back_pointers[node] : -1;
+        }
+        void reach(int node, float g_value, int back_pointer)
+        {
+            m_search_stamps[node] = m_search_stamp;
+            m_g_values[node] = g_value;
+            m_back_pointers[node] = back_pointer;
+        }
+        PathFinder::SearchArea newArea(std::span<const int> tri_ind2chunk, std::size_t n_chunks);
+        //! \brief lets searches in the area returned by the last newArea() enter \p chunk_ind
+        void allow(int chunk_ind) { m_chunk_stamps[chunk_ind] = m_area_stamp; }
+
+        PathFinder::SearchContext m_path_finder_context; //! for the searches on triangles
+        std::vector<float> m_g_values;
+        std::vector<int> m_back_pointers;
+        std::vector<std::uint32_t> m_search_stamps; //! values of the two above are valid only where this is m_search_stamp
+        std::uint32_t m_search_stamp = 0;
+        std::vector<NodePQ> m_to_visit;             //! heap of the open nodes
+        std::vector<std::uint32_t> m_chunk_stamps;  //! chunks holding m_area_stamp belong to the current area
+        std::uint32_t m_area_stamp = 0;
+        std::vector<TriInd> m_targets;              //! triangles of the nodes of a chunk for PathFinder::findCosts
+        std::vector<float> m_start_costs;           //! from start to the nodes of its chunk
+        std::vector<float> m_end_costs;             //! from the nodes of the chunk of end to end
+    };
+
+    //! \param path_finder must be updated before this, it is used for all searches on triangles
+    //! \param chunk_size side of the chunks
+    //! \param radius of the widest agent the costs are computed for, wider agents get paths from the path finder
+    PathHierarchy(const Triangulation<Vertex> &cdt, const PathFinder &path_finder, int chunk_size, float radius);
+
+    void update();
+
+    PathFinder::PathData findPath(cdt::Vector2f r_start, cdt::Vector2f r_end, float radius);
+    PathFinder::PathData findPath(cdt::Vector2f r_start, cdt::Vector2f r_end, float radius,
+                                  SearchContext &context) const;
+
+    int chunkOf(cdt::Vector2f r) const;
+    std::size_t nChunks() const { return m_chunks.size(); }
+    std::size_t nNodes() const { return m_nodes.size(); }
+    //! \returns number of chunks whose costs were recomputed by the last update()
+    std::size_t nRefreshedChunks() const { return m_n_refreshed_chunks; }
+
+private:
+    void findEntrances();
+    void computeCosts(int chunk_ind, SearchContext &context);
+    void buildLinks();
+
+private:
+    const Triangulation<Vertex> &m_cdt;
+    const PathFinder &m_path_finder;
+    int m_chunk_size;
+    float m_radius;
+    cdt::Vector2i m_n_chunks = {0, 0};
+
+    std::vector<int> m_tri_ind2chunk;
+    std::vector<Chunk> m_chunks;
+    std::vector<Node> m_nodes;
+    std::vector<int> m_first_links; //! links of node n are m_links[m_first_links[n]] up to m_links[m_first_links[n + 1]]
+    std::vector<Link> m_links;
+    std::size_t m_n_refreshed_chunks = 0;
+
+    SearchContext m_search_context; //! used by the overload of findPath without a context
+};
@@ -0,0 +1,152 @@
+#include "PathQueryService.h"
+
+#include <algorithm>
+#include <utility>
+
+//! \param path_finder must stay alive and up to date with its triangulation as long as the service exists
+//! \param n_threads number of workers, at least one is started
+PathQueryService::PathQueryService(const PathFinder &path_finder, std::size_t n_threads)
+    : m_path_finder(path_finder)
+{
+    n_threads = std::max<std::size_t>(n_threads, 1);
+    m_workers.reserve(n_threads);
+    for (std::size_t i = 0; i < n_threads; ++i)
+    {
+        m_workers.emplace_back([this]()
+                               { workerLoop(); });
+    }
+}
+
+//! \brief answers the requests still in the queue and stops the workers
+PathQueryService::~PathQueryService()
+{
+    {
+        std::scoped_lock lock(m_mutex);
+        m_is_stopping = true;
+    }
+    m_job_added.notify_all();
+    for (auto &worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+//! \returns future holding the path, or the exception thrown while finding it
+std::future<PathFinder::PathData> PathQueryService::submit(const Request &request)
+{
+    Job job;
+    job.request = request;
+    auto result = job.result.get_future();
+    {
+        std::scoped_lock lock(m_mutex);
+        m_jobs.push_back(std::move(job));
+    }
+    m_job_added.notify_one();
+    return result;
+}
+
+//! \returns one future per request in the same order
+std::vector<std::future<PathFinder::PathData>> PathQueryService::submit(std::span<const Request> requests)
+{
+    std::vector<std::future<PathFinder::PathData>> results;
+    results.reserve(requests.size());
+    {
+        std::scoped_lock lock(m_mutex);
+        for (const auto &request : requests)
+        {
+            Job job;
+            job.request = request;
+            results.push_back(job.result.get_future());
+            m_jobs.push_back(std::move(job));
+        }
+    }
+    m_job_added.notify_all();
+    return results;
+}
+
+//! \brief queues \p requests and returns right away, paths are handed to \p on_found as soon as they are found
+//! \brief when finding a path or \p on_found throws, the other requests are still answered and wait() rethrows
+//! \param on_found called once per request from any of the workers, possibly at the same time
+void PathQueryService::submit(std::span<const Request> requests, Callback on_found)
+{
+    const auto shared_on_found = std::make_shared<const Callback>(std::move(on_found));
+    {
+        std::scoped_lock lock(m_mutex);
+        for (std::size_t request_ind = 0; request_ind < requests.size(); ++request_ind)
+        {
+            Job job;
+            job.request = requests[request_ind];
+            job.request_ind = request_ind;
+            job.on_found = shared_on_found;
+            m_jobs.push_back(std::move(job));
+        }
+    }
+    m_job_added.notify_all();
+}
+
+//! \brief blocks until every submitted request is answered, then rethrows the first exception thrown while a request
+//! \brief submitted with a callback was answered
+void PathQueryService::wait()
+{
+    std::unique_lock lock(m_mutex);
+    m_all_done.wait(lock, [this]()
+                    { return m_jobs.empty() && m_n_running == 0; });
+    if (m_callback_error)
+    {
+        std::rethrow_exception(std::exchange(m_callback_error, nullptr));
+    }
+}
+
+void PathQueryService::workerLoop()
+{
+    PathFinder::SearchContext context;
+    std::unique_lock lock(m_mutex);
+    while (true)
+    {
+        m_job_added.wait(lock, [this]()
+                         { return m_is_stopping || !m_jobs.empty(); });
+        if (m_jobs.empty())
+        { //! stopping and nothing left to answer
+            return;
+        }
+        auto job = std::move(m_jobs.front());
+        m_jobs.pop_front();
+        m_n_running++;
+        lock.unlock();
+
+        const auto &[start, end, radius] = job.request;
+        std::exception_ptr callback_error;
+        if (job.on_found)
+        {
+            try
+            {
+                (*job.on_found)(job.request_ind, m_path_finder.doPathFinding(start, end, radius, context));
+            }
+            catch (...)
+            {
+                callback_error = std::current_exception();
+            }
+        }
+        else
+        {
+            try
+            {
+                job.result.set_value(m_path_finder.doPathFinding(start, end, radius, context));
+            }
+            catch (...)
+            {
+                job.result.set_exception(std::current_exception());
+            }
+        }
+
+        lock.lock();
+        if (callback_error && !m_callback_error)
+        {
+            m_callback_error = callback_error;
+        }
+        if (--m_n_running == 0 && m_jobs.empty())
+        {
+            m_all_done.notify_all();
+        }
+    }
+}
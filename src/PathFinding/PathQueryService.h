@@ -0,0 +1,74 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "PathFinder.h"
+
+//! \class answers path requests on a fixed set of worker threads sharing one PathFinder
+//! \brief every worker owns a PathFinder::SearchContext, so the path finder, its triangulation and the triangle widths
+//! \brief are only read and are shared by all workers. Neither of them may change while requests are pending: call
+//! \brief wait() before editing the triangulation or calling PathFinder::update()
+class PathQueryService
+{
+public:
+    //! \struct one path to find
+    struct Request
+    {
+        cdt::Vector2f start;
+        cdt::Vector2f end;
+        float radius = 0.f;
+    };
+
+    //! \brief called on a worker thread with the index of the request within its batch and the found path
+    using Callback = std::function<void(std::size_t request_ind, PathFinder::PathData &&path)>;
+
+public:
+    explicit PathQueryService(const PathFinder &path_finder,
+                              std::size_t n_threads = std::thread::hardware_concurrency());
+    ~PathQueryService();
+
+    PathQueryService(const PathQueryService &) = delete;
+    PathQueryService &operator=(const PathQueryService &) = delete;
+
+    std::size_t nThreads() const { return m_workers.size(); }
+
+    std::future<PathFinder::PathData> submit(const Request &request);
+    std::vector<std::future<PathFinder::PathData>> submit(std::span<const Request> requests);
+    void submit(std::span<const Request> requests, Callback on_found);
+
+    void wait();
+
+private:
+    //! \struct request waiting in the queue together with where its result goes
+    struct Job
+    {
+        Request request;
+        std::size_t request_ind = 0;
+        std::promise<PathFinder::PathData> result; //! used when on_found is empty
+        std::shared_ptr<const Callback> on_found;  //! shared by all jobs of a batch
+    };
+
+    void workerLoop();
+
+private:
+    const PathFinder &m_path_finder;
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_mutex; //! guards everything below
+    std::condition_variable m_job_added;
+    std::condition_variable m_all_done;
+    std::deque<Job> m_jobs;
+    std::size_t m_n_running = 0; //! jobs taken from m_jobs by workers and not finished yet
+    std::exception_ptr m_callback_error; //! first exception thrown while answering a request with a callback
+    bool m_is_stopping = false;
+};
@@ -1,463 +1,209 @@
 #include "ReducedTriangulationGraph.h"
 
-#include <iostream>
+#include <algorithm>
 
 using namespace cdt;
 
-//! \param funnel 
-//! \returns minimal width of a triangle inside a corridor 
-float ReducedTriangulationGraph::calcCorridorWidth(
-    const Funnel& funnel) const {
-    if (funnel.size() == 0) {
-        return MAXFLOAT;
+namespace {
+
+    bool canWalkThrough(const Triangle& tri, int ind_in_tri) {
+        return !tri.isConstrained(ind_in_tri) and tri.neighbours[ind_in_tri] != -1;
     }
 
-    float min_width = dist(funnel[0].first, funnel[0].second);
-    for (int i = 1; i < funnel.size(); ++i) {
-        const auto& l1 = funnel[i - 1].first;
-        const auto& r1 = funnel[i - 1].second;
-        const auto& l2 = funnel[i].first;
-        const auto& r2 = funnel[i].second;
+    int countWalkableEdges(const Triangle& tri) {
+        int n_walkable = 0;
+        for (int k = 0; k < 3; ++k) {
+            if (canWalkThrough(tri, k)) {
+                n_walkable += 1;
+            }
+        }
+        return n_walkable;
+    }
 
-        // Edgef left_segment(l1, l2);
-        // Edgef right_segment(r1, r2);
+} // namespace
 
-        // const auto new_width = distanceOfSegments(left_segment, right_segment);
-        // if (new_width < min_width) {
-        //     min_width = new_width;
-        // }
+//! \returns widest agent passing \p crossings from \p first_crossing to \p last_crossing when walking from start
+float ReducedTriangulationGraph::minWidthFromStart(std::span<const Crossing> crossings, int first_crossing,
+                                                   int last_crossing) {
+    float width = MAXFLOAT;
+    for (int crossing = first_crossing; crossing <= last_crossing; ++crossing) {
+        width = std::min(width, crossings[crossing].width_from_start);
     }
-    return min_width;
-}
-
-float ReducedTriangulationGraph::sign2(const cdt::Vector2f& p1, const cdt::Vector2f& p2, const cdt::Vector2f& p3) const {
-    return (p3.x - p1.x) * (p2.y - p1.y) - (p2.x - p1.x) * (p3.y - p1.y);
+    return width;
 }
 
-//! \brief computes path distance within triangles funnel using \p funnel_data  
-//! \param r_start
-//! \param r_end
-//! \param funnel
-//! \param cdt Triangulation object (is this really needed here?)
-//! \returns distance of the shortes path within given funnel
-float ReducedTriangulationGraph::funnelDistance(const cdt::Vector2f r_start, const cdt::Vector2f r_end, Funnel& funnel,
-                                                const Triangulation& cdt) const {
-
-    std::deque<cdt::Vector2f> smoothed_path = {r_start};
-
-    cdt::Vector2f right;
-    cdt::Vector2f left;
-    cdt::Vector2f portal_apex = r_start;
-    cdt::Vector2f portal_right = r_start;
-    cdt::Vector2f portal_left = r_start;
-
-    int right_index = 0;
-    int left_index = 0;
-    int apex_index = 0;
-    for (int i = 1; i < funnel.size(); ++i) {
-
-        right = funnel[i].first;
-        left = funnel[i].second;
-
-        if (sign2(portal_apex, portal_right, right) >= 0.f) { //! if the portal shrank from right
-            bool is_same_point = vequal(portal_apex, portal_right);
-            if (is_same_point or sign2(portal_apex, portal_left, right) <
-                                     0.f) { //! if the new right segment of the portal crosses the left segment
-                portal_right = right;
-                right_index = i;
-            } else {
-                smoothed_path.push_back(portal_left);
-                portal_apex = portal_left;
-                apex_index = left_index;
-                portal_right = portal_apex;
-                right_index = apex_index;
-                i = left_index;
-                continue;
-            }
-        }
-        if (sign2(portal_apex, portal_left, left) <= 0.f) { //! same as above but we move left portal segment
-            bool is_same_point = vequal(portal_apex, portal_left);
-            if (is_same_point or sign2(portal_apex, portal_right, left) > 0.f) {
-                portal_left = left;
-                left_index = i;
-            } else {
-                smoothed_path.push_back(portal_right);
-                portal_apex = portal_right;
-                apex_index = right_index;
-                portal_left = portal_apex;
-                left_index = apex_index;
-                i = right_index;
-                continue;
-            }
-        }
-    }
-    smoothed_path.push_back(r_end);
-    float distance = 0;
-    for (int i = 0; i < smoothed_path.size() - 1; ++i) {
-        distance += dist(smoothed_path[i], smoothed_path[i + 1]);
+//! \returns widest agent passing \p crossings from \p last_crossing down to \p first_crossing when walking from end
+float ReducedTriangulationGraph::minWidthFromEnd(std::span<const Crossing> crossings, int first_crossing,
+                                                 int last_crossing) {
+    float width = MAXFLOAT;
+    for (int crossing = first_crossing; crossing <= last_crossing; ++crossing) {
+        width = std::min(width, crossings[crossing].width_from_end);
     }
-    return distance;
+    return width;
 }
 
-//! \brief constructs reduced triangulation graph from full triangulation 
-//! \brief also assings graph-component to each triangle ind and writes it to \p tri_ind2component  
-//! \param cdt full triangulation object
-//! \param tri_ind2component  
-void ReducedTriangulationGraph::constructFromTriangulation(Triangulation& cdt, std::vector<TriInd>& tri_ind2component) {
+int ReducedTriangulationGraph::addVertex(TriInd tri_ind) {
+    const int vertex = vertex2tri_ind.size();
+    tri_ind2vertex[tri_ind] = vertex;
+    vertex2tri_ind.push_back(tri_ind);
+    reduced_vertices.emplace_back();
+    vertex2edge_inds2.push_back({-1, -1, -1});
+    visited.push_back({false, false, false});
+    return vertex;
+}
 
+//! \brief walks from \p vertex through its edge \p ind_in_tri until the next vertex and stores the corridor in between
+//! \param widths of the triangle edges, 3 per triangle
+void ReducedTriangulationGraph::traceCorridor(const Triangulation& cdt, std::span<const float> widths, int vertex,
+                                              int ind_in_tri) {
     const auto& triangles = cdt.m_triangles;
-    const auto& vertices = cdt.m_vertices;
-    tri_ind2vertex.resize(triangles.size());
-    vertex2tri_ind.clear();
-    vertex2edge_inds2.clear();
-    edges.clear();
-
-
-    auto count_free_edges = [](const Triangle& tri) {
-        int n_free_edges = 0;
+    const int edge_ind = edges.size();
+    const auto entry_tri_ind = vertex2tri_ind[vertex];
+
+    Corridor e;
+    e.start = {entry_tri_ind, ind_in_tri};
+    e.first_tri = corridor_tri_inds.size();
+    e.first_crossing = corridor_crossings.size();
+    Crossing crossing;
+    crossing.width_from_start = widths[3 * entry_tri_ind + ind_in_tri];
+
+    auto prev_tri_ind_corridor = entry_tri_ind;
+    auto tri_ind_corridor = triangles[entry_tri_ind].neighbours[ind_in_tri];
+    auto prev_center = cdt.getCenter(entry_tri_ind);
+    float length = 0;
+    while (tri_ind2vertex[tri_ind_corridor] == -1) { //! we walk along the corridor until the next crossroads or dead-end
+        const auto& tri = triangles[tri_ind_corridor];
+        const auto center = cdt.getCenter(tri);
+        length += dist(prev_center, center);
+        prev_center = center;
+
+        const int back_ind_in_tri = indInTriOf(tri, prev_tri_ind_corridor);
+        int ind_in_tri_corridor = -1;
         for (int k = 0; k < 3; ++k) {
-            if (!tri.is_constrained[k]) {
-                n_free_edges += 1;
+            if (k != back_ind_in_tri and canWalkThrough(tri, k)) {
+                ind_in_tri_corridor = k;
             }
         }
-        return n_free_edges;
-    };
-
-    auto can_walk_through = [](const Triangle& tri, int ind_in_tri) {
-        return !tri.is_constrained[ind_in_tri] and tri.neighbours[ind_in_tri] != -1;
-    };
-
-    tri_ind2component.resize(triangles.size());
-    std::cout << "there are " << std::to_string(triangles.size()) << " in triangulation\n";
-
-    std::vector<bool> visited_tris(triangles.size(), false);
-    int component_ind = 0;
-    auto flood = [&](const TriInd tri_ind) {
-        if (visited_tris[tri_ind]) {
-            return;
-        }
-        std::queue<TriInd> to_visit({tri_ind});
+        assert(ind_in_tri_corridor != -1);
 
-        while (!to_visit.empty()) {
-            const auto entry_tri_ind = to_visit.front();
-            const auto& entry_tri = triangles[entry_tri_ind];
-            to_visit.pop();
-            if (visited_tris[entry_tri_ind]) {
-                continue;
-            }
-            visited_tris[entry_tri_ind] = true;
-            tri_ind2component[entry_tri_ind] = component_ind;
-            for (int k = 0; k < 3; ++k) {
-                if (can_walk_through(entry_tri, k)) {
-                    to_visit.push(entry_tri.neighbours[k]);
-                }
-            }
-        }
-        component_ind++;
-    };
+        tri_ind2corridor[tri_ind_corridor] = {edge_ind, static_cast<int>(e.n_tris)};
+        corridor_tri_inds.push_back(tri_ind_corridor);
+        e.n_tris++;
+        crossing.length = length;
+        crossing.width_from_end = widths[3 * tri_ind_corridor + back_ind_in_tri];
+        corridor_crossings.push_back(crossing);
+        crossing.width_from_start = widths[3 * tri_ind_corridor + ind_in_tri_corridor];
 
-    std::queue<TriPathData> to_visit;
-    //! we want to start from all crossroads
-    int edge_ind = 0;
-    int n_vertices = 0;
-    for (TriInd tri_ind = 0; tri_ind < triangles.size(); ++tri_ind) {
-        flood(tri_ind);
-        const auto& tri = triangles[tri_ind];
-        const auto n_free_edges = count_free_edges(tri);
-        if (n_free_edges != 2) { //! crossroads or dead end within boundaries
-            for (int ind_in_tri = 0; ind_in_tri < 3; ++ind_in_tri) {
-                if (can_walk_through(tri, ind_in_tri)) {
-                    to_visit.push({tri_ind, ind_in_tri});
-                }
-            }
-            tri_ind2vertex[tri_ind] = n_vertices;
-            vertex2tri_ind.push_back(tri_ind);
-            n_vertices += 1;
-            //                }
-        }
+        prev_tri_ind_corridor = tri_ind_corridor;
+        tri_ind_corridor = tri.neighbours[ind_in_tri_corridor];
     }
-    vertex2edge_inds2.resize(n_vertices);
-    visited.resize(n_vertices, std::array<bool, 3>({false, false, false}));
-
-
-    int tri_ind_corridor;
-    int prev_tri_ind_corridor;
-    int ind_in_tri_corridor;
-    while (!to_visit.empty()) {
-        const auto entry_tri_ind = to_visit.front().current;
-        const auto entry_ind_in_tri = to_visit.front().to;
-        to_visit.pop();
-        const auto& entry_tri = triangles[entry_tri_ind];
-
-        assert(tri_ind2vertex[entry_tri_ind] >= 0 and tri_ind2vertex[entry_tri_ind] < n_vertices);
-        if (visited[tri_ind2vertex[entry_tri_ind]][entry_ind_in_tri]) { //! no visiting more than once and no buildings
-            continue;
-        }
 
-        visited[tri_ind2vertex[entry_tri_ind]][entry_ind_in_tri] = true;
-        tri_ind_corridor = entry_tri.neighbours[entry_ind_in_tri];
-        prev_tri_ind_corridor = entry_tri_ind;
-        ind_in_tri_corridor = entry_ind_in_tri;
-
-        int n_free = 0;
-        Corridor e;
-        Funnel funnel;
-        const auto left_start = asFloat(entry_tri.verts[next(entry_ind_in_tri)]);
-        const auto right_start = asFloat(entry_tri.verts[entry_ind_in_tri]);
-        const auto r_start = (right_start + left_start) / 2.f;
-        funnel.push_back({right_start, left_start});
-
-        e.start = {entry_tri_ind, entry_ind_in_tri};
-        while (tri_ind_corridor !=
-               entry_tri_ind) { //! we walk along the corridor until either end, dead-end or next crossroads
-            const auto& tri = triangles[tri_ind_corridor];
-
-            n_free = 0;
-            for (int k = 0; k < 3; ++k) {
-                if (!tri.is_constrained[k] and tri.neighbours[k] != prev_tri_ind_corridor) {
-                    n_free++;
-                    ind_in_tri_corridor = k;
-                }
-            }
-            if (n_free == 2 or n_free == 0) {
-                break;
-            }
-            e.tri_inds.push_back(tri_ind_corridor);
-            e.from_start.push_back(ind_in_tri_corridor);
-            tri_ind2vertex[tri_ind_corridor] = edge_ind;
-
-            auto left_vertex_of_portal = asFloat(tri.verts[next(ind_in_tri_corridor)]);
-            auto right_vertex_of_portal = asFloat(tri.verts[ind_in_tri_corridor]);
-
-            prev_tri_ind_corridor = tri_ind_corridor;
-            tri_ind_corridor = tri.neighbours[ind_in_tri_corridor];
-
-            funnel.emplace_back(right_vertex_of_portal, left_vertex_of_portal);
-            //                funnel_vertex_inds.emplace_back(right_index, left_index);
-        }
-
-        auto& end_tri_ind = tri_ind_corridor;
-        auto& end_tri = triangles[end_tri_ind];
-        int ind_in_tri_from_end = indInTriOf(end_tri, prev_tri_ind_corridor);
-        e.end = {static_cast<TriInd>(end_tri_ind), ind_in_tri_from_end};
-
-        if (e.tri_inds.size() > 0) {
-            const auto& tri = triangles[e.tri_inds.front()];
-            e.from_end.push_back(indInTriOf(tri, entry_tri_ind));
-        }
-        for (int i = 1; i < e.tri_inds.size(); i++) {
-            const auto& tri = triangles.at(e.tri_inds[i]);
-            e.from_end.push_back(indInTriOf(tri, e.tri_inds[i - 1]));
-        }
-
-        //            left_index = end_tri.vertinds[ind_in_tri_from_end];
-        //            right_index = end_tri.vertinds[next(ind_in_tri_from_end)];
-        const auto right_end = asFloat(end_tri.verts[next(ind_in_tri_from_end)]);
-        const auto left_end = asFloat(end_tri.verts[ind_in_tri_from_end]);
-        const auto r_end = (right_end + left_end) / 2.f;
-
-        funnel.push_back({right_end, left_end});
-        e.corridor_points = funnel;
-        e.width = calcCorridorWidth(funnel);
-
-        funnel.front() = {r_start, r_start};
-        funnel.back() = {r_end, r_end};
-        e.length = funnelDistance(r_start, r_end, funnel, cdt);
-
-        vertex2edge_inds2[tri_ind2vertex[end_tri_ind]][ind_in_tri_from_end] = edge_ind;
-        vertex2edge_inds2[tri_ind2vertex[entry_tri_ind]][entry_ind_in_tri] = edge_ind;
-        visited[tri_ind2vertex[end_tri_ind]][ind_in_tri_from_end] = true;
-        visited[tri_ind2vertex[entry_tri_ind]][entry_ind_in_tri] = true;
-
-        //            cdt.renumber(end_tri, end_tri_ind, entry_tri, entry_tri_ind);
-
-        edges.push_back(e);
-
-        edge_ind++;
-    }
+    const auto end_tri_ind = tri_ind_corridor;
+    const int ind_in_tri_from_end = indInTriOf(triangles[end_tri_ind], prev_tri_ind_corridor);
+    length += dist(prev_center, cdt.getCenter(end_tri_ind));
+    e.end = {end_tri_ind, ind_in_tri_from_end};
+    crossing.length = length;
+    crossing.width_from_end = widths[3 * end_tri_ind + ind_in_tri_from_end];
+    corridor_crossings.push_back(crossing);
+    e.length = length;
+
+    const auto crossings = crossingsOf(e);
+    const auto width_from_start = minWidthFromStart(crossings, 0, e.n_tris);
+    const auto width_from_end = minWidthFromEnd(crossings, 0, e.n_tris);
+    e.width = std::min(width_from_start, width_from_end);
+
+    const auto end_vertex = tri_ind2vertex[end_tri_ind];
+    reduced_vertices[end_vertex].neighbours[ind_in_tri_from_end] = vertex;
+    reduced_vertices[end_vertex].widths[ind_in_tri_from_end] = width_from_end;
+    reduced_vertices[end_vertex].lengths[ind_in_tri_from_end] = length;
+
+    reduced_vertices[vertex].neighbours[ind_in_tri] = end_vertex;
+    reduced_vertices[vertex].widths[ind_in_tri] = width_from_start;
+    reduced_vertices[vertex].lengths[ind_in_tri] = length;
+
+    vertex2edge_inds2[end_vertex][ind_in_tri_from_end] = edge_ind;
+    vertex2edge_inds2[vertex][ind_in_tri] = edge_ind;
+    visited[end_vertex][ind_in_tri_from_end] = true;
+    visited[vertex][ind_in_tri] = true;
+
+    edges.push_back(e);
 }
 
-//! \brief constructs reduced triangulation graph from full triangulation 
-//! \brief also assings graph-component to each triangle ind and writes it to \p tri_ind2component  
+//! \brief constructs reduced triangulation graph from full triangulation
+//! \brief also assings graph-component to each triangle ind and writes it to \p tri_ind2component
 //! \param cdt full triangulation object
-//! \param tri_ind2component  
-void ReducedTriangulationGraph::constructFromTriangulationCenters(Triangulation& cdt,
-                                                                  std::vector<TriInd>& tri_ind2component) {
+//! \param widths of the triangle edges as computed by PathFinder, 3 per triangle
+//! \param tri_ind2component
+void ReducedTriangulationGraph::constructFromTriangulation(const Triangulation& cdt, std::span<const float> widths,
+                                                           std::vector<TriInd>& tri_ind2component) {
 
     const auto& triangles = cdt.m_triangles;
-    const auto& vertices = cdt.m_vertices;
-    tri_ind2vertex.resize(triangles.size());
+    assert(widths.size() == 3 * triangles.size());
+    tri_ind2vertex.assign(triangles.size(), -1);
+    tri_ind2corridor.assign(triangles.size(), {});
     vertex2tri_ind.clear();
     reduced_vertices.clear();
     vertex2edge_inds2.clear();
+    visited.clear();
     edges.clear();
-
-    auto count_free_edges = [](const Triangle& tri) {
-        int n_free_edges = 0;
-        for (int k = 0; k < 3; ++k) {
-            if (!tri.is_constrained[k]) {
-                n_free_edges += 1;
-            }
-        }
-        return n_free_edges;
-    };
-
-    auto can_walk_through = [](const Triangle& tri, int ind_in_tri) {
-        return !tri.is_constrained[ind_in_tri] and tri.neighbours[ind_in_tri] != -1;
-    };
+    corridor_tri_inds.clear();
+    corridor_crossings.clear();
+    corridor_tri_inds.reserve(triangles.size());
 
     tri_ind2component.resize(triangles.size());
-    // std::cout << "there are " << std::to_string(triangles.size()) << " in triangulation\n";
 
     std::vector<bool> visited_tris(triangles.size(), false);
+    std::vector<TriInd> to_visit;
     int component_ind = 0;
     auto flood = [&](const TriInd tri_ind) {
         if (visited_tris[tri_ind]) {
             return;
         }
-        std::queue<TriInd> to_visit({tri_ind});
+        to_visit.push_back(tri_ind);
 
         while (!to_visit.empty()) {
-            const auto entry_tri_ind = to_visit.front();
+            const auto entry_tri_ind = to_visit.back();
             const auto& entry_tri = triangles[entry_tri_ind];
-            to_visit.pop();
+            to_visit.pop_back();
             if (visited_tris[entry_tri_ind]) {
                 continue;
             }
             visited_tris[entry_tri_ind] = true;
             tri_ind2component[entry_tri_ind] = component_ind;
             for (int k = 0; k < 3; ++k) {
-                if (can_walk_through(entry_tri, k)) {
-                    to_visit.push(entry_tri.neighbours[k]);
+                if (canWalkThrough(entry_tri, k)) {
+                    to_visit.push_back(entry_tri.neighbours[k]);
                 }
             }
         }
         component_ind++;
     };
 
-    std::queue<TriPathData> to_visit;
-    //! we want to start from all crossroads
-    int edge_ind = 0;
-    int n_vertices = 0;
+    //! we want to start from all crossroads and dead ends
     for (TriInd tri_ind = 0; tri_ind < triangles.size(); ++tri_ind) {
         flood(tri_ind);
-        const auto& tri = triangles[tri_ind];
-        const auto n_free_edges = count_free_edges(tri);
-        if (n_free_edges != 2) { //! crossroads or dead end within boundaries
-            for (int ind_in_tri = 0; ind_in_tri < 3; ++ind_in_tri) {
-                if (can_walk_through(tri, ind_in_tri)) {
-                    to_visit.push({tri_ind, ind_in_tri});
-                }
-            }
-            tri_ind2vertex[tri_ind] = n_vertices;
-            vertex2tri_ind.push_back(tri_ind);
-            n_vertices += 1;
+        if (countWalkableEdges(triangles[tri_ind]) != 2) {
+            addVertex(tri_ind);
         }
     }
-    vertex2edge_inds2.resize(n_vertices);
-    reduced_vertices.resize(n_vertices);
-    visited.resize(n_vertices); //! not sure why I can't initialize in .resize  but it does not work :D
-    std::fill(visited.begin(), visited.end(), std::array<bool, 3>({false, false, false}));
-
-    int tri_ind_corridor;
-    int prev_tri_ind_corridor;
-    int ind_in_tri_corridor;
-    while (!to_visit.empty()) {
-        const auto entry_tri_ind = to_visit.front().current;
-        const auto entry_ind_in_tri = to_visit.front().to;
-        to_visit.pop();
-        const auto& entry_tri = triangles[entry_tri_ind];
-
-        assert(tri_ind2vertex[entry_tri_ind] >= 0 and tri_ind2vertex[entry_tri_ind] < n_vertices);
-        if (visited[tri_ind2vertex[entry_tri_ind]][entry_ind_in_tri]) { //! no visiting more than once and no buildings
-            continue;
-        }
-
-        visited[tri_ind2vertex[entry_tri_ind]][entry_ind_in_tri] = true;
-        tri_ind_corridor = entry_tri.neighbours[entry_ind_in_tri];
-        prev_tri_ind_corridor = entry_tri_ind;
-        ind_in_tri_corridor = entry_ind_in_tri;
-
-        int n_free = 0;
-        Corridor e;
-        Funnel funnel;
-        const auto left_start = asFloat(entry_tri.verts[next(entry_ind_in_tri)]);
-        const auto right_start = asFloat(entry_tri.verts[entry_ind_in_tri]);
-        const auto r_start = asFloat(entry_tri.verts[0] + entry_tri.verts[1] + entry_tri.verts[2])/3.f;
-        funnel.push_back({right_start, left_start});
-
-        e.start = {entry_tri_ind, entry_ind_in_tri};
-        while (tri_ind_corridor !=
-               entry_tri_ind) { //! we walk along the corridor until either end, dead-end or next crossroads
-            const auto& tri = triangles[tri_ind_corridor];
 
-            n_free = 0;
-            for (int k = 0; k < 3; ++k) {
-                if (!tri.is_constrained[k] and tri.neighbours[k] != prev_tri_ind_corridor) {
-                    n_free++;
-                    ind_in_tri_corridor = k;
-                }
+    auto trace_from = [&](int vertex) {
+        const auto& tri = triangles[vertex2tri_ind[vertex]];
+        for (int ind_in_tri = 0; ind_in_tri < 3; ++ind_in_tri) {
+            if (canWalkThrough(tri, ind_in_tri) and !visited[vertex][ind_in_tri]) {
+                traceCorridor(cdt, widths, vertex, ind_in_tri);
             }
-            if (n_free == 2 or n_free == 0) {
-                break;
-            }
-            e.tri_inds.push_back(tri_ind_corridor);
-            e.from_start.push_back(ind_in_tri_corridor);
-            tri_ind2vertex[tri_ind_corridor] = edge_ind;
-
-            auto left_vertex_of_portal = asFloat(tri.verts[next(ind_in_tri_corridor)]);
-            auto right_vertex_of_portal = asFloat(tri.verts[ind_in_tri_corridor]);
-
-            prev_tri_ind_corridor = tri_ind_corridor;
-            tri_ind_corridor = tri.neighbours[ind_in_tri_corridor];
-
-            funnel.emplace_back(right_vertex_of_portal, left_vertex_of_portal);
         }
+    };
+    const int n_vertices = vertex2tri_ind.size();
+    for (int vertex = 0; vertex < n_vertices; ++vertex) {
+        trace_from(vertex);
+    }
 
-        auto& end_tri_ind = tri_ind_corridor;
-        auto& end_tri = triangles[end_tri_ind];
-        int ind_in_tri_from_end = indInTriOf(end_tri, prev_tri_ind_corridor);
-        e.end = {static_cast<TriInd>(end_tri_ind), ind_in_tri_from_end};
-
-        if (e.tri_inds.size() > 0) {
-            const auto& tri = triangles[e.tri_inds.front()];
-            e.from_end.push_back(indInTriOf(tri, entry_tri_ind));
-        }
-        for (int i = 1; i < e.tri_inds.size(); i++) {
-            const auto& tri = triangles.at(e.tri_inds[i]);
-            e.from_end.push_back(indInTriOf(tri, e.tri_inds[i - 1]));
+    //! what is left are loops of corridor triangles around an obstacle, each gets one vertex
+    for (TriInd tri_ind = 0; tri_ind < triangles.size(); ++tri_ind) {
+        if (tri_ind2vertex[tri_ind] == -1 and tri_ind2corridor[tri_ind].corridor == -1) {
+            trace_from(addVertex(tri_ind));
         }
-
-        const auto right_end = asFloat(end_tri.verts[next(ind_in_tri_from_end)]);
-        const auto left_end = asFloat(end_tri.verts[ind_in_tri_from_end]);
-        const auto r_end =  asFloat(end_tri.verts[0] + end_tri.verts[1] + end_tri.verts[2])/3.f;
-
-        funnel.push_back({right_end, left_end});
-        //            funnel_vertex_inds.push_back({-1, -1});
-        e.width = calcCorridorWidth(funnel);
-        funnel.front() = {r_start, r_start};
-        funnel.back() = {r_end, r_end};
-
-        e.length = funnelDistance(r_start, r_end, funnel, cdt);
-
-        reduced_vertices[tri_ind2vertex[end_tri_ind]].neighbours[ind_in_tri_from_end] = tri_ind2vertex[entry_tri_ind];
-        reduced_vertices[tri_ind2vertex[end_tri_ind]].widths[ind_in_tri_from_end] = e.width;
-        reduced_vertices[tri_ind2vertex[end_tri_ind]].lengths[ind_in_tri_from_end] = e.length;
-
-        reduced_vertices[tri_ind2vertex[entry_tri_ind]].neighbours[entry_ind_in_tri] = tri_ind2vertex[end_tri_ind];
-        reduced_vertices[tri_ind2vertex[entry_tri_ind]].widths[entry_ind_in_tri] = e.width;
-        reduced_vertices[tri_ind2vertex[entry_tri_ind]].lengths[entry_ind_in_tri] = e.length;
-
-        vertex2edge_inds2[tri_ind2vertex[end_tri_ind]][ind_in_tri_from_end] = edge_ind;
-        vertex2edge_inds2[tri_ind2vertex[entry_tri_ind]][entry_ind_in_tri] = edge_ind;
-        visited[tri_ind2vertex[end_tri_ind]][ind_in_tri_from_end] = true;
-        visited[tri_ind2vertex[entry_tri_ind]][entry_ind_in_tri] = true;
-
-        //            cdt.renumber(end_tri, end_tri_ind, entry_tri, entry_tri_ind);
-
-        edges.push_back(e);
-
-        edge_ind++;
     }
-    
-}
\ No newline at end of file
+}
@@ -1,6 +1,7 @@
 #pragma once
 
-#include <queue>
+#include <deque>
+#include <span>
 
 #include "../core.h"
 #include "../Triangulation.h"
@@ -18,56 +19,83 @@ typedef std::deque<Portal> Funnel;
 
 
 //! \struct data  held at a vertex in a reduced triangulation graph
+//! \brief index k belongs to the corridor leaving the vertex triangle through its edge k
 struct ReducedVertex {
-    std::array<float, 3> widths = {MAXFLOAT, MAXFLOAT, MAXFLOAT};
+    std::array<float, 3> widths = {MAXFLOAT, MAXFLOAT, MAXFLOAT}; //! widest agent walking the corridor from here
     std::array<float, 3> lengths = {0, 0, 0};
-    std::array<int, 3> neighbours = {-1, -1, -1};
+    std::array<int, 3> neighbours = {-1, -1, -1}; //! reduced vertex at the other end of the corridor
 };
 
-//! \class reduced version of full triangulation graph where we store only edges of crossroad triangles as graph vertices.
-//! \class distances between vertices are calculated using paths from funnel algorithm connecting midpoints of the
-//! \class crossroads edges through triangle corridors. \class triangles with only one uncostrained edge (dead ends) are also
-//! \class  considered vertices;
+//! \class reduced version of full triangulation graph where we store only crossroad triangles (three walkable edges)
+//! \class and dead ends (at most one walkable edge) as graph vertices. Vertices are connected by corridors: chains of
+//! \class triangles with exactly two walkable edges. Lengths of corridors are sums of distances between centers of
+//! \class their triangles, so A* on the reduced graph finds the same paths as A* on all triangles. Corridors forming
+//! \class a loop without any crossroad get one of their triangles promoted to a vertex
 struct ReducedTriangulationGraph {
 
     using TriInd = cdt::TriInd;
-    using Triangulation = cdt::Triangulation<cdt::Triangle>;
+    using Triangulation = cdt::Triangulation<cdt::Vector2i>;
 
-    std::vector<int> tri_ind2vertex;
+    //! \struct position of a corridor triangle within its corridor
+    struct CorridorPlace {
+        int corridor = -1; //! -1 for triangles which are reduced vertices
+        int position = 0;  //! index into Corridor::tri_inds
+    };
+
+    std::vector<int> tri_ind2vertex; //! -1 for corridor triangles
+    std::vector<CorridorPlace> tri_ind2corridor;
     std::vector<TriInd> vertex2tri_ind;
     std::vector<ReducedVertex> reduced_vertices;
-    std::vector<std::array<int, 3>> vertex2edge_inds2;
+    std::vector<std::array<int, 3>> vertex2edge_inds2; //! corridor leaving the vertex through edge k, -1 if there is none
 
     struct TriPathData {
         TriInd current;
         int to;
     };
 
+    //! \struct step of a corridor from one of its triangles into the next one
+    struct Crossing {
+        float length = 0;                  //! distance from the center of start to the center of the entered triangle
+        float width_from_start = MAXFLOAT; //! width of the crossed edge measured in the triangle before it
+        float width_from_end = MAXFLOAT;   //! width of the crossed edge measured in the triangle after it
+    };
+
+    //! \struct walk from the vertex triangle start.current through its edge start.to to the vertex triangle end.current
+    //! \brief which it enters through its edge end.to. Its triangles and crossings are stored in corridor_tri_inds and
+    //! \brief corridor_crossings, crossing i enters triangle i (the end triangle for the last one)
     struct Corridor {
         TriPathData start;
         TriPathData end;
 
         float length = 0;
-        float width = MAXFLOAT;
+        float width = MAXFLOAT; //! narrower of the widths of both directions
 
-        std::vector<TriInd> tri_inds;
-        std::vector<int> from_start;
-        std::vector<int> from_end;
-        Funnel corridor_points;
+        std::size_t first_tri = 0;
+        std::size_t n_tris = 0;
+        std::size_t first_crossing = 0; //! there are n_tris + 1 crossings
 
         Corridor() = default;
     };
     std::vector<Corridor> edges;
+    std::vector<TriInd> corridor_tri_inds;
+    std::vector<Crossing> corridor_crossings;
+
+    std::span<const TriInd> trianglesOf(const Corridor& corridor) const {
+        return {corridor_tri_inds.data() + corridor.first_tri, corridor.n_tris};
+    }
+    std::span<const Crossing> crossingsOf(const Corridor& corridor) const {
+        return {corridor_crossings.data() + corridor.first_crossing, corridor.n_tris + 1};
+    }
+    static float minWidthFromStart(std::span<const Crossing> crossings, int first_crossing, int last_crossing);
+    static float minWidthFromEnd(std::span<const Crossing> crossings, int first_crossing, int last_crossing);
 
   private:
     std::vector<std::array<bool, 3>> visited;
 
-    float sign2(const cdt::Vector2f& p1, const cdt::Vector2f& p2, const cdt::Vector2f& p3) const;
-    float calcCorridorWidth(const Funnel& funnel) const;
+    void traceCorridor(const Triangulation& cdt, std::span<const float> widths, int vertex, int ind_in_tri);
+    int addVertex(TriInd tri_ind);
 
   public:
-    float funnelDistance(const cdt::Vector2f r_start, const cdt::Vector2f r_end, Funnel& fd,
-                         const Triangulation& cdt) const;
-    void constructFromTriangulation(Triangulation& cdt, std::vector<TriInd>& tri_ind2component);
-    void constructFromTriangulationCenters(Triangulation& cdt, std::vector<TriInd>& tri_ind2component);
+    void constructFromTriangulation(const Triangulation& cdt, std::span<const float> widths,
+                                    std::vector<TriInd>& tri_ind2component);
 };
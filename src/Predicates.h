@@ -0,0 +1,219 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+namespace cdt
+{
+
+    //! \brief exact geometric predicates. Integer coordinates are evaluated in integer arithmetic, the others
+    //! \brief first by a floating point filter and only if its result is too close to zero by exact expansions
+
+    namespace detail
+    {
+        template <class VecType>
+        constexpr bool has_integral_coords = std::is_integral_v<std::remove_cvref_t<decltype(VecType::x)>>;
+
+        constexpr double epsilon = 0x1p-53; //! half of the distance between 1 and the next double
+        constexpr double orientation_error_bound = (3. + 16. * epsilon) * epsilon;
+        constexpr double in_circle_error_bound = (10. + 96. * epsilon) * epsilon;
+
+        //! \brief sum of two doubles as a nonoverlapping pair \p sum + \p error
+        inline void twoSum(double a, double b, double &sum, double &error)
+        {
+            sum = a + b;
+            const double b_virtual = sum - a;
+            const double a_virtual = sum - b_virtual;
+            error = (a - a_virtual) + (b - b_virtual);
+        }
+
+        //! \struct exact sum of a few doubles stored as nonoverlapping components of increasing magnitude
+        template <int N>
+        struct Expansion
+        {
+            std::array<double, N> components{};
+            int size = 0;
+
+            //! \brief adds exact product of \p a and \p b to the sum
+            void addProduct(double a, double b)
+            {
+                const double product = a * b;
+                add(product);
+                add(std::fma(a, b, -product));
+            }
+
+            void add(double b)
+            {
+                for (int i = 0; i < size; ++i)
+                {
+                    twoSum(b, components[i], b, components[i]);
+                }
+                components[size++] = b;
+            }
+
+            //! \returns sign of the sum which is the sign of its largest nonzero component
+            int sign() const
+            {
+                for (int i = size - 1; i >= 0; --i)
+                {
+                    if (components[i] != 0.)
+                    {
+                        return components[i] > 0. ? 1 : -1;
+                    }
+                }
+                return 0;
+            }
+        };
+
+        //! \struct signed 128 bit integer wide enough for the exact product of two 64 bit integers
+        //! \brief ISO C++ has no such type, so it is kept in two's complement as two 64 bit halves
+        struct Int128
+        {
+            std::uint64_t low = 0;
+            std::uint64_t high = 0;
+
+            //! \returns exact product of \p a and \p b
+            static Int128 product(std::int64_t a, std::int64_t b)
+            {
+                const std::uint64_t a_abs = a < 0 ? 0 - static_cast<std::uint64_t>(a) : a;
+                const std::uint64_t b_abs = b < 0 ? 0 - static_cast<std::uint64_t>(b) : b;
+                const std::uint64_t a_low = a_abs & 0xffffffffu, a_high = a_abs >> 32;
+                const std::uint64_t b_low = b_abs & 0xffffffffu, b_high = b_abs >> 32;
+                const std::uint64_t low_low = a_low * b_low;
+                const std::uint64_t low_high = a_low * b_high;
+                const std::uint64_t high_low = a_high * b_low;
+                //! sum of the middle 32 bit words and the carry from the lowest word, it fits into 64 bits
+                const std::uint64_t middle = (low_low >> 32) + (low_high & 0xffffffffu) + (high_low & 0xffffffffu);
+
+                Int128 result;
+                result.low = (middle << 32) | (low_low & 0xffffffffu);
+                result.high = a_high * b_high + (low_high >> 32) + (high_low >> 32) + (middle >> 32);
+                return (a < 0) != (b < 0) ? -result : result;
+            }
+
+            Int128 operator-() const
+            {
+                Int128 result;
+                result.low = 0 - low;
+                result.high = ~high + (low == 0);
+                return result;
+            }
+            Int128 operator+(const Int128 &other) const
+            {
+                Int128 result;
+                result.low = low + other.low;
+                result.high = high + other.high + (result.low < low);
+                return result;
+            }
+            Int128 operator-(const Int128 &other) const { return *this + -other; }
+            //! \brief valid as long as the difference of the two fits, which holds for products of 64 bit integers
+            bool operator<(const Int128 &other) const { return (*this - other).sign() < 0; }
+
+            int sign() const
+            {
+                if (static_cast<std::int64_t>(high) != 0)
+                {
+                    return static_cast<std::int64_t>(high) > 0 ? 1 : -1;
+                }
+                return low != 0 ? 1 : 0;
+            }
+        };
+
+        template <class V1, class V2, class V3>
+        int orientationExact(const V1 &a, const V2 &b, const V3 &c)
+        {
+            //! (a - c) x (b - c) expanded into products of coordinates, which are exact as a pair of doubles
+            Expansion<12> det;
+            det.addProduct(a.x, b.y);
+            det.addProduct(-static_cast<double>(a.y), b.x);
+            det.addProduct(b.x, c.y);
+            det.addProduct(-static_cast<double>(b.y), c.x);
+            det.addProduct(c.x, a.y);
+            det.addProduct(-static_cast<double>(c.y), a.x);
+            return det.sign();
+        }
+    } // namespace detail
+
+    //! \returns 1 if \p a, \p b, \p c turn counterclockwise, -1 if clockwise and 0 if they are collinear
+    //! \brief the orientation is taken in a coordinate system with y going up (the same as cdt::orient)
+    //! \brief integer coordinates are handled exactly as long as their differences stay below 2^31
+    template <class V1, class V2, class V3>
+    inline int orientation(const V1 &a, const V2 &b, const V3 &c)
+    {
+        if constexpr (detail::has_integral_coords<V1> && detail::has_integral_coords<V2> &&
+                      detail::has_integral_coords<V3>)
+        {
+            const long long det = (static_cast<long long>(b.x) - a.x) * (static_cast<long long>(c.y) - a.y) -
+                                  (static_cast<long long>(b.y) - a.y) * (static_cast<long long>(c.x) - a.x);
+            return (det > 0) - (det < 0);
+        }
+        else
+        {
+            const double det_left = (static_cast<double>(a.x) - c.x) * (static_cast<double>(b.y) - c.y);
+            const double det_right = (static_cast<double>(a.y) - c.y) * (static_cast<double>(b.x) - c.x);
+            const double det = det_left - det_right;
+            const double error_bound = detail::orientation_error_bound * (std::abs(det_left) + std::abs(det_right));
+            if (det > error_bound || -det > error_bound)
+            {
+                return det > 0. ? 1 : -1;
+            }
+            return detail::orientationExact(a, b, c);
+        }
+    }
+
+    //! \returns 1 if \p d lies inside of the circle going through \p a, \p b, \p c, -1 if it lies outside and
+    //! \returns 0 if all four are cocircular. Inside and outside swap when \p a, \p b, \p c turn clockwise
+    //! \brief only integer coordinates are supported, their differences must stay below 2^30
+    template <class VecType>
+    inline int inCircle(const VecType &a, const VecType &b, const VecType &c, const VecType &d)
+    {
+        static_assert(detail::has_integral_coords<VecType>, "exact inCircle needs integer coordinates");
+
+        const long long adx = static_cast<long long>(a.x) - d.x;
+        const long long ady = static_cast<long long>(a.y) - d.y;
+        const long long bdx = static_cast<long long>(b.x) - d.x;
+        const long long bdy = static_cast<long long>(b.y) - d.y;
+        const long long cdx = static_cast<long long>(c.x) - d.x;
+        const long long cdy = static_cast<long long>(c.y) - d.y;
+
+        //! differences are exact in doubles, so the filter needs to account only for the products
+        const double a_lift = static_cast<double>(adx) * adx + static_cast<double>(ady) * ady;
+        const double b_lift = static_cast<double>(bdx) * bdx + static_cast<double>(bdy) * bdy;
+        const double c_lift = static_cast<double>(cdx) * cdx + static_cast<double>(cdy) * cdy;
+        const double bc_left = static_cast<double>(bdx) * cdy;
+        const double bc_right = static_cast<double>(cdx) * bdy;
+        const double ca_left = static_cast<double>(cdx) * ady;
+        const double ca_right = static_cast<double>(adx) * cdy;
+        const double ab_left = static_cast<double>(adx) * bdy;
+        const double ab_right = static_cast<double>(bdx) * ady;
+        const double det = a_lift * (bc_left - bc_right) + b_lift * (ca_left - ca_right) + c_lift * (ab_left - ab_right);
+        const double permanent = a_lift * (std::abs(bc_left) + std::abs(bc_right)) +
+                                 b_lift * (std::abs(ca_left) + std::abs(ca_right)) +
+                                 c_lift * (std::abs(ab_left) + std::abs(ab_right));
+        const double error_bound = detail::in_circle_error_bound * permanent;
+        if (det > error_bound || -det > error_bound)
+        {
+            return det > 0. ? 1 : -1;
+        }
+
+        //! lifts and the 2x2 minors stay below 2^61, so each of their products fits into 128 bits
+        using detail::Int128;
+        const long long a_lift_exact = adx * adx + ady * ady;
+        const long long b_lift_exact = bdx * bdx + bdy * bdy;
+        const long long c_lift_exact = cdx * cdx + cdy * cdy;
+        const Int128 det_exact = Int128::product(a_lift_exact, bdx * cdy - cdx * bdy) +
+                                 Int128::product(b_lift_exact, cdx * ady - adx * cdy) +
+                                 Int128::product(c_lift_exact, adx * bdy - bdx * ady);
+        return det_exact.sign();
+    }
+
+    //! \returns true if segments [\p a, \p b] and [\p c, \p d] cross in a single point lying inside of both
+    template <class VecType>
+    inline bool segmentsCross(const VecType &a, const VecType &b, const VecType &c, const VecType &d)
+    {
+        return orientation(c, d, a) * orientation(c, d, b) < 0 && orientation(a, b, c) * orientation(a, b, d) < 0;
+    }
+
+} // namespace cdt
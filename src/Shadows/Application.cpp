@@ -114,12 +114,12 @@ Application::Application(cdt::Vector2i box_size)
 
         for (auto &tri : m_cdt.m_triangles)
         {
-            sf::Vector2f v1(tri.verts[0].x, tri.verts[0].y);
-            sf::Vector2f v2(tri.verts[1].x, tri.verts[1].y);
-            sf::Vector2f v3(tri.verts[2].x, tri.verts[2].y);
-            tri.is_constrained[0] ? drawLine(m_window, v1, v2, sf::Color::Red) : drawLine(m_window, v1, v2);
-            tri.is_constrained[1] ? drawLine(m_window, v2, v3, sf::Color::Red) : drawLine(m_window, v2, v3);
-            tri.is_constrained[2] ? drawLine(m_window, v3, v1, sf::Color::Red) : drawLine(m_window, v3, v1);
+            sf::Vector2f v1(m_cdt.vertexOf(tri, 0).x, m_cdt.vertexOf(tri, 0).y);
+            sf::Vector2f v2(m_cdt.vertexOf(tri, 1).x, m_cdt.vertexOf(tri, 1).y);
+            sf::Vector2f v3(m_cdt.vertexOf(tri, 2).x, m_cdt.vertexOf(tri, 2).y);
+            tri.isConstrained(0) ? drawLine(m_window, v1, v2, sf::Color::Red) : drawLine(m_window, v1, v2);
+            tri.isConstrained(1) ? drawLine(m_window, v2, v3, sf::Color::Red) : drawLine(m_window, v2, v3);
+            tri.isConstrained(2) ? drawLine(m_window, v3, v1, sf::Color::Red) : drawLine(m_window, v3, v1);
         }
 
         sf::RectangleShape player_rect;
@@ -181,25 +181,8 @@ Application::Application(cdt::Vector2i box_size)
         auto mouse_pos = cdt::Vector2f{mouse_pos_sf.x, mouse_pos_sf.y};
         if (event.type == sf::Event::MouseButtonReleased && event.mouseButton.button == sf::Mouse::Right)
         {
-            m_cdt.reset();
             m_map.changeTiles(MapGrid::Tile::Wall, mouse_pos, {2, 2});
-            auto edges = m_map.extractEdges();
-            std::vector<cdt::EdgeVInd> edge_inds;
-            for (auto &e : edges)
-            {
-                cdt::EdgeVInd e_ind;
-                auto v_ind1 = m_cdt.insertVertexAndGetData(e.from).overlapping_vertex;
-                e_ind.from = (v_ind1 == -1 ? m_cdt.m_vertices.size() - 1 : v_ind1);
-
-                auto v_ind2 = m_cdt.insertVertexAndGetData(e.to()).overlapping_vertex;
-                e_ind.to = (v_ind2 == -1 ? m_cdt.m_vertices.size() - 1 : v_ind2);
-
-                edge_inds.push_back(e_ind);
-            }
-            for (auto &e : edge_inds)
-            {
-                m_cdt.insertConstraint(e);
-            }
+            m_map.updateTriangulation(m_cdt);
         }
 
         if (event.type == sf::Event::MouseWheelMoved)
@@ -1,80 +1,86 @@
 #include "MapGrid.h"
 
-std::vector<Edge> MapGrid::extractEdges() const
+namespace
 {
-    std::vector<Edge> edges;
-
-    for (int iy = 1; iy < m_cell_count.y - 1; ++iy)
+    //! \brief walks \p n_cells cells from \p start in steps of \p step and adds one edge for each run of walls
+    //! \brief cell at r contributes segment going from r + \p offset to r + \p step + \p offset
+    template <class IsWall>
+    void addWallRuns(IsWall &&is_wall, cdt::Vector2i start, cdt::Vector2i step, int n_cells, cdt::Vector2i offset,
+                     bool is_reversed, std::vector<Edge> &edges)
     {
-        bool is_scanning_up = false;
-        bool is_scanning_down = false;
-        Vertex vl_up, vr_up;
-        Vertex vl_down, vr_down;
-        for (int ix = 1; ix < m_cell_count.x; ++ix)
+        bool is_scanning = false;
+        Vertex run_start;
+        auto r = start;
+        for (int i = 0; i <= n_cells; ++i, r += step)
         {
-            if (is_scanning_up && !isWall(Direction::Up, ix, iy))
+            const bool is_wall_here = i < n_cells && is_wall(r.x, r.y);
+            if (is_scanning && !is_wall_here)
             {
-                is_scanning_up = false;
-                vr_up = {ix, iy};
-                edges.push_back({vl_up, vr_up});
+                is_scanning = false;
+                is_reversed ? edges.push_back({r + offset, run_start + offset})
+                            : edges.push_back({run_start + offset, r + offset});
             }
-            if (!is_scanning_up && isWall(Direction::Up, ix, iy))
+            if (!is_scanning && is_wall_here)
             {
-                vl_up = {ix, iy};
-                is_scanning_up = true;
-            }
-
-            if (is_scanning_down && !isWall(Direction::Down, ix, iy))
-            {
-                is_scanning_down = false;
-                vr_down = {ix, iy};
-                edges.push_back({vr_down, vl_down});
-            }
-            if (!is_scanning_down && isWall(Direction::Down, ix, iy))
-            {
-                is_scanning_down = true;
-                vl_down = {ix, iy};
+                run_start = r;
+                is_scanning = true;
             }
         }
     }
 
-    //! scan up-down
-    for (int ix = 1; ix < m_cell_count.x - 1; ++ix)
+    //! \brief clamps window of cells [\p lower_left, \p upper_right] to the grid
+    void clampWindow(cdt::Vector2i &lower_left, cdt::Vector2i &upper_right, cdt::Vector2i cell_count)
     {
-        bool is_scanning_left = false;
-        bool is_scanning_right = false;
-        Vertex vl_up, vr_up;
-        Vertex vl_down, vr_down;
-        for (int iy = 1; iy < m_cell_count.y; ++iy)
-        {
-            if (is_scanning_left && !isWall(Direction::Left, ix, iy))
-            {
-                is_scanning_left = false;
-                vr_up = {ix, iy};
-                edges.push_back({vl_up, vr_up});
-            }
-            if (!is_scanning_left && isWall(Direction::Left, ix, iy))
-            {
-                vl_up = {ix, iy};
-                is_scanning_left = true;
-            }
+        lower_left = {std::max(lower_left.x, 0), std::max(lower_left.y, 0)};
+        upper_right = {std::min(upper_right.x, cell_count.x - 1), std::min(upper_right.y, cell_count.y - 1)};
+    }
+} // namespace
 
-            if (is_scanning_right && !isWall(Direction::Right, ix, iy))
-            {
-                is_scanning_right = false;
-                vr_down = {ix, iy};
-                edges.push_back({vr_down, vl_down});
-            }
-            if (!is_scanning_right && isWall(Direction::Right, ix, iy))
-            {
-                is_scanning_right = true;
-                vl_down = {ix, iy};
-            }
-        }
+std::vector<Edge> MapGrid::extractEdges() const
+{
+    return extractEdges({0, 0}, m_cell_count - cdt::Vector2i{1, 1});
+}
+
+//! \brief extracts walls of tiles in window [\p lower_left, \p upper_right], walls are cut at the window border
+std::vector<Edge> MapGrid::extractEdges(cdt::Vector2i lower_left, cdt::Vector2i upper_right) const
+{
+    std::vector<Edge> edges;
+    clampWindow(lower_left, upper_right, m_cell_count);
+    const auto is_wall = [this](Direction dir)
+    { return [this, dir](int ix, int iy)
+      { return isWall(dir, ix, iy); }; };
+
+    const auto width = upper_right.x - lower_left.x + 1;
+    const auto height = upper_right.y - lower_left.y + 1;
+    for (int iy = lower_left.y; iy <= upper_right.y; ++iy)
+    {
+        addWallRuns(is_wall(Direction::Up), {lower_left.x, iy}, {1, 0}, width, {0, 0}, false, edges);
+        addWallRuns(is_wall(Direction::Down), {lower_left.x, iy}, {1, 0}, width, {0, 0}, true, edges);
+    }
+    for (int ix = lower_left.x; ix <= upper_right.x; ++ix)
+    {
+        addWallRuns(is_wall(Direction::Left), {ix, lower_left.y}, {0, 1}, height, {0, 0}, false, edges);
+        addWallRuns(is_wall(Direction::Right), {ix, lower_left.y}, {0, 1}, height, {0, 0}, true, edges);
     }
     return edges;
 }
 
+//! \brief retriangulates just the region changed by changeTiles since the last update
+//! \param cdt triangulation holding walls of the map as it was before the changes
+void MapGrid::updateTriangulation(cdt::Triangulation<Vertex> &cdt)
+{
+    if (m_dirty.is_empty)
+    {
+        return;
+    }
+    //! walls of the neighbouring tiles change too, the extraction window is one tile bigger still
+    //! so that the walls lying on border of the replaced rectangle get extracted as well
+    const cdt::Vector2i halo = {1, 1};
+    const auto edges = extractEdges(m_dirty.lower_left - halo - halo, m_dirty.upper_right + halo + halo);
+    cdt.replaceConstraintsInRect(m_dirty.lower_left - halo, m_dirty.upper_right + halo + halo, edges);
+    m_dirty = {};
+}
+
 bool MapGrid::isAtBoundary(int ix, int iy) const
 {
     return ix >= m_cell_count.x - 1 || iy >= m_cell_count.y - 1 ||
@@ -131,6 +137,10 @@ void MapGrid::changeTiles(Tile new_tile, cdt::Vector2i lower_left, cdt::Vector2i
             m_tiles.at(cell_ind) = new_tile;
         }
     }
+    if (size.x > 0 && size.y > 0)
+    {
+        m_dirty.add(lower_left, lower_left + size - cdt::Vector2i{1, 1});
+    }
 }
 
 bool MapGridDiagonal::isWall(Direction dir, int ix, int iy) const
@@ -173,164 +183,74 @@ void MapGridDiagonal::changeTiles(Tile new_tile, cdt::Vector2i lower_left, cdt::
             m_tiles.at(cell_ind) = new_tile;
         }
     }
+    if (size.x > 0 && size.y > 0)
+    {
+        m_dirty.add(lower_left, lower_left + size - cdt::Vector2i{1, 1});
+    }
 }
 
 std::vector<Edge> MapGridDiagonal::extractEdges() const
 {
-    std::vector<Edge> edges;
+    return extractEdges({0, 0}, m_cell_count - cdt::Vector2i{1, 1});
+}
 
-    for (int iy = 1; iy < m_cell_count.y - 1; ++iy)
+//! \brief extracts walls of tiles in window [\p lower_left, \p upper_right], walls are cut at the window border
+std::vector<Edge> MapGridDiagonal::extractEdges(cdt::Vector2i lower_left, cdt::Vector2i upper_right) const
+{
+    std::vector<Edge> edges;
+    clampWindow(lower_left, upper_right, m_cell_count);
+    const auto is_wall = [this](Direction dir)
+    { return [this, dir](int ix, int iy)
+      { return isWall(dir, ix, iy); }; };
+
+    const auto width = upper_right.x - lower_left.x + 1;
+    const auto height = upper_right.y - lower_left.y + 1;
+    for (int iy = lower_left.y; iy <= upper_right.y; ++iy)
     {
-        bool is_scanning_up = false;
-        bool is_scanning_down = false;
-        Vertex vl_up, vr_up;
-        Vertex vl_down, vr_down;
-        for (int ix = 1; ix < m_cell_count.x; ++ix)
-        {
-            if (is_scanning_up && !isWall(Direction::Up, ix, iy))
-            {
-                is_scanning_up = false;
-                vr_up = {ix, iy};
-                edges.push_back({vl_up, vr_up});
-            }
-            if (!is_scanning_up && isWall(Direction::Up, ix, iy))
-            {
-                vl_up = {ix, iy};
-                is_scanning_up = true;
-            }
-
-            if (is_scanning_down && !isWall(Direction::Down, ix, iy))
-            {
-                is_scanning_down = false;
-                vr_down = {ix, iy + 1};
-                edges.push_back({vr_down, vl_down});
-            }
-            if (!is_scanning_down && isWall(Direction::Down, ix, iy))
-            {
-                is_scanning_down = true;
-                vl_down = {ix, iy + 1};
-            }
-        }
+        addWallRuns(is_wall(Direction::Up), {lower_left.x, iy}, {1, 0}, width, {0, 0}, false, edges);
+        addWallRuns(is_wall(Direction::Down), {lower_left.x, iy}, {1, 0}, width, {0, 1}, true, edges);
     }
-
-    //! scan up-down
-    for (int ix = 1; ix < m_cell_count.x - 1; ++ix)
+    for (int ix = lower_left.x; ix <= upper_right.x; ++ix)
     {
-        bool is_scanning_left = false;
-        bool is_scanning_right = false;
-        Vertex vl_up, vr_up;
-        Vertex vl_down, vr_down;
-        for (int iy = 1; iy < m_cell_count.y; ++iy)
-        {
-            if (is_scanning_left && !isWall(Direction::Left, ix, iy))
-            {
-                is_scanning_left = false;
-                vr_up = {ix, iy};
-                edges.push_back({vl_up, vr_up});
-            }
-            if (!is_scanning_left && isWall(Direction::Left, ix, iy))
-            {
-                vl_up = {ix, iy};
-                is_scanning_left = true;
-            }
-
-            if (is_scanning_right && !isWall(Direction::Right, ix, iy))
-            {
-                is_scanning_right = false;
-                vr_down = {ix + 1, iy};
-                edges.push_back({vr_down, vl_down});
-            }
-            if (!is_scanning_right && isWall(Direction::Right, ix, iy))
-            {
-                is_scanning_right = true;
-                vl_down = {ix + 1, iy};
-            }
-        }
+        addWallRuns(is_wall(Direction::Left), {ix, lower_left.y}, {0, 1}, height, {0, 0}, false, edges);
+        addWallRuns(is_wall(Direction::Right), {ix, lower_left.y}, {0, 1}, height, {1, 0}, true, edges);
     }
 
-    //! scan diagonally from left up to right down
-    const auto i_diag_max = m_cell_count.x + m_cell_count.y - 2;
-    for (int i_diag = 0; i_diag < i_diag_max; ++i_diag)
+    //! diagonals start in the left column and continue along the bottom (top) row of the window
+    for (int i = 1 - height; i < width; ++i)
     {
-        int ix = std::max(0, i_diag - m_cell_count.x);
-        int iy = std::max(0, m_cell_count.y - i_diag);
-        bool is_scanning_down = false;
-        bool is_scanning_up = false;
-        Vertex vl_up, vr_up;
-        Vertex vl_down, vr_down;
-        while (ix < m_cell_count.x && iy < m_cell_count.y)
-        {
-            if (is_scanning_down && !isWall(Direction::LeftDown, ix, iy))
-            {
-                is_scanning_down = false;
-                vr_up = {ix, iy};
-                edges.push_back({vl_up, vr_up});
-            }
-            if (!is_scanning_down && isWall(Direction::LeftDown, ix, iy))
-            {
-                vl_up = {ix, iy};
-                is_scanning_down = true;
-            }
-
-            if (is_scanning_up && !isWall(Direction::RightUp, ix, iy))
-            {
-                is_scanning_up = false;
-                vr_down = {ix, iy};
-                edges.push_back({vr_down, vl_down});
-            }
-            if (!is_scanning_up && isWall(Direction::RightUp, ix, iy))
-            {
-                is_scanning_up = true;
-                vl_down = {ix, iy};
-            }
-            ix++;
-            iy++;
-        }
+        const cdt::Vector2i start = {lower_left.x + std::max(i, 0), lower_left.y + std::max(-i, 0)};
+        const auto n_cells = std::min(upper_right.x - start.x, upper_right.y - start.y) + 1;
+        addWallRuns(is_wall(Direction::LeftDown), start, {1, 1}, n_cells, {0, 0}, false, edges);
+        addWallRuns(is_wall(Direction::RightUp), start, {1, 1}, n_cells, {0, 0}, true, edges);
     }
-
-    //! scan diagonally form left down to right up
-    for (int i_diag = 0; i_diag < i_diag_max; ++i_diag)
+    for (int i = 1 - height; i < width; ++i)
     {
-        int ix = std::max(0, i_diag - m_cell_count.y);
-        int iy = std::min(i_diag, m_cell_count.y - 1);
-
-        bool is_scanning_down = false;
-        bool is_scanning_up = false;
-        Vertex vl_up, vr_up;
-        Vertex vl_down, vr_down;
-        while (ix < m_cell_count.x && iy > 0)
-        {
-            if (is_scanning_down && !isWall(Direction::LeftUp, ix, iy))
-            {
-                is_scanning_down = false;
-                vr_up = {ix, iy + 1};
-                edges.push_back({vl_up, vr_up});
-            }
-            if (!is_scanning_down && isWall(Direction::LeftUp, ix, iy))
-            {
-                vl_up = {ix, iy + 1};
-                is_scanning_down = true;
-            }
-
-            if (is_scanning_up && !isWall(Direction::RightDown, ix, iy))
-            {
-                is_scanning_up = false;
-                vr_down = {ix, iy + 1};
-                edges.push_back({vr_down, vl_down});
-            }
-            if (!is_scanning_up && isWall(Direction::RightDown, ix, iy))
-            {
-                is_scanning_up = true;
-                vl_down = {ix, iy + 1};
-            }
-            ix++;
-            iy--;
-        }
+        const cdt::Vector2i start = {lower_left.x + std::max(i, 0), upper_right.y - std::max(-i, 0)};
+        const auto n_cells = std::min(upper_right.x - start.x, start.y - lower_left.y) + 1;
+        addWallRuns(is_wall(Direction::LeftUp), start, {1, -1}, n_cells, {0, 1}, false, edges);
+        addWallRuns(is_wall(Direction::RightDown), start, {1, -1}, n_cells, {0, 1}, true, edges);
     }
-
     return edges;
 }
 
+//! \brief retriangulates just the region changed by changeTiles since the last update
+//! \param cdt triangulation holding walls of the map as it was before the changes
+void MapGridDiagonal::updateTriangulation(cdt::Triangulation<Vertex> &cdt)
+{
+    if (m_dirty.is_empty)
+    {
+        return;
+    }
+    //! corners of the neighbouring tiles change too, the extraction window is one tile bigger still
+    //! so that the walls lying on border of the replaced rectangle get extracted as well
+    const cdt::Vector2i halo = {1, 1};
+    transformCorners(m_dirty.lower_left - halo, m_dirty.upper_right + halo);
+    const auto edges = extractEdges(m_dirty.lower_left - halo - halo, m_dirty.upper_right + halo + halo);
+    cdt.replaceConstraintsInRect(m_dirty.lower_left - halo, m_dirty.upper_right + halo + halo, edges);
+    m_dirty = {};
+}
+
 bool MapGridDiagonal::isAtBoundary(int ix, int iy) const
 {
     return ix >= m_cell_count.x - 1 || iy >= m_cell_count.y - 1 ||
@@ -438,66 +358,86 @@ void MapGridDiagonal::transformCorners()
     {
         for (int ix = 1; ix < m_cell_count.x; ++ix)
         {
-            auto cell_index = cellIndex(ix, iy);
-            const auto t_left = m_tiles[cell_index + deltaInd(Direction::Left)];
-            const auto t_right = m_tiles[cell_index + deltaInd(Direction::Right)];
-            const auto t_up = m_tiles[cell_index + deltaInd(Direction::Up)];
-            const auto t_down = m_tiles[cell_index + deltaInd(Direction::Down)];
-            auto &t = m_tiles[cell_index];
-            int n_walls_around = (t_left == Tile::Wall) + (t_right == Tile::Wall) +
-                                 (t_down == Tile::Wall) + (t_up == Tile::Wall);
-            if (t != Tile::Ground)
-            {
+            transformCorner(ix, iy);
+        }
+    }
+}
 
-                if (n_walls_around == 2)
-                {
-                    bool is_ul_corner = t_left == Tile::Ground and t_up == Tile::Ground;
-                    bool is_ur_corner = t_right == Tile::Ground and t_up == Tile::Ground;
-                    bool is_dl_corner = t_left == Tile::Ground and t_down == Tile::Ground;
-                    bool is_dr_corner = t_right == Tile::Ground and t_down == Tile::Ground;
+//! \brief recomputes corners of tiles in window [\p lower_left, \p upper_right]
+void MapGridDiagonal::transformCorners(cdt::Vector2i lower_left, cdt::Vector2i upper_right)
+{
+    lower_left = {std::max(lower_left.x, 1), std::max(lower_left.y, 1)};
+    upper_right = {std::min(upper_right.x, m_cell_count.x - 1), std::min(upper_right.y, m_cell_count.y - 2)};
+    for (int iy = lower_left.y; iy <= upper_right.y; ++iy)
+    {
+        for (int ix = lower_left.x; ix <= upper_right.x; ++ix)
+        {
+            m_boundaries.erase(cellIndex(ix, iy));
+            transformCorner(ix, iy);
+        }
+    }
+}
 
-                    if (is_ul_corner)
-                    {
-                        m_boundaries[cell_index].dir = Direction::LeftUp;
-                    }
-                    if (is_ur_corner)
-                    {
-                        m_boundaries[cell_index].dir = Direction::RightUp;
-                    }
-                    if (is_dl_corner)
-                    {
-                        m_boundaries[cell_index].dir = Direction::LeftDown;
-                    }
-                    if (is_dr_corner)
-                    {
-                        m_boundaries[cell_index].dir = Direction::RightDown;
-                    }
-                }
-            }
+void MapGridDiagonal::transformCorner(int ix, int iy)
+{
+    auto cell_index = cellIndex(ix, iy);
+    const auto t_left = m_tiles[cell_index + deltaInd(Direction::Left)];
+    const auto t_right = m_tiles[cell_index + deltaInd(Direction::Right)];
+    const auto t_up = m_tiles[cell_index + deltaInd(Direction::Up)];
+    const auto t_down = m_tiles[cell_index + deltaInd(Direction::Down)];
+    auto &t = m_tiles[cell_index];
+    int n_walls_around = (t_left == Tile::Wall) + (t_right == Tile::Wall) +
+                         (t_down == Tile::Wall) + (t_up == Tile::Wall);
+    if (t != Tile::Ground)
+    {
+
+        if (n_walls_around == 2)
+        {
+            bool is_ul_corner = t_left == Tile::Ground and t_up == Tile::Ground;
+            bool is_ur_corner = t_right == Tile::Ground and t_up == Tile::Ground;
+            bool is_dl_corner = t_left == Tile::Ground and t_down == Tile::Ground;
+            bool is_dr_corner = t_right == Tile::Ground and t_down == Tile::Ground;
 
-            if (n_walls_around == 3)
+            if (is_ul_corner)
             {
-                bool is_up = t_up == Tile::Ground;
-                bool is_left = t_left == Tile::Ground;
-                bool is_down = t_down == Tile::Ground;
-                bool is_right = t_right == Tile::Ground;
-                if (is_up)
-                {
-                    m_boundaries[cell_index].dir = Direction::Up;
-                }
-                if (is_left)
-                {
-                    m_boundaries[cell_index].dir = Direction::Left;
-                }
-                if (is_down)
-                {
-                    m_boundaries[cell_index].dir = Direction::Down;
-                }
-                if (is_right)
-                {
-                    m_boundaries[cell_index].dir = Direction::Right;
-                }
+                m_boundaries[cell_index].dir = Direction::LeftUp;
+            }
+            if (is_ur_corner)
+            {
+                m_boundaries[cell_index].dir = Direction::RightUp;
             }
+            if (is_dl_corner)
+            {
+                m_boundaries[cell_index].dir = Direction::LeftDown;
+            }
+            if (is_dr_corner)
+            {
+                m_boundaries[cell_index].dir = Direction::RightDown;
+            }
+        }
+    }
+
+    if (n_walls_around == 3)
+    {
+        bool is_up = t_up == Tile::Ground;
+        bool is_left = t_left == Tile::Ground;
+        bool is_down = t_down == Tile::Ground;
+        bool is_right = t_right == Tile::Ground;
+        if (is_up)
+        {
+            m_boundaries[cell_index].dir = Direction::Up;
+        }
+        if (is_left)
+        {
+            m_boundaries[cell_index].dir = Direction::Left;
+        }
+        if (is_down)
+        {
+            m_boundaries[cell_index].dir = Direction::Down;
+        }
+        if (is_right)
+        {
+            m_boundaries[cell_index].dir = Direction::Right;
         }
     }
 }
\ No newline at end of file
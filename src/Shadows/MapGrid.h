@@ -2,12 +2,34 @@
 
 #include "../Triangulation.h"
 
+#include <algorithm>
 #include <unordered_map>
 
 
 using Vertex = cdt::Vector2i;
 using Edge = cdt::EdgeI<Vertex>;
 
+//! \struct rectangle of tiles changed since the triangulation was last updated
+struct DirtyRegion
+{
+    cdt::Vector2i lower_left;
+    cdt::Vector2i upper_right; //! inclusive
+    bool is_empty = true;
+
+    void add(cdt::Vector2i new_lower_left, cdt::Vector2i new_upper_right)
+    {
+        if (is_empty)
+        {
+            lower_left = new_lower_left;
+            upper_right = new_upper_right;
+            is_empty = false;
+            return;
+        }
+        lower_left = {std::min(lower_left.x, new_lower_left.x), std::min(lower_left.y, new_lower_left.y)};
+        upper_right = {std::max(upper_right.x, new_upper_right.x), std::max(upper_right.y, new_upper_right.y)};
+    }
+};
+
 class MapGrid : public cdt::Grid
 {
 
@@ -32,6 +54,11 @@ public:
     void changeTiles(Tile new_tile, cdt::Vector2i lower_left, cdt::Vector2i size);
 
     std::vector<Edge> extractEdges() const;
+    std::vector<Edge> extractEdges(cdt::Vector2i lower_left, cdt::Vector2i upper_right) const;
+
+    void updateTriangulation(cdt::Triangulation<Vertex> &cdt);
+    //! \brief forgets the changes made so far, call it when the triangulation was built from the whole map
+    void clearDirtyRegion() { m_dirty = {}; }
 
 private:
     bool isAtBoundary(int ix, int iy) const;
@@ -40,6 +67,7 @@ private:
 private:
     cdt::Vector2i m_size;
     std::vector<Tile> m_tiles;
+    DirtyRegion m_dirty;
 };
 
 class MapGridDiagonal : public cdt::Grid
@@ -71,13 +99,20 @@ public:
     void changeTiles(Tile new_tile, cdt::Vector2i lower_left, cdt::Vector2i size);
 
     std::vector<Edge> extractEdges() const;
+    std::vector<Edge> extractEdges(cdt::Vector2i lower_left, cdt::Vector2i upper_right) const;
     
     void transformCorners();
+    void transformCorners(cdt::Vector2i lower_left, cdt::Vector2i upper_right);
     void extractBoundaries();
 
+    void updateTriangulation(cdt::Triangulation<Vertex> &cdt);
+    //! \brief forgets the changes made so far, call it when the triangulation was built from the whole map
+    void clearDirtyRegion() { m_dirty = {}; }
+
 private:
     bool isAtBoundary(int ix, int iy) const;
     bool isWall(Direction dir, int ix, int iy) const;
+    void transformCorner(int ix, int iy);
 
 
     enum class BoundaryTile
@@ -101,6 +136,7 @@ private:
     cdt::Vector2i m_size;
     std::vector<Tile> m_tiles;
     std::unordered_map<int, BoundaryData> m_boundaries;
+    DirtyRegion m_dirty;
 
     std::unordered_map<Direction, int> delta_inds;
 };
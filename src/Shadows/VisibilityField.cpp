@@ -1,6 +1,6 @@
 #include "VisibilityField.h"
 
-VisionField::VisionField(cdt::Triangulation<cdt::Vector2i> &cdt) : m_cdt(cdt) {}
+VisionField::VisionField(const cdt::Triangulation<cdt::Vector2i> &cdt) : m_cdt(cdt) {}
 
 bool VisionField::isVisible(cdt::Vector2f query) const
 {
@@ -49,7 +49,7 @@ void VisionField::contrstuctField(cdt::Vector2f from, cdt::Vector2f look_dir)
     float max_length = 1000.f;
 
     const auto &triangles = m_cdt.m_triangles;
-    auto start_tri_ind = m_cdt.findTriangle(from, false);
+    auto start_tri_ind = m_cdt.findTriangle(from, m_locate_cursor);
 
     std::vector<Walker> to_visit;
     auto &curr_tri = triangles.at(start_tri_ind);
@@ -57,9 +57,9 @@ void VisionField::contrstuctField(cdt::Vector2f from, cdt::Vector2f look_dir)
     //! when standing on some line,
     //! we move the point very little towards triangle center
     //!  so that we don't have to deal with it (dirty but maybe works)
-    auto v1 = asFloat(curr_tri.verts[0]);
-    auto v2 = asFloat(curr_tri.verts[1]);
-    auto v3 = asFloat(curr_tri.verts[2]);
+    auto v1 = asFloat(m_cdt.vertexOf(curr_tri, 0));
+    auto v2 = asFloat(m_cdt.vertexOf(curr_tri, 1));
+    auto v3 = asFloat(m_cdt.vertexOf(curr_tri, 2));
     auto center = cdt::Vector2f(v1 + v2 + v3) / 3.f;
     if (lies_on_line(from, v2, v1) || lies_on_line(from, v3, v2) || lies_on_line(from, v1, v3))
     {
@@ -68,8 +68,8 @@ void VisionField::contrstuctField(cdt::Vector2f from, cdt::Vector2f look_dir)
 
     for (int i = 0; i < 3; ++i)
     {
-        auto left = asFloat(curr_tri.verts[next(i)]);
-        auto right = asFloat(curr_tri.verts[i]);
+        auto left = asFloat(m_cdt.vertexOf(curr_tri, next(i)));
+        auto right = asFloat(m_cdt.vertexOf(curr_tri, i));
 
         // if (!in_vision_cone(left))
         // { //! find where left side of vision cone hit the tri-edge
@@ -89,7 +89,7 @@ void VisionField::contrstuctField(cdt::Vector2f from, cdt::Vector2f look_dir)
         //     }
         // }
 
-        if (!curr_tri.is_constrained[i])
+        if (!curr_tri.isConstrained(i))
         {
             to_visit.push_back({start_tri_ind, curr_tri.neighbours[i], left, right});
         }
@@ -122,9 +122,9 @@ void VisionField::contrstuctField(cdt::Vector2f from, cdt::Vector2f look_dir)
         }
 
         auto opposite_ind_in_tri = m_cdt.oppositeIndex(prev_tri_ind, curr_tri);
-        auto opposite_vert = asFloat(curr_tri.verts[opposite_ind_in_tri]);
-        auto left_vert = asFloat(curr_tri.verts[next(opposite_ind_in_tri)]);
-        auto right_vert = asFloat(curr_tri.verts[prev(opposite_ind_in_tri)]);
+        auto opposite_vert = asFloat(m_cdt.vertexOf(curr_tri, opposite_ind_in_tri));
+        auto left_vert = asFloat(m_cdt.vertexOf(curr_tri, next(opposite_ind_in_tri)));
+        auto right_vert = asFloat(m_cdt.vertexOf(curr_tri, prev(opposite_ind_in_tri)));
 
         auto left_neighbour = curr_tri.neighbours[opposite_ind_in_tri];
         auto right_neighbour = curr_tri.neighbours[prev(opposite_ind_in_tri)];
@@ -132,8 +132,8 @@ void VisionField::contrstuctField(cdt::Vector2f from, cdt::Vector2f look_dir)
         auto o_left = orient2(from, opposite_vert, left);
         auto o_right = orient2(from, right, opposite_vert);
 
-        bool left_is_transparent = !curr_tri.is_constrained[opposite_ind_in_tri];
-        bool right_is_transparent = !curr_tri.is_constrained[prev(opposite_ind_in_tri)];
+        bool left_is_transparent = !curr_tri.isConstrained(opposite_ind_in_tri);
+        bool right_is_transparent = !curr_tri.isConstrained(prev(opposite_ind_in_tri));
         bool left_was_added = vequal(left_vert, left);
         bool right_was_added = vequal(right_vert, right);
 
@@ -26,7 +26,7 @@ class VisionField
     };
 
 public:
-    VisionField(cdt::Triangulation<cdt::Vector2i> &cdt);
+    VisionField(const cdt::Triangulation<cdt::Vector2i> &cdt);
 
     bool            isVisible(cdt::Vector2f query) const;
 
@@ -41,7 +41,8 @@ private:
     float m_max_angle = +60;
 
     std::vector<VisionCone> m_vision;
-    cdt::Triangulation<cdt::Vector2i> &m_cdt;
+    const cdt::Triangulation<cdt::Vector2i> &m_cdt;
+    cdt::LocateCursor m_locate_cursor; //! own point location state, so fields of different threads can share m_cdt
 };
 
 
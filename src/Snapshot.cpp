@@ -0,0 +1,153 @@
+#include "Snapshot.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CDT_SNAPSHOT_MMAP
+#endif
+
+namespace cdt
+{
+
+    //! \brief opens and checks the snapshot in \p filename, throws std::runtime_error if it is missing or malformed
+    SnapshotFile::SnapshotFile(const std::string &filename)
+    {
+#ifdef CDT_SNAPSHOT_MMAP
+        const int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd != -1)
+        {
+            struct stat file_stat;
+            if (::fstat(fd, &file_stat) == 0 && file_stat.st_size > 0)
+            {
+                void *data = ::mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (data != MAP_FAILED)
+                {
+                    m_data = static_cast<const std::byte *>(data);
+                    m_n_bytes = file_stat.st_size;
+                    m_is_mapped = true;
+                }
+            }
+            ::close(fd);
+        }
+#endif
+        if (!m_is_mapped)
+        {
+            std::ifstream file(filename, std::ios::binary | std::ios::ate);
+            if (!file.is_open())
+            {
+                throw std::runtime_error("cannot open snapshot " + filename);
+            }
+            m_buffer.resize(file.tellg());
+            file.seekg(0);
+            file.read(reinterpret_cast<char *>(m_buffer.data()), m_buffer.size());
+            m_data = m_buffer.data();
+            m_n_bytes = m_buffer.size();
+        }
+
+        try
+        {
+            validate();
+        }
+        catch (...)
+        {
+            unmap(); //! the destructor does not run when the constructor throws
+            throw;
+        }
+    }
+
+    SnapshotFile::~SnapshotFile()
+    {
+        unmap();
+    }
+
+    void SnapshotFile::unmap()
+    {
+#ifdef CDT_SNAPSHOT_MMAP
+        if (m_is_mapped)
+        {
+            ::munmap(const_cast<std::byte *>(m_data), m_n_bytes);
+            m_is_mapped = false;
+        }
+#endif
+    }
+
+    //! \returns bytes of \p section, empty if the section was not stored
+    std::span<const std::byte> SnapshotFile::section(SnapshotSection section) const
+    {
+        const auto &entry = header().sections[static_cast<std::size_t>(section)];
+        return {m_data + entry.offset, static_cast<std::size_t>(entry.n_bytes)};
+    }
+
+    void SnapshotFile::validate() const
+    {
+        if (m_n_bytes < sizeof(SnapshotHeader))
+        {
+            throw std::runtime_error("snapshot is too small");
+        }
+        const SnapshotHeader expected;
+        const auto &stored = header();
+        if (std::memcmp(stored.magic, expected.magic, sizeof(expected.magic)) != 0)
+        {
+            throw std::runtime_error("file is not a snapshot");
+        }
+        if (stored.version != expected.version)
+        {
+            throw std::runtime_error("snapshot version " + std::to_string(stored.version) + " is not supported");
+        }
+        if (stored.byte_order_mark != expected.byte_order_mark)
+        {
+            throw std::runtime_error("snapshot was written with a different byte order");
+        }
+        for (const auto &entry : stored.sections)
+        {
+            if (entry.offset % snapshot_alignment != 0 || entry.offset > m_n_bytes ||
+                entry.n_bytes > m_n_bytes - entry.offset)
+            {
+                throw std::runtime_error("snapshot is truncated or corrupted");
+            }
+        }
+    }
+
+    //! \brief writes \p header followed by \p sections into \p filename, throws std::runtime_error on failure
+    //! \param header its section table gets filled here
+    void writeSnapshot(const std::string &filename, SnapshotHeader header, std::span<const SnapshotSectionData> sections)
+    {
+        auto aligned = [](std::uint64_t offset)
+        { return (offset + snapshot_alignment - 1) / snapshot_alignment * snapshot_alignment; };
+
+        std::uint64_t offset = aligned(sizeof(SnapshotHeader));
+        for (const auto &[section, bytes] : sections)
+        {
+            header.sections[static_cast<std::size_t>(section)] = {offset, bytes.size()};
+            offset = aligned(offset + bytes.size());
+        }
+
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("cannot write snapshot " + filename);
+        }
+        const char padding[snapshot_alignment] = {};
+        auto write_padded = [&](const void *data, std::size_t n_bytes)
+        {
+            file.write(static_cast<const char *>(data), n_bytes);
+            file.write(padding, aligned(n_bytes) - n_bytes);
+        };
+        write_padded(&header, sizeof(header));
+        for (const auto &[section, bytes] : sections)
+        {
+            write_padded(bytes.data(), bytes.size());
+        }
+        if (!file)
+        {
+            throw std::runtime_error("failed writing snapshot " + filename);
+        }
+    }
+
+} // namespace cdt
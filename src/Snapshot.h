@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace cdt
+{
+
+    //! \brief parts of a snapshot file, each is a plain array stored exactly as it lies in memory
+    enum class SnapshotSection : std::uint32_t
+    {
+        Vertices,       //! Triangulation::m_vertices
+        Triangles,      //! Triangulation::m_triangles including neighbours, constraint and back index bits
+        Vertex2Tri,     //! Triangulation::m_vertex2tri
+        FixedEdgeSlots, //! slots of the EdgeSet holding constrained edges, so the set needs no reinsertion
+        Cell2Tri,       //! triangle of each cell of the locate grid
+        TriangleWidths, //! optional, 3 floats per triangle as computed by PathFinder
+        Count
+    };
+
+    //! \struct where a section lies within the file
+    struct SnapshotSectionEntry
+    {
+        std::uint64_t offset = 0; //! from the start of the file, a multiple of snapshot_alignment
+        std::uint64_t n_bytes = 0;
+    };
+
+    //! \struct start of every snapshot file
+    //! \brief the format is native: files are meant to be baked and loaded on machines with the same byte order
+    //! \brief and type layout, which the header records and SnapshotFile checks
+    struct SnapshotHeader
+    {
+        char magic[8] = {'C', 'D', 'T', 'S', 'N', 'A', 'P', '\0'};
+        std::uint32_t version = 1;
+        std::uint32_t byte_order_mark = 0x01020304;
+        std::uint32_t vertex_size = 0;
+        std::uint32_t triangle_size = 0;
+        std::int32_t boundary[2] = {0, 0};
+        std::int32_t cell_count[2] = {0, 0};
+        std::uint64_t n_fixed_edges = 0; //! number of used slots in FixedEdgeSlots
+        SnapshotSectionEntry sections[static_cast<std::size_t>(SnapshotSection::Count)];
+    };
+
+    constexpr std::size_t snapshot_alignment = 64; //! sections start at cache line boundaries
+
+    //! \class read only view of a snapshot file
+    //! \brief on POSIX systems the file is memory mapped, elsewhere it is read into a buffer owned by the view. The
+    //! \brief loaders do not use the sections in place: Triangulation::loadSnapshot checks and copies every one of
+    //! \brief them, so loading is linear in the file size and the mapping only saves the intermediate buffer
+    class SnapshotFile
+    {
+    public:
+        explicit SnapshotFile(const std::string &filename);
+        ~SnapshotFile();
+
+        SnapshotFile(const SnapshotFile &) = delete;
+        SnapshotFile &operator=(const SnapshotFile &) = delete;
+
+        const SnapshotHeader &header() const { return *reinterpret_cast<const SnapshotHeader *>(m_data); }
+
+        std::span<const std::byte> section(SnapshotSection section) const;
+
+        //! \returns \p section viewed as an array of T without copying it
+        //! \brief throws std::runtime_error if the section does not hold a whole number of T
+        template <class T>
+        std::span<const T> array(SnapshotSection section) const
+        {
+            const auto bytes = this->section(section);
+            if (bytes.size() % sizeof(T) != 0)
+            {
+                throw std::runtime_error("snapshot section does not hold whole elements");
+            }
+            return {reinterpret_cast<const T *>(bytes.data()), bytes.size() / sizeof(T)};
+        }
+
+    private:
+        void validate() const;
+        void unmap();
+
+    private:
+        const std::byte *m_data = nullptr;
+        std::size_t m_n_bytes = 0;
+        bool m_is_mapped = false;
+        std::vector<std::byte> m_buffer; //! holds the file when it could not be mapped
+    };
+
+    //! \struct one section to be written by writeSnapshot
+    struct SnapshotSectionData
+    {
+        SnapshotSection section;
+        std::span<const std::byte> bytes;
+    };
+
+    void writeSnapshot(const std::string &filename, SnapshotHeader header, std::span<const SnapshotSectionData> sections);
+
+} // namespace cdt
@@ -4,6 +4,7 @@
 #include "test_vecs.cc"
 #include "test_geometry.cc"
 #include "test_cdt.cc"
+#include "test_pathfinding.cc"
 
 int main(int argc, char **argv) {
   testing::InitGoogleTest(&argc, argv);
@@ -1,7 +1,27 @@
 #pragma once
 #include <gtest/gtest.h>
 
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
 #include "../Triangulation.h"
+#include "../ThreadPool.h"
+#include "../Snapshot.h"
+
+namespace
+{
+    //! \returns \p n_vertices points spread over the \p range box shifted by \p offset, the same ones in every run
+    std::vector<cdt::Vector2i> scatteredVertices(int n_vertices, cdt::Vector2i range, int offset = 0)
+    {
+        std::vector<cdt::Vector2i> vertices;
+        for (int i = 0; i < n_vertices; ++i)
+        {
+            vertices.push_back({(i * 37) % range.x + offset, (i * 61) % range.y + offset});
+        }
+        return vertices;
+    }
+} // namespace
 
 TEST(TestTriangulation, SuperTriangle) {
 
@@ -48,3 +68,756 @@ TEST(TestTriangulation, BoundingBox) {
 }
 
 
+TEST(TestTriangulation, ConstraintsKeepTopologyConsistent) {
+
+    using namespace cdt;
+
+    Triangulation cdt({20, 20});
+
+    cdt.insertVertex({2, 3});
+    cdt.insertVertex({17, 15});
+    cdt.insertVertex({10, 4});
+    cdt.insertVertex({6, 16});
+    cdt.insertVertex({12, 10});
+    cdt.insertConstraint({4, 5});
+    cdt.insertConstraint({6, 8});
+
+    EXPECT_TRUE(cdt.triangulationIsConsistent());
+
+    int n_constrained_halfedges = 0;
+    for (const auto &tri : cdt.m_triangles)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            const EdgeVInd e = {tri.vert_inds[k], tri.vert_inds[next(k)]};
+            if (e == EdgeVInd{4, 5} || e == EdgeVInd{6, 8})
+            {
+                EXPECT_TRUE(tri.isConstrained(k));
+                n_constrained_halfedges++;
+            }
+        }
+    }
+    EXPECT_EQ(n_constrained_halfedges, 4);
+}
+
+TEST(TestTriangulation, BulkInsertion) {
+
+    using namespace cdt;
+
+    Triangulation cdt({100, 100});
+
+    auto verts = scatteredVertices(500, {101, 97});
+    verts.push_back(verts.front()); //! duplicates are skipped
+
+    cdt.insertVertices(verts);
+
+    EXPECT_EQ(cdt.m_vertices.size(), 4 + 500 - 1); //! [0,0] is already a boundary vertex
+    EXPECT_TRUE(cdt.triangulationIsConsistent());
+    EXPECT_TRUE(cdt.allAreDelaunay());
+}
+
+TEST(TestTriangulation, DivideAndConquerBuild) {
+
+    using namespace cdt;
+
+    auto verts = scatteredVertices(500, {101, 97});
+    verts.push_back({50, 0});  //! lies on the boundary
+    verts.push_back({30, 30}); //! collinear with many others
+    verts.push_back({30, 31});
+    verts.push_back({-5, 3}); //! outside of the boundary
+
+    Triangulation incremental({100, 100});
+    incremental.insertVertices(verts);
+
+    Triangulation cdt({100, 100});
+    const auto vert_inds = cdt.buildFromVertices(verts);
+
+    ASSERT_EQ(vert_inds.size(), verts.size());
+    EXPECT_EQ(vert_inds.back(), -1);
+    for (std::size_t i = 0; i + 1 < verts.size(); ++i)
+    {
+        EXPECT_TRUE(cdt.m_vertices.at(vert_inds[i]) == verts[i]);
+    }
+    EXPECT_EQ(vert_inds.front(), 0); //! [0,0] is already a boundary vertex
+    EXPECT_EQ(cdt.m_vertices.size(), incremental.m_vertices.size());
+    EXPECT_EQ(cdt.m_triangles.size(), incremental.m_triangles.size());
+    EXPECT_TRUE(cdt.triangulationIsConsistent());
+    EXPECT_TRUE(cdt.allAreDelaunay());
+}
+
+TEST(TestTriangulation, ParallelBuildMatchesSerial) {
+
+    using namespace cdt;
+
+    //! enough vertices for 4 strips, many of them share a column or lie on a common circle
+    std::vector<Vector2i> verts;
+    for (int i = 0; i < 40000; ++i)
+    {
+        verts.push_back({(i * 7919) % 1999, static_cast<int>((i * 104729ll) % 1997)});
+    }
+
+    Triangulation serial({2000, 2000});
+    const auto serial_inds = serial.buildFromVertices(verts);
+
+    ThreadPool pool(4);
+    Triangulation parallel({2000, 2000});
+    const auto parallel_inds = parallel.buildFromVertices(verts, &pool);
+
+    EXPECT_EQ(parallel_inds, serial_inds);
+    EXPECT_EQ(parallel.m_triangles.size(), serial.m_triangles.size());
+    EXPECT_TRUE(parallel.triangulationIsConsistent());
+    EXPECT_TRUE(parallel.allAreDelaunay());
+}
+
+TEST(TestTriangulation, BatchConstraints) {
+
+    using namespace cdt;
+
+    Triangulation cdt({50, 50});
+
+    std::vector<Vector2i> square = {{10, 10}, {30, 10}, {30, 30}, {10, 30}};
+    const auto square_inds = cdt.insertPolyline(square, true);
+
+    std::vector<EdgeI<Vector2i>> walls = {{{5, 40}, {20, 40}}, {{20, 40}, {20, 45}}, {{5, 40}, {20, 40}}};
+    cdt.insertConstraints(walls);
+
+    std::vector<EdgeVInd> repeated = {{square_inds[0], square_inds[1]}, {square_inds[1], square_inds[0]}};
+    cdt.insertConstraints(repeated);
+
+    EXPECT_EQ(cdt.m_vertices.size(), 4 + 4 + 3); //! shared wall endpoint is inserted only once
+    EXPECT_TRUE(cdt.triangulationIsConsistent());
+    EXPECT_TRUE(cdt.allAreDelaunay());
+
+    int n_constrained_halfedges = 0;
+    for (const auto &tri : cdt.m_triangles)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            n_constrained_halfedges += tri.isConstrained(k);
+        }
+    }
+    EXPECT_EQ(n_constrained_halfedges, 2 * (4 + 2) + 4); //! boundary edges have just one side
+}
+
+TEST(TestTriangulation, ConstraintThroughVerticesIsSplit) {
+
+    using namespace cdt;
+
+    Triangulation cdt({60, 60});
+    std::vector<Vector2i> verts = {{10, 30}, {20, 30}, {25, 30}, {40, 30}, {50, 30}, {30, 20}, {30, 40}, {35, 31}};
+    const auto vert_inds = cdt.insertVertices(verts);
+    cdt.insertConstraint({vert_inds[1], vert_inds[2]}); //! an existing part gets reused
+
+    cdt.insertConstraint({vert_inds[0], vert_inds[4]});
+    EXPECT_TRUE(cdt.triangulationIsConsistent());
+    EXPECT_FALSE(cdt.m_fixed_edges.contains({vert_inds[0], vert_inds[4]}));
+    for (int i = 0; i < 4; ++i)
+    {
+        EXPECT_TRUE(cdt.m_fixed_edges.contains({vert_inds[i], vert_inds[i + 1]}));
+    }
+    EXPECT_EQ(cdt.m_fixed_edges.size(), 4 + 4);
+
+    ASSERT_TRUE(cdt.removeConstraint({vert_inds[4], vert_inds[0]}));
+    EXPECT_EQ(cdt.m_fixed_edges.size(), 4);
+}
+
+TEST(TestTriangulation, RemoveVerticesAndConstraints) {
+
+    using namespace cdt;
+
+    auto verts = scatteredVertices(300, {101, 97});
+    verts.push_back({50, 0}); //! lies on the boundary
+
+    Triangulation cdt({100, 100});
+    cdt.insertVertices(verts);
+
+    EXPECT_FALSE(cdt.removeVertex(0)); //! corners of the boundary stay
+    std::vector<Vector2i> removed;
+    for (VertInd v_ind = cdt.m_vertices.size() - 1; v_ind >= 4; v_ind -= 3)
+    {
+        removed.push_back(cdt.m_vertices[v_ind]);
+        ASSERT_TRUE(cdt.removeVertex(v_ind));
+    }
+    EXPECT_TRUE(cdt.triangulationIsConsistent());
+    EXPECT_TRUE(cdt.allAreDelaunay());
+    for (const auto &v : removed)
+    {
+        EXPECT_TRUE(std::find(cdt.m_vertices.begin(), cdt.m_vertices.end(), v) == cdt.m_vertices.end());
+    }
+
+    Triangulation rebuilt({100, 100});
+    rebuilt.insertVertices(cdt.m_vertices);
+    EXPECT_EQ(cdt.m_triangles.size(), rebuilt.m_triangles.size());
+
+    auto count_constrained_halfedges = [](const auto &cdt)
+    {
+        int n_constrained_halfedges = 0;
+        for (const auto &tri : cdt.m_triangles)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                n_constrained_halfedges += tri.isConstrained(k);
+            }
+        }
+        return n_constrained_halfedges;
+    };
+
+    Triangulation walls({50, 50});
+    std::vector<Vector2i> corners = {{10, 10}, {30, 12}, {25, 30}};
+    const auto corner_inds = walls.insertPolyline(corners, true);
+    walls.insertVertex({20, 11}); //! splits the first wall in two
+    EXPECT_EQ(count_constrained_halfedges(walls), 2 * 4 + 4);
+
+    ASSERT_TRUE(walls.removeVertex(walls.m_vertices.size() - 1)); //! the wall gets merged back
+    EXPECT_EQ(count_constrained_halfedges(walls), 2 * 3 + 4);
+    ASSERT_TRUE(walls.removeVertex(corner_inds[2])); //! both walls ending in the corner disappear
+    EXPECT_EQ(count_constrained_halfedges(walls), 2 * 1 + 4);
+
+    walls.insertVertex({20, 11});
+    ASSERT_TRUE(walls.removeConstraint({corner_inds[1], corner_inds[0]})); //! removes both parts
+    EXPECT_FALSE(walls.removeConstraint({corner_inds[0], corner_inds[1]}));
+    EXPECT_EQ(count_constrained_halfedges(walls), 4);
+    EXPECT_TRUE(walls.triangulationIsConsistent());
+    EXPECT_TRUE(walls.allAreDelaunay());
+}
+
+TEST(TestTriangulation, ConstraintSetMatchesEdgeFlags) {
+
+    using namespace cdt;
+
+    Triangulation cdt({64, 64});
+    std::vector<EdgeI<Vector2i>> walls; //! unit tile walls, all of the same length and axis aligned
+    for (int y = 4; y < 60; y += 8)
+    {
+        for (int x = 4; x < 60; x += 2)
+        {
+            walls.push_back({{x, y}, {x + 1, y}});
+            walls.push_back({{x + 1, y}, {x + 1, y + 1}});
+        }
+    }
+    cdt.insertConstraints(walls);
+
+    const auto constraints_match_flags = [](const auto &cdt)
+    {
+        std::size_t n_constrained_edges = 0;
+        for (TriInd tri_ind = 0; tri_ind < cdt.m_triangles.size(); ++tri_ind)
+        {
+            const auto &tri = cdt.m_triangles[tri_ind];
+            for (int k = 0; k < 3; ++k)
+            {
+                const EdgeVInd e = {tri.vert_inds[k], tri.vert_inds[next(k)]};
+                if (tri.isConstrained(k) && (tri.neighbours[k] == -1 || tri.neighbours[k] > tri_ind))
+                {
+                    n_constrained_edges++;
+                    if (!cdt.m_fixed_edges.contains(e) || !cdt.m_fixed_edges.contains({e.to, e.from}))
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+        return n_constrained_edges == cdt.m_fixed_edges.size();
+    };
+    EXPECT_EQ(cdt.m_fixed_edges.size(), walls.size() + 4);
+    EXPECT_TRUE(constraints_match_flags(cdt));
+
+    //! removing vertices moves the last vertex into the freed index together with its constraints
+    for (VertInd v_ind = 7; v_ind < cdt.m_vertices.size(); v_ind += 11)
+    {
+        ASSERT_TRUE(cdt.removeVertex(v_ind));
+    }
+    const auto removed_wall = std::find_if(walls.begin(), walls.end(), [&](const auto &wall)
+                                           { return cdt.removeConstraint({cdt.findVertex(wall.from),
+                                                                          cdt.findVertex(wall.to())}); });
+    EXPECT_TRUE(removed_wall != walls.end());
+    cdt.insertVertex({9, 4}); //! splits a wall in two
+    EXPECT_TRUE(cdt.triangulationIsConsistent());
+    EXPECT_TRUE(constraints_match_flags(cdt));
+}
+
+TEST(TestTriangulation, ReplaceConstraintsInRect) {
+
+    using namespace cdt;
+
+    Triangulation cdt({50, 50});
+    std::vector<EdgeI<Vector2i>> walls = {{{5, 10}, {40, 10}}, {{20, 20}, {22, 20}}};
+    cdt.insertConstraints(walls);
+
+    auto count_constrained_halfedges = [&cdt]()
+    {
+        int n_constrained_halfedges = 0;
+        for (const auto &tri : cdt.m_triangles)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                n_constrained_halfedges += tri.isConstrained(k);
+            }
+        }
+        return n_constrained_halfedges;
+    };
+
+    //! the long wall gets cut at the border, the short one disappears and the new one is clipped
+    std::vector<EdgeI<Vector2i>> new_walls = {{{18, 15}, {18, 30}}};
+    cdt.replaceConstraintsInRect({15, 5}, {25, 25}, new_walls);
+    EXPECT_EQ(cdt.m_vertices.size(), 4 + 6);
+    EXPECT_NE(cdt.findVertex({15, 10}), -1);
+    EXPECT_NE(cdt.findVertex({18, 25}), -1);
+    EXPECT_EQ(cdt.findVertex({20, 20}), -1);
+    EXPECT_EQ(count_constrained_halfedges(), 2 * 3 + 4);
+    EXPECT_TRUE(cdt.triangulationIsConsistent());
+
+    //! restoring the long wall merges its parts back together, the clipped new wall lies inside and disappears
+    std::vector<EdgeI<Vector2i>> old_walls = {{{5, 10}, {40, 10}}};
+    cdt.replaceConstraintsInRect({15, 5}, {25, 25}, old_walls);
+    EXPECT_EQ(cdt.m_vertices.size(), 4 + 2);
+    EXPECT_EQ(cdt.findVertex({15, 10}), -1);
+    EXPECT_EQ(count_constrained_halfedges(), 2 * 1 + 4);
+    EXPECT_TRUE(cdt.triangulationIsConsistent());
+    EXPECT_TRUE(cdt.allAreDelaunay());
+}
+
+TEST(TestTriangulation, ReplaceConstraintsInRectKeepsSlopedWalls) {
+
+    using namespace cdt;
+
+    //! grid points of the wall lie 5 apart in x, the rectangle borders at x = 17 and x = 27 fall between them
+    Triangulation cdt({50, 50});
+    const EdgeI<Vector2i> wall = {{5, 8}, {40, 15}};
+    cdt.insertConstraints(std::vector<EdgeI<Vector2i>>{wall});
+
+    cdt.replaceConstraintsInRect({17, 5}, {27, 25}, {});
+    EXPECT_NE(cdt.findVertex({15, 10}), -1);
+    EXPECT_NE(cdt.findVertex({30, 13}), -1);
+    int n_constrained_halfedges = 0;
+    for (const auto &tri : cdt.m_triangles)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            if (tri.isConstrained(k) && tri.neighbours[k] != -1)
+            { //! kept parts are not bent towards rounded cut points
+                n_constrained_halfedges++;
+                EXPECT_EQ(orientation(wall.from, wall.to(), cdt.m_vertices[tri.vert_inds[k]]), 0);
+                EXPECT_EQ(orientation(wall.from, wall.to(), cdt.m_vertices[tri.vert_inds[next(k)]]), 0);
+            }
+        }
+    }
+    EXPECT_EQ(n_constrained_halfedges, 2 * 2);
+    EXPECT_TRUE(cdt.triangulationIsConsistent());
+
+    //! the restored wall is cut at the same grid points, so its parts merge back together
+    cdt.replaceConstraintsInRect({17, 5}, {27, 25}, std::vector<EdgeI<Vector2i>>{wall});
+    EXPECT_EQ(cdt.m_vertices.size(), 4 + 2);
+    EXPECT_TRUE(cdt.triangulationIsConsistent());
+}
+
+TEST(TestTriangulation, SearchGridFollowsEdits) {
+
+    using namespace cdt;
+
+    //! the search grid is never refreshed explicitly, it has to grow and shrink together with the triangulation
+    Triangulation cdt({200, 100});
+    auto all_queries_found = [&cdt]()
+    {
+        for (int i = 0; i < 200; ++i)
+        {
+            const Vector2f query = {(i * 53 % 199) + 0.5f, (i * 29 % 97) + 0.5f};
+            const auto tri_ind = cdt.findTriangle(query);
+            if (tri_ind == -1 || !isInTriangle(query, cdt.m_triangles[tri_ind], cdt.m_vertices))
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    EXPECT_TRUE(all_queries_found());
+    for (const auto &vertex : scatteredVertices(1000, {199, 97}))
+    {
+        cdt.insertVertex(vertex);
+    }
+    EXPECT_TRUE(all_queries_found());
+
+    for (VertInd v_ind = cdt.m_vertices.size() - 1; v_ind >= 4; --v_ind)
+    {
+        if (v_ind % 10 != 0)
+        {
+            ASSERT_TRUE(cdt.removeVertex(v_ind));
+        }
+    }
+    EXPECT_TRUE(all_queries_found());
+    EXPECT_TRUE(cdt.triangulationIsConsistent());
+}
+
+TEST(TestTriangulation, WalkFindsPointsOnVerticesAndEdges) {
+
+    using namespace cdt;
+
+    Triangulation cdt({100, 100});
+    std::vector<Vector2i> corners = {{10, 10}, {90, 20}, {50, 80}};
+    cdt.insertPolyline(corners, true);
+    for (const auto &vertex : scatteredVertices(300, {101, 97}))
+    {
+        cdt.insertVertex(vertex);
+    }
+    cdt.resetLocateStats();
+
+    for (VertInd v_ind = 0; v_ind < cdt.m_vertices.size(); ++v_ind)
+    {
+        const auto tri_ind = cdt.findTriangle(asFloat(cdt.m_vertices[v_ind]));
+        ASSERT_NE(tri_ind, -1);
+        const auto &vert_inds = cdt.m_triangles[tri_ind].vert_inds;
+        EXPECT_NE(std::find(vert_inds.begin(), vert_inds.end(), v_ind), vert_inds.end());
+    }
+    for (const auto &tri : cdt.m_triangles)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            const auto midpoint = asFloat(cdt.m_vertices[tri.vert_inds[k]] + cdt.m_vertices[tri.vert_inds[(k + 1) % 3]]) / 2.f;
+            const auto tri_ind = cdt.findTriangle(midpoint, true);
+            ASSERT_NE(tri_ind, -1);
+            EXPECT_TRUE(isInTriangle(midpoint, cdt.m_triangles[tri_ind], cdt.m_vertices));
+        }
+    }
+    EXPECT_EQ(cdt.findTriangle(Vector2f{-1.f, 50.f}), -1);
+
+    const auto &stats = cdt.locateStats();
+    EXPECT_EQ(stats.n_queries, cdt.m_vertices.size() + 3 * cdt.m_triangles.size());
+    EXPECT_EQ(stats.n_restarts, 0);
+}
+
+TEST(TestTriangulation, ConstrainedTriangulationStaysDelaunay) {
+
+    using namespace cdt;
+
+    Triangulation cdt({100, 100});
+    for (const auto &vertex : scatteredVertices(300, {101, 97}))
+    {
+        cdt.insertVertex(vertex);
+    }
+    for (int y = 3; y < 97; y += 4)
+    {
+        const auto from = cdt.insertVertexAndGetData((y * 13) % 50, y);
+        const VertInd from_ind = from.overlapping_vertex != -1 ? from.overlapping_vertex : cdt.m_vertices.size() - 1;
+        const auto to = cdt.insertVertexAndGetData((y * 13) % 50 + 40, y);
+        const VertInd to_ind = to.overlapping_vertex != -1 ? to.overlapping_vertex : cdt.m_vertices.size() - 1;
+        cdt.insertConstraint({from_ind, to_ind});
+    }
+    EXPECT_TRUE(cdt.triangulationIsConsistent());
+    EXPECT_TRUE(cdt.allAreDelaunay()); //! flips around the constraints used to compare the wrong circumcircle
+}
+
+TEST(TestTriangulation, CavityConstraintInsertion) {
+
+    using namespace cdt;
+
+    auto verts = scatteredVertices(600, {199, 197}, 1);
+    std::vector<EdgeI<Vector2i>> walls;
+    for (int y = 5; y < 195; y += 10)
+    {
+        walls.push_back({{(y * 13) % 50 + 2, y}, {(y * 13) % 50 + 140, y + 3}}); //! long, may run through vertices
+    }
+
+    Triangulation cavity({200, 200});
+    cavity.setConstraintInsertion(ConstraintInsertion::Cavity);
+    cavity.insertVertices(verts);
+    cavity.insertConstraints(walls);
+    EXPECT_TRUE(cavity.triangulationIsConsistent());
+    EXPECT_TRUE(cavity.allAreDelaunay());
+
+    for (const auto &wall : walls)
+    { //! the parts split by vertices lying on the wall join into the whole wall
+        EXPECT_TRUE(cavity.removeConstraint({cavity.findVertex(wall.from), cavity.findVertex(wall.to())}));
+    }
+    EXPECT_EQ(cavity.m_fixed_edges.size(), 4);
+    EXPECT_TRUE(cavity.allAreDelaunay());
+}
+
+TEST(TestTriangulation, VertexKnowsItsTriangle) {
+
+    using namespace cdt;
+
+    const auto every_vertex_has_its_triangle = [](const auto &cdt)
+    {
+        if (cdt.m_vertex2tri.size() != cdt.m_vertices.size())
+        {
+            return false;
+        }
+        for (VertInd v_ind = 0; v_ind < cdt.m_vertices.size(); ++v_ind)
+        {
+            const auto tri_ind = cdt.m_vertex2tri[v_ind];
+            if (tri_ind >= cdt.m_triangles.size() || cdt.indexOf(v_ind, cdt.m_triangles[tri_ind]) == -1)
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    auto verts = scatteredVertices(300, {99, 97}, 1);
+    Triangulation cdt({100, 100});
+    cdt.insertVertices(verts);
+    EXPECT_TRUE(every_vertex_has_its_triangle(cdt));
+
+    cdt.insertConstraints(std::vector<EdgeI<Vector2i>>{{{3, 10}, {90, 14}}, {{10, 50}, {10, 90}}, {{20, 20}, {80, 80}}});
+    EXPECT_TRUE(every_vertex_has_its_triangle(cdt));
+
+    for (VertInd v_ind = 5; v_ind < cdt.m_vertices.size(); v_ind += 7)
+    {
+        ASSERT_TRUE(cdt.removeVertex(v_ind));
+    }
+    EXPECT_TRUE(every_vertex_has_its_triangle(cdt));
+
+    cdt.buildFromVertices(verts);
+    EXPECT_TRUE(every_vertex_has_its_triangle(cdt));
+}
+
+TEST(TestTriangulation, ConstLocateFromSeveralThreads) {
+
+    using namespace cdt;
+
+    Triangulation cdt({200, 200});
+    for (const auto &vertex : scatteredVertices(2000, {199, 197}, 1))
+    {
+        cdt.insertVertex(vertex);
+    }
+    cdt.resetLocateStats();
+    const auto &shared_cdt = cdt;
+
+    //! each thread walks with its own cursor, the triangulation is only read
+    constexpr int n_threads = 4;
+    std::vector<int> n_found(n_threads, 0);
+    std::vector<LocateCursor> cursors(n_threads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n_threads; ++t)
+    {
+        threads.emplace_back([&, t]()
+                             {
+            for (int i = 0; i < 500; ++i)
+            {
+                const Vector2f query = {((i + t * 500) * 53 % 199) + 0.5f, ((i + t * 500) * 29 % 197) + 0.5f};
+                const auto tri_ind = shared_cdt.findTriangle(query, cursors[t], i % 2 == 1);
+                n_found[t] += tri_ind != -1 && isInTriangle(query, shared_cdt.m_triangles[tri_ind], shared_cdt.m_vertices);
+            } });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    for (int t = 0; t < n_threads; ++t)
+    {
+        EXPECT_EQ(n_found[t], 500);
+        EXPECT_EQ(cursors[t].stats.n_queries, 500);
+    }
+    EXPECT_EQ(cdt.locateStats().n_queries, 0);
+}
+
+TEST(TestTriangulation, LocateManyWithAndWithoutHints) {
+
+    using namespace cdt;
+
+    Triangulation cdt({300, 300});
+    for (const auto &vertex : scatteredVertices(3000, {299, 293}, 1))
+    {
+        cdt.insertVertex(vertex);
+    }
+    std::vector<Vector2f> agents;
+    for (int i = 0; i < 5000; ++i)
+    {
+        agents.push_back({(i * 53 % 297) + 1.5f, (i * 29 % 293) + 1.5f});
+    }
+    agents.push_back({-1.f, 10.f}); //! outside of the boundary
+
+    const auto all_located = [&](const std::vector<TriInd> &tri_inds)
+    {
+        for (std::size_t i = 0; i + 1 < agents.size(); ++i)
+        {
+            if (tri_inds[i] == -1 || !isInTriangle(agents[i], cdt.m_triangles[tri_inds[i]], cdt.m_vertices))
+            {
+                return false;
+            }
+        }
+        return tri_inds.back() == -1;
+    };
+
+    ThreadPool pool(4);
+    std::vector<TriInd> tri_inds(agents.size());
+    cdt.locateMany(agents, tri_inds);
+    EXPECT_TRUE(all_located(tri_inds));
+    std::fill(tri_inds.begin(), tri_inds.end(), 0);
+    cdt.locateMany(agents, tri_inds, false, &pool);
+    EXPECT_TRUE(all_located(tri_inds));
+
+    //! agents move a little, their previous triangles are the hints, some of them got lost
+    for (std::size_t i = 0; i + 1 < agents.size(); ++i)
+    {
+        agents[i] += Vector2f{(i % 3) - 1.f, (i % 5) * 0.5f - 1.f};
+    }
+    for (std::size_t i = 0; i < tri_inds.size(); i += 7)
+    {
+        tri_inds[i] = -1;
+    }
+    cdt.locateMany(agents, tri_inds, true, &pool);
+    EXPECT_TRUE(all_located(tri_inds));
+}
+
+TEST(TestTriangulation, SnapshotRoundTrip) {
+
+    using namespace cdt;
+
+    Triangulation cdt({200, 200});
+    for (const auto &vertex : scatteredVertices(500, {199, 197}, 1))
+    {
+        cdt.insertVertex(vertex);
+    }
+    const std::vector<EdgeI<Vector2i>> walls = {{{10, 10}, {150, 40}}, {{20, 180}, {190, 120}}};
+    cdt.insertConstraints(walls);
+    const std::vector<float> widths(3 * cdt.m_triangles.size(), 2.5f);
+
+    const auto filename = (std::filesystem::temp_directory_path() / "cdt_snapshot_test.bin").string();
+    cdt.saveSnapshot(filename, widths);
+
+    Triangulation<Vector2i> loaded;
+    {
+        SnapshotFile snapshot(filename);
+        loaded.loadSnapshot(snapshot);
+        const auto stored_widths = snapshot.array<float>(SnapshotSection::TriangleWidths);
+        EXPECT_TRUE(std::equal(widths.begin(), widths.end(), stored_widths.begin(), stored_widths.end()));
+    }
+    EXPECT_EQ(loaded.m_vertices, cdt.m_vertices);
+    EXPECT_EQ(loaded.m_vertex2tri, cdt.m_vertex2tri);
+    ASSERT_EQ(loaded.m_triangles.size(), cdt.m_triangles.size());
+    for (std::size_t tri_ind = 0; tri_ind < cdt.m_triangles.size(); ++tri_ind)
+    {
+        EXPECT_EQ(loaded.m_triangles[tri_ind].vert_inds, cdt.m_triangles[tri_ind].vert_inds);
+        EXPECT_EQ(loaded.m_triangles[tri_ind].neighbours, cdt.m_triangles[tri_ind].neighbours);
+        EXPECT_EQ(loaded.m_triangles[tri_ind].constraints, cdt.m_triangles[tri_ind].constraints);
+    }
+    EXPECT_EQ(loaded.m_fixed_edges.size(), cdt.m_fixed_edges.size());
+    EXPECT_TRUE(loaded.triangulationIsConsistent());
+
+    LocateCursor cursor;
+    LocateCursor loaded_cursor;
+    for (int i = 0; i < 100; ++i)
+    {
+        const Vector2f query = {(i * 13 % 197) + 0.5f, (i * 7 % 193) + 0.5f};
+        EXPECT_EQ(loaded.findTriangle(query, loaded_cursor), cdt.findTriangle(query, cursor));
+    }
+
+    //! the loaded triangulation can be edited further
+    loaded.insertVertex({5, 100});
+    loaded.insertVertex({100, 5});
+    loaded.insertConstraint({loaded.findVertex({5, 100}), loaded.findVertex({100, 5})});
+    EXPECT_TRUE(loaded.triangulationIsConsistent());
+
+    //! a damaged neighbour index is caught by loading instead of by the first query
+    std::uint64_t triangles_offset = 0;
+    {
+        SnapshotFile snapshot(filename);
+        triangles_offset = snapshot.header().sections[static_cast<std::size_t>(SnapshotSection::Triangles)].offset;
+    }
+    {
+        std::fstream file(filename, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(triangles_offset + offsetof(Triangle, neighbours));
+        const TriInd out_of_range = cdt.m_triangles.size() + 7;
+        file.write(reinterpret_cast<const char *>(&out_of_range), sizeof(out_of_range));
+    }
+    {
+        SnapshotFile snapshot(filename);
+        Triangulation<Vector2i> damaged;
+        EXPECT_THROW(damaged.loadSnapshot(snapshot), std::runtime_error);
+    }
+
+    //! sections not holding a whole number of elements are rejected
+    const std::byte odd_bytes[5] = {};
+    const SnapshotSectionData odd_sections[] = {{SnapshotSection::TriangleWidths, odd_bytes}};
+    writeSnapshot(filename, SnapshotHeader{}, odd_sections);
+    EXPECT_THROW(SnapshotFile{filename}.array<float>(SnapshotSection::TriangleWidths), std::runtime_error);
+
+    {
+        std::ofstream garbage(filename, std::ios::binary | std::ios::trunc);
+        garbage << "not a snapshot at all";
+    }
+    EXPECT_THROW(SnapshotFile{filename}, std::runtime_error);
+    std::filesystem::remove(filename);
+}
+
+TEST(TestTriangulation, ReorderKeepsTriangulation) {
+
+    using namespace cdt;
+
+    Triangulation cdt({300, 300});
+    for (const auto &vertex : scatteredVertices(3000, {299, 293}, 1))
+    {
+        cdt.insertVertex(vertex);
+    }
+    const std::vector<EdgeI<Vector2i>> walls = {{{10, 10}, {250, 40}}, {{20, 280}, {290, 120}}};
+    cdt.insertConstraints(walls);
+
+    const auto old_triangles = cdt.m_triangles;
+    const auto old_vertices = cdt.m_vertices;
+    const auto n_fixed_edges = cdt.m_fixed_edges.size();
+    //! mean distance in memory between neighbouring triangles
+    auto mean_neighbour_distance = [](const std::vector<Triangle> &triangles)
+    {
+        double distance = 0.;
+        for (TriInd tri_ind = 0; tri_ind < triangles.size(); ++tri_ind)
+        {
+            for (const auto neighbour : triangles[tri_ind].neighbours)
+            {
+                distance += neighbour == -1 ? 0. : std::abs(static_cast<double>(neighbour) - tri_ind);
+            }
+        }
+        return distance / triangles.size();
+    };
+
+    const auto reordering = cdt.reorder();
+    EXPECT_TRUE(cdt.triangulationIsConsistent());
+    EXPECT_TRUE(cdt.allAreDelaunay());
+    EXPECT_LT(mean_neighbour_distance(cdt.m_triangles), mean_neighbour_distance(old_triangles) / 4.);
+
+    ASSERT_EQ(reordering.new_vert_inds.size(), old_vertices.size());
+    for (VertInd v_ind = 0; v_ind < old_vertices.size(); ++v_ind)
+    {
+        EXPECT_TRUE(cdt.m_vertices[reordering.new_vert_inds[v_ind]] == old_vertices[v_ind]);
+    }
+    ASSERT_EQ(reordering.new_tri_inds.size(), old_triangles.size());
+    for (TriInd tri_ind = 0; tri_ind < old_triangles.size(); ++tri_ind)
+    {
+        const auto &old_tri = old_triangles[tri_ind];
+        const auto &tri = cdt.m_triangles[reordering.new_tri_inds[tri_ind]];
+        EXPECT_EQ(tri.constraints, old_tri.constraints);
+        EXPECT_TRUE(cdt.vertexOf(tri, 0) == old_vertices[old_tri.vert_inds[0]]);
+    }
+    EXPECT_EQ(cdt.m_fixed_edges.size(), n_fixed_edges); //! the set got refilled from the constraint flags
+
+    LocateCursor cursor;
+    for (int i = 0; i < 100; ++i)
+    {
+        const Vector2f query = {(i * 13 % 297) + 0.5f, (i * 7 % 293) + 0.5f};
+        const auto tri_ind = cdt.findTriangle(query, cursor);
+        ASSERT_NE(tri_ind, -1);
+        EXPECT_TRUE(isInTriangle(query, cdt.m_triangles[tri_ind], cdt.m_vertices));
+    }
+
+    //! the reordered triangulation can be edited further
+    cdt.insertVertex({5, 100});
+    cdt.insertVertex({100, 5});
+    cdt.insertConstraint({cdt.findVertex({5, 100}), cdt.findVertex({100, 5})});
+    EXPECT_TRUE(cdt.triangulationIsConsistent());
+}
+
+TEST(TestTriangulation, ConstraintsStartingOnBoundary) {
+
+    using namespace cdt;
+
+    for (const auto mode : {ConstraintInsertion::EdgeFlips, ConstraintInsertion::Cavity})
+    {
+        Triangulation cdt({64, 64});
+        cdt.setConstraintInsertion(mode);
+        //! the second wall starts on the bottom boundary, the third one lies on the right boundary
+        const std::vector<EdgeI<Vector2i>> walls = {{{0, 36}, {64, 36}}, {{36, 0}, {36, 26}}, {{64, 10}, {64, 50}}};
+        cdt.insertConstraints(walls);
+        EXPECT_TRUE(cdt.triangulationIsConsistent());
+        EXPECT_TRUE(cdt.m_fixed_edges.contains({cdt.findVertex({36, 0}), cdt.findVertex({36, 26})}));
+    }
+}
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include "../Vector2.h"
+#include "../Predicates.h"
 
 TEST(TestBasicGeometry, Dot)
 {
@@ -172,3 +173,63 @@ TEST(TestSegmentsIntersectOrTouch, SegmentsTouchStartPoints)
     EXPECT_FLOAT_EQ(intersection.x, 5);
     EXPECT_FLOAT_EQ(intersection.y, 5);
 }
+
+TEST(TestExactPredicates, Orientation)
+{
+    using namespace cdt;
+
+    //! products of these coordinates do not fit into int anymore
+    Vector2i a(-2000000000, -2000000000);
+    Vector2i b(2000000000, 2000000000);
+    EXPECT_EQ(orientation(a, b, Vector2i{0, 0}), 0);
+    EXPECT_EQ(orientation(a, b, Vector2i{0, 1}), 1);
+    EXPECT_EQ(orientation(a, b, Vector2i{1, 0}), -1);
+
+    //! the query lies on the segment up to a fraction of float precision where the filter has to give up
+    Vector2f p(0.5f, 0.5f);
+    Vector2f q(12.f, 12.f);
+    Vector2f r(24.f, 24.f);
+    EXPECT_EQ(orientation(p, q, r), 0);
+    EXPECT_EQ(orientation(p, q, Vector2f{std::nextafter(24.f, 25.f), 24.f}), -1);
+    EXPECT_EQ(orientation(p, q, Vector2f{24.f, std::nextafter(24.f, 25.f)}), 1);
+    EXPECT_EQ(orientation(Vector2f{0.5f, 0.5f}, Vector2i{12, 12}, Vector2i{24, 24}), 0);
+}
+
+TEST(TestExactPredicates, InCircle)
+{
+    using namespace cdt;
+
+    //! counterclockwise points on a circle with radius 5 * 2^20
+    const int scale = 1 << 20;
+    Vector2i a(5 * scale, 0);
+    Vector2i b(0, 5 * scale);
+    Vector2i c(-3 * scale, 4 * scale);
+    EXPECT_EQ(inCircle(a, b, c, Vector2i{-4 * scale, -3 * scale}), 0);
+    EXPECT_EQ(inCircle(a, b, c, Vector2i{-4 * scale + 1, -3 * scale}), 1);
+    EXPECT_EQ(inCircle(a, b, c, Vector2i{-4 * scale - 1, -3 * scale}), -1);
+    EXPECT_EQ(inCircle(a, c, b, Vector2i{-4 * scale + 1, -3 * scale}), -1); //! clockwise triangle swaps the sign
+}
+
+TEST(TestExactPredicates, Int128Products)
+{
+    using cdt::detail::Int128;
+
+    const auto min = std::numeric_limits<std::int64_t>::min();
+    const auto max = std::numeric_limits<std::int64_t>::max();
+    const auto square_of_min = Int128::product(min, min); //! 2^126
+    EXPECT_EQ(square_of_min.high, std::uint64_t{1} << 62);
+    EXPECT_EQ(square_of_min.low, 0u);
+    const auto minus_one = Int128::product(-1, 1);
+    EXPECT_EQ(minus_one.high, ~std::uint64_t{0});
+    EXPECT_EQ(minus_one.low, ~std::uint64_t{0});
+    EXPECT_EQ(minus_one.sign(), -1);
+    EXPECT_EQ(Int128::product(0, min).sign(), 0);
+
+    //! (2^63 - 1)^2 and 2^126 differ by 2^64 - 1, which only the low half holds
+    const auto difference = square_of_min - Int128::product(max, max);
+    EXPECT_EQ(difference.high, 0u);
+    EXPECT_EQ(difference.low, ~std::uint64_t{0});
+    EXPECT_TRUE(Int128::product(max, max) < square_of_min);
+    EXPECT_TRUE(Int128::product(min, max) < Int128::product(max, -max));
+    EXPECT_FALSE(Int128::product(3, -5) < Int128::product(-5, 3));
+}
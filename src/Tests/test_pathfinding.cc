@@ -0,0 +1,336 @@
+#pragma once
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <filesystem>
+
+#include "../PathFinding/ChunkedWorld.h"
+#include "../PathFinding/PathHierarchy.h"
+#include "../PathFinding/PathQueryService.h"
+
+namespace
+{
+    //! \returns true if no part of \p path crosses any of \p walls
+    bool avoidsWalls(const std::vector<cdt::Vector2f> &path, const std::vector<EdgeI<Vertex>> &walls)
+    {
+        for (std::size_t i = 0; i + 1 < path.size(); ++i)
+        {
+            for (const auto &wall : walls)
+            {
+                if (segmentsIntersect(path[i], path[i + 1], asFloat(wall.from), asFloat(wall.to())))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    float pathLength(const std::deque<cdt::Vector2f> &path)
+    {
+        float length = 0.f;
+        for (std::size_t i = 0; i + 1 < path.size(); ++i)
+        {
+            length += norm(path[i + 1] - path[i]);
+        }
+        return length;
+    }
+
+    //! walls of the default map: a long one with a gap at its right end and a short one below it
+    const std::vector<EdgeI<Vertex>> map_walls = {{{0, 100}, {170, 100}}, {{100, 30}, {100, 90}}};
+
+    //! \returns map of \p size with \p n_vertices scattered inside of its boundary and \p walls as constraints
+    Triangulation<Vertex> makeWalledMap(Vertex size = {200, 200}, int n_vertices = 1000,
+                                        const std::vector<EdgeI<Vertex>> &walls = map_walls)
+    {
+        Triangulation<Vertex> cdt(size);
+        for (int i = 0; i < n_vertices; ++i)
+        {
+            cdt.insertVertex({(i * 37) % (size.x - 1) + 1, (i * 61) % (size.y - 3) + 1});
+        }
+        cdt.insertConstraints(walls);
+        return cdt;
+    }
+
+    //! \returns start and end of the \p i-th query in [5, \p range + 5), off the integer grid so no point lies on an edge
+    std::pair<cdt::Vector2f, cdt::Vector2f> makeQuery(int i, int range = 190)
+    {
+        return {{(i * 53) % range + 5.37f, (i * 29) % range + 5.61f},
+                {(i * 31) % range + 5.43f, (i * 71) % range + 5.29f}};
+    }
+} // namespace
+
+TEST(TestPathFinder, ReorderKeepsPaths) {
+
+    using namespace cdt;
+
+    auto cdt = makeWalledMap();
+
+    PathFinder path_finder(cdt);
+    path_finder.update();
+    const auto path = path_finder.doPathFinding({10.f, 10.f}, {10.f, 180.f}, 1.f).path;
+
+    path_finder.reorder(cdt.reorder());
+    const auto widths = path_finder.triangle2tri_widths_;
+    path_finder.update();
+    for (std::size_t tri_ind = 0; tri_ind < widths.size(); ++tri_ind)
+    {
+        EXPECT_TRUE(std::equal(widths[tri_ind].widths, widths[tri_ind].widths + 3,
+                               path_finder.triangle2tri_widths_[tri_ind].widths));
+    }
+
+    const auto reordered_path = path_finder.doPathFinding({10.f, 10.f}, {10.f, 180.f}, 1.f).path;
+    ASSERT_FALSE(reordered_path.empty());
+    EXPECT_TRUE(avoidsWalls({reordered_path.begin(), reordered_path.end()}, map_walls));
+    EXPECT_NEAR(pathLength(reordered_path), pathLength(path), 1e-3f * pathLength(path));
+}
+
+TEST(TestPathFinder, SearchesDoNotShareState) {
+
+    using namespace cdt;
+
+    auto cdt = makeWalledMap();
+
+    //! every query of the reused path finder has to match the same query of a fresh one
+    PathFinder reused(cdt);
+    reused.update();
+    const std::vector<std::pair<cdt::Vector2f, cdt::Vector2f>> queries = {
+        {{10.f, 10.f}, {10.f, 180.f}}, {{150.f, 50.f}, {20.f, 60.f}}, {{10.f, 180.f}, {190.f, 190.f}},
+        {{50.f, 50.f}, {150.f, 150.f}}, {{10.f, 10.f}, {10.f, 180.f}}};
+    for (const auto &[r_start, r_end] : queries)
+    {
+        PathFinder fresh(cdt);
+        fresh.update();
+        const auto path = reused.doPathFinding(r_start, r_end, 1.f).path;
+        const auto fresh_path = fresh.doPathFinding(r_start, r_end, 1.f).path;
+        EXPECT_TRUE(std::equal(path.begin(), path.end(), fresh_path.begin(), fresh_path.end(), vequal));
+        EXPECT_TRUE(avoidsWalls({path.begin(), path.end()}, map_walls));
+    }
+}
+
+TEST(TestPathFinder, ReducedGraphFindsSamePaths) {
+
+    using namespace cdt;
+
+    //! a row of narrow gaps and a closed room make corridors, dead ends and a loop around the room
+    const auto cdt = makeWalledMap({200, 200}, 600,
+                                   {{{0, 100}, {40, 100}}, {{42, 100}, {90, 100}}, {{93, 100}, {150, 100}},
+                                    {{155, 100}, {200, 100}}, {{120, 130}, {160, 130}}, {{160, 130}, {160, 170}},
+                                    {{160, 170}, {120, 170}}, {{120, 170}, {120, 130}}, {{30, 20}, {30, 80}},
+                                    {{33, 20}, {33, 80}}});
+
+    PathFinder path_finder(cdt);
+    path_finder.update();
+    for (int i = 0; i < 100; ++i)
+    {
+        const auto [r_start, r_end] = makeQuery(i);
+        const float radius = 0.2f + (i % 4) * 0.6f;
+
+        path_finder.setUseReducedGraph(false);
+        const auto path = path_finder.doPathFinding(r_start, r_end, radius).path;
+        path_finder.setUseReducedGraph(true);
+        const auto reduced_path = path_finder.doPathFinding(r_start, r_end, radius).path;
+
+        //! triangles of both paths have the same cost, but ties may pick different triangles
+        EXPECT_NEAR(pathLength(reduced_path), pathLength(path), 1e-2f * pathLength(path));
+    }
+}
+
+TEST(TestPathFinder, QueryServiceMatchesSerialSearch) {
+
+    using namespace cdt;
+
+    auto cdt = makeWalledMap();
+
+    PathFinder path_finder(cdt);
+    path_finder.update();
+    std::vector<PathQueryService::Request> requests;
+    for (int i = 0; i < 64; ++i)
+    {
+        const auto [r_start, r_end] = makeQuery(i);
+        requests.push_back({r_start, r_end, 1.f});
+    }
+
+    PathQueryService service(path_finder, 4);
+    auto futures = service.submit(requests);
+    std::vector<std::deque<cdt::Vector2f>> found(requests.size());
+    service.submit(requests, [&found](std::size_t request_ind, PathFinder::PathData &&path)
+                   { found[request_ind] = std::move(path.path); });
+    service.wait();
+
+    for (std::size_t i = 0; i < requests.size(); ++i)
+    {
+        const auto &[r_start, r_end, radius] = requests[i];
+        const auto path = path_finder.doPathFinding(r_start, r_end, radius).path;
+        const auto future_path = futures[i].get().path;
+        EXPECT_TRUE(std::equal(path.begin(), path.end(), future_path.begin(), future_path.end(), vequal));
+        EXPECT_TRUE(std::equal(path.begin(), path.end(), found[i].begin(), found[i].end(), vequal));
+    }
+}
+
+TEST(TestPathFinder, QueryServiceRethrowsCallbackErrors) {
+
+    using namespace cdt;
+
+    auto cdt = makeWalledMap();
+
+    PathFinder path_finder(cdt);
+    path_finder.update();
+    std::vector<PathQueryService::Request> requests;
+    for (int i = 0; i < 16; ++i)
+    {
+        const auto [r_start, r_end] = makeQuery(i);
+        requests.push_back({r_start, r_end, 1.f});
+    }
+
+    //! a throwing callback neither kills its worker nor keeps wait() from returning
+    PathQueryService service(path_finder, 2);
+    std::atomic<int> n_found = 0;
+    service.submit(requests, [&n_found](std::size_t request_ind, PathFinder::PathData &&)
+                   {
+                       if (request_ind % 4 == 0)
+                       {
+                           throw std::runtime_error("callback failed");
+                       }
+                       n_found++;
+                   });
+    EXPECT_THROW(service.wait(), std::runtime_error);
+    EXPECT_EQ(n_found, 12);
+
+    service.submit(requests, [&n_found](std::size_t, PathFinder::PathData &&)
+                   { n_found++; });
+    EXPECT_NO_THROW(service.wait());
+    EXPECT_EQ(n_found, 28);
+}
+
+TEST(TestPathHierarchy, PathsCloseToFlatSearch) {
+
+    using namespace cdt;
+
+    auto cdt = makeWalledMap({256, 256}, 1500,
+                             {{{0, 100}, {40, 100}}, {{42, 100}, {90, 100}}, {{93, 100}, {150, 100}},
+                              {{155, 100}, {256, 100}}, {{120, 130}, {160, 130}}, {{160, 130}, {160, 170}},
+                              {{160, 170}, {120, 170}}, {{120, 170}, {120, 130}}, {{30, 20}, {30, 80}},
+                              {{200, 150}, {200, 250}}});
+
+    PathFinder path_finder(cdt);
+    path_finder.update();
+    PathHierarchy hierarchy(cdt, path_finder, 32, 1.f);
+    hierarchy.update();
+    EXPECT_EQ(hierarchy.nRefreshedChunks(), hierarchy.nChunks());
+
+    const auto check_paths = [&]()
+    {
+        for (int i = 0; i < 100; ++i)
+        {
+            const auto [r_start, r_end] = makeQuery(i, 246);
+            const float radius = (i % 3) * 0.5f;
+
+            const auto path = path_finder.doPathFinding(r_start, r_end, radius).path;
+            const auto hierarchy_path = hierarchy.findPath(r_start, r_end, radius).path;
+            ASSERT_GE(hierarchy_path.size(), 2);
+            EXPECT_TRUE(vequal(hierarchy_path.front(), r_start));
+            EXPECT_TRUE(vequal(hierarchy_path.back(), r_end));
+            //! the coarse search only picks the chunks, so the path may take a longer way around obstacles
+            EXPECT_LE(pathLength(hierarchy_path), 1.2f * pathLength(path) + 1e-3f);
+        }
+    };
+    check_paths();
+
+    //! closing a gap changes only a few chunks around it
+    cdt.insertConstraints(std::vector<EdgeI<Vertex>>{{{40, 100}, {42, 100}}});
+    path_finder.update();
+    hierarchy.update();
+    EXPECT_GT(hierarchy.nRefreshedChunks(), 0);
+    EXPECT_LT(hierarchy.nRefreshedChunks(), hierarchy.nChunks() / 4);
+    check_paths();
+}
+
+TEST(TestChunkedWorld, PathCrossesChunks) {
+
+    using namespace cdt;
+
+    //! 4x3 chunks of 64x64, a horizontal wall with a gap near the right end splits the world,
+    //! a vertical wall crosses the seam between chunks (1,0) and (1,1)
+    std::vector<EdgeI<Vertex>> walls = {{{0, 100}, {200, 100}}, {{230, 100}, {256, 100}}, {{100, 30}, {100, 90}}};
+    const ChunkedWorld *observed_world = nullptr;
+    std::size_t max_loaded_chunks = 0; //! loaded chunks seen whenever a chunk gets built, also in the middle of a query
+    ChunkedWorld world({64, 64}, {4, 3}, [&](Vector2i, Vector2i)
+                       {
+                           if (observed_world)
+                           {
+                               max_loaded_chunks = std::max(max_loaded_chunks, observed_world->nLoadedChunks());
+                           }
+                           return walls;
+                       });
+    observed_world = &world;
+    const auto cache_directory = std::filesystem::temp_directory_path() / "cdt_chunked_world_test";
+    world.setCacheDirectory(cache_directory);
+    world.setMaxLoadedChunks(3);
+    world.setSearchMargin(3); //! the gap lies three chunks away from start and end
+
+    const Vector2f r_start = {10.f, 10.f};
+    const Vector2f r_end = {10.f, 180.f};
+    const auto path = world.findPath(r_start, r_end, 1.f);
+    ASSERT_GE(path.size(), 2);
+    EXPECT_TRUE(vequal(path.front(), r_start));
+    EXPECT_TRUE(vequal(path.back(), r_end));
+    EXPECT_TRUE(avoidsWalls(path, walls));
+    EXPECT_TRUE(std::any_of(path.begin(), path.end(), [](Vector2f r)
+                            { return r.x > 195.f && r.x < 235.f && std::abs(r.y - 100.f) < 5.f; }));
+    EXPECT_LE(world.nLoadedChunks(), 3);
+    EXPECT_LE(max_loaded_chunks, 3 + 1); //! the chunk being built counts already
+
+    //! evicted chunks come back from the cache and give the same path
+    EXPECT_EQ(world.findPath(r_start, r_end, 1.f).size(), path.size());
+
+    //! closing the gap rebuilds the chunks around it, the two halves are no longer connected
+    walls.push_back({{200, 100}, {230, 100}});
+    world.invalidate({200, 100}, {230, 100});
+    EXPECT_TRUE(world.findPath(r_start, r_end, 1.f).empty());
+    EXPECT_FALSE(world.findPath(r_start, {250.f, 20.f}, 1.f).empty());
+    EXPECT_LE(max_loaded_chunks, 3 + 1);
+
+    std::filesystem::remove_all(cache_directory);
+}
+
+TEST(TestChunkedWorld, NarrowGapBlocksWideAgents) {
+
+    using namespace cdt;
+
+    //! a wall across the single chunk with a gap of 2 which the regions of the chunk do not know about
+    const std::vector<EdgeI<Vertex>> walls = {{{0, 32}, {30, 32}}, {{32, 32}, {64, 32}}};
+    ChunkedWorld world({64, 64}, {1, 1}, [&walls](Vector2i, Vector2i)
+                       { return walls; });
+
+    EXPECT_TRUE(world.findPath({10.f, 10.f}, {10.f, 50.f}, 3.f).empty());
+
+    const auto path = world.findPath({10.f, 10.f}, {10.f, 50.f}, 0.5f);
+    ASSERT_GE(path.size(), 2);
+    EXPECT_TRUE(avoidsWalls(path, walls));
+}
+
+TEST(TestChunkedWorld, NarrowGapTakesWiderDetour) {
+
+    using namespace cdt;
+
+    //! the wall has a gap of 2 in the left chunk and a gap of 10 in the right one, both chunks are single regions
+    const std::vector<EdgeI<Vertex>> walls = {{{0, 32}, {30, 32}}, {{32, 32}, {100, 32}}, {{110, 32}, {128, 32}}};
+    ChunkedWorld world({64, 64}, {2, 1}, [&walls](Vector2i, Vector2i)
+                       { return walls; });
+
+    const Vector2f r_start = {10.f, 10.f};
+    const Vector2f r_end = {10.f, 50.f};
+    const auto path = world.findPath(r_start, r_end, 3.f);
+    ASSERT_GE(path.size(), 2);
+    EXPECT_TRUE(vequal(path.front(), r_start));
+    EXPECT_TRUE(vequal(path.back(), r_end));
+    EXPECT_TRUE(avoidsWalls(path, walls));
+    EXPECT_TRUE(std::any_of(path.begin(), path.end(), [](Vector2f r)
+                            { return r.x > 100.f && r.x < 110.f && std::abs(r.y - 32.f) < 5.f; }));
+
+    //! the narrow gap is still taken by agents fitting through it
+    const auto narrow_path = world.findPath(r_start, r_end, 0.5f);
+    EXPECT_TRUE(std::none_of(narrow_path.begin(), narrow_path.end(), [](Vector2f r)
+                             { return r.x > 64.f; }));
+}
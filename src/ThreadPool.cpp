@@ -0,0 +1,92 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace cdt
+{
+
+    //! \param n_threads number of threads working on a batch including the caller of parallelFor
+    ThreadPool::ThreadPool(std::size_t n_threads)
+    {
+        n_threads = std::max<std::size_t>(n_threads, 1);
+        m_workers.reserve(n_threads - 1);
+        for (std::size_t i = 0; i + 1 < n_threads; ++i)
+        {
+            m_workers.emplace_back([this]()
+                                   { workerLoop(); });
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::scoped_lock lock(m_mutex);
+            m_is_stopping = true;
+        }
+        m_batch_started.notify_all();
+        for (auto &worker : m_workers)
+        {
+            worker.join();
+        }
+    }
+
+    //! \brief calls \p job(i) for each i in [0, \p n_jobs) spread over the threads of the pool
+    //! \brief returns after all the jobs finished. Must not be called from several threads at once
+    //! \param n_jobs number of jobs
+    //! \param job function running a single job, it must not throw
+    void ThreadPool::parallelFor(std::size_t n_jobs, const std::function<void(std::size_t)> &job)
+    {
+        if (n_jobs == 0)
+        {
+            return;
+        }
+
+        std::unique_lock lock(m_mutex);
+        m_job = &job;
+        m_n_jobs = n_jobs;
+        m_next_job = 0;
+        m_n_finished_jobs = 0;
+        m_batch_ind++;
+        m_batch_started.notify_all();
+
+        runJobs(lock);
+        m_batch_finished.wait(lock, [this]()
+                              { return m_n_finished_jobs == m_n_jobs; });
+        m_job = nullptr;
+    }
+
+    void ThreadPool::workerLoop()
+    {
+        std::size_t last_batch_ind = 0;
+        std::unique_lock lock(m_mutex);
+        while (true)
+        {
+            m_batch_started.wait(lock, [&]()
+                                 { return m_is_stopping || m_batch_ind != last_batch_ind; });
+            if (m_is_stopping)
+            {
+                return;
+            }
+            last_batch_ind = m_batch_ind;
+            runJobs(lock);
+        }
+    }
+
+    //! \brief takes jobs of the current batch until there are none left, \p lock is released while a job runs
+    void ThreadPool::runJobs(std::unique_lock<std::mutex> &lock)
+    {
+        while (m_next_job < m_n_jobs)
+        {
+            const auto job_ind = m_next_job++;
+            const auto *job = m_job;
+            lock.unlock();
+            (*job)(job_ind);
+            lock.lock();
+            if (++m_n_finished_jobs == m_n_jobs)
+            {
+                m_batch_finished.notify_all();
+            }
+        }
+    }
+
+} // namespace cdt
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cdt
+{
+
+    //! \class fixed set of worker threads running batches of numbered jobs
+    //! \brief the thread calling parallelFor works on the batch as well, so a pool of size 1 has no workers
+    class ThreadPool
+    {
+    public:
+        explicit ThreadPool(std::size_t n_threads = std::thread::hardware_concurrency());
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        //! \returns number of threads running the jobs including the one calling parallelFor
+        std::size_t size() const { return m_workers.size() + 1; }
+
+        void parallelFor(std::size_t n_jobs, const std::function<void(std::size_t)> &job);
+
+    private:
+        void workerLoop();
+        void runJobs(std::unique_lock<std::mutex> &lock);
+
+    private:
+        std::vector<std::thread> m_workers;
+
+        std::mutex m_mutex; //! guards everything below
+        std::condition_variable m_batch_started;
+        std::condition_variable m_batch_finished;
+        const std::function<void(std::size_t)> *m_job = nullptr;
+        std::size_t m_n_jobs = 0;
+        std::size_t m_next_job = 0;
+        std::size_t m_n_finished_jobs = 0;
+        std::size_t m_batch_ind = 0; //! lets sleeping workers tell a new batch from a spurious wake up
+        bool m_is_stopping = false;
+    };
+
+} // namespace cdt
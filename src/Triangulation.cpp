@@ -1,10 +1,17 @@
 #include "Triangulation.h"
+#include "DelaunayBuilder.h"
+#include "ThreadPool.h"
+#include "Snapshot.h"
 
 #include <fstream>
 #include <iostream>
 #include <string>
 #include <stack>
 #include <queue>
+#include <unordered_set>
+#include <random>
+#include <numeric>
+#include <type_traits>
 
 #include <SFML/Graphics.hpp>
 
@@ -30,9 +37,8 @@ void inline drawTriInds(cdt::Triangulation<cdt::Vector2i> &cdt, sf::RenderWindow
     num.setFillColor(sf::Color::Blue);
     for (int ind = 0; ind < cdt.m_triangles.size(); ++ind)
     {
-        auto &tri = cdt.m_triangles.at(ind);
         num.setString(std::to_string(ind));
-        auto center = asFloat(tri.verts[0] + tri.verts[1] + tri.verts[2]) / 3.f;
+        auto center = cdt.getCenter(ind);
         num.setPosition(center.x, center.y); // - sf::Vector2f(num.getGlobalBounds().width, num.getLocalBounds().height)
         num.setScale(0.03f, 0.03f);
         window.draw(num);
@@ -42,21 +48,124 @@ void inline drawTriInds(cdt::Triangulation<cdt::Vector2i> &cdt, sf::RenderWindow
 void inline drawTriangulation(cdt::Triangulation<cdt::Vector2i> &cdt, sf::RenderWindow &window)
 {
     window.clear(sf::Color::White);
-    int tri_ind = 0;
     for (auto &tri : cdt.m_triangles)
     {
-        sf::Vector2f v1(tri.verts[0].x, tri.verts[0].y);
-        sf::Vector2f v2(tri.verts[1].x, tri.verts[1].y);
-        sf::Vector2f v3(tri.verts[2].x, tri.verts[2].y);
-        tri.is_constrained[0] ? drawLine(window, v1, v2, sf::Color::Red) : drawLine(window, v1, v2);
-        tri.is_constrained[1] ? drawLine(window, v2, v3, sf::Color::Red) : drawLine(window, v2, v3);
-        tri.is_constrained[2] ? drawLine(window, v3, v1, sf::Color::Red) : drawLine(window, v3, v1);
+        for (int k = 0; k < 3; ++k)
+        {
+            const auto &v_from = cdt.vertexOf(tri, k);
+            const auto &v_to = cdt.vertexOf(tri, cdt::next(k));
+            sf::Vector2f v1(v_from.x, v_from.y);
+            sf::Vector2f v2(v_to.x, v_to.y);
+            tri.isConstrained(k) ? drawLine(window, v1, v2, sf::Color::Red) : drawLine(window, v1, v2);
+        }
     }
 }
 
 namespace cdt
 {
 
+    namespace
+    {
+        //! the search grid gets about this many triangles per cell, so a walk from the cell takes only a few steps
+        constexpr std::size_t triangles_per_cell = 4;
+
+        //! \returns \p a / \p b rounded down, \p b must be nonzero
+        inline long long floorDiv(long long a, long long b)
+        {
+            const auto quotient = a / b;
+            return quotient - ((a % b != 0) && ((a < 0) != (b < 0)));
+        }
+
+        //! \returns \p a / \p b rounded up, \p b must be nonzero
+        inline long long ceilDiv(long long a, long long b)
+        {
+            return -floorDiv(-a, b);
+        }
+
+        //! \brief cuts the segment [\p from, \p to] to its shortest part which covers the intersection with the
+        //! \brief rectangle [\p lower_left, \p upper_right] and ends at grid points lying on the segment. Cut points
+        //! \brief are exact, but lie outside of the rectangle unless the segment crosses its border at a grid point
+        //! \returns false if less than a single point of the segment lies in the rectangle
+        template <class Vertex>
+        bool clipToRect(Vertex &from, Vertex &to, const Vertex &lower_left, const Vertex &upper_right)
+        {
+            const long long dx = static_cast<long long>(to.x) - from.x;
+            const long long dy = static_cast<long long>(to.y) - from.y;
+            //! grid points of the segment are from + k * d / n_steps for k in [0, n_steps]
+            const long long n_steps = std::gcd(dx, dy);
+            if (n_steps == 0)
+            {
+                return false;
+            }
+            //! the part in the rectangle is t in [t_min, t_max] along from + t * d, kept as fractions with positive
+            //! denominators so that the comparisons stay exact
+            long long t_min_num = 0, t_min_den = 1;
+            long long t_max_num = 1, t_max_den = 1;
+            long long k_min = 0;
+            long long k_max = n_steps;
+            //! keeps the part satisfying p * t <= q
+            auto clip = [&](long long p, long long q)
+            {
+                if (p == 0)
+                {
+                    return q >= 0;
+                }
+                if (p < 0)
+                {
+                    p = -p;
+                    q = -q; //! t >= q / p
+                    if (q * t_min_den > t_min_num * p)
+                    {
+                        t_min_num = q;
+                        t_min_den = p;
+                    }
+                    k_min = std::max(k_min, floorDiv(q * n_steps, p));
+                }
+                else
+                {
+                    if (q * t_max_den < t_max_num * p)
+                    {
+                        t_max_num = q;
+                        t_max_den = p;
+                    }
+                    k_max = std::min(k_max, ceilDiv(q * n_steps, p));
+                }
+                return t_min_num * t_max_den < t_max_num * t_min_den;
+            };
+            if (!clip(-dx, static_cast<long long>(from.x) - lower_left.x) ||
+                !clip(dx, static_cast<long long>(upper_right.x) - from.x) ||
+                !clip(-dy, static_cast<long long>(from.y) - lower_left.y) ||
+                !clip(dy, static_cast<long long>(upper_right.y) - from.y))
+            {
+                return false;
+            }
+            const auto step_x = dx / n_steps;
+            const auto step_y = dy / n_steps;
+            const Vertex new_from(from.x + static_cast<int>(k_min * step_x), from.y + static_cast<int>(k_min * step_y));
+            to = Vertex(from.x + static_cast<int>(k_max * step_x), from.y + static_cast<int>(k_max * step_y));
+            from = new_from;
+            return true;
+        }
+
+        //! \brief sorts parts of \p values on the threads of \p pool and merges them pairwise
+        template <class T>
+        void parallelSort(std::vector<T> &values, ThreadPool &pool)
+        {
+            const std::size_t n_parts = pool.size();
+            auto part_begin = [&](std::size_t part)
+            { return values.begin() + std::min(part, n_parts) * values.size() / n_parts; };
+            pool.parallelFor(n_parts, [&](std::size_t part)
+                             { std::sort(part_begin(part), part_begin(part + 1)); });
+            for (std::size_t width = 1; width < n_parts; width *= 2)
+            {
+                pool.parallelFor((n_parts + 2 * width - 1) / (2 * width), [&](std::size_t pair_ind)
+                                 {
+                    const auto first = 2 * width * pair_ind;
+                    std::inplace_merge(part_begin(first), part_begin(first + width), part_begin(first + 2 * width)); });
+            }
+        }
+    } // namespace
+
     template <class Vertex>
     Triangulation<Vertex>::Triangulation(Vertex box_size)
         : m_boundary(box_size)
@@ -69,10 +178,10 @@ namespace cdt
     void Triangulation<Vertex>::reset()
     {
         m_vertices.clear();
+        m_vertex2tri.clear();
         m_triangles.clear();
-        m_tri_ind2vert_inds.clear();
         m_fixed_edges.clear();
-        m_last_found = 0;
+        m_cursor.hint = 0;
 
         std::fill(m_cell2tri_ind.begin(), m_cell2tri_ind.end(), -1);
         createBoundary(m_boundary);
@@ -85,196 +194,240 @@ namespace cdt
     template <class Vertex>
     TriInd Triangulation<Vertex>::findTriangle(Vertex query_point, bool from_last_found)
     {
+        if (!from_last_found && cellGridNeedsResize())
+        {
+            updateCellGrid();
+        }
+        return locateTriangle(query_point, m_cursor, from_last_found);
+    }
 
-        TriInd tri_ind = m_last_found;
-        if (!from_last_found)
+    //! \brief searches for triangle containing query_point
+    //! \param query_point point whose containing triangle we are looking for
+    //! \param start_from_last_found whether we start looking from previously found triangle... uses search grid if false
+    //!\returns index of a triangle containing query_point or -1 if no such triangle is found
+    template <class Vertex>
+    TriInd Triangulation<Vertex>::findTriangle(cdt::Vector2f query_point, bool from_last_found)
+    {
+        if (!from_last_found && cellGridNeedsResize())
         {
-            auto cell_ind = m_grid->coordToCell(asFloat(query_point));
-            tri_ind = m_cell2tri_ind.at(cell_ind);
-            if (tri_ind == -1)
-            { //! if there is no triangle yet in a cell we default to linear search
-                for (TriInd i = 0; i < m_triangles.size(); ++i)
-                {
-                    if (isInTriangle(query_point, m_triangles[i]))
-                    {
-                        m_last_found = i;
-                        return i;
-                    }
-                }
-            }
+            updateCellGrid();
         }
+        return locateTriangle(query_point, m_cursor, from_last_found);
+    }
+
+    //! \brief searches for triangle containing query_point without changing the triangulation, so any number of
+    //! \brief threads can call it at once as long as each one has its own \p cursor and nobody edits meanwhile
+    //! \param query_point point whose containing triangle we are looking for
+    //! \param cursor remembers where the previous query of the caller ended and counts the queries
+    //! \param start_from_hint whether we start looking from cursor.hint... uses search grid if false
+    //!\returns index of a triangle containing query_point or -1 if no such triangle is found
+    template <class Vertex>
+    TriInd Triangulation<Vertex>::findTriangle(cdt::Vector2f query_point, LocateCursor &cursor,
+                                               bool start_from_hint) const
+    {
+        return locateTriangle(query_point, cursor, start_from_hint);
+    }
 
-        Vertex v_current;
+    //! \brief integer version of the const findTriangle, it walks without floating point filters
+    template <class Vertex>
+    TriInd Triangulation<Vertex>::findTriangle(const Vertex &query_point, LocateCursor &cursor,
+                                               bool start_from_hint) const
+    {
+        return locateTriangle(query_point, cursor, start_from_hint);
+    }
 
-        if (isInTriangle(query_point, m_triangles[tri_ind]))
+    //! \brief finds triangles containing all of the \p queries at once, without changing the triangulation
+    //! \brief without hints the queries are bucketed by the search grid cell containing them and each walk starts
+    //! \brief where the previous one in the same cell ended. Queries with a hint walk from it, which takes just
+    //! \brief a few steps when they barely moved
+    //! \param queries points whose containing triangles we are looking for
+    //! \param tri_inds gets index of the triangle containing each query or -1, must be as long as \p queries
+    //! \param use_hints whether \p tri_inds already holds triangles found for the queries before (e.g. in the previous
+    //! \param use_hints tick), invalid ones like -1 are ignored
+    //! \param pool when given, the queries are split into chunks located by the threads of the pool
+    template <class Vertex>
+    void Triangulation<Vertex>::locateMany(std::span<const cdt::Vector2f> queries, std::span<TriInd> tri_inds,
+                                           bool use_hints, ThreadPool *pool) const
+    {
+        assert(queries.size() == tri_inds.size());
+        if (queries.empty())
         {
-            return tri_ind;
+            return;
         }
-        { //!  we look at triangle edges and find in which direction we need to go
-            const auto &tri = m_triangles[tri_ind];
 
-            const auto v0 = asFloat(tri.verts[0]);
-            const auto v1 = asFloat(tri.verts[1]);
-            const auto v2 = asFloat(tri.verts[2]);
-            const auto r_start = (v0 + v1 + v2) / 3.f;
-
-            if (segmentsIntersectOrTouch(r_start, asFloat(query_point), v0, v1))
-            {
-                tri_ind = tri.neighbours[0];
-                v_current = tri.verts[0];
-            }
-            else if (segmentsIntersectOrTouch(r_start, asFloat(query_point), v1, v2))
+        //! counting sort by cells is linear, a comparison sort along a curve costs more than the walks it shortens
+        std::vector<std::uint32_t> cell_inds;
+        std::vector<std::uint32_t> order;
+        if (!use_hints)
+        {
+            cell_inds.resize(queries.size());
+            std::vector<std::uint32_t> cell_starts(m_cell2tri_ind.size() + 1, 0);
+            for (std::size_t i = 0; i < queries.size(); ++i)
             {
-                tri_ind = tri.neighbours[1];
-                v_current = tri.verts[1];
+                cell_inds[i] = withinBoundary(queries[i]) ? m_grid->coordToCell(queries[i]) : 0;
+                cell_starts[cell_inds[i] + 1]++;
             }
-            else if (segmentsIntersectOrTouch(r_start, asFloat(query_point), v2, v0))
+            std::partial_sum(cell_starts.begin(), cell_starts.end(), cell_starts.begin());
+            order.resize(queries.size());
+            for (std::size_t i = 0; i < queries.size(); ++i)
             {
-                tri_ind = tri.neighbours[2];
-                v_current = tri.verts[2];
+                order[cell_starts[cell_inds[i]]++] = i;
             }
-            else
-            {
-                tri_ind = -1;
-            } // throw std::runtime_error("we should never get here!");}
         }
-        if (tri_ind == -1)
-        { //! if we cannot find way (no idea why yet) we do brute force
-            for (TriInd i = 0; i < m_triangles.size(); ++i)
+
+        //! chunks are small enough for the threads to balance their load but each still has enough queries
+        //! to share walks within the cells
+        constexpr std::size_t min_chunk_size = 64;
+        const std::size_t n_chunks =
+            pool ? std::clamp<std::size_t>(queries.size() / min_chunk_size, 1, 4 * pool->size()) : 1;
+        const auto locate_chunk = [&](std::size_t chunk_ind)
+        {
+            const auto begin = chunk_ind * queries.size() / n_chunks;
+            const auto end = (chunk_ind + 1) * queries.size() / n_chunks;
+            LocateCursor cursor;
+            for (auto i = begin; i < end; ++i)
             {
-                if (isInTriangle(query_point, m_triangles[i]))
+                const auto query_ind = use_hints ? i : order[i];
+                bool start_from_hint = false;
+                if (use_hints && tri_inds[query_ind] < m_triangles.size())
+                {
+                    cursor.hint = tri_inds[query_ind];
+                    start_from_hint = true;
+                }
+                else if (!use_hints && i > begin)
                 {
-                    m_last_found = i;
-                    return i;
+                    start_from_hint = cell_inds[query_ind] == cell_inds[order[i - 1]];
                 }
+                tri_inds[query_ind] = locateTriangle(queries[query_ind], cursor, start_from_hint);
             }
+        };
+
+        if (pool && n_chunks > 1)
+        {
+            pool->parallelFor(n_chunks, locate_chunk);
         }
-        //! walk in the found diraction to triangle containing end_ind;
-        while (!isInTriangle(query_point, m_triangles[tri_ind]))
+        else
         {
-            const auto &tri = m_triangles[tri_ind];
-
-            const auto index_in_tri = indexOf(v_current, tri);
-            assert(index_in_tri != -1);
-
-            const auto v1 = asFloat(tri.verts[next(index_in_tri)]);
-            const auto v2 = asFloat(tri.verts[prev(index_in_tri)]);
-
-            if (segmentsIntersectOrTouch(asFloat(v_current), asFloat(query_point), v1, v2))
-            {
-                tri_ind = tri.neighbours[next(index_in_tri)];
-                v_current = tri.verts[next(index_in_tri)];
-            }
-            else
-            {
-                tri_ind = tri.neighbours[index_in_tri];
-            }
+            locate_chunk(0);
         }
-
-        m_last_found = tri_ind;
-        return tri_ind;
     }
 
-    //! \brief searches for triangle containing query_point
-    //! \param query_point point whose containing triangle we are looking for
-    //! \param start_from_last_found whether we start looking from previously found triangle... uses search grid if false
-    //!\returns index of a triangle containing query_point or -1 if no such triangle is found
+    //! \brief implements all findTriangle overloads, integer queries keep their type so that the walk
+    //! \brief needs no floating point filters. The search grid is used as it is, only the non-const
+    //! \brief overloads resize it
     template <class Vertex>
-    TriInd Triangulation<Vertex>::findTriangle(cdt::Vector2f query_point, bool from_last_found)
+    template <class VectorType>
+    TriInd Triangulation<Vertex>::locateTriangle(const VectorType &query_point, LocateCursor &cursor,
+                                                 bool start_from_hint) const
     {
 
-        if(!withinBoundary(query_point))
+        if (!withinBoundary(query_point))
         {
             return -1;
         }
 
-        TriInd tri_ind = m_last_found;
-        if (!from_last_found)
+        cursor.stats.n_queries++;
+        //! the hint may come from before an edit which removed triangles
+        const TriInd hint = cursor.hint < m_triangles.size() ? cursor.hint : 0;
+        TriInd tri_ind = hint;
+        if (!start_from_hint)
         {
-            auto cell_ind = m_grid->coordToCell(query_point);
+            auto cell_ind = m_grid->coordToCell(static_cast<cdt::Vector2f>(query_point));
             tri_ind = m_cell2tri_ind.at(cell_ind);
-            if (tri_ind == -1)
-            { //! if there is no triangle yet in a cell we default to linear search
-                for (TriInd i = 0; i < m_triangles.size(); ++i)
-                {
-                    if (isInTriangle(query_point, m_triangles[i]))
-                    {
-                        m_last_found = i;
-                        return i;
-                    }
-                }
+            if (tri_ind == -1 || tri_ind >= m_triangles.size())
+            { //! if there is no valid triangle in a cell we walk from the last found one
+                cursor.stats.n_empty_cells++;
+                tri_ind = hint;
             }
         }
 
-        Vertex v_current;
-
-        if (isInTriangle(query_point, m_triangles[tri_ind]))
+        tri_ind = walkToTriangle(query_point, tri_ind, cursor);
+        //! the walk got stuck (possible only due to rounding), so we jump to the closest of a few sampled vertices
+        for (std::size_t n_samples = 8; tri_ind == -1 && n_samples <= 8 * m_triangles.size(); n_samples *= 2)
         {
-            return tri_ind;
+            cursor.stats.n_restarts++;
+            tri_ind = walkToTriangle(query_point,
+                                     sampleTriangleNear(static_cast<cdt::Vector2f>(query_point), n_samples, cursor),
+                                     cursor);
         }
-        { //!  we look at triangle edges and find in which direction we need to go
-            const auto &tri = m_triangles[tri_ind];
+        if (tri_ind == -1)
+        {
+            return -1;
+        }
+
+        cursor.hint = tri_ind; //! cache the result
+        return tri_ind;
+    }
 
-            const auto v0 = asFloat(tri.verts[0]);
-            const auto v1 = asFloat(tri.verts[1]);
-            const auto v2 = asFloat(tri.verts[2]);
-            const cdt::Vector2f r_start = (v0 + v1 + v2) / 3.f;
+    //! \brief remembering stochastic walk: leaves the current triangle through a randomly chosen edge having
+    //! \brief \p query_point on its outer side, never through the edge it came from. Points lying exactly on
+    //! \brief an edge or on a vertex count as inside, so the walk stops in any triangle touching them
+    //! \param query_point point whose containing triangle we are looking for
+    //! \param tri_ind index of the triangle where the walk starts
+    //! \returns index of a triangle containing \p query_point or -1 if the walk did not finish in time
+    template <class Vertex>
+    template <class VectorType>
+    TriInd Triangulation<Vertex>::walkToTriangle(const VectorType &query_point, TriInd tri_ind,
+                                                 LocateCursor &cursor) const
+    {
+        //! stored triangles turn clockwise, so the query is on the outer side of edge k when it turns left of it
+        const auto is_outside = [&](const Triangle &tri, int k)
+        { return orientation(vertexOf(tri, k), vertexOf(tri, next(k)), query_point) > 0; };
 
-            if (segmentsIntersectOrTouch(r_start, query_point, v0, v1))
-            {
-                tri_ind = tri.neighbours[0];
-                v_current = tri.verts[0];
-            }
-            else if (segmentsIntersectOrTouch(r_start, query_point, v1, v2))
+        //! a walk visiting more triangles than there are in the triangulation must be going in circles
+        TriInd came_from = -1;
+        for (std::size_t n_steps = 0; n_steps <= m_triangles.size(); ++n_steps)
+        {
+            const auto &tri = m_triangles[tri_ind];
+            const int first_edge = cursor.walk_gen() % 3;
+            int exit_edge = -1;
+            for (int i = 0; i < 3 && exit_edge == -1; ++i)
             {
-                tri_ind = tri.neighbours[1];
-                v_current = tri.verts[1];
+                const int k = (first_edge + i) % 3;
+                if (tri.neighbours[k] != came_from && is_outside(tri, k))
+                {
+                    exit_edge = k;
+                }
             }
-            else if (segmentsIntersectOrTouch(r_start, query_point, v2, v0))
+            if (exit_edge == -1)
             {
-                tri_ind = tri.neighbours[2];
-                v_current = tri.verts[2];
+                cursor.stats.n_steps += n_steps;
+                return tri_ind;
             }
-            else
+            if (tri.neighbours[exit_edge] == -1)
             {
-                tri_ind = -1;
-            } // throw std::runtime_error("we should never get here!");}
-        }
-        if (tri_ind == -1)
-        { //! if we cannot find way (no idea why yet) we do brute force
-            for (TriInd i = 0; i < m_triangles.size(); ++i)
-            {
-                if (isInTriangle(query_point, m_triangles[i]))
-                {
-                    m_last_found = i;
-                    return i;
-                }
+                break; //! the query lies beyond the hull, which can happen only due to rounding
             }
+            came_from = tri_ind;
+            tri_ind = tri.neighbours[exit_edge];
         }
-        //! walk in the found diraction to triangle containing query;
-        while (!isInTriangle(query_point, m_triangles[tri_ind]))
-        {
-            const auto &tri = m_triangles[tri_ind];
-
-            const auto index_in_tri = indexOf(v_current, tri);
-            assert(index_in_tri != -1);
-
-            const auto &v1 = asFloat(tri.verts[next(index_in_tri)]);
-            const auto &v2 = asFloat(tri.verts[prev(index_in_tri)]);
+        return -1;
+    }
 
-            if (segmentsIntersectOrTouch(asFloat(v_current), query_point, v1, v2))
-            {
-                tri_ind = tri.neighbours[next(index_in_tri)];
-                v_current = tri.verts[next(index_in_tri)];
-            }
-            else
+    //! \brief jump part of jump-and-walk: picks a few random vertices and finds a triangle of the closest one
+    //! \param query_point
+    //! \param n_samples number of sampled vertices
+    //! \param cursor provides the random numbers
+    //! \returns index of a triangle having the sampled vertex closest to \p query_point
+    template <class Vertex>
+    TriInd Triangulation<Vertex>::sampleTriangleNear(cdt::Vector2f query_point, std::size_t n_samples,
+                                                     LocateCursor &cursor) const
+    {
+        VertInd best_v_ind = cursor.walk_gen() % m_vertices.size();
+        float best_dist = std::numeric_limits<float>::max();
+        for (std::size_t i = 0; i < n_samples; ++i)
+        {
+            const VertInd v_ind = cursor.walk_gen() % m_vertices.size();
+            const auto dist = norm2(asFloat(m_vertices[v_ind]) - query_point);
+            if (dist < best_dist)
             {
-                tri_ind = tri.neighbours[index_in_tri];
+                best_dist = dist;
+                best_v_ind = v_ind;
             }
         }
-
-        m_last_found = tri_ind; //! cache the result
-        return tri_ind;
+        //! vertices detached during constraint insertion point to no triangle until they get re-inserted
+        const auto tri_ind = m_vertex2tri[best_v_ind];
+        return tri_ind < m_triangles.size() ? tri_ind : 0;
     }
 
     //! \brief creates supertriangle which contains specified boundary then
@@ -284,24 +437,22 @@ namespace cdt
     {
         m_boundary = box_size;
 
-        m_grid = std::make_unique<Grid>(cdt::Vector2i{20, 20}, box_size);
-        m_cell2tri_ind.resize(m_grid->getNCells(), -1);
+        m_grid = std::make_unique<Grid>(cdt::Vector2i{1, 1}, box_size); //! grows with the triangulation
+        m_cell2tri_ind.assign(m_grid->getNCells(), -1);
 
-        Triangle<Vertex> super_triangle;
-        m_tri_ind2vert_inds.push_back({0, 1, 2});
+        Triangle super_triangle;
+        super_triangle.vert_inds = {0, 1, 2};
 
         Vertex super_tri0 = {m_boundary.x / 2, m_boundary.y * 3};
         Vertex super_tri1 = {3 * m_boundary.x, -m_boundary.y / 2};
         Vertex super_tri2 = {-3 * m_boundary.x, -m_boundary.y / 2};
 
-        // super_triangle.verts[0] = super_tri0;
-        // super_triangle.verts[1] = super_tri1;
-        // super_triangle.verts[2] = super_tri2;
         m_triangles.push_back(super_triangle);
 
         m_vertices.push_back(super_tri0);
         m_vertices.push_back(super_tri1);
         m_vertices.push_back(super_tri2);
+        m_vertex2tri.insert(m_vertex2tri.end(), 3, 0);
     }
 
     //! \brief creates supertriangle which contains specified boundary then
@@ -311,24 +462,22 @@ namespace cdt
     void Triangulation<Vertex>::createBoundaryAndSuperTriangle(cdt::Vector2i box_size)
     {
 
-        m_grid = std::make_unique<Grid>(cdt::Vector2i{20, 20}, box_size);
-        m_cell2tri_ind.resize(m_grid->getNCells(), -1);
+        m_grid = std::make_unique<Grid>(cdt::Vector2i{1, 1}, box_size); //! grows with the triangulation
+        m_cell2tri_ind.assign(m_grid->getNCells(), -1);
 
-        Triangle<Vertex> super_triangle;
-        m_tri_ind2vert_inds.push_back({0, 1, 2});
+        Triangle super_triangle;
+        super_triangle.vert_inds = {0, 1, 2};
 
         Vertex super_tri0 = {m_boundary.x / 2, m_boundary.y * 3};
         Vertex super_tri1 = {3 * m_boundary.x, -m_boundary.y / 2};
         Vertex super_tri2 = {-3 * m_boundary.x, -m_boundary.y / 2};
 
-        super_triangle.verts[0] = super_tri0;
-        super_triangle.verts[1] = super_tri1;
-        super_triangle.verts[2] = super_tri2;
         m_triangles.push_back(super_triangle);
 
         m_vertices.push_back(super_tri0);
         m_vertices.push_back(super_tri1);
         m_vertices.push_back(super_tri2);
+        m_vertex2tri.insert(m_vertex2tri.end(), 3, 0);
 
         Vertex v1 = {0, 0};
         Vertex v2 = Vertex{m_boundary.x, 0};
@@ -365,33 +514,27 @@ namespace cdt
 
         m_boundary = box_size;
 
-        m_grid = std::make_unique<Grid>(cdt::Vector2i{20, 20}, box_size);
-        m_cell2tri_ind.resize(m_grid->getNCells(), -1);
+        m_grid = std::make_unique<Grid>(cdt::Vector2i{1, 1}, box_size); //! grows with the triangulation
+        m_cell2tri_ind.assign(m_grid->getNCells(), -1);
 
-        Triangle<Vertex> tri_up;
-        Triangle<Vertex> tri_down;
-        m_tri_ind2vert_inds.push_back({0, 2, 1});
-        m_tri_ind2vert_inds.push_back({0, 3, 2});
+        Triangle tri_up;
+        Triangle tri_down;
 
         Vertex v0 = {0, 0};
         Vertex v1 = Vertex{m_boundary.x, 0};
         Vertex v2 = m_boundary;
         Vertex v3 = Vertex{0, m_boundary.y};
-        tri_up.verts[0] = v0;
-        tri_up.verts[1] = v2;
-        tri_up.verts[2] = v1;
+        tri_up.vert_inds = {0, 2, 1};
         tri_up.neighbours = {1, -1u, -1u};
-        tri_up.is_constrained[0] = false;
-        tri_up.is_constrained[1] = true;
-        tri_up.is_constrained[2] = true;
+        tri_up.setBackIndex(0, 2);
+        tri_up.setConstrained(1, true);
+        tri_up.setConstrained(2, true);
 
-        tri_down.verts[0] = v0;
-        tri_down.verts[1] = v3;
-        tri_down.verts[2] = v2;
+        tri_down.vert_inds = {0, 3, 2};
         tri_down.neighbours = {-1u, -1u, 0};
-        tri_down.is_constrained[0] = true;
-        tri_down.is_constrained[1] = true;
-        tri_down.is_constrained[2] = false;
+        tri_down.setBackIndex(2, 0);
+        tri_down.setConstrained(0, true);
+        tri_down.setConstrained(1, true);
 
         m_triangles.push_back(tri_up);
         m_triangles.push_back(tri_down);
@@ -400,16 +543,12 @@ namespace cdt
         m_vertices.push_back(v1);
         m_vertices.push_back(v2);
         m_vertices.push_back(v3);
+        m_vertex2tri.insert(m_vertex2tri.end(), {0, 0, 0, 1});
 
-        EdgeVInd e1 = {0, 1};
-        EdgeVInd e2 = {1, 2};
-        EdgeVInd e3 = {2, 3};
-        EdgeVInd e4 = {3, 0};
-
-        m_fixed_edges.insert({v0, v1});
-        m_fixed_edges.insert({v1, v2});
-        m_fixed_edges.insert({v2, v3});
-        m_fixed_edges.insert({v3, v0});
+        m_fixed_edges.insert({0, 1});
+        m_fixed_edges.insert({1, 2});
+        m_fixed_edges.insert({2, 3});
+        m_fixed_edges.insert({3, 0});
 
         assert(triangulationIsConsistent());
     }
@@ -418,7 +557,7 @@ namespace cdt
     //! \param tri
     //! \returns index in triangle of the vertex in tri opposite of triangle \p np
     template <class Vertex>
-    int Triangulation<Vertex>::oppositeIndex(const TriInd np, const Triangle<Vertex> &tri)
+    int Triangulation<Vertex>::oppositeIndex(const TriInd np, const Triangle &tri) const
     {
         if (np == tri.neighbours[0])
         {
@@ -439,19 +578,17 @@ namespace cdt
     }
 
     //! \param tri  trian
-    //! \param e    edge containing vertex coordinates it connects
-    //! \returns index of triangle opposite of \p tri accross \p edge
+    //! \param e    edge containing vertex indices it connects
+    //! \returns index of triangle opposite of \p tri accross \p edge or -1 if \p tri does not contain the edge
     template <class Vertex>
-    TriInd Triangulation<Vertex>::triangleOppositeOfEdge(const Triangle<Vertex> &tri, const EdgeI<Vertex> &e) const
+    TriInd Triangulation<Vertex>::triangleOppositeOfEdge(const Triangle &tri, const EdgeVInd &e) const
     {
-        const auto i2 = indexOf(e.from, tri);
-        const auto i1 = indexOf(e.to(), tri);
-        if (i1 == -1 or i2 == -1)
+        const auto opposite_ind_in_tri = oppositeOfEdge(tri, e);
+        if (opposite_ind_in_tri == -1)
         {
             return -1;
         }
-        assert(i1 != -1 && i2 != -1);
-        return tri.neighbours[(oppositeOfEdge(tri, e) + 1) % 3];
+        return tri.neighbours[next(opposite_ind_in_tri)];
     }
 
     //! \param e1 edge containg indices of vertices forming a first edge
@@ -460,28 +597,63 @@ namespace cdt
     template <class Vertex>
     bool Triangulation<Vertex>::edgesIntersect(const EdgeVInd e1, const EdgeVInd e2) const noexcept
     {
-        return segmentsIntersect(m_vertices[e1.from], m_vertices[e1.to], m_vertices[e2.from], m_vertices[e2.to]);
+        return segmentsCross(m_vertices[e1.from], m_vertices[e1.to], m_vertices[e2.from], m_vertices[e2.to]);
     }
 
-    //! \param e1 edge containg vertices forming a first edge
-    //! \param e2 edge containg vertices forming a second edge
-    //! \returns true if lines representing given edges intersect
+    //! \returns true if the number of triangles per cell of the search grid drifted too far from triangles_per_cell
+    template <class Vertex>
+    bool Triangulation<Vertex>::cellGridNeedsResize() const
+    {
+        const auto n_cells = m_cell2tri_ind.size();
+        return m_triangles.size() > 2 * triangles_per_cell * n_cells ||
+               (n_cells > 1 && 2 * m_triangles.size() < triangles_per_cell * n_cells);
+    }
+
+    //! \brief points the search grid cell containing center of \p tri_ind to \p tri_ind
+    //! \brief called for every created or changed triangle so the grid stays current without full updates
     template <class Vertex>
-    bool Triangulation<Vertex>::edgesIntersect(const EdgeI<Vertex> e1, const EdgeI<Vertex> e2) const noexcept
+    void Triangulation<Vertex>::updateCellOf(TriInd tri_ind)
     {
-        return segmentsIntersect(e1.from, e1.to(), e2.from, e2.to());
+        const auto center = getCenter(tri_ind);
+        const int ix = center.x / m_grid->m_cell_size.x; //! inlined Grid::coordToCell, this runs for every flip
+        const int iy = center.y / m_grid->m_cell_size.y;
+        if (0 <= ix && ix < m_grid->m_cell_count.x && 0 <= iy && iy < m_grid->m_cell_count.y)
+        {
+            m_cell2tri_ind[ix + iy * m_grid->m_cell_count.x] = tri_ind;
+        }
+    }
+
+    //! \brief points each corner of \p tri_ind to \p tri_ind in m_vertex2tri
+    //! \brief called together with updateCellOf, so every vertex always knows one triangle of its star
+    template <class Vertex>
+    void Triangulation<Vertex>::updateVertex2Tri(TriInd tri_ind)
+    {
+        const auto &tri = m_triangles[tri_ind];
+        m_vertex2tri[tri.vert_inds[0]] = tri_ind;
+        m_vertex2tri[tri.vert_inds[1]] = tri_ind;
+        m_vertex2tri[tri.vert_inds[2]] = tri_ind;
     }
 
-    //! \brief updates search grid used to find triangles
-    //! \brief should be called whenever triagulation changes
+    //! \brief resizes search grid used to find triangles to about triangles_per_cell triangles per cell
+    //! \brief and finds triangle for each of its cells. Cells are kept current during changes of the triangulation
+    //! \brief and the grid gets resized on its own once the triangulation grows or shrinks enough, so
+    //! \brief calling this is needed only after editing m_triangles directly
     template <class Vertex>
     void Triangulation<Vertex>::updateCellGrid()
     {
+        const auto n_cells_wanted = std::max<std::size_t>(1, m_triangles.size() / triangles_per_cell);
+        const auto aspect_ratio = static_cast<float>(m_boundary.x) / m_boundary.y;
+        const int n_cells_x = std::max(1, static_cast<int>(std::round(std::sqrt(n_cells_wanted * aspect_ratio))));
+        const int n_cells_y = std::max(1, static_cast<int>(std::round(n_cells_wanted / static_cast<float>(n_cells_x))));
+        if (m_grid->m_cell_count.x != n_cells_x || m_grid->m_cell_count.y != n_cells_y)
+        {
+            m_grid = std::make_unique<Grid>(cdt::Vector2i{n_cells_x, n_cells_y}, asFloat(m_boundary));
+            m_cell2tri_ind.assign(m_grid->getNCells(), -1);
+        }
+
         const auto dx = m_grid->m_cell_size.x;
         const auto dy = m_grid->m_cell_size.y;
 
-        const auto n_cells_x = m_grid->m_cell_count.x;
-        const auto n_cells_y = m_grid->m_cell_count.y;
         for (int j = 0; j < n_cells_y - 1; j++)
         { //! we walk zig-zag so that each next cell grid is close to the last one which helps findTriangle
             for (int i = 0; i < n_cells_x; i++)
@@ -517,164 +689,283 @@ namespace cdt
         }
     }
 
-    //! \brief inserts vertex given we know that it lies directly on the given edge
-    //! \param v_ind index of inserted vertex
-    //! \param tri_ind_a index of counterclockwise triangle
-    //! \param tri_ind_b index of a clockwise triangle
-    //! \param edge
+    //! \brief renumbers triangles and vertices in the order of a Hilbert curve through their positions
+    //! \brief after many insertions and swaps the numbering follows the edit history, so walks over neighbouring
+    //! \brief triangles jump all over memory. Afterwards neighbours mostly lie close to each other in m_triangles
+    //! \returns new indices of the old triangles and vertices, e.g. to remap indices held by a PathFinder
     template <class Vertex>
-    void Triangulation<Vertex>::insertVertexOnEdge(const Vertex &new_vertex, TriInd tri_ind_a, TriInd tri_ind_b, const EdgeI<Vertex> &e)
+    Reordering Triangulation<Vertex>::reorder()
     {
-        const auto new_vertex_ind = m_vertices.size() - 1;
-
-        const auto tri_ind_a_new = m_triangles.size();
-        const auto tri_ind_b_new = m_triangles.size() + 1;
-
-        auto tri_a = m_triangles.at(tri_ind_a);
-        auto tri_b = m_triangles.at(tri_ind_b);
-
-        const auto ind_in_tri_a = oppositeOfEdge(tri_a, e);
-        const auto ind_in_tri_b = oppositeOfEdge(tri_b, e);
-
-        Triangle<Vertex> tri_a_new = tri_a;
-        Triangle<Vertex> tri_b_new = tri_b;
-
-        m_tri_ind2vert_inds.push_back(m_tri_ind2vert_inds[tri_ind_a]);
-        m_tri_ind2vert_inds.push_back(m_tri_ind2vert_inds[tri_ind_b]);
+        //! curve coordinates are scaled down so that three times the boundary fits into hilbert_order bits
+        constexpr int hilbert_order = 16;
+        int shift = 0;
+        while ((3 * std::max(m_boundary.x, m_boundary.y) >> shift) >= (1 << hilbert_order))
+        {
+            shift++;
+        }
+        auto curve_ind = [&](const Vertex &tripled_position)
+        {
+            const auto x = std::clamp(static_cast<int>(tripled_position.x), 0, 3 * m_boundary.x) >> shift;
+            const auto y = std::clamp(static_cast<int>(tripled_position.y), 0, 3 * m_boundary.y) >> shift;
+            return hilbertIndex(x, y, hilbert_order);
+        };
+        //! \returns for each new index the old one and fills \p new_inds with the inverse
+        auto sort_by_curve = [](const std::vector<std::uint64_t> &curve_inds, auto &new_inds)
+        {
+            std::vector<std::uint32_t> old_inds(curve_inds.size());
+            std::iota(old_inds.begin(), old_inds.end(), 0);
+            std::stable_sort(old_inds.begin(), old_inds.end(), [&curve_inds](std::uint32_t a, std::uint32_t b)
+                             { return curve_inds[a] < curve_inds[b]; });
+            new_inds.resize(old_inds.size());
+            for (std::size_t new_ind = 0; new_ind < old_inds.size(); ++new_ind)
+            {
+                new_inds[old_inds[new_ind]] = new_ind;
+            }
+            return old_inds;
+        };
 
-        for (int i = 0; i < 3; ++i)
+        Reordering reordering;
+        std::vector<std::uint64_t> curve_inds(m_vertices.size());
+        for (std::size_t v_ind = 0; v_ind < m_vertices.size(); ++v_ind)
         {
-            tri_a_new.is_constrained[i] = false;
+            curve_inds[v_ind] = curve_ind(m_vertices[v_ind] * 3);
         }
-        for (int i = 0; i < 3; ++i)
+        const auto old_vert_inds = sort_by_curve(curve_inds, reordering.new_vert_inds);
+
+        curve_inds.resize(m_triangles.size());
+        for (std::size_t tri_ind = 0; tri_ind < m_triangles.size(); ++tri_ind)
         {
-            tri_b_new.is_constrained[i] = false;
+            const auto &tri = m_triangles[tri_ind];
+            curve_inds[tri_ind] = curve_ind(vertexOf(tri, 0) + vertexOf(tri, 1) + vertexOf(tri, 2));
         }
+        const auto old_tri_inds = sort_by_curve(curve_inds, reordering.new_tri_inds);
+
+        const auto &new_tri_inds = reordering.new_tri_inds;
+        const auto &new_vert_inds = reordering.new_vert_inds;
+        auto new_tri_ind = [&new_tri_inds](TriInd tri_ind)
+        { return tri_ind == -1 ? tri_ind : new_tri_inds[tri_ind]; };
 
-        //    tri_a_new.vertinds[(ind_in_tri_a + 1) % 3] = new_vertex_ind;
-        m_tri_ind2vert_inds[tri_ind_a_new][(ind_in_tri_a + 1) % 3] = new_vertex_ind;
-        tri_a_new.verts[(ind_in_tri_a + 1) % 3] = new_vertex;
-        tri_a_new.neighbours[ind_in_tri_a] = tri_ind_a;
-        tri_a_new.neighbours[(ind_in_tri_a + 1) % 3] = tri_ind_b;
-        tri_a_new.is_constrained[(ind_in_tri_a + 1) % 3] = true;
-        if (tri_a.is_constrained[(ind_in_tri_a + 2) % 3])
+        //! edge indices within triangles stay the same, so constraint flags and back indices stay valid
+        std::vector<Triangle> triangles(m_triangles.size());
+        for (std::size_t tri_ind = 0; tri_ind < triangles.size(); ++tri_ind)
         {
-            tri_a_new.is_constrained[(ind_in_tri_a + 2) % 3] = true;
+            auto &tri = triangles[tri_ind];
+            tri = m_triangles[old_tri_inds[tri_ind]];
+            for (int k = 0; k < 3; ++k)
+            {
+                tri.vert_inds[k] = new_vert_inds[tri.vert_inds[k]];
+                tri.neighbours[k] = new_tri_ind(tri.neighbours[k]);
+            }
         }
-        //    tri_a.vertinds[(ind_in_tri_a + 2) % 3] = new_vertex_ind;
-        m_tri_ind2vert_inds[tri_ind_a][(ind_in_tri_a + 2) % 3] = new_vertex_ind;
-        tri_a.verts[(ind_in_tri_a + 2) % 3] = new_vertex;
-        tri_a.neighbours[(ind_in_tri_a + 1) % 3] = tri_ind_b_new;
-        tri_a.neighbours[(ind_in_tri_a + 2) % 3] = tri_ind_a_new;
-        tri_a.is_constrained[(ind_in_tri_a + 2) % 3] = false;
+        m_triangles = std::move(triangles);
 
-        //    tri_b_new.vertinds[(ind_in_tri_b + 1) % 3] = new_vertex_ind;
-        m_tri_ind2vert_inds[tri_ind_b_new][(ind_in_tri_b + 1) % 3] = new_vertex_ind;
-        tri_b_new.verts[(ind_in_tri_b + 1) % 3] = new_vertex;
-        tri_b_new.neighbours[ind_in_tri_b] = tri_ind_b;
-        tri_b_new.neighbours[(ind_in_tri_b + 1) % 3] = tri_ind_a;
-        tri_b_new.is_constrained[(ind_in_tri_b + 1) % 3] = true;
-        if (tri_b.is_constrained[(ind_in_tri_b + 2) % 3])
+        std::vector<Vertex> vertices(m_vertices.size());
+        std::vector<TriInd> vertex2tri(m_vertex2tri.size());
+        for (std::size_t v_ind = 0; v_ind < vertices.size(); ++v_ind)
         {
-            tri_b_new.is_constrained[(ind_in_tri_b + 2) % 3] = true;
+            vertices[v_ind] = m_vertices[old_vert_inds[v_ind]];
+            vertex2tri[v_ind] = new_tri_ind(m_vertex2tri[old_vert_inds[v_ind]]);
         }
-        //    tri_b.vertinds[(ind_in_tri_b + 2) % 3] = new_vertex_ind;
-        m_tri_ind2vert_inds[tri_ind_b][(ind_in_tri_b + 2) % 3] = new_vertex_ind;
-        tri_b.verts[(ind_in_tri_b + 2) % 3] = new_vertex;
-        tri_b.neighbours[(ind_in_tri_b + 1) % 3] = tri_ind_a_new;
-        tri_b.neighbours[(ind_in_tri_b + 2) % 3] = tri_ind_b_new;
-        tri_b.is_constrained[(ind_in_tri_b + 2) % 3] = false;
+        m_vertices = std::move(vertices);
+        m_vertex2tri = std::move(vertex2tri);
 
-        //! we tell old triangles that they have a new neighbour;
-        if (tri_a_new.neighbours[(ind_in_tri_a + 2) % 3] != -1)
+        //! the set is keyed by vertex indices, so it gets refilled from the constraint flags
+        m_fixed_edges.clear();
+        for (const auto &tri : m_triangles)
         {
-            auto &tri_next = m_triangles[tri_a_new.neighbours[(ind_in_tri_a + 2) % 3]];
-            for (int i = 0; i < 3; ++i)
+            for (int k = 0; k < 3; ++k)
             {
-                if (tri_next.neighbours[i] == tri_ind_a)
+                if (tri.isConstrained(k))
                 {
-                    tri_next.neighbours[i] = tri_ind_a_new;
-                    break;
+                    m_fixed_edges.insert({tri.vert_inds[k], tri.vert_inds[next(k)]});
                 }
             }
         }
-        //! we tell old triangles that they have a new neighbour;
-        if (tri_b_new.neighbours[(ind_in_tri_b + 2) % 3] != -1)
+
+        for (auto &tri_ind : m_cell2tri_ind)
         {
-            auto &tri_next = m_triangles[tri_b_new.neighbours[(ind_in_tri_b + 2) % 3]];
-            for (int i = 0; i < 3; ++i)
-            {
-                if (tri_next.neighbours[i] == tri_ind_b)
-                {
-                    tri_next.neighbours[i] = tri_ind_b_new;
-                    break;
-                }
-            }
+            tri_ind = new_tri_ind(tri_ind);
         }
+        m_cursor.hint = m_triangles.empty() ? 0 : new_tri_ind(m_cursor.hint);
 
-        m_triangles.push_back(tri_a_new);
-        m_triangles.push_back(tri_b_new);
-        m_triangles[tri_ind_a] = tri_a;
-        m_triangles[tri_ind_b] = tri_b;
-        m_fixed_edges.erase(e);
-        m_fixed_edges.insert({e.from, new_vertex});
-        m_fixed_edges.insert({new_vertex, e.to()});
+        assert(triangulationIsConsistent());
+        return reordering;
+    }
 
-        //! fix delaunay property
-        std::stack<std::pair<TriInd, TriInd>> triangles_to_fix;
-        if (tri_a_new.neighbours[(ind_in_tri_a + 2) % 3] != -1)
+    //! \brief makes triangles \p tri_ind_a and \p tri_ind_b neighbours across edges \p ind_in_a and \p ind_in_b
+    //! \brief either of the triangles may be -1 (boundary), in which case only the other one is updated
+    template <class Vertex>
+    void Triangulation<Vertex>::linkNeighbours(TriInd tri_ind_a, int ind_in_a, TriInd tri_ind_b, int ind_in_b)
+    {
+        if (tri_ind_a != -1)
         {
-            triangles_to_fix.push({tri_ind_a_new, tri_a_new.neighbours[(ind_in_tri_a + 2) % 3]});
+            m_triangles[tri_ind_a].neighbours[ind_in_a] = tri_ind_b;
+            m_triangles[tri_ind_a].setBackIndex(ind_in_a, ind_in_b);
         }
-        if (tri_a.neighbours[ind_in_tri_a] != -1)
+        if (tri_ind_b != -1)
         {
-            triangles_to_fix.push({tri_ind_a, tri_a.neighbours[ind_in_tri_a]});
+            m_triangles[tri_ind_b].neighbours[ind_in_b] = tri_ind_a;
+            m_triangles[tri_ind_b].setBackIndex(ind_in_b, ind_in_a);
         }
+    }
 
-        if (tri_b_new.neighbours[(ind_in_tri_b + 2) % 3] != -1)
+    //! \brief restores Delaunay property around newly inserted vertex by Lawson flips
+    //! \param v_ind index of the inserted vertex
+    //! \param edges_to_fix triangles paired with index of their edge lying opposite of \p v_ind
+    template <class Vertex>
+    void Triangulation<Vertex>::legalizeAround(VertInd v_ind, std::vector<std::pair<TriInd, int>> &edges_to_fix)
+    {
+        const auto &vp = m_vertices[v_ind];
+        while (!edges_to_fix.empty())
         {
-            triangles_to_fix.push({tri_ind_b_new, tri_b_new.neighbours[(ind_in_tri_b + 2) % 3]});
+            const auto [tri_ind, edge_ind] = edges_to_fix.back();
+            edges_to_fix.pop_back();
+
+            const auto &tri = m_triangles[tri_ind];
+            const auto next_tri_ind = tri.neighbours[edge_ind];
+            if (next_tri_ind == -1 || tri.isConstrained(edge_ind))
+            {
+                continue;
+            }
+            assert(tri.vert_inds[prev(edge_ind)] == v_ind);
+
+            const auto &next_tri = m_triangles[next_tri_ind];
+            const auto opposite_ind_in_tri = tri.oppositeInNeighbour(edge_ind);
+            const auto &v3 = vertexOf(next_tri, opposite_ind_in_tri);
+            const auto &v1 = vertexOf(next_tri, next(opposite_ind_in_tri));
+            const auto &v2 = vertexOf(next_tri, prev(opposite_ind_in_tri));
+
+            if (needSwap(vp, v1, v2, v3))
+            {
+                swapConnectingEdgeCounterClockwise(tri_ind, prev(edge_ind));
+                //! both triangles still contain v_ind and their far edges are the ones to check now
+                edges_to_fix.emplace_back(tri_ind, edge_ind);
+                edges_to_fix.emplace_back(next_tri_ind, opposite_ind_in_tri);
+            }
         }
-        if (tri_b.neighbours[ind_in_tri_b] != -1)
+    }
+
+    //! \brief restores Delaunay property by Lawson flips starting from given edges
+    //! \brief unlike legalizeAround the swapped edges do not need to share a vertex
+    //! \param edges_to_fix triangles paired with index of their edge which should be checked
+    template <class Vertex>
+    void Triangulation<Vertex>::legalizeEdges(std::vector<std::pair<TriInd, int>> &edges_to_fix)
+    {
+        while (!edges_to_fix.empty())
         {
-            triangles_to_fix.push({tri_ind_b, tri_b.neighbours[ind_in_tri_b]});
+            const auto [tri_ind_a, edge_ind] = edges_to_fix.back();
+            edges_to_fix.pop_back();
+
+            const auto &tri_a = m_triangles[tri_ind_a];
+            const auto tri_ind_b = tri_a.neighbours[edge_ind];
+            if (tri_ind_b == -1 || tri_a.isConstrained(edge_ind))
+            {
+                continue;
+            }
+
+            const auto opposite_ind_in_tri_a = prev(edge_ind);
+            const auto opposite_ind_in_tri_b = tri_a.oppositeInNeighbour(edge_ind);
+            const auto &va = vertexOf(tri_a, opposite_ind_in_tri_a);
+            const auto &vb = vertexOf(m_triangles[tri_ind_b], opposite_ind_in_tri_b);
+            const auto &v1 = vertexOf(tri_a, next(opposite_ind_in_tri_a));
+            const auto &v2 = vertexOf(tri_a, prev(opposite_ind_in_tri_a));
+
+            if (needSwap(vb, v1, v2, va) && isConvex(va, v1, vb, v2))
+            {
+                swapConnectingEdgeClockwise(tri_ind_a, opposite_ind_in_tri_a);
+                //! a = (A, B, L) and b = (B, A, R), the outer edges of the quadrilateral are checked next
+                edges_to_fix.emplace_back(tri_ind_a, next(opposite_ind_in_tri_a));
+                edges_to_fix.emplace_back(tri_ind_a, prev(opposite_ind_in_tri_a));
+                edges_to_fix.emplace_back(tri_ind_b, next(opposite_ind_in_tri_b));
+                edges_to_fix.emplace_back(tri_ind_b, prev(opposite_ind_in_tri_b));
+            }
         }
+    }
+
+    //! \brief inserts vertex given we know that it lies directly on the given edge
+    //! \param new_vertex_ind index of inserted vertex
+    //! \param tri_ind_a index of triangle containing the edge
+    //! \param edge_ind_in_a index of the split edge in triangle \p tri_ind_a
+    template <class Vertex>
+    void Triangulation<Vertex>::insertVertexOnEdge(VertInd new_vertex_ind, TriInd tri_ind_a, int edge_ind_in_a)
+    {
+        const auto tri_a = m_triangles[tri_ind_a];
+        const auto tri_ind_b = tri_a.neighbours[edge_ind_in_a];
+        const bool edge_is_constrained = tri_a.isConstrained(edge_ind_in_a);
+
+        //! a = (A, X, Y) gets split into a = (A, X, p) and a_new = (A, p, Y)
+        const auto oa = prev(edge_ind_in_a);
+        const auto v_x = tri_a.vert_inds[next(oa)];
+        const auto v_y = tri_a.vert_inds[prev(oa)];
+
+        const TriInd tri_ind_a_new = m_triangles.size();
+        const TriInd tri_ind_b_new = tri_ind_b != -1 ? tri_ind_a_new + 1 : -1;
+
+        Triangle tri_a_new = tri_a;
+        tri_a_new.vert_inds[next(oa)] = new_vertex_ind;
+        tri_a_new.constraints = 0;
+        tri_a_new.setConstrained(next(oa), edge_is_constrained);
+        tri_a_new.setConstrained(prev(oa), tri_a.isConstrained(prev(oa)));
+        m_triangles.push_back(tri_a_new);
 
-        while (!triangles_to_fix.empty())
+        auto &new_a = m_triangles[tri_ind_a];
+        new_a.vert_inds[prev(oa)] = new_vertex_ind;
+        new_a.setConstrained(prev(oa), false);
+
+        linkNeighbours(tri_ind_a, prev(oa), tri_ind_a_new, oa);
+        linkNeighbours(tri_ind_a_new, prev(oa), tri_a.neighbours[prev(oa)], tri_a.backIndex(prev(oa)));
+
+        if (tri_ind_b != -1)
         {
-            auto next_tri_ind = triangles_to_fix.top().second;
-            auto &next_tri = m_triangles[next_tri_ind];
-            auto old_tri_ind = triangles_to_fix.top().first;
-            auto &old_tri = m_triangles[old_tri_ind];
-            triangles_to_fix.pop();
+            //! b = (B, Y, X) gets split into b = (B, Y, p) and b_new = (B, p, X)
+            const auto tri_b = m_triangles[tri_ind_b];
+            const auto ob = tri_a.oppositeInNeighbour(edge_ind_in_a);
 
-            auto opposite_ind_in_tri = oppositeIndex(old_tri_ind, next_tri);
-            auto new_vert_ind_in_tri = indexOf(new_vertex, old_tri);
-            auto v3 = next_tri.verts[opposite_ind_in_tri];
-            auto v1 = next_tri.verts[(opposite_ind_in_tri + 1) % 3];
-            auto v2 = next_tri.verts[(opposite_ind_in_tri + 2) % 3];
-            auto vp = new_vertex;
+            Triangle tri_b_new = tri_b;
+            tri_b_new.vert_inds[next(ob)] = new_vertex_ind;
+            tri_b_new.constraints = 0;
+            tri_b_new.setConstrained(next(ob), edge_is_constrained);
+            tri_b_new.setConstrained(prev(ob), tri_b.isConstrained(prev(ob)));
+            m_triangles.push_back(tri_b_new);
 
-            ;
-            //        EdgeVInd flipped_edge = {next_tri.vertinds[(opposite_ind_in_tri + 1) % 3],
-            //        next_tri.vertinds[(opposite_ind_in_tri + 2) % 3]};
-            if (needSwap(vp, v1, v2, v3) && !next_tri.is_constrained[next(opposite_ind_in_tri)])
-            {
+            auto &new_b = m_triangles[tri_ind_b];
+            new_b.vert_inds[prev(ob)] = new_vertex_ind;
+            new_b.setConstrained(prev(ob), false);
 
-                auto &a = old_tri.verts[(new_vert_ind_in_tri + 2) % 3];
-                assert(isCounterClockwise(a, v3, vp));
-                swapConnectingEdgeClockwise(old_tri_ind, next_tri_ind);
+            linkNeighbours(tri_ind_b, prev(ob), tri_ind_b_new, ob);
+            linkNeighbours(tri_ind_b_new, prev(ob), tri_b.neighbours[prev(ob)], tri_b.backIndex(prev(ob)));
+            linkNeighbours(tri_ind_a_new, next(oa), tri_ind_b, next(ob));
+            linkNeighbours(tri_ind_b_new, next(ob), tri_ind_a, next(oa));
+            updateCellOf(tri_ind_b);
+            updateVertex2Tri(tri_ind_b);
+            updateCellOf(tri_ind_b_new);
+            updateVertex2Tri(tri_ind_b_new);
+        }
+        else
+        {
+            m_triangles[tri_ind_a_new].neighbours[next(oa)] = -1;
+        }
+        updateCellOf(tri_ind_a);
+        updateVertex2Tri(tri_ind_a);
+        updateCellOf(tri_ind_a_new);
+        updateVertex2Tri(tri_ind_a_new);
 
-                if (old_tri.neighbours[(new_vert_ind_in_tri + 1) % 3] != -1)
-                {
-                    triangles_to_fix.emplace(old_tri_ind, old_tri.neighbours[(new_vert_ind_in_tri + 1) % 3]);
-                }
-                if (next_tri.neighbours[(opposite_ind_in_tri + 2) % 3] != -1)
-                {
-                    triangles_to_fix.emplace(next_tri_ind, next_tri.neighbours[(opposite_ind_in_tri + 2) % 3]);
-                }
-            }
+        if (edge_is_constrained)
+        {
+            m_fixed_edges.erase({v_x, v_y});
+            m_fixed_edges.insert({v_x, new_vertex_ind});
+            m_fixed_edges.insert({new_vertex_ind, v_y});
+        }
+
+        //! fix delaunay property
+        std::vector<std::pair<TriInd, int>> edges_to_fix = {{tri_ind_a, oa}, {tri_ind_a_new, prev(oa)}};
+        if (tri_ind_b != -1)
+        {
+            const auto ob = tri_a.oppositeInNeighbour(edge_ind_in_a);
+            edges_to_fix.emplace_back(tri_ind_b, ob);
+            edges_to_fix.emplace_back(tri_ind_b_new, prev(ob));
         }
+        legalizeAround(new_vertex_ind, edges_to_fix);
     }
 
     //! \param new_vertex
@@ -685,21 +976,13 @@ namespace cdt
     VertInd Triangulation<Vertex>::findOverlappingVertex(const Vertex &new_vertex, const TriInd tri_ind) const
     {
         assert(tri_ind != -1);
-        const auto old_triangle = m_triangles[tri_ind];
-        const auto v0 = old_triangle.verts[0];
-        const auto v1 = old_triangle.verts[1];
-        const auto v2 = old_triangle.verts[2];
-        if (v0 == new_vertex)
-        {
-            return m_tri_ind2vert_inds[tri_ind][0];
-        }
-        if (v1 == new_vertex)
-        {
-            return m_tri_ind2vert_inds[tri_ind][1];
-        }
-        if (v2 == new_vertex)
+        const auto &old_triangle = m_triangles[tri_ind];
+        for (int k = 0; k < 3; ++k)
         {
-            return m_tri_ind2vert_inds[tri_ind][2];
+            if (vertexOf(old_triangle, k) == new_vertex)
+            {
+                return old_triangle.vert_inds[k];
+            }
         }
         return -1;
     }
@@ -713,30 +996,15 @@ namespace cdt
     EdgeVInd Triangulation<Vertex>::findOverlappingEdge(const Vertex &new_vertex, const TriInd tri_ind) const
     {
         const auto &old_triangle = m_triangles[tri_ind];
-        const auto v0 = old_triangle.verts[0];
-        const auto v1 = old_triangle.verts[1];
-        const auto v2 = old_triangle.verts[2];
-
-        const auto &vert_inds = m_tri_ind2vert_inds[tri_ind];
-
-        cdt::Vector2i edge_normal0 = {-(v1.y - v0.y), v1.x - v0.x};
-        cdt::Vector2i edge_normal1 = {-(v2.y - v1.y), v2.x - v1.x};
-        cdt::Vector2i edge_normal2 = {-(v0.y - v2.y), v0.x - v2.x};
-        EdgeI edge0 = {old_triangle.verts[0], old_triangle.verts[1]};
-        EdgeI edge1 = {old_triangle.verts[1], old_triangle.verts[2]};
-        EdgeI edge2 = {old_triangle.verts[2], old_triangle.verts[0]};
-        if (old_triangle.is_constrained[0] && dot(new_vertex - v0, edge_normal0) == 0)
-        {
-            return {vert_inds[0], vert_inds[1]};
-        }
-        else if (old_triangle.is_constrained[1] && dot(new_vertex - v1, edge_normal1) == 0)
+        for (int k = 0; k < 3; ++k)
         {
-            return {vert_inds[1], vert_inds[2]};
-        }
-        else if (old_triangle.is_constrained[2] && dot(new_vertex - v2, edge_normal2) == 0)
-        {
-            return {vert_inds[2], vert_inds[0]};
-            ;
+            const auto &v_from = vertexOf(old_triangle, k);
+            const auto &v_to = vertexOf(old_triangle, next(k));
+            cdt::Vector2i edge_normal = {-(v_to.y - v_from.y), v_to.x - v_from.x};
+            if (old_triangle.isConstrained(k) && dot(new_vertex - v_from, edge_normal) == 0)
+            {
+                return {old_triangle.vert_inds[k], old_triangle.vert_inds[next(k)]};
+            }
         }
         return EdgeVInd();
     }
@@ -763,35 +1031,171 @@ namespace cdt
     }
 
     //! \brief inserts all \p verts into the triangulation
-    //!
+    //! \brief vertices are shuffled into biased randomized rounds (BRIO) where each round is twice as large as
+    //! \brief the previous one and is sorted along a Hilbert curve, so each insertion walks only a few triangles
+    //! \param verts vertices to insert, duplicates and vertices outside of the boundary are skipped
+    //! \returns index in m_vertices of each vertex in \p verts or -1 for the ones outside of the boundary
     template <class Vertex>
-    void Triangulation<Vertex>::insertVertices(const std::vector<Vertex> &verts)
+    std::vector<VertInd> Triangulation<Vertex>::insertVertices(std::span<const Vertex> verts)
     {
-        int vert_ind = m_vertices.size();
-        std::vector<std::vector<Vertex>> m_grid2vert_inds(m_grid->getNCells());
+        std::vector<VertInd> vert_inds(verts.size(), -1);
+        if (verts.empty())
+        {
+            return vert_inds;
+        }
 
-        //! sort vertices into bins formed by grid cells
-        for (auto &v : verts)
+        std::vector<std::size_t> insertion_order(verts.size());
+        std::iota(insertion_order.begin(), insertion_order.end(), 0);
+        std::mt19937 gen(verts.size()); //! fixed seed so that the resulting triangulation is reproducible
+        std::shuffle(insertion_order.begin(), insertion_order.end(), gen);
+
+        //! curve coordinates are scaled down so that the whole boundary fits into hilbert_order bits
+        constexpr int hilbert_order = 16;
+        int shift = 0;
+        while ((std::max(m_boundary.x, m_boundary.y) >> shift) >= (1 << hilbert_order))
+        {
+            shift++;
+        }
+        std::vector<std::uint64_t> curve_inds(verts.size());
+        for (std::size_t i = 0; i < verts.size(); ++i)
         {
-            m_grid2vert_inds.at(m_grid->cellIndex(v)).push_back(v);
-            vert_ind++;
+            const auto x = std::clamp(static_cast<int>(verts[i].x), 0, m_boundary.x) >> shift;
+            const auto y = std::clamp(static_cast<int>(verts[i].y), 0, m_boundary.y) >> shift;
+            curve_inds[i] = hilbertIndex(x, y, hilbert_order);
         }
 
-        auto cells_x = m_grid->m_cell_count.x;
-        for (int iy = 0; iy < m_grid->m_cell_count.y; iy++)
+        //! the last round holds half of the vertices, the one before it a quarter and so on
+        constexpr std::size_t min_round_size = 16;
+        std::vector<std::size_t> round_ends;
+        for (auto round_end = verts.size(); round_end > 0; round_end /= 2)
         {
-            bool odd_line = iy % 2 == 1;
-            for (int ix = 0; ix < m_grid->m_cell_count.x; ix++)
+            round_ends.push_back(round_end);
+            if (round_end <= min_round_size)
             {
+                break;
+            }
+        }
+        std::reverse(round_ends.begin(), round_ends.end());
+
+        std::size_t round_begin = 0;
+        for (const auto round_end : round_ends)
+        {
+            std::sort(insertion_order.begin() + round_begin, insertion_order.begin() + round_end,
+                      [&curve_inds](std::size_t a, std::size_t b)
+                      { return curve_inds[a] < curve_inds[b]; });
+            round_begin = round_end;
+        }
+
+        for (const auto vert_ind : insertion_order)
+        {
+            const auto n_verts_before = m_vertices.size();
+            const auto data = insertVertexAndGetData(verts[vert_ind], true);
+            if (data.overlapping_vertex != -1)
+            {
+                vert_inds[vert_ind] = data.overlapping_vertex;
+            }
+            else if (m_vertices.size() > n_verts_before)
+            {
+                vert_inds[vert_ind] = n_verts_before;
+            }
+        }
+        return vert_inds;
+    }
+
+    //! \brief throws away current triangulation and builds Delaunay triangulation of the boundary and \p verts
+    //! \brief at once by divide and conquer in O(n log n), constraints are meant to be inserted afterwards
+    //! \param verts vertices to triangulate, duplicates and vertices outside of the boundary are skipped
+    //! \param pool when not null, sorting and triangulating of vertical strips of the vertices runs on its threads
+    //! \returns index in m_vertices of each vertex in \p verts or -1 for the ones outside of the boundary
+    template <class Vertex>
+    std::vector<VertInd> Triangulation<Vertex>::buildFromVertices(const std::vector<Vertex> &verts, ThreadPool *pool)
+    {
+        reset();
+        const std::size_t n_boundary_verts = m_vertices.size();
+        const auto n_verts = n_boundary_verts + verts.size();
+        const auto vertex_at = [&](std::size_t i) -> const Vertex &
+        { return i < n_boundary_verts ? m_vertices[i] : verts[i - n_boundary_verts]; };
+
+        //! vertices sorted by packed coordinates put duplicates next to each other (boundary vertices come first)
+        std::vector<std::pair<std::uint64_t, std::size_t>> sorted_verts;
+        sorted_verts.reserve(n_verts);
+        for (std::size_t i = 0; i < n_verts; ++i)
+        {
+            const auto &v = vertex_at(i);
+            if (withinBoundary(v))
+            {
+                sorted_verts.emplace_back((static_cast<std::uint64_t>(v.x) << 32) | static_cast<std::uint32_t>(v.y), i);
+            }
+        }
+        if (pool && pool->size() > 1)
+        {
+            parallelSort(sorted_verts, *pool);
+        }
+        else
+        {
+            std::sort(sorted_verts.begin(), sorted_verts.end());
+        }
+
+        std::vector<std::size_t> first_occurrence(n_verts, -1);
+        for (std::size_t i = 0; i < sorted_verts.size(); ++i)
+        {
+            const bool is_duplicate = i > 0 && sorted_verts[i].first == sorted_verts[i - 1].first;
+            const auto vert = sorted_verts[i].second;
+            first_occurrence[vert] = is_duplicate ? first_occurrence[sorted_verts[i - 1].second] : vert;
+        }
+
+        std::vector<VertInd> vert_inds(n_verts, -1);
+        std::iota(vert_inds.begin(), vert_inds.begin() + n_boundary_verts, 0);
+        m_vertices.reserve(n_verts);
+        for (std::size_t i = n_boundary_verts; i < n_verts; ++i)
+        {
+            if (first_occurrence[i] == i)
+            {
+                vert_inds[i] = m_vertices.size();
+                m_vertices.push_back(verts[i - n_boundary_verts]);
+            }
+            else if (first_occurrence[i] != -1)
+            {
+                vert_inds[i] = vert_inds[first_occurrence[i]];
+            }
+        }
 
-                int ix_walk = odd_line * (cells_x - 1) + (1 - 2 * odd_line) * ix;
-                auto cell_ind = m_grid->cellIndex(ix_walk, iy);
-                for (auto &v : m_grid2vert_inds.at(cell_ind))
+        std::vector<VertInd> sorted_vert_inds;
+        sorted_vert_inds.reserve(m_vertices.size());
+        for (const auto &[key, vert] : sorted_verts)
+        {
+            if (first_occurrence[vert] == vert)
+            {
+                sorted_vert_inds.push_back(vert_inds[vert]);
+            }
+        }
+
+        DelaunayBuilder<Vertex> builder;
+        m_triangles = builder.triangulate(m_vertices, std::move(sorted_vert_inds), pool);
+        m_vertex2tri.assign(m_vertices.size(), -1);
+        for (TriInd tri_ind = 0; tri_ind < m_triangles.size(); ++tri_ind)
+        {
+            updateVertex2Tri(tri_ind);
+        }
+
+        //! the hull of the triangulation is the boundary so every edge without neighbour is a boundary constraint
+        m_fixed_edges.clear();
+        for (auto &tri : m_triangles)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                if (tri.neighbours[k] == -1)
                 {
-                    auto data = insertVertexAndGetData(v, true);
+                    tri.setConstrained(k, true);
+                    m_fixed_edges.insert({tri.vert_inds[k], tri.vert_inds[next(k)]});
                 }
             }
         }
+        assert(triangulationIsConsistent());
+
+        m_cursor.hint = 0;
+        updateCellGrid();
+        return {vert_inds.begin() + n_boundary_verts, vert_inds.end()};
     }
 
     //! \brief inserts \p new_vertex into triangulation, the inserted vertex can either:
@@ -803,14 +1207,13 @@ namespace cdt
     VertexInsertionData Triangulation<Vertex>::insertVertexAndGetData(const Vertex &new_vertex, bool search_from_last_one)
     {
         VertexInsertionData data;
-        
-        if(!withinBoundary(new_vertex))
+
+        if (!withinBoundary(new_vertex))
         {
             return data;
         }
 
         auto tri_ind = findTriangle(new_vertex, search_from_last_one);
-        const auto old_triangle = m_triangles[tri_ind];
 
         data.overlapping_vertex = findOverlappingVertex(new_vertex, tri_ind);
         if (data.overlapping_vertex != -1)
@@ -820,171 +1223,71 @@ namespace cdt
 
         const auto new_vertex_ind = m_vertices.size();
         m_vertices.push_back(new_vertex);
+        m_vertex2tri.push_back(-1); //! set by the insertion below
 
         const auto overlapping_edge = findOverlappingEdge(new_vertex, tri_ind);
         if (overlapping_edge.from != -1)
         {
-            const EdgeI edge_i = {m_vertices[overlapping_edge.from], m_vertices[overlapping_edge.to]};
-            insertVertexOnEdge(new_vertex, tri_ind, triangleOppositeOfEdge(old_triangle, edge_i), edge_i);
+            insertVertexOnEdge(new_vertex_ind, tri_ind, indexOf(overlapping_edge.from, m_triangles[tri_ind]));
             data.overlapping_edge = overlapping_edge;
             return data;
         }
 
-        insertVertexIntoSpace(new_vertex, tri_ind, new_vertex_ind);
+        insertVertexIntoSpace(tri_ind, new_vertex_ind);
         return data;
     }
 
-    //! \brief inserts \p new_vertex into triangulation knowing it lies in free space (not on edge or vertex)
-    //! \param new_vertex
-    //! \param search_from_last_one should be true if last added vertex is not far from \p new_vertex
-    //! \returns data relating to the actual type of insertion performed
+    //! \brief inserts vertex at \p new_vertex_ind into triangulation knowing it lies in free space (not on edge or vertex)
+    //! \param tri_ind index of the triangle containing the new vertex
+    //! \param new_vertex_ind index of the new vertex in m_vertices
     template <class Vertex>
-    void Triangulation<Vertex>::insertVertexIntoSpace(const Vertex &new_vertex, TriInd tri_ind, VertInd new_vertex_ind)
+    void Triangulation<Vertex>::insertVertexIntoSpace(TriInd tri_ind, VertInd new_vertex_ind)
     {
-
         const auto old_triangle = m_triangles[tri_ind];
 
+        //! old triangle (a, b, c) is split into t1 = (a, b, p), t2 = (p, b, c) and t3 = (a, p, c),
+        //! each keeps the outer edge of the old triangle at the same index
         const auto first_new_triangle_ind = tri_ind;
-        const auto second_new_triangle_ind = m_triangles.size();
-        const auto third_new_triangle_ind = m_triangles.size() + 1;
+        const TriInd second_new_triangle_ind = m_triangles.size();
+        const TriInd third_new_triangle_ind = m_triangles.size() + 1;
 
         Triangle t1_new = old_triangle;
         Triangle t2_new = old_triangle;
         Triangle t3_new = old_triangle;
 
-        m_tri_ind2vert_inds.push_back(m_tri_ind2vert_inds[tri_ind]);
-        m_tri_ind2vert_inds.push_back(m_tri_ind2vert_inds[tri_ind]);
+        t1_new.vert_inds[2] = new_vertex_ind;
+        t1_new.constraints = 0;
+        t1_new.setConstrained(0, old_triangle.isConstrained(0));
 
-        // assert(hasGoodOrientation(old_triangle));
+        t2_new.vert_inds[0] = new_vertex_ind;
+        t2_new.constraints = 0;
+        t2_new.setConstrained(1, old_triangle.isConstrained(1));
 
-        for (int i = 0; i < 3; ++i)
-        {
-            t1_new.is_constrained[i] = false;
-        }
-        for (int i = 0; i < 3; ++i)
-        {
-            t2_new.is_constrained[i] = false;
-        }
-        for (int i = 0; i < 3; ++i)
-        {
-            t3_new.is_constrained[i] = false;
-        }
-        //    m_tri_ind2vert_inds[first_new_triangle_ind] = new_vertex_ind;
-        m_tri_ind2vert_inds[first_new_triangle_ind][2] = new_vertex_ind;
-        t1_new.verts[2] = new_vertex;
-        t1_new.neighbours[2] = third_new_triangle_ind;
-        t1_new.neighbours[1] = second_new_triangle_ind;
-        if (old_triangle.is_constrained[0])
-        {
-            t1_new.is_constrained[0] = true;
-        }
+        t3_new.vert_inds[1] = new_vertex_ind;
+        t3_new.constraints = 0;
+        t3_new.setConstrained(2, old_triangle.isConstrained(2));
 
         m_triangles[tri_ind] = t1_new;
-
-        //    t2_new.vertinds[0] =  new_vertex_ind;
-        m_tri_ind2vert_inds[second_new_triangle_ind][0] = new_vertex_ind;
-        t2_new.verts[0] = new_vertex;
-        t2_new.neighbours[0] = first_new_triangle_ind;
-        t2_new.neighbours[2] = third_new_triangle_ind;
-        if (old_triangle.is_constrained[1])
-        {
-            t2_new.is_constrained[1] = true;
-        }
-
-        //    t3_new.vertinds[1] = new_vertex_ind;
-        m_tri_ind2vert_inds[third_new_triangle_ind][1] = new_vertex_ind;
-        t3_new.verts[1] = new_vertex;
-        t3_new.neighbours[1] = second_new_triangle_ind;
-        t3_new.neighbours[0] = first_new_triangle_ind;
-        if (old_triangle.is_constrained[2])
-        {
-            t3_new.is_constrained[2] = true;
-        }
-
-        //! fix delaunay property
-        std::stack<std::pair<TriInd, TriInd>> triangles_to_fix;
-        if (old_triangle.neighbours[0] != -1)
-        {
-            triangles_to_fix.push({first_new_triangle_ind, old_triangle.neighbours[0]});
-        }
-        if (old_triangle.neighbours[1] != -1)
-        {
-            triangles_to_fix.push({second_new_triangle_ind, old_triangle.neighbours[1]});
-        }
-        if (old_triangle.neighbours[2] != -1)
-        {
-            triangles_to_fix.push({third_new_triangle_ind, old_triangle.neighbours[2]});
-        }
-
-        //! we tell old triangles that they have a new neighbour;
-        if (old_triangle.neighbours[1] != -1)
-        {
-            auto neighbour = old_triangle.neighbours[1];
-            auto &tri_next = m_triangles[neighbour];
-            for (int i = 0; i < 3; ++i)
-            {
-                if (tri_next.neighbours[i] == tri_ind)
-                {
-                    tri_next.neighbours[i] = second_new_triangle_ind;
-                    break;
-                }
-            }
-        }
-        if (old_triangle.neighbours[2] != -1)
-        {
-            auto neighbour = old_triangle.neighbours[2];
-            auto &tri_next = m_triangles[neighbour];
-            for (int i = 0; i < 3; ++i)
-            {
-                if (tri_next.neighbours[i] == tri_ind)
-                {
-                    tri_next.neighbours[i] = third_new_triangle_ind;
-                    break;
-                }
-            }
-        }
-
-        //        removeTriangle(tri_ind);
-
-        //        m_triangles.push_back(t1_new);
         m_triangles.push_back(t2_new);
         m_triangles.push_back(t3_new);
 
-        while (!triangles_to_fix.empty())
-        {
-            auto next_tri_ind = triangles_to_fix.top().second;
-            auto &next_tri = m_triangles[next_tri_ind];
-            auto old_tri_ind = triangles_to_fix.top().first;
-            auto &old_tri = m_triangles[old_tri_ind];
-            triangles_to_fix.pop();
-
-            auto opposite_ind_in_tri = oppositeIndex(old_tri_ind, next_tri);
-            auto newvert_ind_in_tri = indexOf(new_vertex, old_tri);
-            auto v3 = next_tri.verts[opposite_ind_in_tri];
-            auto v1a = next_tri.verts[(opposite_ind_in_tri + 1) % 3];
-            auto v2a = next_tri.verts[(opposite_ind_in_tri + 2) % 3];
-            auto vp = new_vertex;
-
-            //        EdgeVInd flipped_edge = {next_tri.vertinds[(opposite_ind_in_tri + 1) % 3],
-            //        next_tri.vertinds[(opposite_ind_in_tri + 2) % 3]};
-
-            if (needSwap(vp, v1a, v2a, v3) && !next_tri.is_constrained[next(opposite_ind_in_tri)])
-            {
-
-                auto &a = old_tri.verts[(newvert_ind_in_tri + 2) % 3];
-                assert(isCounterClockwise(a, v3, vp));
-                swapConnectingEdgeCounterClockwise(old_tri_ind, next_tri_ind);
+        linkNeighbours(first_new_triangle_ind, 1, second_new_triangle_ind, 0);
+        linkNeighbours(first_new_triangle_ind, 2, third_new_triangle_ind, 0);
+        linkNeighbours(second_new_triangle_ind, 2, third_new_triangle_ind, 1);
+        //! we tell old triangles that they have a new neighbour;
+        linkNeighbours(second_new_triangle_ind, 1, old_triangle.neighbours[1], old_triangle.backIndex(1));
+        linkNeighbours(third_new_triangle_ind, 2, old_triangle.neighbours[2], old_triangle.backIndex(2));
+        updateCellOf(first_new_triangle_ind);
+        updateVertex2Tri(first_new_triangle_ind);
+        updateCellOf(second_new_triangle_ind);
+        updateVertex2Tri(second_new_triangle_ind);
+        updateCellOf(third_new_triangle_ind);
+        updateVertex2Tri(third_new_triangle_ind);
 
-                if (old_tri.neighbours[(newvert_ind_in_tri + 1) % 3] != -1)
-                {
-                    triangles_to_fix.emplace(old_tri_ind, old_tri.neighbours[(newvert_ind_in_tri + 1) % 3]);
-                }
-                if (next_tri.neighbours[(opposite_ind_in_tri + 2) % 3] != -1)
-                {
-                    triangles_to_fix.emplace(next_tri_ind, next_tri.neighbours[(opposite_ind_in_tri + 2) % 3]);
-                }
-            }
-        }
+        //! fix delaunay property
+        std::vector<std::pair<TriInd, int>> edges_to_fix = {
+            {first_new_triangle_ind, 0}, {second_new_triangle_ind, 1}, {third_new_triangle_ind, 2}};
+        legalizeAround(new_vertex_ind, edges_to_fix);
     }
 
     //! \returns true if quadrilateral formed by the giver four vertices is convex
@@ -992,138 +1295,322 @@ namespace cdt
     bool Triangulation<Vertex>::isConvex(const Vertex v1, const Vertex v2, const Vertex v3,
                                          const Vertex v4) const
     { //! v1-v3 and v2-v4 are diagonals
-        return segmentsIntersect(v1, v3, v2, v4);
+        return segmentsCross(v1, v3, v2, v4);
     }
 
-    //! \param edge represented by vertex coordinates
+    //! \param edge represented by vertex indices
     //! \param tri
-    //! \returns index in triangle of the vertex in \p tri which is opposite of the \p edge
+    //! \returns index in triangle of the vertex in \p tri which is opposite of the \p edge or -1 if edge is not in \p tri
     template <class Vertex>
-    int Triangulation<Vertex>::oppositeOfEdge(const Triangle<Vertex> &tri, const EdgeI<Vertex> &e) const
+    int Triangulation<Vertex>::oppositeOfEdge(const Triangle &tri, const EdgeVInd &e) const
     {
         const auto i1 = indexOf(e.from, tri);
-        const auto i2 = indexOf(e.to(), tri);
+        const auto i2 = indexOf(e.to, tri);
+        if (i1 == -1 or i2 == -1)
+        {
+            return -1;
+        }
         return 3 - (i1 + i2); //! i1 + i2 has values 1,2,3.. corresponding output should be 2,1,0
     }
 
-    //! \brief checks if neighbours of each triangles are consistent and
-    //! \brief if m_tri_ind2vert_inds points to right place in m_vertices array
+    //! \brief checks if neighbours of each triangles are consistent, i.e. they point at each other
+    //! \brief across the same edge with matching back indices and constraint flags
     template <class Vertex>
     bool Triangulation<Vertex>::triangulationIsConsistent() const
     {
-        for (int tri_ind = 0; tri_ind < m_triangles.size(); ++tri_ind)
+        for (TriInd tri_ind = 0; tri_ind < m_triangles.size(); ++tri_ind)
         {
             const auto &tri = m_triangles[tri_ind];
             for (int k = 0; k < 3; ++k)
             {
+                if (tri.vert_inds[k] >= m_vertices.size())
+                {
+                    return false;
+                }
                 const auto neighbour_tri_ind = tri.neighbours[k];
                 if (neighbour_tri_ind != -1)
                 {
                     const auto &neighbour_tri = m_triangles[neighbour_tri_ind];
-                    const auto ind_in_neirhbour_tri = 0;
-                    const auto found_at =
-                        std::find(neighbour_tri.neighbours.begin(), neighbour_tri.neighbours.end(), tri_ind) -
-                        neighbour_tri.neighbours.begin();
-                    if (found_at < 0 or found_at > 2)
+                    const auto ind_in_neighbour = tri.backIndex(k);
+                    if (neighbour_tri.neighbours[ind_in_neighbour] != tri_ind ||
+                        neighbour_tri.backIndex(ind_in_neighbour) != k)
                     {
                         return false;
                     }
-                    if (tri.is_constrained[k] xor neighbour_tri.is_constrained[found_at])
+                    if (neighbour_tri.vert_inds[ind_in_neighbour] != tri.vert_inds[next(k)] ||
+                        neighbour_tri.vert_inds[next(ind_in_neighbour)] != tri.vert_inds[k])
+                    {
+                        return false;
+                    }
+                    if (tri.isConstrained(k) xor neighbour_tri.isConstrained(ind_in_neighbour))
                     {
                         return false;
                     }
-                }
-                const auto v = tri.verts[k];
-                if (v != m_vertices[m_tri_ind2vert_inds[tri_ind][k]])
-                {
-                    return false;
                 }
             }
         }
+
+        if (m_vertex2tri.size() != m_vertices.size())
+        {
+            return false;
+        }
+        for (VertInd v_ind = 0; v_ind < m_vertices.size(); ++v_ind)
+        {
+            const auto tri_ind = m_vertex2tri[v_ind];
+            if (tri_ind >= m_triangles.size() || indexOf(v_ind, m_triangles[tri_ind]) == -1)
+            {
+                return false;
+            }
+        }
         return true;
     }
 
+    //! \brief forces triangulation to have a constrained edge connecting \p e.from and \p e.to
+    //! \brief and draws every edge swap into \p window (for debugging)
+    //! \param e edge representing the constraint
+    template <class Vertex>
+    void Triangulation<Vertex>::insertConstraint(const EdgeVInd e, sf::RenderWindow &window)
+    {
+        m_font.loadFromFile("../Resources/arial.ttf");
+        m_debug_window = &window;
+        insertConstraint(e);
+        m_debug_window = nullptr;
+    }
+
     //! \brief forces triangulation to have a constrained edge connecting \p e.from and \p e.to
     //! \param e edge representing the constraint
     template <class Vertex>
     void Triangulation<Vertex>::insertConstraint(const EdgeVInd e)
     {
+        m_scratch.newly_created_edges.clear();
+        m_scratch.newly_created_edge_tris.clear();
+        insertConstraintParts(e);
+        fixNewlyCreatedEdges();
+    }
+
+    //! \brief forces triangulation to have constrained edges given by \p edges
+    //! \brief duplicate edges are skipped and the rest is inserted in the order of a Hilbert curve so that consecutive
+    //! \brief insertions touch nearby triangles, Delaunay property is restored just once at the end
+    //! \param edges edges representing the constraints
+    template <class Vertex>
+    void Triangulation<Vertex>::insertConstraints(std::span<const EdgeVInd> edges)
+    {
+        auto &ordered_edges = m_scratch.ordered_edges;
+        ordered_edges.clear();
+        for (const auto &e : edges)
+        {
+            if (e.from != e.to)
+            {
+                ordered_edges.emplace_back(0, EdgeVInd{std::min(e.from, e.to), std::max(e.from, e.to)});
+            }
+        }
+        std::sort(ordered_edges.begin(), ordered_edges.end(), [](const auto &a, const auto &b)
+                  { return a.second.from < b.second.from ||
+                           (a.second.from == b.second.from && a.second.to < b.second.to); });
+        ordered_edges.erase(std::unique(ordered_edges.begin(), ordered_edges.end(), [](const auto &a, const auto &b)
+                                        { return a.second == b.second; }),
+                            ordered_edges.end());
 
-        auto vi_ind = e.from;
-        auto vj_ind = e.to;
-        auto vi = m_vertices[vi_ind];
-        auto vj = m_vertices[vj_ind];
-        if (m_fixed_edges.count({vi, vj}) > 0 || e.from == e.to) //! constrained edge alread exists
+        //! order by position of the edge midpoints along a Hilbert curve
+        constexpr int hilbert_order = 16;
+        int shift = 0;
+        while ((2 * std::max(m_boundary.x, m_boundary.y) >> shift) >= (1 << hilbert_order))
         {
-            return;
+            shift++;
+        }
+        for (auto &[curve_ind, e] : ordered_edges)
+        {
+            const auto doubled_mid = m_vertices[e.from] + m_vertices[e.to];
+            const auto x = std::clamp(static_cast<int>(doubled_mid.x), 0, 2 * m_boundary.x) >> shift;
+            const auto y = std::clamp(static_cast<int>(doubled_mid.y), 0, 2 * m_boundary.y) >> shift;
+            curve_ind = hilbertIndex(x, y, hilbert_order);
+        }
+        std::sort(ordered_edges.begin(), ordered_edges.end(), [](const auto &a, const auto &b)
+                  { return a.first < b.first; });
+
+        m_scratch.newly_created_edges.clear();
+        m_scratch.newly_created_edge_tris.clear();
+        for (const auto &[curve_ind, e] : ordered_edges)
+        {
+            insertConstraintParts(e);
         }
-        m_fixed_edges.insert({vi, vj});
+        fixNewlyCreatedEdges();
+    }
 
-        std::deque<EdgeI<Vertex>> intersected_edges;
-        std::deque<TriInd> intersected_tri_inds;
-        findIntersectingEdges(e, intersected_edges, intersected_tri_inds);
+    //! \brief inserts endpoints of \p edges and forces triangulation to have constrained edges connecting them
+    //! \brief endpoints shared by several edges are inserted only once
+    //! \param edges edges given by coordinates of their endpoints
+    template <class Vertex>
+    void Triangulation<Vertex>::insertConstraints(std::span<const EdgeI<Vertex>> edges)
+    {
+        std::vector<Vertex> endpoints;
+        endpoints.reserve(2 * edges.size());
+        for (const auto &e : edges)
+        {
+            endpoints.push_back(e.from);
+            endpoints.push_back(e.to());
+        }
+        const auto vert_inds = insertVertices(endpoints);
 
-        auto overlapsx = findOverlappingConstraints(vi, vj);
-        auto overlaps = findOverlappingConstraints2(vi, vj);
-        if (!overlaps.empty())
+        std::vector<EdgeVInd> edge_inds;
+        edge_inds.reserve(edges.size());
+        for (std::size_t i = 0; i < edges.size(); ++i)
         {
-            for (const auto &overlap : overlaps)
+            if (vert_inds[2 * i] != -1 && vert_inds[2 * i + 1] != -1)
             {
-                insertConstraint(overlap);
+                edge_inds.push_back({vert_inds[2 * i], vert_inds[2 * i + 1]});
             }
-            insertConstraint({e.from, overlaps[0].from});
-            for (int i = 1; i < overlaps.size(); ++i)
+        }
+        insertConstraints(edge_inds);
+    }
+
+    //! \brief inserts \p points and forces triangulation to have constrained edges between consecutive points
+    //! \param points vertices of the polyline
+    //! \param is_closed whether the last point gets connected to the first one (the polyline is a polygon)
+    //! \returns index in m_vertices of each of the \p points or -1 for the ones outside of the boundary
+    template <class Vertex>
+    std::vector<VertInd> Triangulation<Vertex>::insertPolyline(std::span<const Vertex> points, bool is_closed)
+    {
+        const auto vert_inds = insertVertices(points);
+
+        std::vector<EdgeVInd> edge_inds;
+        edge_inds.reserve(points.size());
+        for (std::size_t i = 0; i + 1 < vert_inds.size(); ++i)
+        {
+            edge_inds.push_back({vert_inds[i], vert_inds[i + 1]});
+        }
+        if (is_closed && vert_inds.size() > 2)
+        {
+            edge_inds.push_back({vert_inds.back(), vert_inds.front()});
+        }
+        std::erase_if(edge_inds, [](const EdgeVInd &e)
+                      { return e.from == -1 || e.to == -1; });
+        insertConstraints(edge_inds);
+        return vert_inds;
+    }
+
+    //! \brief forces triangulation to have a constrained edge connecting \p e.from and \p e.to
+    //! \brief Delaunay property is not restored, edges that need to be checked are added to
+    //! \brief m_scratch.newly_created_edges. A constraint going through existing vertices is split into parts
+    //! \brief which are inserted one by one from the work list m_scratch.pending_parts
+    //! \param e edge representing the constraint
+    template <class Vertex>
+    void Triangulation<Vertex>::insertConstraintParts(const EdgeVInd e)
+    {
+        auto &pending_parts = m_scratch.pending_parts;
+        auto &overlaps = m_scratch.overlaps;
+        pending_parts.clear();
+        pending_parts.push_back(e);
+        while (!pending_parts.empty())
+        {
+            const auto part = pending_parts.back();
+            pending_parts.pop_back();
+            if (part.from == part.to || !m_fixed_edges.insert(part)) //! constrained edge alread exists
             {
-                insertConstraint({overlaps.at(i - 1).to, overlaps.at(i).from});
+                continue;
             }
-            insertConstraint({e.to, overlaps.back().to});
-            return;
-        }
 
-        std::vector<EdgeI<Vertex>> newly_created_edges;
-        std::vector<std::pair<TriInd, TriInd>> newly_created_edge_tris;
+            findIntersectingEdges(part);
+
+            collectOverlaps(part, overlaps);
+            if (overlaps.empty())
+            {
+                insertConstraintPart(part);
+                continue;
+            }
 
-        EdgeI e_inserted = {vi, vj};
+            //! the parts are pushed in reverse so that they get inserted from overlaps first to the last gap
+            pending_parts.push_back({part.to, overlaps.back().to});
+            for (auto i = overlaps.size() - 1; i > 0; --i)
+            {
+                pending_parts.push_back({overlaps[i - 1].to, overlaps[i].from});
+            }
+            pending_parts.push_back({part.from, overlaps[0].from});
+            pending_parts.insert(pending_parts.end(), overlaps.rbegin(), overlaps.rend());
+
+            const bool is_split = overlaps.size() > 1 || std::minmax(overlaps[0].from, overlaps[0].to) !=
+                                                              std::minmax(part.from, part.to);
+            if (is_split)
+            { //! only the parts are remembered so that they can be removed separately
+                m_fixed_edges.erase(part);
+            }
+        }
+    }
 
-        //! remove intersecting edges
-        while (!intersected_edges.empty())
+    //! \brief swaps away edges crossing \p e which were found by findIntersectingEdges (Steps 3.1 - 4.1)
+    //! \param e constraint which does not go through any vertex
+    template <class Vertex>
+    void Triangulation<Vertex>::insertConstraintPart(const EdgeVInd e)
+    {
+        if (m_constraint_insertion == ConstraintInsertion::Cavity)
         {
-            auto tri_ind = intersected_tri_inds.front();
-            auto &tri = m_triangles[tri_ind];
-            intersected_tri_inds.pop_front();
-            auto e_next = intersected_edges.front();
-            intersected_edges.pop_front();
+            if (!m_scratch.intersected_edges.empty())
+            {
+                retriangulateCavity(e);
+            }
+            return;
+        }
 
-            auto next_tri_ind = triangleOppositeOfEdge(tri, e_next);
-            auto &next_tri = m_triangles[next_tri_ind];
+        const auto vi = m_vertices[e.from];
+        const auto vj = m_vertices[e.to];
+        auto &intersected_edges = m_scratch.intersected_edges;
+        auto &intersected_tri_inds = m_scratch.intersected_tri_inds;
+        auto &newly_created_edges = m_scratch.newly_created_edges;
+        auto &newly_created_edge_tris = m_scratch.newly_created_edge_tris;
+        const auto first_new_edge = newly_created_edges.size();
+
+        //! remove intersecting edges (steps 3.1 3.2), the buffers work as queues starting at i_front
+        for (std::size_t i_front = 0; i_front < intersected_edges.size(); ++i_front)
+        {
+            auto tri_ind = intersected_tri_inds[i_front];
+            auto e_next = intersected_edges[i_front];
+            if (oppositeOfEdge(m_triangles[tri_ind], e_next) == -1)
+            { //! a later swap in the same triangle moved the queued edge into one of the other swapped triangles
+                const auto star = trianglesAround(e_next.from);
+                const auto it = std::find_if(star.begin(), star.end(), [&](const auto &tri_and_ind)
+                                             { return indexOf(e_next.to, m_triangles[tri_and_ind.first]) != -1; });
+                assert(it != star.end());
+                tri_ind = it->first;
+            }
+            const auto &tri = m_triangles[tri_ind];
+            const auto v_current_ind_in_tri = oppositeOfEdge(tri, e_next);
+            assert(v_current_ind_in_tri != -1); //! triangle must contain e_next;
 
-            auto v_current_ind = m_tri_ind2vert_inds[tri_ind][oppositeOfEdge(tri, e_next)];
-            auto v_current = tri.verts[oppositeOfEdge(tri, e_next)];
-            auto v_opposite_ind_in_tri = oppositeIndex(tri_ind, next_tri);
-            auto v_opposite_current = next_tri.verts[v_opposite_ind_in_tri];
+            const auto next_tri_ind = tri.neighbours[next(v_current_ind_in_tri)];
+            const auto v_opposite_ind_in_tri = tri.oppositeInNeighbour(next(v_current_ind_in_tri));
+
+            const auto v_current_ind = tri.vert_inds[v_current_ind_in_tri];
+            const auto v_opposite_ind = m_triangles[next_tri_ind].vert_inds[v_opposite_ind_in_tri];
+            const auto v_current = m_vertices[v_current_ind];
+            const auto v_opposite_current = m_vertices[v_opposite_ind];
 
             //! we can swap edges only in convex quadrilaterals otherwise bad shapes get created
-            if (isConvex(v_current, e_next.from, v_opposite_current, e_next.to()))
+            if (isConvex(v_current, m_vertices[e_next.from], v_opposite_current, m_vertices[e_next.to]))
             {
                 if (isCounterClockwise(v_opposite_current, vi, vj))
                 {
-                    swapConnectingEdgeCounterClockwise(next_tri_ind, tri_ind);
-                    assert(triangulationIsConsistent());
+                    swapConnectingEdgeCounterClockwise(next_tri_ind, v_opposite_ind_in_tri);
                 }
                 else
                 {
-                    swapConnectingEdgeClockwise(tri_ind, next_tri_ind);
-                    assert(triangulationIsConsistent());
+                    swapConnectingEdgeClockwise(tri_ind, v_current_ind_in_tri);
                 }
+                assert(triangulationIsConsistent());
                 assert(allTrianglesValid());
 
-                e_next = {v_current, v_opposite_current};
+                if (m_debug_window)
+                {
+                    drawTriangulation(*this, *m_debug_window);
+                    drawTriInds(*this, *m_debug_window);
+                    m_debug_window->display();
+                }
+
+                e_next = {v_current_ind, v_opposite_ind};
 
-                if (edgesIntersect(e_next, e_inserted))
+                if (edgesIntersect(e_next, e))
                 {
                     intersected_edges.push_back(e_next);
                     intersected_tri_inds.push_back(tri_ind);
-                    auto ind_in_tri = oppositeOfEdge(m_triangles.at(tri_ind), e_next);
                 }
                 else
                 {
@@ -1138,627 +1625,884 @@ namespace cdt
             }
         }
 
-        //! Fix Delaunay triangulation (Steps 4.1 - 4.3)
-        bool some_swap_happened = true;
-        while (some_swap_happened)
+        //! the constraint itself was created by one of the swaps (Step 4.1)
+        for (auto i = first_new_edge; i < newly_created_edges.size(); ++i)
         {
-            some_swap_happened = false;
-
-            for (int i = 0; i < newly_created_edges.size(); ++i)
+            if (newly_created_edges[i] == e)
             {
-                const auto &e_new = newly_created_edges[i];
-                const auto tri_ind_a = newly_created_edge_tris[i].first;
+                const auto [tri_ind_a, opposite_ind_in_tri_a] = findNewlyCreatedEdge(e, newly_created_edge_tris[i]);
                 auto &tri_a = m_triangles[tri_ind_a];
-                auto tri_ind_b = triangleOppositeOfEdge(tri_a, e_new);
-                if (tri_ind_b == -1)
+                auto &tri_b = m_triangles[tri_a.neighbours[next(opposite_ind_in_tri_a)]];
+                tri_b.setConstrained(tri_a.backIndex(next(opposite_ind_in_tri_a)), true);
+                tri_a.setConstrained(next(opposite_ind_in_tri_a), true);
+            }
+        }
+    }
+
+    //! \brief removes triangles pierced by \p e and triangulates the polygons on both sides of \p e directly
+    //! \brief (Anglada's algorithm), the result is constrained Delaunay so nothing needs to be swapped later
+    //! \brief the new triangles reuse indices of the removed ones as there is always the same number of them
+    //! \brief when the constraint runs into a vertex, only the part up to the vertex is inserted and the rest is
+    //! \brief pushed to m_scratch.pending_parts
+    //! \param e constraint whose first pierced triangle was found by findIntersectingEdges
+    template <class Vertex>
+    void Triangulation<Vertex>::retriangulateCavity(const EdgeVInd e)
+    {
+        auto &cavity = m_scratch.cavity;
+        auto &polygons = m_scratch.polygons;
+        for (auto &polygon : polygons)
+        {
+            polygon.vert_inds.clear();
+            polygon.outer_edges.clear();
+        }
+        cavity.clear();
+        m_scratch.detached.clear();
+        auto &[left, right] = polygons;
+
+        const auto &va = m_vertices[e.from];
+        const auto &vb = m_vertices[e.to];
+        const auto outer_edge = [this](TriInd tri_ind, int ind_in_tri) -> OuterEdge
+        {
+            const auto &tri = m_triangles[tri_ind];
+            return {tri.neighbours[ind_in_tri], tri.backIndex(ind_in_tri), tri.isConstrained(ind_in_tri)};
+        };
+        //! a vertex whose whole star is pierced shows up on both sides of the tip of an edge sticking into the
+        //! cavity, such vertices are detached and inserted again once the cavity is triangulated
+        const auto extend = [this](auto &polygon, VertInd w_ind, const OuterEdge &outer)
+        {
+            const auto n_verts = polygon.vert_inds.size();
+            if (polygon.vert_inds[n_verts - 2] == w_ind)
+            {
+                const auto tip_ind = polygon.vert_inds.back();
+                if (polygon.outer_edges.back().is_constrained)
                 {
-                    tri_ind_b = newly_created_edge_tris[i].second;
+                    m_fixed_edges.erase({w_ind, tip_ind});
+                    m_scratch.pending_parts.push_back({w_ind, tip_ind});
                 }
-                auto &tri_b = m_triangles[tri_ind_b];
+                m_scratch.detached.push_back(tip_ind);
+                polygon.vert_inds.pop_back();
+                polygon.outer_edges.pop_back();
+                return;
+            }
+            polygon.vert_inds.push_back(w_ind);
+            polygon.outer_edges.push_back(outer);
+        };
+
+        //! triangles turn clockwise so the vertex following e.from lies left of e
+        auto tri_ind = m_scratch.intersected_tri_inds.front();
+        const auto ind_of_a = indexOf(e.from, m_triangles[tri_ind]);
+        left.vert_inds = {e.from, m_triangles[tri_ind].vert_inds[next(ind_of_a)]};
+        right.vert_inds = {e.from, m_triangles[tri_ind].vert_inds[prev(ind_of_a)]};
+        left.outer_edges.push_back(outer_edge(tri_ind, ind_of_a));
+        right.outer_edges.push_back(outer_edge(tri_ind, prev(ind_of_a)));
+        cavity.push_back(tri_ind);
+
+        //! walk over the pierced triangles, each is entered through its edge going from the right to the left side
+        auto entry_tri_ind = tri_ind;
+        auto entry_ind = next(ind_of_a);
+        while (true)
+        {
+            assert(!m_triangles[entry_tri_ind].isConstrained(entry_ind)); //! constraints must not cross each other
+            tri_ind = m_triangles[entry_tri_ind].neighbours[entry_ind];
+            entry_ind = m_triangles[entry_tri_ind].backIndex(entry_ind);
+            cavity.push_back(tri_ind);
 
-                const auto opposite_ind_in_tri_a = oppositeOfEdge(tri_a, e_new);
-                const auto opposite_ind_in_tri_b = oppositeOfEdge(tri_b, e_new);
+            const auto &tri = m_triangles[tri_ind];
+            const auto w_ind = tri.vert_inds[prev(entry_ind)];
+            const auto side = orientation(va, vb, m_vertices[w_ind]);
+            if (w_ind != e.to && side == 0)
+            { //! the constraint goes through a vertex, the part behind it is inserted separately
+                m_fixed_edges.erase(e);
+                m_fixed_edges.insert({e.from, w_ind});
+                m_scratch.pending_parts.push_back({w_ind, e.to});
+            }
+            if (side == 0)
+            {
+                extend(left, w_ind, outer_edge(tri_ind, next(entry_ind)));
+                extend(right, w_ind, outer_edge(tri_ind, prev(entry_ind)));
+                break;
+            }
 
-                vi = tri_a.verts[opposite_ind_in_tri_a];
-                vj = tri_b.verts[opposite_ind_in_tri_b];
-                vi_ind = m_tri_ind2vert_inds[tri_ind_a][opposite_ind_in_tri_a];
-                auto vi_ind_next = m_tri_ind2vert_inds[tri_ind_a][next(opposite_ind_in_tri_a)];
-                auto vi_ind_prev = m_tri_ind2vert_inds[tri_ind_a][prev(opposite_ind_in_tri_a)];
+            entry_tri_ind = tri_ind;
+            if (side > 0)
+            {
+                extend(left, w_ind, outer_edge(tri_ind, next(entry_ind)));
+                entry_ind = prev(entry_ind);
+            }
+            else
+            {
+                extend(right, w_ind, outer_edge(tri_ind, prev(entry_ind)));
+                entry_ind = next(entry_ind);
+            }
+        }
 
-                if (e_new == e_inserted)
+        //! each polygon is split by the vertex c whose circumcircle with the base edge is empty into two smaller
+        //! polygons, they are processed from a stack holding the base edge and the triangle lying across it
+        auto &tasks = m_scratch.cavity_tasks;
+        std::size_t n_used_tris = 0;
+        std::pair<TriInd, int> constraint_side = {-1, 0}; //! edge of the first triangle lying on e
+        for (int side = 0; side < 2; ++side)
+        {
+            const auto &polygon = polygons[side];
+            tasks.push_back({0, polygon.vert_inds.size() - 1, constraint_side.first, constraint_side.second});
+            while (!tasks.empty())
+            {
+                const auto task = tasks.back();
+                tasks.pop_back();
+                if (task.j == task.i + 1)
                 {
-                    tri_a.is_constrained[next(opposite_ind_in_tri_a)] = true;
-                    tri_b.is_constrained[next(opposite_ind_in_tri_b)] = true;
+                    const auto &outer = polygon.outer_edges[task.i];
+                    linkNeighbours(task.tri_ind, task.ind_in_tri, outer.tri_ind, outer.ind_in_tri);
+                    m_triangles[task.tri_ind].setConstrained(task.ind_in_tri, outer.is_constrained);
                     continue;
                 }
 
-                const auto v1 = m_vertices.at(vi_ind_next);
-                const auto v2 = m_vertices.at(vi_ind_prev);
+                //! all polygon vertices lie on one side of the base edge, so a vertex lies inside of the circle through
+                //! vi, vj and vc exactly when it sees the base edge under a larger angle than vc. Angles are compared by
+                //! their cotangents dot / |cross|, cross multiplied so that the comparison stays exact in integers
+                const auto &vi = m_vertices[polygon.vert_inds[task.i]];
+                const auto &vj = m_vertices[polygon.vert_inds[task.j]];
+                auto cotangent_of = [&](std::size_t k)
+                {
+                    const auto &vk = m_vertices[polygon.vert_inds[k]];
+                    const long long ix = static_cast<long long>(vi.x) - vk.x, iy = static_cast<long long>(vi.y) - vk.y;
+                    const long long jx = static_cast<long long>(vj.x) - vk.x, jy = static_cast<long long>(vj.y) - vk.y;
+                    return std::pair<long long, long long>{ix * jx + iy * jy, std::abs(ix * jy - iy * jx)};
+                };
+                auto c = task.i + 1;
+                auto [c_dot, c_cross] = cotangent_of(c);
+                for (auto k = task.i + 2; k < task.j; ++k)
+                {
+                    const auto [k_dot, k_cross] = cotangent_of(k);
+                    if (detail::Int128::product(k_dot, c_cross) < detail::Int128::product(c_dot, k_cross))
+                    {
+                        c = k;
+                        c_dot = k_dot;
+                        c_cross = k_cross;
+                    }
+                }
 
-                bool edge_needs_swap = needSwap(vi, v1, v2, vj);
-                bool is_convex = true; //! Convexity check should be automatically taken care of by needSwap but it doesn't
-                                       //! and I don't know why yet :(
-                if (!isConvex(m_vertices[vi_ind], v1, v2, m_vertices[vj_ind]))
+                //! both orderings are clockwise, the left polygon lies counterclockwise of its base edges
+                const auto new_tri_ind = cavity[n_used_tris++];
+                Triangle tri;
+                int ind_ij, ind_ic, ind_cj;
+                if (side == 0)
+                {
+                    tri.vert_inds = {polygon.vert_inds[task.i], polygon.vert_inds[c], polygon.vert_inds[task.j]};
+                    ind_ij = 2, ind_ic = 0, ind_cj = 1;
+                }
+                else
                 {
-                    is_convex = false;
+                    tri.vert_inds = {polygon.vert_inds[task.i], polygon.vert_inds[task.j], polygon.vert_inds[c]};
+                    ind_ij = 0, ind_ic = 2, ind_cj = 1;
                 }
-                if (edge_needs_swap && is_convex)
+                m_triangles[new_tri_ind] = tri;
+                linkNeighbours(new_tri_ind, ind_ij, task.tri_ind, task.ind_in_tri);
+                if (task.tri_ind == -1)
                 {
+                    constraint_side = {new_tri_ind, ind_ij};
+                }
+                updateCellOf(new_tri_ind);
+                updateVertex2Tri(new_tri_ind);
+                tasks.push_back({c, task.j, new_tri_ind, ind_cj});
+                tasks.push_back({task.i, c, new_tri_ind, ind_ic});
+            }
+        }
+        assert(n_used_tris + 2 * m_scratch.detached.size() == cavity.size());
 
-                    swapConnectingEdgeClockwise(tri_ind_a, tri_ind_b);
-                    assert(allTrianglesValid());
+        auto &tri_a = m_triangles[constraint_side.first];
+        tri_a.setConstrained(constraint_side.second, true);
+        m_triangles[tri_a.neighbours[constraint_side.second]].setConstrained(tri_a.backIndex(constraint_side.second),
+                                                                             true);
+        m_cursor.hint = constraint_side.first;
 
-                    some_swap_happened = true;
-                    newly_created_edges[i] = {vi, vj};
+        if (!m_scratch.detached.empty())
+        {
+            removeTriangles({cavity.begin() + n_used_tris, cavity.end()});
+            for (const auto tip_ind : m_scratch.detached)
+            {
+                const auto &tip = m_vertices[tip_ind];
+                const auto tri_ind = findTriangle(tip, true);
+                const auto overlapping_edge = findOverlappingEdge(tip, tri_ind);
+                if (overlapping_edge.from != -1)
+                {
+                    insertVertexOnEdge(tip_ind, tri_ind, indexOf(overlapping_edge.from, m_triangles[tri_ind]));
+                }
+                else
+                {
+                    insertVertexIntoSpace(tri_ind, tip_ind);
                 }
             }
         }
+        assert(triangulationIsConsistent());
+        assert(allTrianglesValid());
     }
 
-    //! \brief forces triangulation to have a constrained edge connecting \p e.from and \p e.to
-    //! \param e edge representing the constraint
+    //! \param e edge created by a swap during constraint insertion
+    //! \param tri_inds triangles which contained \p e when it was created
+    //! \returns index of the triangle from \p tri_inds containing \p e and index of the vertex opposite of \p e in it
+    //! \returns {-1, -1} if \p e got swapped away by insertion of a later constraint
     template <class Vertex>
-    void Triangulation<Vertex>::insertConstraint(const EdgeVInd e, sf::RenderWindow &window)
+    std::pair<TriInd, int> Triangulation<Vertex>::findNewlyCreatedEdge(const EdgeVInd &e,
+                                                                       std::pair<TriInd, TriInd> tri_inds) const
     {
-
-        auto vi_ind = e.from;
-        auto vj_ind = e.to;
-        auto vi = m_vertices[vi_ind];
-        auto vj = m_vertices[vj_ind];
-        if (m_fixed_edges.count({vi, vj}) > 0 || e.from == e.to) //! constrained edge alread exists
+        for (const auto tri_ind : {tri_inds.first, tri_inds.second})
         {
-            return;
+            const auto opposite_ind_in_tri = oppositeOfEdge(m_triangles[tri_ind], e);
+            if (opposite_ind_in_tri != -1)
+            {
+                return {tri_ind, opposite_ind_in_tri};
+            }
         }
-        m_fixed_edges.insert({vi, vj});
+        return {-1, -1};
+    }
 
-        auto overlapsx = findOverlappingConstraints(vi, vj);
-        auto overlaps = findOverlappingConstraints2(vi, vj);
-        if (!overlaps.empty())
+    //! \brief restores Delaunay property of edges created during constraint insertion (Steps 4.2 - 4.3)
+    //! \brief swaps propagate to the outer edges of the swapped quadrilaterals, as the triangles around
+    //! \brief the constraint changed and their old edges need not be Delaunay anymore either
+    //! \brief the edges and the pairs of triangles containing them when created are in m_scratch
+    template <class Vertex>
+    void Triangulation<Vertex>::fixNewlyCreatedEdges()
+    {
+        const auto &newly_created_edges = m_scratch.newly_created_edges;
+        const auto &newly_created_edge_tris = m_scratch.newly_created_edge_tris;
+        auto &edges_to_fix = m_scratch.edges_to_fix;
+        edges_to_fix.clear();
+        for (std::size_t i = 0; i < newly_created_edges.size(); ++i)
+        {
+            const auto [tri_ind, opposite_ind_in_tri] = findNewlyCreatedEdge(newly_created_edges[i],
+                                                                             newly_created_edge_tris[i]);
+            if (tri_ind != -1)
+            {
+                edges_to_fix.emplace_back(tri_ind, next(opposite_ind_in_tri));
+            }
+        }
+        legalizeEdges(edges_to_fix);
+    }
+
+    //! \param v_ind index of a vertex
+    //! \returns triangles around \p v_ind paired with index of \p v_ind in them, each one shares its edge prev(index)
+    //! \returns with the next one. For vertices on the boundary the first triangle is the one touching the boundary
+    //! \returns with its edge going out of \p v_ind
+    template <class Vertex>
+    std::vector<std::pair<TriInd, int>> Triangulation<Vertex>::trianglesAround(VertInd v_ind) const
+    {
+        auto tri_ind = m_vertex2tri[v_ind];
+        auto ind_in_tri = indexOf(v_ind, m_triangles[tri_ind]);
+        assert(ind_in_tri != -1);
+
+        //! rotate backwards until we hit the boundary or get back to where we started
+        const auto start_tri_ind = tri_ind;
+        while (true)
         {
-            for (auto overlap : overlaps)
+            const auto &tri = m_triangles[tri_ind];
+            const auto prev_tri_ind = tri.neighbours[ind_in_tri];
+            if (prev_tri_ind == -1)
             {
-                if (overlap != e)
-                {
-                    insertConstraint(overlap);
-                }
+                break;
             }
-            //! inserts constraints between overlapping edges to fill the empty space
-            insertConstraint({e.from, overlaps[0].from});
-            for (int i = 1; i < overlaps.size(); ++i)
+            ind_in_tri = next(tri.backIndex(ind_in_tri));
+            tri_ind = prev_tri_ind;
+            if (tri_ind == start_tri_ind)
             {
-                insertConstraint({overlaps.at(i - 1).to, overlaps.at(i).from});
+                break;
             }
-            insertConstraint({e.to, overlaps.back().to});
-            return;
         }
 
-        std::deque<EdgeI<Vertex>> intersected_edges;
-        std::deque<TriInd> intersected_tri_inds;
-        findIntersectingEdges(e, intersected_edges, intersected_tri_inds);
-
-        std::vector<EdgeI<Vertex>> newly_created_edges;
-        std::vector<std::pair<TriInd, TriInd>> newly_created_edge_tris;
-
-        EdgeI e_inserted = {vi, vj};
-
-        m_font.loadFromFile("../Resources/arial.ttf");
-
-        //! remove intersecting edges (steps 3.1 3.2)
-        while (!intersected_edges.empty())
+        std::vector<std::pair<TriInd, int>> star;
+        const auto first_tri_ind = tri_ind;
+        do
         {
-
-            auto tri_ind = intersected_tri_inds.front();
-            auto &tri = m_triangles[tri_ind];
-            intersected_tri_inds.pop_front();
-            auto e_next = intersected_edges.front();
-            intersected_edges.pop_front();
-
-            auto next_tri_ind = triangleOppositeOfEdge(tri, e_next);
-            auto &next_tri = m_triangles[next_tri_ind];
-
-            assert(next_tri_ind != -1); //! triangle must contain e_next;
-
-            // auto v_current_ind = m_tri_ind2vert_inds[tri_ind][oppositeOfEdge(tri, e_next)];
-            auto v_current = tri.verts[oppositeOfEdge(tri, e_next)];
-            auto v_opposite_ind_in_tri = oppositeIndex(tri_ind, next_tri);
-            auto v_opposite_current = next_tri.verts[v_opposite_ind_in_tri];
-
-            //! we can swap edges only in convex quadrilaterals otherwise bad shapes get created
-            if (isConvex(v_current, e_next.from, v_opposite_current, e_next.to()))
+            star.emplace_back(tri_ind, ind_in_tri);
+            const auto &tri = m_triangles[tri_ind];
+            const auto next_tri_ind = tri.neighbours[prev(ind_in_tri)];
+            if (next_tri_ind == -1)
             {
-                if (isCounterClockwise(v_opposite_current, vi, vj))
-                {
-                    swapConnectingEdgeCounterClockwise(next_tri_ind, tri_ind);
-                }
-                else
-                {
-                    swapConnectingEdgeClockwise(next_tri_ind, tri_ind);
-                }
-                drawTriangulation(*this, window);
-                drawTriInds(*this, window);
-                window.display();
-
-                assert(allTrianglesValid());
-                assert(triangulationIsConsistent());
+                break;
+            }
+            ind_in_tri = tri.backIndex(prev(ind_in_tri));
+            tri_ind = next_tri_ind;
+        } while (tri_ind != first_tri_ind);
+        return star;
+    }
 
-                e_next = {v_current, v_opposite_current};
+    //! \returns triangle of the star of \p v_ind from which rotating through neighbours[indexOf(v_ind, tri)]
+    //! \returns visits the whole star. Any of them for an inner vertex, the one lying at the boundary for
+    //! \returns a vertex on the boundary, whose star is open
+    template <class Vertex>
+    TriInd Triangulation<Vertex>::firstTriangleAround(VertInd v_ind) const
+    {
+        const auto start_tri_ind = m_vertex2tri[v_ind];
+        auto tri_ind = start_tri_ind;
+        while (true)
+        {
+            const auto &tri = m_triangles[tri_ind];
+            const auto next_tri_ind = tri.neighbours[prev(indexOf(v_ind, tri))];
+            if (next_tri_ind == -1)
+            {
+                return tri_ind;
+            }
+            tri_ind = next_tri_ind;
+            if (tri_ind == start_tri_ind)
+            {
+                return tri_ind;
+            }
+        }
+    }
 
-                if (edgesIntersect(e_next, e_inserted))
-                {
-                    intersected_edges.push_back(e_next);
-                    intersected_tri_inds.push_back(tri_ind);
-                    auto ind_in_tri = oppositeOfEdge(m_triangles.at(tri_ind), e_next);
-                }
-                else
+    //! \brief removes triangles which are not referenced by any other triangle anymore
+    //! \brief the last triangles are moved into the freed slots so indices of some other triangles change
+    //! \param tri_inds indices of the removed triangles
+    template <class Vertex>
+    void Triangulation<Vertex>::removeTriangles(std::vector<TriInd> tri_inds)
+    {
+        std::sort(tri_inds.begin(), tri_inds.end(), std::greater<TriInd>());
+        for (const auto tri_ind : tri_inds)
+        {
+            const TriInd last_tri_ind = m_triangles.size() - 1;
+            if (tri_ind != last_tri_ind)
+            {
+                m_triangles[tri_ind] = m_triangles[last_tri_ind];
+                const auto &moved_tri = m_triangles[tri_ind];
+                for (int k = 0; k < 3; ++k)
                 {
-                    newly_created_edges.push_back(e_next);
-                    newly_created_edge_tris.push_back({tri_ind, next_tri_ind});
+                    if (moved_tri.neighbours[k] != -1)
+                    {
+                        m_triangles[moved_tri.neighbours[k]].neighbours[moved_tri.backIndex(k)] = tri_ind;
+                    }
                 }
+                updateCellOf(tri_ind);
+                updateVertex2Tri(tri_ind);
             }
-            else
-            {
-                intersected_edges.push_back(e_next);
-                intersected_tri_inds.push_back(tri_ind);
-            }
+            m_triangles.pop_back();
         }
 
-        m_fixed_edges.insert(e_inserted);
+        //! cells and hints still pointing to removed triangles are ignored by findTriangle
+    }
+
+    template <class Vertex>
+    bool Triangulation<Vertex>::isBoundaryCorner(const Vertex &v) const
+    {
+        return (v.x == 0 || v.x == m_boundary.x) && (v.y == 0 || v.y == m_boundary.y);
+    }
 
-        //! Fix Delaunay triangulation (Steps 4.1 - 4.3)
-        bool some_swap_happened = true;
-        while (some_swap_happened)
+    //! \brief removes vertex \p v_ind and retriangulates the polygon formed by its neighbours
+    //! \brief constraints ending in the vertex are removed as well, unless the vertex just splits a straight
+    //! \brief constraint in two, in that case the two parts get merged. The last vertex takes index \p v_ind
+    //! \param v_ind index of the removed vertex
+    //! \returns false if \p v_ind does not exist or it is a corner of the boundary (those cannot be removed)
+    template <class Vertex>
+    bool Triangulation<Vertex>::removeVertex(VertInd v_ind)
+    {
+        if (v_ind >= m_vertices.size() || isBoundaryCorner(m_vertices[v_ind]))
         {
-            some_swap_happened = false;
+            return false;
+        }
+        const auto v = m_vertices[v_ind];
+        const auto star = trianglesAround(v_ind);
+        const bool on_boundary = m_triangles[star.front().first].neighbours[star.front().second] == -1;
 
-            for (int i = 0; i < newly_created_edges.size(); ++i)
+        //! polygon around the star, its edge j goes from polygon[j] to polygon[j+1]
+        std::vector<VertInd> polygon;
+        std::vector<OuterEdge> outer_edges; //! triangles lying outside of each polygon edge
+        std::vector<VertInd> constrained_ends;
+        for (const auto &[tri_ind, ind_in_tri] : star)
+        {
+            const auto &tri = m_triangles[tri_ind];
+            polygon.push_back(tri.vert_inds[next(ind_in_tri)]);
+            outer_edges.push_back({tri.neighbours[next(ind_in_tri)], tri.backIndex(next(ind_in_tri)),
+                                   tri.isConstrained(next(ind_in_tri))});
+            if (tri.isConstrained(ind_in_tri) && tri.neighbours[ind_in_tri] != -1)
             {
-                const auto &e_new = newly_created_edges[i];
-                const auto tri_ind_a = newly_created_edge_tris[i].first;
-                auto &tri_a = m_triangles[tri_ind_a];
-                auto tri_ind_b = triangleOppositeOfEdge(tri_a, e_new);
-                if (tri_ind_b == -1)
-                {
-                    tri_ind_b = newly_created_edge_tris[i].second;
-                }
-                auto &tri_b = m_triangles[tri_ind_b];
-
-                const auto opposite_ind_in_tri_a = oppositeOfEdge(tri_a, e_new);
-                const auto opposite_ind_in_tri_b = oppositeOfEdge(tri_b, e_new);
+                constrained_ends.push_back(tri.vert_inds[next(ind_in_tri)]);
+            }
+        }
+        if (on_boundary)
+        { //! the hole gets closed by a new boundary edge
+            const auto &[tri_ind, ind_in_tri] = star.back();
+            polygon.push_back(m_triangles[tri_ind].vert_inds[prev(ind_in_tri)]);
+            outer_edges.push_back({-1u, 0, true});
 
-                vi = tri_a.verts[opposite_ind_in_tri_a];
-                vj = tri_b.verts[opposite_ind_in_tri_b];
-                vi_ind = m_tri_ind2vert_inds[tri_ind_a][opposite_ind_in_tri_a];
-                auto vi_ind_next = m_tri_ind2vert_inds[tri_ind_a][next(opposite_ind_in_tri_a)];
-                auto vi_ind_prev = m_tri_ind2vert_inds[tri_ind_a][prev(opposite_ind_in_tri_a)];
+            m_fixed_edges.erase({polygon.front(), v_ind});
+            m_fixed_edges.erase({v_ind, polygon.back()});
+            m_fixed_edges.insert({polygon.front(), polygon.back()});
+        }
+        for (const auto end_ind : constrained_ends)
+        {
+            m_fixed_edges.erase({v_ind, end_ind});
+        }
 
-                if (e_new == e_inserted)
+        //! ear clipping, Delaunay property is restored by swapping the diagonals afterwards
+        std::vector<TriInd> free_tri_inds;
+        for (const auto &[tri_ind, ind_in_tri] : star)
+        {
+            free_tri_inds.push_back(tri_ind);
+        }
+        std::vector<std::pair<TriInd, int>> diagonals;
+        while (polygon.size() >= 3)
+        {
+            const auto n_corners = polygon.size();
+            std::size_t ear = 0;
+            for (; ear < n_corners; ++ear)
+            {
+                const auto &v_prev = m_vertices[polygon[(ear + n_corners - 1) % n_corners]];
+                const auto &v_ear = m_vertices[polygon[ear]];
+                const auto &v_next = m_vertices[polygon[(ear + 1) % n_corners]];
+                if (orient(v_prev, v_ear, v_next) >= 0)
                 {
-                    tri_a.is_constrained[next(opposite_ind_in_tri_a)] = true;
-                    tri_b.is_constrained[next(opposite_ind_in_tri_b)] = true;
-                    continue;
+                    continue; //! triangles turn clockwise so this corner is not convex
                 }
-
-                const auto v1 = m_vertices.at(vi_ind_next);
-                const auto v2 = m_vertices.at(vi_ind_prev);
-
-                bool edge_needs_swap = needSwap(vi, v1, v2, vj);
-                bool is_convex = true; //! Convexity check should be automatically taken care of by needSwap but it doesn't
-                                       //! and I don't know why yet :(
-                if (!isConvex(m_vertices[vi_ind], v1, v2, m_vertices[vj_ind]))
+                bool is_empty = true;
+                for (std::size_t j = 0; j + 3 < n_corners && is_empty; ++j)
                 {
-                    is_convex = false;
+                    const auto &v_other = m_vertices[polygon[(ear + 2 + j) % n_corners]];
+                    is_empty = !isInTriangle(v_other, v_prev, v_ear, v_next);
                 }
-                if (edge_needs_swap && is_convex)
+                if (is_empty)
                 {
+                    break;
+                }
+            }
+            assert(ear < n_corners);
+
+            const auto prev_corner = (ear + n_corners - 1) % n_corners;
+            const auto next_corner = (ear + 1) % n_corners;
+            const auto tri_ind = free_tri_inds.back();
+            free_tri_inds.pop_back();
+
+            Triangle tri;
+            tri.vert_inds = {polygon[prev_corner], polygon[ear], polygon[next_corner]};
+            m_triangles[tri_ind] = tri;
+            const auto &in_edge = outer_edges[prev_corner];
+            const auto &out_edge = outer_edges[ear];
+            linkNeighbours(tri_ind, 0, in_edge.tri_ind, in_edge.ind_in_tri);
+            linkNeighbours(tri_ind, 1, out_edge.tri_ind, out_edge.ind_in_tri);
+            m_triangles[tri_ind].setConstrained(0, in_edge.is_constrained);
+            m_triangles[tri_ind].setConstrained(1, out_edge.is_constrained);
+            updateCellOf(tri_ind);
+            updateVertex2Tri(tri_ind);
+
+            if (n_corners == 3)
+            {
+                const auto &closing_edge = outer_edges[next_corner];
+                linkNeighbours(tri_ind, 2, closing_edge.tri_ind, closing_edge.ind_in_tri);
+                m_triangles[tri_ind].setConstrained(2, closing_edge.is_constrained);
+                break;
+            }
+            m_triangles[tri_ind].neighbours[2] = -1; //! gets linked when the other side of the diagonal is clipped
+            diagonals.emplace_back(tri_ind, 2);
+            outer_edges[prev_corner] = {tri_ind, 2, false};
+            polygon.erase(polygon.begin() + ear);
+            outer_edges.erase(outer_edges.begin() + ear);
+        }
+        legalizeEdges(diagonals);
+        removeTriangles(free_tri_inds);
 
-                    swapConnectingEdgeClockwise(tri_ind_a, tri_ind_b);
-                    assert(allTrianglesValid());
-
-                    some_swap_happened = true;
-                    newly_created_edges[i] = {vi, vj};
+        //! the last vertex takes place of the removed one
+        const VertInd last_v_ind = m_vertices.size() - 1;
+        if (v_ind != last_v_ind)
+        {
+            for (const auto &[tri_ind, ind_in_tri] : trianglesAround(last_v_ind))
+            {
+                auto &tri = m_triangles[tri_ind];
+                for (const auto k : {ind_in_tri, prev(ind_in_tri)})
+                { //! constrained edges are keyed by vertex indices, each one is seen from both of its triangles
+                    const auto v_other = tri.vert_inds[k == ind_in_tri ? next(k) : k];
+                    if (tri.isConstrained(k) && m_fixed_edges.erase({last_v_ind, v_other}))
+                    {
+                        m_fixed_edges.insert({v_ind, v_other});
+                    }
                 }
+                tri.vert_inds[ind_in_tri] = v_ind;
             }
+            m_vertices[v_ind] = m_vertices.back();
+            m_vertex2tri[v_ind] = m_vertex2tri.back();
+            std::replace(constrained_ends.begin(), constrained_ends.end(), last_v_ind, v_ind);
+        }
+        m_vertices.pop_back();
+        m_vertex2tri.pop_back();
+
+        if (constrained_ends.size() == 2 &&
+            liesBetween(v, m_vertices[constrained_ends[0]], m_vertices[constrained_ends[1]]))
+        {
+            insertConstraint({constrained_ends[0], constrained_ends[1]});
         }
+        assert(triangulationIsConsistent());
+        return true;
     }
 
-    //! \brief swaps edge connecting \p tri_ind_a with tri_ind_b such that they move in a clockwise manner
-    //! \param tri_ind_a index of a triangle
-    //! \param tri_ind_a index of another triangle
+    //! \brief makes the constraint between \p e.from and \p e.to an ordinary edge and restores Delaunay property
+    //! \brief around it, the constraint may consist of several collinear parts split by vertices lying on it
+    //! \param e edge representing the constraint
+    //! \returns false if there is no such constraint or it lies on the boundary
     template <class Vertex>
-    void Triangulation<Vertex>::swapConnectingEdgeClockwise(const TriInd &tri_ind_a, const TriInd &tri_ind_b)
+    bool Triangulation<Vertex>::removeConstraint(const EdgeVInd e)
     {
-        auto &tri_a = m_triangles[tri_ind_a];
-        auto &tri_b = m_triangles[tri_ind_b];
-
-        auto v_a_ind_in_tri = oppositeIndex(tri_ind_b, tri_a);
-        auto v_b_ind_in_tri = oppositeIndex(tri_ind_a, tri_b);
-
-        //! change vertices -> prev(a) becomes b and prev(b) becomes a;
-        const auto &v_b = tri_b.verts[v_b_ind_in_tri];
-        const auto &v_a = tri_a.verts[v_a_ind_in_tri];
-        const auto &v_left = tri_a.verts[prev(v_a_ind_in_tri)];
-        const auto &v_right = tri_a.verts[next(v_a_ind_in_tri)];
-        tri_a.verts[next(v_a_ind_in_tri)] = v_b;
-        tri_b.verts[next(v_b_ind_in_tri)] = v_a;
-
-        //! change neighbours
-        const auto na = tri_a.neighbours[(v_a_ind_in_tri)];
-        const auto nb = tri_b.neighbours[(v_b_ind_in_tri)];
-        const auto na_prev = tri_a.neighbours[prev(v_a_ind_in_tri)];
-        const auto nb_prev = tri_b.neighbours[prev(v_b_ind_in_tri)];
-        tri_a.neighbours[next(v_a_ind_in_tri)] = nb;
-        tri_a.neighbours[(v_a_ind_in_tri)] = tri_ind_b;
-        tri_b.neighbours[next(v_b_ind_in_tri)] = na;
-        tri_b.neighbours[(v_b_ind_in_tri)] = tri_ind_a;
-        //! change constraints
-        tri_a.is_constrained[next(v_a_ind_in_tri)] = tri_b.is_constrained[(v_b_ind_in_tri)];
-        tri_b.is_constrained[next(v_b_ind_in_tri)] = tri_a.is_constrained[(v_a_ind_in_tri)];
-        tri_a.is_constrained[(v_a_ind_in_tri)] = false;
-        tri_b.is_constrained[(v_b_ind_in_tri)] = false;
-
-        m_tri_ind2vert_inds.at(tri_ind_a)[next(v_a_ind_in_tri)] = m_tri_ind2vert_inds.at(tri_ind_b)[v_b_ind_in_tri];
-        m_tri_ind2vert_inds.at(tri_ind_b)[next(v_b_ind_in_tri)] = m_tri_ind2vert_inds.at(tri_ind_a)[v_a_ind_in_tri];
-
-        //! tell neighbours that there was a swap changed
-        if (nb != -1)
+        if (e.from == e.to || e.from >= m_vertices.size() || e.to >= m_vertices.size())
         {
-            auto &changed_neighbour_tri = m_triangles[nb];
-            auto ind_in_neighbour = oppositeIndex(tri_ind_b, changed_neighbour_tri);
-            changed_neighbour_tri.neighbours[next(ind_in_neighbour)] = tri_ind_a;
+            return false;
+        }
+        const auto &vj = m_vertices[e.to];
+
+        //! walk from e.from to e.to over constrained parts
+        std::vector<std::pair<TriInd, int>> parts;
+        auto v_current_ind = e.from;
+        while (v_current_ind != e.to)
+        {
+            const auto &v_current = m_vertices[v_current_ind];
+            const auto star = trianglesAround(v_current_ind);
+            const auto part_it = std::find_if(star.begin(), star.end(), [&](const auto &tri_and_ind)
+                                              {
+                const auto &tri = m_triangles[tri_and_ind.first];
+                const auto ind_in_tri = tri_and_ind.second;
+                const auto v_next_ind = tri.vert_inds[next(ind_in_tri)];
+                return tri.isConstrained(ind_in_tri) && tri.neighbours[ind_in_tri] != -1 &&
+                       (v_next_ind == e.to || liesBetween(m_vertices[v_next_ind], v_current, vj)); });
+            if (part_it == star.end())
+            {
+                return false;
+            }
+            parts.push_back(*part_it);
+            v_current_ind = m_triangles[part_it->first].vert_inds[next(part_it->second)];
         }
-        if (na != -1)
+
+        m_fixed_edges.erase(e);
+        for (const auto &[tri_ind, ind_in_tri] : parts)
         {
-            auto &changed_neighbour_tri = m_triangles[na];
-            auto ind_in_neighbour = oppositeIndex(tri_ind_a, changed_neighbour_tri);
-            changed_neighbour_tri.neighbours[next(ind_in_neighbour)] = tri_ind_b;
+            auto &tri = m_triangles[tri_ind];
+            m_fixed_edges.erase({tri.vert_inds[ind_in_tri], tri.vert_inds[next(ind_in_tri)]});
+            m_triangles[tri.neighbours[ind_in_tri]].setConstrained(tri.backIndex(ind_in_tri), false);
+            tri.setConstrained(ind_in_tri, false);
         }
+        legalizeEdges(parts);
+        return true;
     }
 
-    //! \brief swaps edge connecting \p tri_ind_a with tri_ind_b such that they move in a counter-clockwise manner
-    //! \param tri_ind_a index of a triangle
-    //! \param tri_ind_a index of another triangle
+    //! \returns index of the vertex with coordinates \p v or -1 if there is no such vertex
     template <class Vertex>
-    void Triangulation<Vertex>::swapConnectingEdgeCounterClockwise(const TriInd &tri_ind_a, const TriInd &tri_ind_b)
+    VertInd Triangulation<Vertex>::findVertex(const Vertex &v)
     {
-        auto &tri_a = m_triangles[tri_ind_a];
-        auto &tri_b = m_triangles[tri_ind_b];
-
-        auto v_a_ind_in_tri = oppositeIndex(tri_ind_b, tri_a);
-        auto v_b_ind_in_tri = oppositeIndex(tri_ind_a, tri_b);
-
-        //! change vertices -> prev(a) becomes b and prev(b) becomes a;
-        const auto &v_b = tri_b.verts[v_b_ind_in_tri];
-        const auto &v_a = tri_a.verts[v_a_ind_in_tri];
-        const auto &v_left = tri_a.verts[prev(v_a_ind_in_tri)];
-        const auto &v_right = tri_a.verts[next(v_a_ind_in_tri)];
-
-        tri_a.verts[prev(v_a_ind_in_tri)] = v_b;
-        tri_b.verts[prev(v_b_ind_in_tri)] = v_a;
-
-        //! change neighbours
-        const auto na_prev = tri_a.neighbours[prev(v_a_ind_in_tri)];
-        const auto nb_prev = tri_b.neighbours[prev(v_b_ind_in_tri)];
-        tri_a.neighbours[next(v_a_ind_in_tri)] = nb_prev;
-        tri_a.neighbours[prev(v_a_ind_in_tri)] = tri_ind_b;
-        tri_b.neighbours[next(v_b_ind_in_tri)] = na_prev;
-        tri_b.neighbours[prev(v_b_ind_in_tri)] = tri_ind_a;
-        //! change constraints
-        tri_a.is_constrained[next(v_a_ind_in_tri)] = tri_b.is_constrained[prev(v_b_ind_in_tri)];
-        tri_b.is_constrained[next(v_b_ind_in_tri)] = tri_a.is_constrained[prev(v_a_ind_in_tri)];
-        tri_a.is_constrained[prev(v_a_ind_in_tri)] = false;
-        tri_b.is_constrained[prev(v_b_ind_in_tri)] = false;
-
-        m_tri_ind2vert_inds.at(tri_ind_a)[prev(v_a_ind_in_tri)] = m_tri_ind2vert_inds.at(tri_ind_b)[v_b_ind_in_tri];
-        m_tri_ind2vert_inds.at(tri_ind_b)[prev(v_b_ind_in_tri)] = m_tri_ind2vert_inds.at(tri_ind_a)[v_a_ind_in_tri];
-
-        //! tell neighbours that there was a swap changed
-        if (nb_prev != -1)
-        {
-            auto &changed_neighbour_tri = m_triangles[nb_prev];
-            auto ind_in_neighbour = oppositeIndex(tri_ind_b, changed_neighbour_tri);
-            changed_neighbour_tri.neighbours[next(ind_in_neighbour)] = tri_ind_a;
-        }
-        if (na_prev != -1)
+        if (!withinBoundary(v))
         {
-            auto &changed_neighbour_tri = m_triangles[na_prev];
-            auto ind_in_neighbour = oppositeIndex(tri_ind_a, changed_neighbour_tri);
-            changed_neighbour_tri.neighbours[next(ind_in_neighbour)] = tri_ind_b;
+            return -1;
         }
+        return findOverlappingVertex(v, findTriangle(v, true));
     }
 
+    //! \brief replaces constraints lying in the rectangle [\p lower_left, \p upper_right] by \p edges
+    //! \brief constraints crossing border of the rectangle keep their outer parts unchanged. They are cut at their
+    //! \brief nearest grid points on or beyond the border, as a cut between grid points would bend them. Vertices which
+    //! \brief end up without constraints or just splitting a straight constraint are removed afterwards
+    //! \brief so repeated edits of the same region do not pile up vertices
+    //! \brief new edges reach their grid points the same way, so an edge on a cut constraint joins its outer parts
+    //! \param edges new constraints, their parts lying outside of the rectangle are ignored
     template <class Vertex>
-    std::vector<EdgeI<Vertex>> Triangulation<Vertex>::findOverlappingConstraints(const Vertex &vi, const Vertex &vj)
+    void Triangulation<Vertex>::replaceConstraintsInRect(const Vertex &lower_left, const Vertex &upper_right,
+                                                         std::span<const EdgeI<Vertex>> edges)
     {
+        //! walk over triangles whose bounding box touches the rectangle, this covers all the constraints within
+        std::vector<EdgeVInd> crossing_constraints;
+        auto &to_visit = m_edit_scratch.to_visit;
+        auto &visit_stamps = m_edit_scratch.visit_stamps;
+        auto &visit_stamp = m_edit_scratch.visit_stamp;
+        visit_stamps.resize(m_triangles.size(), 0);
+        if (++visit_stamp == 0)
+        { //! after the stamp wrapped around, triangles visited long ago could look visited by this edit
+            std::fill(visit_stamps.begin(), visit_stamps.end(), 0);
+            visit_stamp = 1;
+        }
+        to_visit.assign(1, findTriangle((lower_left + upper_right) / 2, false));
+        visit_stamps[to_visit.front()] = visit_stamp;
+        while (!to_visit.empty())
+        {
+            const auto &tri = m_triangles[to_visit.back()];
+            to_visit.pop_back();
+            for (int k = 0; k < 3; ++k)
+            {
+                const auto neighbour_ind = tri.neighbours[k];
+                if (neighbour_ind == -1)
+                {
+                    continue;
+                }
+                auto v_from = vertexOf(tri, k);
+                auto v_to = vertexOf(tri, next(k));
+                if (tri.isConstrained(k) && tri.vert_inds[k] < tri.vert_inds[next(k)] &&
+                    clipToRect(v_from, v_to, lower_left, upper_right))
+                {
+                    crossing_constraints.push_back({tri.vert_inds[k], tri.vert_inds[next(k)]});
+                }
 
-        //! walk from tri_ind_start to  tri_ind_end while looking for collinear constrained edges
-        const auto start_tri_ind = findTriangle(vi, false);
-        const auto start_tri = m_triangles[start_tri_ind];
-        const auto end_tri_ind = findTriangle(vj, true);
-        const auto end_tri = m_triangles[end_tri_ind];
-
-        auto tri_ind = start_tri_ind;
-        auto tri = m_triangles[tri_ind];
-        auto index_in_tri = indexOf(vi, tri);
-
-        auto v_left = tri.verts[prev(index_in_tri)];
-        auto v_right = tri.verts[next(index_in_tri)];
-
-        std::vector<EdgeI<Vertex>> overlapps;
-
-        bool prev_touched = false;
+                const auto &neighbour = m_triangles[neighbour_ind];
+                const auto &v0 = vertexOf(neighbour, 0);
+                const auto &v1 = vertexOf(neighbour, 1);
+                const auto &v2 = vertexOf(neighbour, 2);
+                const bool touches_rect = std::max({v0.x, v1.x, v2.x}) >= lower_left.x &&
+                                          std::min({v0.x, v1.x, v2.x}) <= upper_right.x &&
+                                          std::max({v0.y, v1.y, v2.y}) >= lower_left.y &&
+                                          std::min({v0.y, v1.y, v2.y}) <= upper_right.y;
+                if (touches_rect && visit_stamps[neighbour_ind] != visit_stamp)
+                {
+                    visit_stamps[neighbour_ind] = visit_stamp;
+                    to_visit.push_back(neighbour_ind);
+                }
+            }
+        }
 
-        // check if the vj is already connected to vi
-        do
+        std::vector<EdgeI<Vertex>> new_constraints;
+        std::vector<Vertex> touched_vertices;
+        for (const auto &e : crossing_constraints)
         {
-            if (liesBetween(v_right, vi, vj))
+            const auto v_from = m_vertices[e.from];
+            const auto v_to = m_vertices[e.to];
+            auto v_cut_from = v_from;
+            auto v_cut_to = v_to;
+            clipToRect(v_cut_from, v_cut_to, lower_left, upper_right);
+            removeConstraint(e);
+            if (!(v_from == v_cut_from))
             {
-                if (tri.is_constrained[index_in_tri])
-                {
-                    overlapps.push_back({vi, v_right});
-                }
-                break;
+                new_constraints.push_back({v_from, v_cut_from});
             }
-            if (segmentsIntersect(v_left, v_right, vi, vj))
+            if (!(v_cut_to == v_to))
             {
-                tri_ind = triangleOppositeOfEdge(tri, {v_left, v_right});
-                break;
+                new_constraints.push_back({v_cut_to, v_to});
             }
-            tri_ind = tri.neighbours[index_in_tri];
-            tri = m_triangles[tri_ind];
-            index_in_tri = indexOf(vi, tri);
-            v_left = v_right;
-            v_right = tri.verts[next(index_in_tri)];
-        } while (tri_ind != start_tri_ind);
-
-        auto v_current = v_right;
-        auto prev_tri_ind = tri_ind;
-        tri_ind = tri.neighbours[next(index_in_tri)];
-
-        auto opp_vertex = v_right;
-        auto prev_opp_vertex = opp_vertex;
-
-        while (v_current != vj)
+            touched_vertices.insert(touched_vertices.end(), {v_from, v_to, v_cut_from, v_cut_to});
+        }
+        for (const auto &e : edges)
         {
-            auto &tri = m_triangles.at(tri_ind);
-            index_in_tri = indexOf(v_current, tri);
-            opp_vertex = tri.verts[next(index_in_tri)];
-
-            if (liesBetween(v_current, vi, vj) && liesBetween(opp_vertex, vi, vj) && tri.is_constrained[index_in_tri])
+            auto v_from = e.from;
+            auto v_to = e.to();
+            if (clipToRect(v_from, v_to, lower_left, upper_right))
             {
-                overlapps.push_back({v_current, opp_vertex});
+                new_constraints.push_back({v_from, v_to});
+                touched_vertices.insert(touched_vertices.end(), {v_from, v_to});
             }
+        }
+        insertConstraints(std::span<const EdgeI<Vertex>>(new_constraints));
 
-            //!
-            if (orient(vi, vj, opp_vertex) > 0)
+        std::sort(touched_vertices.begin(), touched_vertices.end(), [](const Vertex &a, const Vertex &b)
+                  { return a.x < b.x || (a.x == b.x && a.y < b.y); });
+        touched_vertices.erase(std::unique(touched_vertices.begin(), touched_vertices.end()), touched_vertices.end());
+        for (const auto &v : touched_vertices)
+        {
+            const auto v_ind = findOverlappingVertex(v, findTriangle(v, true));
+            if (v_ind == -1 || isBoundaryCorner(v))
             {
-                v_current = tri.verts[next(index_in_tri)];
-                tri_ind = tri.neighbours[next(index_in_tri)];
-                prev_touched = false;
+                continue;
             }
-            else if (strictly_less(orient(vi, vj, opp_vertex), 0))
+            std::vector<VertInd> constrained_ends;
+            for (const auto &[tri_ind, ind_in_tri] : trianglesAround(v_ind))
             {
-                tri_ind = tri.neighbours[index_in_tri];
+                const auto &tri = m_triangles[tri_ind];
+                if (tri.isConstrained(ind_in_tri) && tri.neighbours[ind_in_tri] != -1)
+                {
+                    constrained_ends.push_back(tri.vert_inds[next(ind_in_tri)]);
+                }
             }
-            else
+            if (constrained_ends.empty() ||
+                (constrained_ends.size() == 2 &&
+                 liesBetween(v, m_vertices[constrained_ends[0]], m_vertices[constrained_ends[1]])))
             {
-                tri_ind = tri.neighbours[next(index_in_tri)];
-                v_current = tri.verts[next(index_in_tri)];
+                removeVertex(v_ind);
             }
         }
-        return overlapps;
     }
 
+    //! \brief swaps edge shared by \p tri_ind_a and its neighbour such that they move in a clockwise manner
+    //! \brief a = (A, R, L), b = (B, L, R) become a = (A, B, L), b = (B, A, R)
+    //! \param tri_ind_a index of a triangle
+    //! \param v_a_ind_in_tri index of vertex in \p tri_ind_a lying opposite of the swapped edge
     template <class Vertex>
-    std::vector<EdgeVInd> Triangulation<Vertex>::findOverlappingConstraints2(const Vertex &vi, const Vertex &vj)
+    void Triangulation<Vertex>::swapConnectingEdgeClockwise(const TriInd tri_ind_a, const int v_a_ind_in_tri)
     {
+        const auto tri_ind_b = m_triangles[tri_ind_a].neighbours[next(v_a_ind_in_tri)];
+        const auto v_b_ind_in_tri = m_triangles[tri_ind_a].oppositeInNeighbour(next(v_a_ind_in_tri));
+        const auto tri_a = m_triangles[tri_ind_a];
+        const auto tri_b = m_triangles[tri_ind_b];
 
-        //! walk from tri_ind_start to  tri_ind_end while looking for collinear constrained edges
-        const auto start_tri_ind = findTriangle(vi, false);
-        const auto start_tri = m_triangles[start_tri_ind];
-        const auto end_tri_ind = findTriangle(vj, true);
-        const auto end_tri = m_triangles[end_tri_ind];
+        //! change vertices -> next(a) becomes b and next(b) becomes a;
+        m_triangles[tri_ind_a].vert_inds[next(v_a_ind_in_tri)] = tri_b.vert_inds[v_b_ind_in_tri];
+        m_triangles[tri_ind_b].vert_inds[next(v_b_ind_in_tri)] = tri_a.vert_inds[v_a_ind_in_tri];
 
-        auto tri_ind = start_tri_ind;
-        auto tri = m_triangles[tri_ind];
-        auto index_in_tri = indexOf(vi, tri);
+        //! change constraints
+        m_triangles[tri_ind_a].setConstrained(next(v_a_ind_in_tri), tri_b.isConstrained(v_b_ind_in_tri));
+        m_triangles[tri_ind_b].setConstrained(next(v_b_ind_in_tri), tri_a.isConstrained(v_a_ind_in_tri));
+        m_triangles[tri_ind_a].setConstrained(v_a_ind_in_tri, false);
+        m_triangles[tri_ind_b].setConstrained(v_b_ind_in_tri, false);
+
+        //! change neighbours and tell them that there was a swap
+        linkNeighbours(tri_ind_a, next(v_a_ind_in_tri), tri_b.neighbours[v_b_ind_in_tri], tri_b.backIndex(v_b_ind_in_tri));
+        linkNeighbours(tri_ind_b, next(v_b_ind_in_tri), tri_a.neighbours[v_a_ind_in_tri], tri_a.backIndex(v_a_ind_in_tri));
+        linkNeighbours(tri_ind_a, v_a_ind_in_tri, tri_ind_b, v_b_ind_in_tri);
+        updateCellOf(tri_ind_a);
+        updateVertex2Tri(tri_ind_a);
+        updateCellOf(tri_ind_b);
+        updateVertex2Tri(tri_ind_b);
+    }
 
-        auto v_left = tri.verts[prev(index_in_tri)];
-        auto v_right = tri.verts[next(index_in_tri)];
+    //! \brief swaps edge shared by \p tri_ind_a and its neighbour such that they move in a counter-clockwise manner
+    //! \brief a = (A, R, L), b = (B, L, R) become a = (A, R, B), b = (B, L, A)
+    //! \param tri_ind_a index of a triangle
+    //! \param v_a_ind_in_tri index of vertex in \p tri_ind_a lying opposite of the swapped edge
+    template <class Vertex>
+    void Triangulation<Vertex>::swapConnectingEdgeCounterClockwise(const TriInd tri_ind_a, const int v_a_ind_in_tri)
+    {
+        const auto tri_ind_b = m_triangles[tri_ind_a].neighbours[next(v_a_ind_in_tri)];
+        const auto v_b_ind_in_tri = m_triangles[tri_ind_a].oppositeInNeighbour(next(v_a_ind_in_tri));
+        const auto tri_a = m_triangles[tri_ind_a];
+        const auto tri_b = m_triangles[tri_ind_b];
 
-        std::vector<EdgeVInd> overlapps;
+        //! change vertices -> prev(a) becomes b and prev(b) becomes a;
+        m_triangles[tri_ind_a].vert_inds[prev(v_a_ind_in_tri)] = tri_b.vert_inds[v_b_ind_in_tri];
+        m_triangles[tri_ind_b].vert_inds[prev(v_b_ind_in_tri)] = tri_a.vert_inds[v_a_ind_in_tri];
 
-        bool prev_touched = false;
+        //! change constraints
+        m_triangles[tri_ind_a].setConstrained(next(v_a_ind_in_tri), tri_b.isConstrained(prev(v_b_ind_in_tri)));
+        m_triangles[tri_ind_b].setConstrained(next(v_b_ind_in_tri), tri_a.isConstrained(prev(v_a_ind_in_tri)));
+        m_triangles[tri_ind_a].setConstrained(prev(v_a_ind_in_tri), false);
+        m_triangles[tri_ind_b].setConstrained(prev(v_b_ind_in_tri), false);
+
+        //! change neighbours and tell them that there was a swap
+        linkNeighbours(tri_ind_a, next(v_a_ind_in_tri), tri_b.neighbours[prev(v_b_ind_in_tri)],
+                       tri_b.backIndex(prev(v_b_ind_in_tri)));
+        linkNeighbours(tri_ind_b, next(v_b_ind_in_tri), tri_a.neighbours[prev(v_a_ind_in_tri)],
+                       tri_a.backIndex(prev(v_a_ind_in_tri)));
+        linkNeighbours(tri_ind_a, prev(v_a_ind_in_tri), tri_ind_b, prev(v_b_ind_in_tri));
+        updateCellOf(tri_ind_a);
+        updateVertex2Tri(tri_ind_a);
+        updateCellOf(tri_ind_b);
+        updateVertex2Tri(tri_ind_b);
+    }
 
-        // check if the vj is already connected to vi
-        do
+    template <class Vertex>
+    std::vector<EdgeI<Vertex>> Triangulation<Vertex>::findOverlappingConstraints(const Vertex &vi, const Vertex &vj)
+    {
+        std::vector<EdgeI<Vertex>> overlapps;
+        for (const auto &overlap : findOverlappingConstraints2(vi, vj))
         {
-            if (liesBetween(v_right, vi, vj))
-            {
-                // if (tri.is_constrained[index_in_tri])
-                {
-                    // overlapps.push_back({vi, v_right});
-                    auto a = indexOf(vi, tri);
-                    auto b = indexOf(v_right, tri);
-                    auto a_ind = m_tri_ind2vert_inds.at(tri_ind)[a];
-                    auto b_ind = m_tri_ind2vert_inds.at(tri_ind)[b];
-
-                    overlapps.push_back({a_ind, b_ind});
-                }
-                break;
-            }
-            if (segmentsIntersect(v_left, v_right, vi, vj))
+            if (m_fixed_edges.contains(overlap))
             {
-                tri_ind = triangleOppositeOfEdge(tri, {v_left, v_right});
-                break;
+                overlapps.push_back({m_vertices[overlap.from], m_vertices[overlap.to]});
             }
-            tri_ind = tri.neighbours[index_in_tri];
-            tri = m_triangles[tri_ind];
-            index_in_tri = indexOf(vi, tri);
-            v_left = v_right;
-            v_right = tri.verts[next(index_in_tri)];
-        } while (tri_ind != start_tri_ind);
-
-        auto v_current = v_right;
-        auto prev_tri_ind = tri_ind;
-        tri_ind = tri.neighbours[next(index_in_tri)];
-
-        auto opp_vertex = v_right;
-        auto prev_opp_vertex = opp_vertex;
+        }
+        return overlapps;
+    }
 
-        while (v_current != vj)
+    template <class Vertex>
+    std::vector<EdgeVInd> Triangulation<Vertex>::findOverlappingConstraints2(const Vertex &vi, const Vertex &vj,
+                                                                             bool start_from_last_found)
+    {
+        std::vector<EdgeVInd> overlaps;
+        if (!withinBoundary(vi))
         {
-            auto &tri = m_triangles.at(tri_ind);
-            index_in_tri = indexOf(v_current, tri);
-            opp_vertex = tri.verts[next(index_in_tri)];
-
-            if (liesBetween(v_current, vi, vj) && liesBetween(opp_vertex, vi, vj)) // && tri.is_constrained[index_in_tri])
-            {                                                                      //! opposite vertex touches the inserted constraints
-                auto a = indexOf(v_current, tri);
-                auto b = indexOf(opp_vertex, tri);
-                auto a_ind = m_tri_ind2vert_inds.at(tri_ind)[a];
-                auto b_ind = m_tri_ind2vert_inds.at(tri_ind)[b];
-                if (dot(vj - vi, opp_vertex - v_current) > 0)
+            return overlaps;
+        }
+        const EdgeVInd e = {findOverlappingVertex(vi, findTriangle(vi, start_from_last_found)), findVertex(vj)};
+        if (e.from != -1 && e.to != -1 && e.from != e.to)
+        {
+            collectOverlaps(e, overlaps);
+            std::erase_if(overlaps, [](const EdgeVInd &overlap)
+                          { return overlap.from == overlap.to; });
+        }
+        return overlaps;
+    }
+
+    //! \brief finds edges lying on the segment between vertices \p e.from and \p e.to, ordered and directed
+    //! \brief from \p e.from to \p e.to. A vertex lying on the segment without such an edge is written as an edge
+    //! \brief of zero length, so the segment gets split there as well
+    //! \param overlapps here the edges are written, previous content gets cleared
+    template <class Vertex>
+    void Triangulation<Vertex>::collectOverlaps(const EdgeVInd &e, std::vector<EdgeVInd> &overlapps)
+    {
+        const auto &vi = m_vertices[e.from];
+        const auto &vj = m_vertices[e.to];
+        overlapps.clear();
+
+        //! hop along e from vertex to vertex lying on it, each hop is either an existing edge (an overlap)
+        //! or a walk through the triangles whose edges e crosses
+        auto v_current_ind = e.from;
+        while (v_current_ind != e.to)
+        {
+            const auto &v_current = m_vertices[v_current_ind];
+            const auto lies_ahead = [&](VertInd v_ind)
+            { return v_ind != v_current_ind && liesBetween(m_vertices[v_ind], v_current, vj); };
+
+            //! rotate around v_current_ind looking for an edge lying on e or a triangle through which e leaves
+            const auto start_tri_ind = firstTriangleAround(v_current_ind);
+            auto tri_ind = start_tri_ind;
+            VertInd v_next_ind = -1;
+            int crossed_ind_in_tri = -1;
+            while (true)
+            {
+                const auto &tri = m_triangles[tri_ind];
+                const auto ind_in_tri = indexOf(v_current_ind, tri);
+                const auto v_right_ind = tri.vert_inds[next(ind_in_tri)];
+                const auto v_left_ind = tri.vert_inds[prev(ind_in_tri)];
+                if (lies_ahead(v_right_ind) || lies_ahead(v_left_ind))
                 {
-                    overlapps.push_back({a_ind, b_ind});
+                    v_next_ind = lies_ahead(v_right_ind) ? v_right_ind : v_left_ind;
+                    break;
                 }
-                else
+                if (segmentsIntersect(m_vertices[v_left_ind], m_vertices[v_right_ind], v_current, vj))
+                {
+                    crossed_ind_in_tri = next(ind_in_tri);
+                    break;
+                }
+                tri_ind = tri.neighbours[ind_in_tri];
+                if (tri_ind == -1 || tri_ind == start_tri_ind)
                 {
-                    overlapps.push_back({b_ind, a_ind});
+                    break;
                 }
             }
 
-            //!
-            if (orient(vi, vj, opp_vertex) > 0)
+            if (v_next_ind != -1)
             {
-                v_current = tri.verts[next(index_in_tri)];
-                tri_ind = tri.neighbours[next(index_in_tri)];
-                prev_touched = false;
+                overlapps.push_back({v_current_ind, v_next_ind});
+                v_current_ind = v_next_ind;
+                continue;
             }
-            else if (strictly_less(orient(vi, vj, opp_vertex), 0))
+            if (crossed_ind_in_tri == -1)
             {
-                tri_ind = tri.neighbours[index_in_tri];
+                assert(false); //! e leaves the triangulation
+                return;
             }
-            else
+
+            //! cross triangles until reaching a vertex lying on e
+            while (true)
             {
-                tri_ind = tri.neighbours[next(index_in_tri)];
-                v_current = tri.verts[next(index_in_tri)];
+                const auto &tri = m_triangles[tri_ind];
+                const auto edge_ind = tri.backIndex(crossed_ind_in_tri);
+                tri_ind = tri.neighbours[crossed_ind_in_tri];
+                const auto &next_tri = m_triangles[tri_ind];
+                const auto opposite_ind = prev(edge_ind);
+                const auto orient_opposite = orient(vi, vj, vertexOf(next_tri, opposite_ind));
+                if (approx_equal_zero(orient_opposite))
+                {
+                    v_current_ind = next_tri.vert_inds[opposite_ind];
+                    if (v_current_ind != e.to)
+                    {
+                        overlapps.push_back({v_current_ind, v_current_ind});
+                    }
+                    break;
+                }
+                //! e leaves through the edge whose endpoints lie on different sides of it
+                const auto orient_from = orient(vi, vj, vertexOf(next_tri, edge_ind));
+                crossed_ind_in_tri = (orient_opposite > 0) != (orient_from > 0) ? prev(edge_ind) : next(edge_ind);
             }
         }
-        return overlapps;
     }
 
-    // template <class Vertex>
-    // void Triangulation<Vertex>::findIntersectingEdges(const EdgeVInd &e, std::deque<EdgeI<Vertex>> &intersected_edges,
-    //                                                   std::deque<TriInd> &intersected_tri_inds)
-    // {
-    //     const auto vi_ind = e.from;
-    //     const auto vj_ind = e.to;
-    //     if (vi_ind == vj_ind)
-    //     {
-    //         return;
-    //     }
-    //     const auto vi = m_vertices[vi_ind];
-    //     const auto vj = m_vertices[vj_ind];
-
-    //     const auto start_tri_ind = findTriangle(vi, false);
-    //     const auto start_tri = m_triangles[start_tri_ind];
-    //     const auto end_tri_ind = findTriangle(vj, true);
-    //     const auto end_tri = m_triangles[end_tri_ind];
-
-    //     EdgeI e_inserted(vi, vj);
-
-    //     auto tri_ind = start_tri_ind;
-    //     auto tri = m_triangles[tri_ind];
-    //     auto index_in_tri = indexOf(vi, tri);
-    //     EdgeI e_next = {tri.verts[prev(index_in_tri)], tri.verts[next(index_in_tri)]};
-    //     if (index_in_tri == -1)
-    //     {
-    //         findTriangle(vi, false);
-    //     }
-    //     bool second_round = false;
-    //     //! find first direction of walk by looking at triangles that contain vi;
-    //     while (!edgesIntersect(e_next, e_inserted))
-    //     {
-    //         tri_ind = tri.neighbours[index_in_tri];
-    //         tri = m_triangles[tri_ind];
-    //         index_in_tri = indexOf(vi, tri);
-
-    //         e_next = {tri.verts[prev(index_in_tri)], tri.verts[next(index_in_tri)]};
-
-    //         if (tri_ind == start_tri_ind)
-    //         {
-    //             if (second_round) //! we are walking in circles so
-    //                 return;
-    //             second_round = true;
-    //         }
-
-    //         if (e_next.from == vj)
-    //         {
-    //             m_triangles[tri_ind].is_constrained[prev(index_in_tri)] = true;
-    //             const auto tri_ind_opposite = triangleOppositeOfEdge(tri, e_inserted);
-    //             const auto ind_in_opposite_tri = indexOf(vi, m_triangles[tri_ind_opposite]);
-    //             m_triangles[tri_ind_opposite].is_constrained[ind_in_opposite_tri] = true;
-    //             return; //! the end vertex of the constraint is already connected to start vertex;
-    //         }
-    //         else if (e_next.to() == vj)
-    //         {
-    //             m_triangles[tri_ind].is_constrained[index_in_tri] = true;
-    //             const auto tri_ind_opposite = triangleOppositeOfEdge(tri, e_inserted);
-    //             const auto ind_in_opposite_tri = indexOf(vj, m_triangles[tri_ind_opposite]);
-    //             m_triangles[tri_ind_opposite].is_constrained[ind_in_opposite_tri] = true;
-    //             return;
-    //         }
-    //     }
-    //     intersected_edges.push_back(e_next);
-    //     intersected_tri_inds.push_back({tri_ind});
-    //     auto v_current = tri.verts[(index_in_tri + 1) % 3];
-    //     tri_ind = tri.neighbours[(index_in_tri + 1) % 3];
-    //     EdgeI<Vertex> e_next1;
-    //     EdgeI<Vertex> e_next2;
-
-    //     //! walk in the found direction to the triangle containing end_ind;
-    //     while (tri_ind != end_tri_ind)
-    //     {
-    //         tri = m_triangles[tri_ind];
-    //         index_in_tri = indexOf(v_current, tri);
-    //         assert(index_in_tri != -1); //! we expect v_current to always exist in tri
-
-    //         e_next1 = {tri.verts[(index_in_tri) % 3], tri.verts[(index_in_tri + 1) % 3]};
-    //         e_next2 = {tri.verts[(index_in_tri + 1) % 3], tri.verts[(index_in_tri + 2) % 3]};
-    //         if (e_next1.from == vj or e_next2.to() == vj or e_next1.to() == vj)
-    //         {
-    //             break; //! we found end_v_ind;
-    //         }
-    //         intersected_tri_inds.push_back(tri_ind);
-
-    //         if (edgesIntersect(e_next1, e_inserted))
-    //         {
-    //             tri_ind = tri.neighbours[index_in_tri];
-    //             intersected_edges.push_back(e_next1);
-    //         }
-    //         else if (edgesIntersect(e_next2, e_inserted))
-    //         {
-    //             intersected_edges.push_back(e_next2);
-    //             tri_ind = tri.neighbours[(index_in_tri + 1) % 3];
-    //             v_current = tri.verts[(index_in_tri + 1) % 3];
-    //         }
-    //         else
-    //         {
-    //             break;
-    //         }
-    //     }
-    //     //    intersected_tri_inds.push_back(tri_ind); //! there is one more triangle compared to intersected edges
-    // }
-
     //! \brief finds existing edges and their corresponding triangles that would intersect with edge \p e
-    //! \brief writes the edges into \p intersected_edges and triangles into \p intersected_tri_inds
+    //! \brief writes the edges into m_scratch.intersected_edges and triangles into m_scratch.intersected_tri_inds
     //! \param e edge containing vertex indices
-    //! \param intersected_edges here the intersected edges are written;
-    //! \param intersected_tri_inds here the tri inds corresponding to \p intersected_edges are written
     template <class Vertex>
-    void Triangulation<Vertex>::findIntersectingEdges(const EdgeVInd &e, std::deque<EdgeI<Vertex>> &intersected_edges,
-                                                      std::deque<TriInd> &intersected_tri_inds)
+    void Triangulation<Vertex>::findIntersectingEdges(const EdgeVInd &e)
     {
+        auto &intersected_edges = m_scratch.intersected_edges;
+        auto &intersected_tri_inds = m_scratch.intersected_tri_inds;
+        intersected_edges.clear();
+        intersected_tri_inds.clear();
+
         const auto vi_ind = e.from;
         const auto vj_ind = e.to;
         if (vi_ind == vj_ind)
@@ -1768,86 +2512,89 @@ namespace cdt
         const auto vi = m_vertices[vi_ind];
         const auto vj = m_vertices[vj_ind];
 
-        const auto start_tri_ind = findTriangle(vi, false);
-        const auto start_tri = m_triangles[start_tri_ind];
-        const auto end_tri_ind = findTriangle(vj, true);
-        const auto end_tri = m_triangles[end_tri_ind];
-
-        EdgeI<Vertex> e_inserted(vi, vj);
+        const auto start_tri_ind = firstTriangleAround(vi_ind);
 
         auto tri_ind = start_tri_ind;
         auto tri = m_triangles[tri_ind];
-        auto index_in_tri = indexOf(vi, tri);
-
-        auto v_left = tri.verts[prev(index_in_tri)];
-        auto v_right = tri.verts[next(index_in_tri)];
+        auto index_in_tri = indexOf(vi_ind, tri);
 
         // check if the vj is already connected to vi
-        do
+        while (true)
         {
-            if (v_right == vj)
+            if (tri.vert_inds[next(index_in_tri)] == vj_ind || tri.vert_inds[prev(index_in_tri)] == vj_ind)
             {
-                m_triangles[tri_ind].is_constrained[index_in_tri] = true;
-                const auto tri_ind_opposite = triangleOppositeOfEdge(tri, e_inserted);
-                const auto ind_in_opposite_tri = indexOf(vj, m_triangles[tri_ind_opposite]);
-                m_triangles[tri_ind_opposite].is_constrained[ind_in_opposite_tri] = true;
+                const auto ind_in_tri = tri.vert_inds[next(index_in_tri)] == vj_ind ? index_in_tri : prev(index_in_tri);
+                m_triangles[tri_ind].setConstrained(ind_in_tri, true);
+                const auto tri_ind_opposite = tri.neighbours[ind_in_tri];
+                if (tri_ind_opposite != -1)
+                {
+                    m_triangles[tri_ind_opposite].setConstrained(tri.backIndex(ind_in_tri), true);
+                }
                 return;
             }
             tri_ind = tri.neighbours[index_in_tri];
+            if (tri_ind == -1 || tri_ind == start_tri_ind)
+            {
+                break;
+            }
             tri = m_triangles[tri_ind];
-            index_in_tri = indexOf(vi, tri);
-            v_right = tri.verts[next(index_in_tri)];
-        } while (tri_ind != start_tri_ind);
+            index_in_tri = indexOf(vi_ind, tri);
+        }
 
         tri_ind = start_tri_ind;
         tri = m_triangles[tri_ind];
-        index_in_tri = indexOf(vi, tri);
-        v_left = tri.verts[prev(index_in_tri)];
-        v_right = tri.verts[next(index_in_tri)];
+        index_in_tri = indexOf(vi_ind, tri);
+        auto v_left = vertexOf(tri, prev(index_in_tri));
+        auto v_right = vertexOf(tri, next(index_in_tri));
         //! find first direction of walk by looking at triangles that contain vi;
         while (!segmentsIntersectOrTouch(v_left, v_right, vi, vj))
         {
             tri_ind = tri.neighbours[index_in_tri];
+            if (tri_ind == -1)
+            {
+                assert(false); //! vj lies outside of the triangulation
+                return;
+            }
             tri = m_triangles[tri_ind];
-            index_in_tri = indexOf(vi, tri);
+            index_in_tri = indexOf(vi_ind, tri);
 
             v_left = v_right;
-            v_right = tri.verts[next(index_in_tri)];
+            v_right = vertexOf(tri, next(index_in_tri));
         }
 
-        intersected_edges.push_back({v_left, v_right});
-        intersected_tri_inds.push_back({tri_ind});
+        intersected_edges.push_back({tri.vert_inds[prev(index_in_tri)], tri.vert_inds[next(index_in_tri)]});
+        intersected_tri_inds.push_back(tri_ind);
 
-        auto v_current = tri.verts[next(index_in_tri)];
+        auto v_current = tri.vert_inds[next(index_in_tri)];
         tri_ind = tri.neighbours[next(index_in_tri)];
-        EdgeI<Vertex> e_next1;
-        EdgeI<Vertex> e_next2;
 
-        //! walk in the found direction to the triangle containing end_ind;
-        while (tri_ind != end_tri_ind)
+        //! walk in the found direction to a triangle containing vj_ind;
+        while (true)
         {
-            tri = m_triangles[tri_ind];
+            const auto &tri = m_triangles[tri_ind];
             index_in_tri = indexOf(v_current, tri);
             assert(index_in_tri != -1); //! we expect v_current to always exist in tri
 
-            e_next1 = {v_current, tri.verts[next(index_in_tri)]};
-            e_next2 = {tri.verts[next(index_in_tri)], tri.verts[prev(index_in_tri)]};
-            if (e_next1.from == vj || e_next2.to() == vj || e_next1.to() == vj)
+            const auto v_next = tri.vert_inds[next(index_in_tri)];
+            const auto v_prev = tri.vert_inds[prev(index_in_tri)];
+            if (v_current == vj_ind || v_next == vj_ind || v_prev == vj_ind)
             {
                 break; //! we found end_v_ind;
             }
             intersected_tri_inds.push_back(tri_ind);
 
-            if (edgesIntersect(e_next1, e_inserted))
+            const EdgeVInd e_next1 = {v_current, v_next};
+            const EdgeVInd e_next2 = {v_next, v_prev};
+            if (edgesIntersect(e_next1, e))
             {
                 intersected_edges.push_back(e_next1);
                 tri_ind = tri.neighbours[index_in_tri];
             }
-            else if (edgesIntersect(e_next2, e_inserted))
+            else if (edgesIntersect(e_next2, e))
             {
                 intersected_edges.push_back(e_next2);
                 tri_ind = tri.neighbours[next(index_in_tri)];
-                v_current = tri.verts[next(index_in_tri)];
+                v_current = v_next;
             }
             else
             {
@@ -1857,77 +2604,70 @@ namespace cdt
     }
 
     template <class Vertex>
-    bool Triangulation<Vertex>::hasGoodOrientation(const Triangle<Vertex> &tri) const
+    bool Triangulation<Vertex>::hasGoodOrientation(const Triangle &tri) const
     {
-        return isCounterClockwise(tri.verts[2], tri.verts[1], tri.verts[0]) &&
-               isCounterClockwise(tri.verts[0], tri.verts[2], tri.verts[1]) &&
-               isCounterClockwise(tri.verts[1], tri.verts[0], tri.verts[2]);
+        const auto &v0 = vertexOf(tri, 0);
+        const auto &v1 = vertexOf(tri, 1);
+        const auto &v2 = vertexOf(tri, 2);
+        return isCounterClockwise(v2, v1, v0) &&
+               isCounterClockwise(v0, v2, v1) &&
+               isCounterClockwise(v1, v0, v2);
     }
 
     template <class Vertex>
     bool Triangulation<Vertex>::isCounterClockwise(const Vertex &v_query, const Vertex &v1, const Vertex &v2) const
     {
-        // Vertex v21_norm = {-v2.y + v1.y, v2.x - v1.x};
-        // dot(v_query - v1, v21_norm) >= 0;
-        return orient(v_query, v1, v2) >= 0;
+        return orientation(v_query, v1, v2) >= 0;
     }
 
-    //! \param v    vertex
+    //! \param v_ind index of a vertex
     //! \param tri  triangle
-    //! \returns index in triangle tri corresponding to vertex \p v
+    //! \returns index in triangle tri corresponding to vertex \p v_ind or -1 if \p tri does not contain it
     template <class Vertex>
-    int Triangulation<Vertex>::indexOf(const Vertex &v, const Triangle<Vertex> &tri) const
+    int Triangulation<Vertex>::indexOf(const VertInd v_ind, const Triangle &tri) const
     {
-        if (tri.verts[0] == v)
+        if (tri.vert_inds[0] == v_ind)
         {
             return 0;
         }
-        else if (tri.verts[1] == v)
+        else if (tri.vert_inds[1] == v_ind)
         {
             return 1;
         }
-        else if (tri.verts[2] == v)
+        else if (tri.vert_inds[2] == v_ind)
         {
             return 2;
         }
         return -1;
     }
 
+    //! \param v    vertex coordinates
+    //! \param tri  triangle
+    //! \returns index in triangle tri corresponding to vertex \p v or -1 if \p tri does not contain it
+    template <class Vertex>
+    int Triangulation<Vertex>::indexOf(const Vertex &v, const Triangle &tri) const
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            if (vertexOf(tri, k) == v)
+            {
+                return k;
+            }
+        }
+        return -1;
+    }
+
     //! \brief vertex \p vp and \p v3 must lie opposite to each other
     //! \param vp
     //! \param v1
     //! \param v2
     //! \param v3
-    //! \returns true if quadrilateral formed by four vertices is Delaunay
+    //! \returns true if \p vp lies strictly inside of the circumcircle of \p v1, \p v2, \p v3 so edge v1-v2 should be swapped
     template <class Vertex>
     bool Triangulation<Vertex>::needSwap(const Vertex &vp, const Vertex &v1, const Vertex &v2, const Vertex &v3) const
     {
-
-        auto v13 = cdt::Vector2f(v1 - v3);
-        auto v23 = cdt::Vector2f(v2 - v3);
-        auto v1p = cdt::Vector2f(v1 - vp);
-        auto v2p = cdt::Vector2f(v2 - vp);
-
-        const auto cos_a = dot(v13, v23);
-        const auto cos_b = dot(v1p, v2p);
-
-        if (cos_a >= 0 && cos_b >= 0)
-        {
-            return false;
-        }
-        if (cos_a < 0 && cos_b < 0)
-        {
-            return true;
-        }
-        const auto sin_ab = static_cast<float>(v13.x * v23.y - v23.x * v13.y) * cos_b +
-                            static_cast<float>(v2p.x * v1p.y - v1p.x * v2p.y) * cos_a;
-
-        if (-sin_ab < 0)
-        { //! I HAVE NO CLUE WHY THERE HAS TO BE MINUS AND IT MAKES ME SAD!!! (in the article there is plus!)
-            return true;
-        }
-
-        return false;
+        //! inCircle flips its sign together with the orientation, so the order of v1 and v2 does not matter
+        return inCircle(v1, v2, v3, vp) * orientation(v1, v2, v3) > 0;
     }
 
     template <class Vertex>
@@ -1954,6 +2694,114 @@ namespace cdt
             //        "say some warning message or something";
         }
     }
+    //! \brief writes vertices, triangles with their neighbours and constraint bits, constrained edges and the locate
+    //! \brief grid into a binary snapshot which loadSnapshot reads back without inserting anything
+    //! \param triangle_widths optional widths of triangle edges, 3 per triangle, stored for PathFinder
+    //! \brief throws std::runtime_error if the file cannot be written
+    template <class Vertex>
+    void Triangulation<Vertex>::saveSnapshot(const std::string &filename, std::span<const float> triangle_widths) const
+    {
+        static_assert(std::is_trivially_copyable_v<Vertex> && std::is_trivially_copyable_v<Triangle>);
+        assert(triangle_widths.empty() || triangle_widths.size() == 3 * m_triangles.size());
+
+        SnapshotHeader header;
+        header.vertex_size = sizeof(Vertex);
+        header.triangle_size = sizeof(Triangle);
+        header.boundary[0] = m_boundary.x;
+        header.boundary[1] = m_boundary.y;
+        header.cell_count[0] = m_grid->m_cell_count.x;
+        header.cell_count[1] = m_grid->m_cell_count.y;
+        header.n_fixed_edges = m_fixed_edges.size();
+
+        const SnapshotSectionData sections[] = {
+            {SnapshotSection::Vertices, std::as_bytes(std::span(m_vertices))},
+            {SnapshotSection::Triangles, std::as_bytes(std::span(m_triangles))},
+            {SnapshotSection::Vertex2Tri, std::as_bytes(std::span(m_vertex2tri))},
+            {SnapshotSection::FixedEdgeSlots, std::as_bytes(m_fixed_edges.slots())},
+            {SnapshotSection::Cell2Tri, std::as_bytes(std::span(m_cell2tri_ind))},
+            {SnapshotSection::TriangleWidths, std::as_bytes(triangle_widths)},
+        };
+        writeSnapshot(filename, header, sections);
+    }
+
+    //! \brief replaces the triangulation by the one stored in \p snapshot, the arrays are checked and copied as they
+    //! \brief are, so loading is linear in the file size and costs about as much as reading the file. Throws std::runtime_error if \p snapshot
+    //! \brief was written by a triangulation with different vertex type, its sections do not fit together or
+    //! \brief hold indices out of range
+    template <class Vertex>
+    void Triangulation<Vertex>::loadSnapshot(const SnapshotFile &snapshot)
+    {
+        const auto &header = snapshot.header();
+        const auto vertices = snapshot.array<Vertex>(SnapshotSection::Vertices);
+        const auto triangles = snapshot.array<Triangle>(SnapshotSection::Triangles);
+        const auto vertex2tri = snapshot.array<TriInd>(SnapshotSection::Vertex2Tri);
+        const auto fixed_edge_slots = snapshot.array<std::uint64_t>(SnapshotSection::FixedEdgeSlots);
+        const auto cell2tri = snapshot.array<TriInd>(SnapshotSection::Cell2Tri);
+        const cdt::Vector2i cell_count = {header.cell_count[0], header.cell_count[1]};
+
+        if (header.vertex_size != sizeof(Vertex) || header.triangle_size != sizeof(Triangle) ||
+            vertex2tri.size() != vertices.size() || cell_count.x <= 0 || cell_count.y <= 0 ||
+            cell2tri.size() != static_cast<std::size_t>(cell_count.x) * cell_count.y)
+        {
+            throw std::runtime_error("snapshot does not match the triangulation");
+        }
+        //! every stored index gets checked before anything is assigned, so a damaged file cannot make later queries
+        //! read out of bounds
+        const auto n_vertices = vertices.size();
+        const auto n_triangles = triangles.size();
+        for (TriInd tri_ind = 0; tri_ind < n_triangles; ++tri_ind)
+        {
+            const auto &tri = triangles[tri_ind];
+            for (int k = 0; k < 3; ++k)
+            {
+                const auto neighbour = tri.neighbours[k];
+                if (tri.vert_inds[k] >= n_vertices ||
+                    (neighbour != -1 && (neighbour >= n_triangles || tri.backIndex(k) > 2 ||
+                                         triangles[neighbour].neighbours[tri.backIndex(k)] != tri_ind)))
+                {
+                    throw std::runtime_error("snapshot holds malformed triangles");
+                }
+            }
+        }
+        for (VertInd v_ind = 0; v_ind < n_vertices; ++v_ind)
+        {
+            const auto tri_ind = vertex2tri[v_ind];
+            if (tri_ind >= n_triangles || indexOf(v_ind, triangles[tri_ind]) == -1)
+            {
+                throw std::runtime_error("snapshot holds malformed vertex triangles");
+            }
+        }
+        if (std::any_of(cell2tri.begin(), cell2tri.end(), [n_triangles](TriInd tri_ind)
+                        { return tri_ind != -1 && tri_ind >= n_triangles; }))
+        {
+            throw std::runtime_error("snapshot holds malformed locate grid");
+        }
+        std::uint64_t n_used_slots = 0;
+        for (const auto key : fixed_edge_slots)
+        { //! keys hold the smaller vertex index in the high and the larger one in the low half, all ones is empty
+            if (key != std::uint64_t(-1))
+            {
+                n_used_slots++;
+                if ((key & 0xffffffffu) >= n_vertices || (key >> 32) >= (key & 0xffffffffu))
+                {
+                    throw std::runtime_error("snapshot holds malformed constrained edges");
+                }
+            }
+        }
+        if (n_used_slots != header.n_fixed_edges || !m_fixed_edges.assignSlots(fixed_edge_slots, header.n_fixed_edges))
+        {
+            throw std::runtime_error("snapshot holds malformed constrained edges");
+        }
+
+        m_boundary = {header.boundary[0], header.boundary[1]};
+        m_grid = std::make_unique<Grid>(cell_count, asFloat(m_boundary));
+        m_vertices.assign(vertices.begin(), vertices.end());
+        m_triangles.assign(triangles.begin(), triangles.end());
+        m_vertex2tri.assign(vertex2tri.begin(), vertex2tri.end());
+        m_cell2tri_ind.assign(cell2tri.begin(), cell2tri.end());
+        m_cursor = {};
+    }
+
     template <class Vertex>
     long long Triangulation<Vertex>::det(const Vertex &v1, const Vertex &v2, const Vertex &v3) const
     {
@@ -1968,7 +2816,7 @@ namespace cdt
     {
         for (auto &tri : m_triangles)
         {
-            if (det(tri.verts[0], tri.verts[1], tri.verts[2]) == 0)
+            if (det(vertexOf(tri, 0), vertexOf(tri, 1), vertexOf(tri, 2)) == 0)
             {
                 return false;
             }
@@ -1976,17 +2824,19 @@ namespace cdt
         return true;
     }
 
+    //! \returns true if no unconstrained edge of triangle \p tri_ind needs to be swapped
     template <class Vertex>
-    bool Triangulation<Vertex>::isDelaunay(const Triangle<Vertex> &tri) const
+    bool Triangulation<Vertex>::isDelaunay(const TriInd tri_ind) const
     {
+        const auto &tri = m_triangles[tri_ind];
         for (int i = 0; i < 3; ++i)
         {
             auto n_ind = tri.neighbours[i];
 
-            if (n_ind != -1)
+            if (n_ind != -1 && !tri.isConstrained(i))
             {
-                auto v_opp = m_vertices.at(oppositeOfEdge(tri, EdgeI{tri.verts[i], tri.verts[next(i)]}));
-                if (needSwap(v_opp, tri.verts[i], tri.verts[next(i)], tri.verts[prev(i)]))
+                const auto &v_opp = vertexOf(m_triangles[n_ind], tri.oppositeInNeighbour(i));
+                if (needSwap(v_opp, vertexOf(tri, i), vertexOf(tri, next(i)), vertexOf(tri, prev(i))))
                 {
                     return false;
                 }
@@ -1998,9 +2848,9 @@ namespace cdt
     template <class Vertex>
     bool Triangulation<Vertex>::allAreDelaunay() const
     {
-        for (const auto &tri : m_triangles)
+        for (TriInd tri_ind = 0; tri_ind < m_triangles.size(); ++tri_ind)
         {
-            if (!isDelaunay(tri))
+            if (!isDelaunay(tri_ind))
             {
                 return false;
             }
@@ -2010,4 +2860,4 @@ namespace cdt
 
     template class Triangulation<cdt::Vector2i>;
 
-} // namespace cdt
\ No newline at end of file
+} // namespace cdt
@@ -1,16 +1,20 @@
 #ifndef BOIDS_TRIANGULATION_H
 #define BOIDS_TRIANGULATION_H
 
-#include <unordered_set>
 #include <deque>
 #include <cassert>
 #include <memory>
 #include <algorithm>
 #include <vector>
 #include <array>
+#include <cstdint>
+#include <span>
+#include <random>
+#include <bit>
 
 #include "core.h"
 #include "Grid.h"
+#include "Predicates.h"
 
 namespace sf
 {
@@ -19,6 +23,8 @@ namespace sf
 
 namespace cdt
 {
+    class ThreadPool;
+    class SnapshotFile;
 
     using TriInd = unsigned int;
     using VertInd = unsigned int;
@@ -54,35 +60,199 @@ namespace cdt
         bool operator==(const EdgeI &e) const { return e.from == from and e.t == t; }
     };
 
+    inline int next(const int ind_in_tri)
+    {
+        assert(ind_in_tri <= 2 && ind_in_tri >= 0);
+        if (ind_in_tri == 2)
+        {
+            return 0;
+        }
+        return ind_in_tri + 1;
+    }
+
+    inline int prev(const int ind_in_tri)
+    {
+        assert(ind_in_tri <= 2 && ind_in_tri >= 0);
+        if (ind_in_tri == 0)
+        {
+            return 2;
+        }
+        return ind_in_tri - 1;
+    }
+
     //! \struct holds data relating to triangle. Ordering is counterclowise (see image)
-    template <class Vertex>
+    //! \brief edge k connects vertices k and next(k) and is shared with neighbours[k]
+    //! \brief vertex coordinates live only in Triangulation::m_vertices, triangles store just indices
     struct Triangle
     {
-        Vertex verts[3];                    //! vertex coordinates
-        std::array<TriInd, 3> neighbours;   //! indices of neighbouring triangles
-        std::array<bool, 3> is_constrained; //! whether corresponding edge is constrained (is this needed here?)
+        std::array<VertInd, 3> vert_inds; //! indices of vertices in the triangulation
+        std::array<TriInd, 3> neighbours; //! indices of neighbouring triangles
+        std::uint8_t constraints = 0;     //! bit k is set when edge k is constrained
+        std::uint8_t back_inds = 0;       //! 2 bits per edge k: index of this triangle in neighbours[k] of the neighbour
 
         explicit Triangle()
         {
+            vert_inds = {-1u, -1u, -1u};
             neighbours = {-1u, -1u, -1u};
-            is_constrained = {false, false, false};
         }
 
-        cdt::Vector2f getCenter() const
+        bool isConstrained(int ind_in_tri) const
         {
-            return asFloat(verts[0] + verts[1] + verts[2]) / 3.f;
+            return (constraints >> ind_in_tri) & 1u;
+        }
+
+        void setConstrained(int ind_in_tri, bool is_constrained)
+        {
+            constraints = (constraints & ~(1u << ind_in_tri)) | (static_cast<unsigned>(is_constrained) << ind_in_tri);
+        }
+
+        //! \returns index of the shared edge as seen from neighbours[ind_in_tri]
+        int backIndex(int ind_in_tri) const
+        {
+            return (back_inds >> (2 * ind_in_tri)) & 3u;
+        }
+
+        void setBackIndex(int ind_in_tri, int ind_in_neighbour)
+        {
+            back_inds = (back_inds & ~(3u << (2 * ind_in_tri))) | (ind_in_neighbour << (2 * ind_in_tri));
+        }
+
+        //! \returns index (within neighbours[ind_in_tri]) of the vertex lying opposite of the edge \p ind_in_tri
+        int oppositeInNeighbour(int ind_in_tri) const
+        {
+            return prev(backIndex(ind_in_tri));
         }
     };
+    static_assert(sizeof(Triangle) == 28, "Triangle should stay compact!");
 
-    //! \struct function object used to convert an edge into a hash
-    struct EdgeHash
+    //! \class set of edges keyed by the indices of their vertices, the direction of an edge does not matter
+    //! \brief open addressing with linear probing, removal shifts the following keys back so no tombstones are left
+    class EdgeSet
     {
-        template <class Vertex>
-        std::size_t operator()(const EdgeI<Vertex> &e) const
+    public:
+        //! \returns true if \p e was not in the set before
+        bool insert(const EdgeVInd e)
         {
-            return std::hash<VertInd>()(e.from.x) ^ std::hash<VertInd>()(e.t.x) ^ std::hash<VertInd>()(e.from.y) ^
-                   std::hash<VertInd>()(e.t.y);
+            if (2 * (m_size + 1) > m_keys.size())
+            {
+                rehash(std::max<std::size_t>(16, 2 * m_keys.size()));
+            }
+            const auto key = keyOf(e);
+            auto slot = slotOf(key);
+            for (; m_keys[slot] != empty_key; slot = (slot + 1) & (m_keys.size() - 1))
+            {
+                if (m_keys[slot] == key)
+                {
+                    return false;
+                }
+            }
+            m_keys[slot] = key;
+            m_size++;
+            return true;
         }
+
+        //! \returns true if \p e was in the set
+        bool erase(const EdgeVInd e)
+        {
+            auto slot = findSlot(keyOf(e));
+            if (slot == -1)
+            {
+                return false;
+            }
+            const auto mask = m_keys.size() - 1;
+            for (auto next_slot = (slot + 1) & mask; m_keys[next_slot] != empty_key; next_slot = (next_slot + 1) & mask)
+            { //! a key moves into the hole unless its home slot lies cyclically between the hole and the key
+                const auto home = slotOf(m_keys[next_slot]);
+                if (((next_slot - home) & mask) >= ((next_slot - slot) & mask))
+                {
+                    m_keys[slot] = m_keys[next_slot];
+                    slot = next_slot;
+                }
+            }
+            m_keys[slot] = empty_key;
+            m_size--;
+            return true;
+        }
+
+        bool contains(const EdgeVInd e) const { return findSlot(keyOf(e)) != -1; }
+        std::size_t size() const { return m_size; }
+
+        void clear()
+        {
+            std::fill(m_keys.begin(), m_keys.end(), empty_key);
+            m_size = 0;
+        }
+
+        //! \returns the slot array as it lies in memory, so it can be stored in a snapshot
+        std::span<const std::uint64_t> slots() const { return m_keys; }
+
+        //! \brief replaces the contents by \p slots taken from slots() of a set holding \p n_edges edges
+        //! \returns false if \p slots cannot come from an EdgeSet, the set is left unchanged then
+        bool assignSlots(std::span<const std::uint64_t> slots, std::size_t n_edges)
+        {
+            if ((!slots.empty() && !std::has_single_bit(slots.size())) || 2 * n_edges > slots.size())
+            {
+                return false;
+            }
+            m_keys.assign(slots.begin(), slots.end());
+            m_size = n_edges;
+            m_shift = slots.empty() ? 64 : 64 - std::countr_zero(slots.size());
+            return true;
+        }
+
+    private:
+        static constexpr std::uint64_t empty_key = -1; //! would be the edge (-1, -1) which is never stored
+
+        static std::uint64_t keyOf(const EdgeVInd e)
+        {
+            const auto [v_min, v_max] = std::minmax(e.from, e.to);
+            return (static_cast<std::uint64_t>(v_min) << 32) | v_max;
+        }
+
+        //! \brief Fibonacci hashing, the multiplication mixes both indices into the high bits used as the slot
+        std::size_t slotOf(std::uint64_t key) const
+        {
+            return (key * 0x9E3779B97F4A7C15ull) >> m_shift;
+        }
+
+        std::size_t findSlot(std::uint64_t key) const
+        {
+            if (m_size == 0)
+            {
+                return -1;
+            }
+            for (auto slot = slotOf(key); m_keys[slot] != empty_key; slot = (slot + 1) & (m_keys.size() - 1))
+            {
+                if (m_keys[slot] == key)
+                {
+                    return slot;
+                }
+            }
+            return -1;
+        }
+
+        void rehash(std::size_t n_slots)
+        {
+            auto old_keys = std::move(m_keys);
+            m_keys.assign(n_slots, empty_key);
+            m_shift = 64 - std::countr_zero(n_slots);
+            for (const auto key : old_keys)
+            {
+                if (key != empty_key)
+                {
+                    auto slot = slotOf(key);
+                    while (m_keys[slot] != empty_key)
+                    {
+                        slot = (slot + 1) & (n_slots - 1);
+                    }
+                    m_keys[slot] = key;
+                }
+            }
+        }
+
+        std::vector<std::uint64_t> m_keys; //! number of slots is a power of two, at most half of them are used
+        std::size_t m_size = 0;
+        int m_shift = 64;
     };
 
     struct VertexInsertionData
@@ -91,6 +261,39 @@ namespace cdt
         EdgeVInd overlapping_edge;
     };
 
+    //! \struct counts how the point location queries were answered
+    struct LocateStats
+    {
+        std::size_t n_queries = 0;     //! calls of findTriangle
+        std::size_t n_empty_cells = 0; //! walks starting from the last found triangle as the grid cell had none
+        std::size_t n_steps = 0;       //! triangles walked through in total
+        std::size_t n_restarts = 0;    //! walks restarted from a sampled vertex after getting stuck
+    };
+
+    //! \struct state of point location owned by the caller of the const findTriangle
+    //! \brief each thread keeps its own cursor, so the triangulation itself is only read
+    struct LocateCursor
+    {
+        TriInd hint = 0;           //! triangle where the previous query ended
+        std::minstd_rand walk_gen; //! picks the order in which the walk tries edges
+        LocateStats stats;
+    };
+
+    //! \brief how insertConstraint gets rid of edges crossing the inserted constraint
+    enum class ConstraintInsertion
+    {
+        EdgeFlips, //! swaps the crossing edges away one by one and restores Delaunay property by more swaps
+        Cavity,    //! removes the pierced triangles and triangulates the polygons on both sides of the constraint
+    };
+
+    //! \struct where triangles and vertices moved in Triangulation::reorder
+    //! \brief anything storing triangle or vertex indices of the triangulation remaps them through these
+    struct Reordering
+    {
+        std::vector<TriInd> new_tri_inds;   //! new index of each old triangle
+        std::vector<VertInd> new_vert_inds; //! new index of each old vertex
+    };
+
     template <class Vertex = cdt::Vector2i>
     class Triangulation
     {
@@ -104,28 +307,73 @@ namespace cdt
         void createSuperTriangle(cdt::Vector2i box_size);
 
         TriInd findTriangle(cdt::Vector2f query_point, bool start_from_last_found = false);
+        TriInd findTriangle(cdt::Vector2f query_point, LocateCursor &cursor, bool start_from_hint = false) const;
+        TriInd findTriangle(const Vertex &query_point, LocateCursor &cursor, bool start_from_hint = false) const;
+        void locateMany(std::span<const cdt::Vector2f> queries, std::span<TriInd> tri_inds, bool use_hints = false,
+                        ThreadPool *pool = nullptr) const;
 
         void insertVertex(const Vertex &v, bool = false);
-        void insertVertexIntoSpace(const Vertex &v, TriInd, VertInd);
+        void insertVertexIntoSpace(TriInd, VertInd);
         VertexInsertionData insertVertexAndGetData(const Vertex &v, bool = false);
         VertexInsertionData insertVertexAndGetData(int vx, int vy, bool = false);
 
-        void insertVertices(const std::vector<Vertex> &verts);
+        std::vector<VertInd> insertVertices(std::span<const Vertex> verts);
+        std::vector<VertInd> buildFromVertices(const std::vector<Vertex> &verts, ThreadPool *pool = nullptr);
 
         void insertConstraint(const EdgeVInd edge);
         void insertConstraint(const EdgeVInd edge, sf::RenderWindow &window);
+        void insertConstraints(std::span<const EdgeVInd> edges);
+        void insertConstraints(std::span<const EdgeI<Vertex>> edges);
+        std::vector<VertInd> insertPolyline(std::span<const Vertex> points, bool is_closed = false);
 
-        int indexOf(const Vertex &v, const Triangle<Vertex> &tri) const;
-        int oppositeIndex(const TriInd np, const Triangle<Vertex> &tri);
+        bool removeVertex(VertInd v_ind);
+        bool removeConstraint(const EdgeVInd edge);
+        void replaceConstraintsInRect(const Vertex &lower_left, const Vertex &upper_right,
+                                      std::span<const EdgeI<Vertex>> edges);
+
+        VertInd findVertex(const Vertex &v);
+
+        int indexOf(const VertInd v_ind, const Triangle &tri) const;
+        int oppositeIndex(const TriInd np, const Triangle &tri) const;
+
+        //! \returns coordinates of the vertex at \p ind_in_tri in \p tri
+        const Vertex &vertexOf(const Triangle &tri, int ind_in_tri) const
+        {
+            return m_vertices[tri.vert_inds[ind_in_tri]];
+        }
+        cdt::Vector2f getCenter(const Triangle &tri) const
+        {
+            return asFloat(vertexOf(tri, 0) + vertexOf(tri, 1) + vertexOf(tri, 2)) / 3.f;
+        }
+        cdt::Vector2f getCenter(TriInd tri_ind) const
+        {
+            return getCenter(m_triangles[tri_ind]);
+        }
+        //! \returns upper right corner of the triangulated box, the lower left one is the origin
+        const cdt::Vector2i &getBoundary() const
+        {
+            return m_boundary;
+        }
 
         void dumpToFile(const std::string filename) const;
+        void saveSnapshot(const std::string &filename, std::span<const float> triangle_widths = {}) const;
+        void loadSnapshot(const SnapshotFile &snapshot);
 
         void updateCellGrid();
+        Reordering reorder();
+
+        void setConstraintInsertion(ConstraintInsertion mode) { m_constraint_insertion = mode; }
+        ConstraintInsertion constraintInsertion() const { return m_constraint_insertion; }
+
+        const LocateStats &locateStats() const { return m_cursor.stats; }
+        void resetLocateStats() { m_cursor.stats = {}; }
 
         bool allAreDelaunay() const;
+        bool triangulationIsConsistent() const;
         std::vector<EdgeI<Vertex>> findOverlappingConstraints(const Vertex &vi, const Vertex &vj);
 
-        std::vector<EdgeVInd> findOverlappingConstraints2(const Vertex &vi, const Vertex &vj);
+        std::vector<EdgeVInd> findOverlappingConstraints2(const Vertex &vi, const Vertex &vj,
+                                                          bool start_from_last_found = false);
 
     private:
         bool areCollinear(const Vertex &v1, const Vertex &v2, const Vertex &v3) const
@@ -138,60 +386,136 @@ namespace cdt
                    dot(v - v_left, v_right - v_left) * dot(v - v_right, v_right - v_left) <= 0;
         }
 
+        int indexOf(const Vertex &v, const Triangle &tri) const;
+
         VertInd findOverlappingVertex(const Vertex &new_vertex, const TriInd tri_ind) const;
         EdgeVInd findOverlappingEdge(const Vertex &new_vertex, const TriInd tri_ind) const;
 
         TriInd findTriangle(Vertex query_point, bool start_from_last_found = false);
+        template <class VectorType>
+        TriInd locateTriangle(const VectorType &query_point, LocateCursor &cursor, bool start_from_hint) const;
+        template <class VectorType>
+        TriInd walkToTriangle(const VectorType &query_point, TriInd tri_ind, LocateCursor &cursor) const;
+        TriInd sampleTriangleNear(cdt::Vector2f query_point, std::size_t n_samples, LocateCursor &cursor) const;
 
         bool edgesIntersect(const EdgeVInd e1, const EdgeVInd e2) const noexcept;
-        bool edgesIntersect(const EdgeI<Vertex> e1, const EdgeI<Vertex> e2) const noexcept;
 
-        void insertVertexOnEdge(const Vertex &v, TriInd tri_ind_a, TriInd tri_ind_b, const EdgeI<Vertex> &edge);
+        void insertVertexOnEdge(VertInd new_vertex_ind, TriInd tri_ind_a, int edge_ind_in_tri);
 
         bool isConvex(const Vertex v1, const Vertex v2, const Vertex v3, const Vertex v4) const;
 
-        int oppositeOfEdge(const Triangle<Vertex> &tri, const EdgeI<Vertex> &e) const;
+        int oppositeOfEdge(const Triangle &tri, const EdgeVInd &e) const;
+
+        TriInd triangleOppositeOfEdge(const Triangle &tri, const EdgeVInd &edge) const;
+
+        void linkNeighbours(TriInd tri_ind_a, int ind_in_a, TriInd tri_ind_b, int ind_in_b);
+
+        void swapConnectingEdgeClockwise(const TriInd tri_ind_a, const int v_a_ind_in_tri);
+        void swapConnectingEdgeCounterClockwise(const TriInd tri_ind_a, const int v_a_ind_in_tri);
+
+        void legalizeAround(VertInd v_ind, std::vector<std::pair<TriInd, int>> &edges_to_fix);
+        void legalizeEdges(std::vector<std::pair<TriInd, int>> &edges_to_fix);
 
-        TriInd triangleOppositeOfEdge(const Triangle<Vertex> &tri, const EdgeI<Vertex> &edge) const;
+        std::vector<std::pair<TriInd, int>> trianglesAround(VertInd v_ind) const;
+        TriInd firstTriangleAround(VertInd v_ind) const;
+        void removeTriangles(std::vector<TriInd> tri_inds);
+        bool isBoundaryCorner(const Vertex &v) const;
 
-        void swapConnectingEdgeClockwise(const TriInd &tri_ind_a, const TriInd &tri_ind_b);
-        void swapConnectingEdgeCounterClockwise(const TriInd &tri_ind_a, const TriInd &tri_ind_b);
+        bool cellGridNeedsResize() const;
+        void updateCellOf(TriInd tri_ind);
+        void updateVertex2Tri(TriInd tri_ind);
 
-        void findIntersectingEdges(const EdgeVInd &e, std::deque<EdgeI<Vertex>> &intersected_edges,
-                                   std::deque<TriInd> &intersected_tri_inds);
+        void findIntersectingEdges(const EdgeVInd &e);
+        void collectOverlaps(const EdgeVInd &e, std::vector<EdgeVInd> &overlaps);
+
+        void insertConstraintParts(const EdgeVInd edge);
+        void insertConstraintPart(const EdgeVInd edge);
+        void retriangulateCavity(const EdgeVInd edge);
+        std::pair<TriInd, int> findNewlyCreatedEdge(const EdgeVInd &e, std::pair<TriInd, TriInd> tri_inds) const;
+        void fixNewlyCreatedEdges();
 
         bool isCounterClockwise(const Vertex &v_query, const Vertex &v1, const Vertex &v2) const;
         bool needSwap(const Vertex &vp, const Vertex &v1, const Vertex &v2, const Vertex &v3) const;
 
         long long det(const Vertex &v1, const Vertex &v2, const Vertex &v3) const;
-        bool hasGoodOrientation(const Triangle<Vertex> &tri) const;
+        bool hasGoodOrientation(const Triangle &tri) const;
         bool allTrianglesValid() const;
 
-        bool isDelaunay(const Triangle<Vertex> &tri) const;
-        bool triangulationIsConsistent() const;
+        bool isDelaunay(const TriInd tri_ind) const;
 
         template <class VectorType>
-        bool withinBoundary(const VectorType& query)
+        bool withinBoundary(const VectorType& query) const
         {
             return query.x >= 0 && query.x <= m_boundary.x &&
                    query.y >= 0 && query.y <= m_boundary.y;
         }
 
     public:
-        std::vector<Triangle<Vertex>> m_triangles;
+        std::vector<Triangle> m_triangles;
         std::vector<Vertex> m_vertices;
-        std::unordered_set<EdgeI<Vertex>, EdgeHash> m_fixed_edges;
-
-        std::vector<std::array<VertInd, 3>> m_tri_ind2vert_inds;
-        std::vector<std::array<bool, 3>> m_triedge_constrained;
+        std::vector<TriInd> m_vertex2tri; //! for each vertex one of the triangles having it as a corner
+        EdgeSet m_fixed_edges; //! every constrained edge, the same edges have their flag set in m_triangles
 
     private:
         std::vector<TriInd> m_cell2tri_ind;
         cdt::Vector2i m_boundary;
 
-        TriInd m_last_found = 0;      //! cached index of last found triangle (in a lot of cases new searched triangle is
-                                      //! near previously found one)
+        LocateCursor m_cursor;        //! used by the non-const findTriangle, its hint is the last found triangle (in a
+                                      //! lot of cases new searched triangle is near previously found one)
         std::unique_ptr<Grid> m_grid; //! underlying grid that will be used for finding triangles containing query point
+
+        sf::RenderWindow *m_debug_window = nullptr; //! when set, constraint insertion draws every edge swap
+
+        ConstraintInsertion m_constraint_insertion = ConstraintInsertion::EdgeFlips;
+
+        //! \struct edge of a polygon being retriangulated together with the triangle lying outside of it
+        struct OuterEdge
+        {
+            TriInd tri_ind;
+            int ind_in_tri;
+            bool is_constrained;
+        };
+
+        //! \struct buffers used by constraint insertion, they are only cleared between calls so that
+        //! \brief inserting constraints does not allocate once the buffers have grown large enough
+        struct ConstraintScratch
+        {
+            std::vector<std::pair<std::uint64_t, EdgeVInd>> ordered_edges; //! batch sorted along a Hilbert curve
+            std::vector<EdgeVInd> pending_parts;                           //! work list of constraints to insert
+            std::vector<EdgeVInd> overlaps;               //! existing edges lying on the inserted constraint
+            std::vector<EdgeVInd> intersected_edges;      //! edges crossing the constraint, used as a queue
+            std::vector<TriInd> intersected_tri_inds;     //! triangles containing the intersected_edges
+            std::vector<EdgeVInd> newly_created_edges;    //! edges created by swaps, checked at the end
+            std::vector<std::pair<TriInd, TriInd>> newly_created_edge_tris; //! triangles containing the new edges
+            std::vector<std::pair<TriInd, int>> edges_to_fix;
+
+            struct CavityPolygon
+            {
+                std::vector<VertInd> vert_inds;   //! from the constraint start to its end along one side
+                std::vector<OuterEdge> outer_edges; //! outer_edges[k] lies between vert_inds[k] and vert_inds[k+1]
+            };
+            struct CavityTask
+            {
+                std::size_t i; //! the polygon part between vert_inds[i] and vert_inds[j] is to be triangulated
+                std::size_t j;
+                TriInd tri_ind; //! triangle lying across the edge from vert_inds[i] to vert_inds[j]
+                int ind_in_tri;
+            };
+            std::vector<TriInd> cavity;                //! triangles pierced by the constraint
+            std::array<CavityPolygon, 2> polygons;     //! left and right of the constraint
+            std::vector<CavityTask> cavity_tasks;
+            std::vector<VertInd> detached; //! vertices inside of the cavity which get inserted again
+        };
+        ConstraintScratch m_scratch;
+
+        //! \struct buffers of replaceConstraintsInRect, so that small edits do not allocate for the walk over triangles
+        struct EditScratch
+        {
+            std::vector<TriInd> to_visit;
+            std::vector<std::uint32_t> visit_stamps; //! triangles holding visit_stamp were visited by the current edit
+            std::uint32_t visit_stamp = 0;
+        };
+        EditScratch m_edit_scratch;
     };
 
     //! \brief used for finding orientation of \p p1 w.r.t. ( \p p3 - \p p2 )
@@ -201,54 +525,40 @@ namespace cdt
         return (p1.x - p3.x) * (p2.y - p3.y) - (p2.x - p3.x) * (p1.y - p3.y);
     }
 
-    inline int next(const int ind_in_tri)
-    {
-        assert(ind_in_tri <= 2 && ind_in_tri >= 0);
-        if (ind_in_tri == 2)
-        {
-            return 0;
-        }
-        return ind_in_tri + 1;
-    }
-
-    inline int prev(const int ind_in_tri)
-    {
-        assert(ind_in_tri <= 2 && ind_in_tri >= 0);
-        if (ind_in_tri == 0)
-        {
-            return 2;
-        }
-        return ind_in_tri - 1;
-    }
-
-    template <class Vertex>
-    inline int indInTriOf(const Triangle<Vertex> &tri, const TriInd neighbour)
+    inline int indInTriOf(const Triangle &tri, const TriInd neighbour)
     {
         auto neighbour_it = ::std::find(tri.neighbours.begin(), tri.neighbours.end(), neighbour);
         return neighbour_it - tri.neighbours.begin();
     }
 
-    //! \brief checks if point \p r lies inside the triangle \p tri
+    //! \brief checks if point \p r lies inside the triangle formed by \p v0, \p v1, \p v2
     //! \tparam VectorType
     //! \param r
-    //! \param tri
     //! \returns true if the point lies inside the triangle
     template <typename VectorType, class Vertex>
-    inline bool isInTriangle(const VectorType &r, const Triangle<Vertex> &tri)
+    inline bool isInTriangle(const VectorType &r, const Vertex &v0, const Vertex &v1, const Vertex &v2)
     {
-        float d1, d2, d3;
-        bool has_neg, has_pos;
-
-        d1 = sign(r, tri.verts[0], tri.verts[1]);
-        d2 = sign(r, tri.verts[1], tri.verts[2]);
-        d3 = sign(r, tri.verts[2], tri.verts[0]);
+        const auto d1 = orientation(r, v0, v1);
+        const auto d2 = orientation(r, v1, v2);
+        const auto d3 = orientation(r, v2, v0);
 
-        has_neg = (d1 < 0) || (d2 < 0) || (d3 < 0);
-        has_pos = (d1 > 0) || (d2 > 0) || (d3 > 0);
+        const bool has_neg = (d1 < 0) || (d2 < 0) || (d3 < 0);
+        const bool has_pos = (d1 > 0) || (d2 > 0) || (d3 > 0);
 
         return !(has_neg && has_pos);
     }
 
+    //! \brief checks if point \p r lies inside the triangle \p tri
+    //! \param r
+    //! \param tri
+    //! \param vertices vertex coordinates of the triangulation containing \p tri
+    //! \returns true if the point lies inside the triangle
+    template <typename VectorType, class Vertex>
+    inline bool isInTriangle(const VectorType &r, const Triangle &tri, const std::vector<Vertex> &vertices)
+    {
+        return isInTriangle(r, vertices[tri.vert_inds[0]], vertices[tri.vert_inds[1]], vertices[tri.vert_inds[2]]);
+    }
+
 } // namespace cdt
 
 #endif // BOIDS_TRIANGULATION_H